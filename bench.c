@@ -0,0 +1,953 @@
+/* *************************************************************************
+* NAME: glutcam/bench.c
+*
+* DESCRIPTION:
+*
+* glutcam_bench: run the capture -> convert/process -> upload pipeline
+* with no window, as fast as it will go, at a list of image sizes, and
+* print what it costs: frames per second, the per-stage latencies from
+* stagestats.c and heap allocations per frame.
+*
+* frames come from the test pattern (init_test_pattern), published and
+* taken from the frame ring the way glutcam does, so the ring, the
+* colour conversion workers and process() all run the code the real
+* program does. only the test pattern's 30 fps pacing is skipped.
+*
+* with -g, each frame is also converted straight into a mapped PBO and
+* uploaded to a texture, as draw_video_frame does; that needs a GL
+* context, which comes from a hidden GLUT window.
+*
+* allocations are counted by wrapping malloc, calloc and realloc (C++
+* new goes through malloc too), over the timed frames only. each
+* thread's are counted too (thread_allocations), so the tracker
+* thread can say which of its stages allocate.
+*
+* with -t each frame waits for the tracker (finish_tracking), so
+* every frame is tracked and its allocations are the frame's. -A
+* makes that a test: the run fails if, after warm-up, the tracker's
+* own code (matching and its bookkeeping) allocated at all. what
+* OpenCV allocates inside the detector, BRIEF, optical flow and
+* findHomography is reported but not held against it.
+*
+* with -f the frames come from a recording instead (init_capture_file,
+* played as fast as they're taken), at the size it was made. -V checks
+* the tracker's matches against BFMatcher's on every frame: real
+* footage is what gives the matcher something to get wrong. -L n has
+* the tracker detect every nth frame and use optical flow in between.
+*
+* PROCESS:
+*
+* make glutcam_bench
+* ./glutcam_bench                     -- 320x240, 720p, 1080p and 4K
+* ./glutcam_bench -s 1280x720 -t -g   -- 720p with tracking and upload
+* ./glutcam_bench -f walk.cap -V       -- track a recording, checking
+*                                        the matcher
+* ./glutcam_bench -s 640x480 -A        -- fail if the tracker allocates
+*
+* GLOBALS: none (Bench_allocs is local to this file)
+*
+* REFERENCES:
+*
+* LIMITATIONS:
+*
+* the tracker (-t) needs the DEF_RGB (OpenCV) build. without it the
+* conversion runs on a worker pool of this program's own, the way
+* process() would run it.
+*
+* REVISION HISTORY:
+*
+*   STR                Description                          Author
+*
+*   17-Oct-26          initial coding
+*   17-Oct-26          count allocations per thread; wait for the
+*                      tracker each frame
+*   17-Oct-26          -f capture file, -V verify the matcher
+*   17-Oct-26          -L optical flow between detections
+*   17-Oct-26          -A fail on the tracker's own allocations
+*
+* TARGET: Linux C, glibc (for the malloc wrappers)
+*
+* This software is in the public domain. if it breaks you get to keep
+* both pieces.
+*
+* ************************************************************************* */
+
+#include <stdio.h>
+#include <stdlib.h> /* malloc, free, atoi  */
+#include <string.h> /* memset, strcmp  */
+#include <unistd.h> /* getopt  */
+
+#include <GL/glew.h>
+#include <GL/glut.h>
+
+#include "glutcam.h"
+#include "testpattern.h" /* init_test_pattern  */
+#include "capfile.h" /* init_capture_file  */
+#include "capture.h" /* start_capture_source, acquire_video_frame, ...  */
+#include "cvProcess.h" /* process, g_toProcess  */
+#include "colorconvert.h" /* select_convert_kernel  */
+#include "workpool.h" /* physical_core_count  */
+#include "pboring.h" /* map_pbo, unmap_pbo, finish_pbo_upload  */
+#include "stagestats.h" /* reset_stage_stats, record_stage_since  */
+#include "timeutil.h" /* monotonic_usec  */
+
+/* BENCH_WARMUP_FRAMES - frames run before timing starts, so caches,  */
+/* PBOs and the tracker's vectors are warm  */
+/* BENCH_PATTERN_FRAMES - test pattern frames to cycle through  */
+/* (more than the cache holds at the larger sizes)  */
+
+#define BENCH_WARMUP_FRAMES 20
+#define BENCH_PATTERN_FRAMES 4
+#define DEFAULT_BENCH_FRAMES 300
+
+extern char *optarg; /* declared in the C library for getopt  */
+
+/* glibc's own allocator, under the names it exports for this  */
+extern void * __libc_malloc(size_t size);
+extern void * __libc_calloc(size_t nmemb, size_t size);
+extern void * __libc_realloc(void * ptr, size_t size);
+
+static unsigned long long Bench_allocs = 0; /* atomic  */
+static __thread unsigned long long Thread_allocs = 0; /* this thread's  */
+
+static struct {
+  int w;
+  int h;
+} Bench_sizes[] = {
+  {320, 240}, {1280, 720}, {1920, 1080}, {3840, 2160}
+};
+
+#define N_BENCH_SIZES ((int)(sizeof(Bench_sizes) / sizeof(Bench_sizes[0])))
+
+/* local prototypes  */
+int parse_bench_args(int argc, char * argv[], Benchargs_t * args);
+int setup_bench_gl(int * argc, char * argv[]);
+int run_bench(const Benchargs_t * args, int width, int height);
+void bench_frame(Sourceparams_t * sourceparams, Workpool_t * pool,
+		 Pboring_t * pbos, unsigned char * rgb, int gl_upload);
+unsigned long long thread_allocations(void); /* for cvProcess.cpp  */
+/* end local prototypes  */
+
+
+
+/* *************************************************************************
+
+
+   NAME:  main
+
+
+   USAGE:
+
+   glutcam_bench [-s WxH]... [-n frames] [-t] [-V] [-A] [-L frames]
+                 [-f capturefile] [-g] [-j nthreads]
+                 [-k auto | scalar | sse2 | avx2 | neon | opencv]
+
+   returns: int
+
+   DESCRIPTION:
+                 parse the command line, set up GL if it's wanted,
+		 and run the benchmark at each size.
+
+		 return 0 if every size ran (and with -A, the
+		 tracker didn't allocate), -1 if not
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int main(int argc, char * argv[])
+{
+  Benchargs_t args;
+  int i, retval;
+
+  if (0 != parse_bench_args(argc, argv, &args))
+    {
+      return(-1);
+    }
+
+  if ((0 != args.gl_upload) && (0 != setup_bench_gl(&argc, argv)))
+    {
+      return(-1);
+    }
+
+  fprintf(stderr, "colour conversion: %s, %d frames per size%s%s\n",
+	  convert_kernel_name(select_convert_kernel(args.convert_kernel)),
+	  args.frames, (0 != args.track) ? ", tracking" : "",
+	  (0 != args.gl_upload) ? ", GL upload" : "");
+
+  retval = 0;
+  for (i = 0; i < args.nsizes; i++)
+    {
+      if (0 != run_bench(&args, args.width[i], args.height[i]))
+	{
+	  retval = -1;
+	}
+    }
+
+  return(retval);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  parse_bench_args
+
+
+   USAGE:
+
+   int some_int;
+   Benchargs_t args;
+
+   some_int =  parse_bench_args(argc, argv, &args);
+
+   if (0 == some_int)
+   -- run it
+   else
+   -- usage was printed
+
+   returns: int
+
+   DESCRIPTION:
+                 fill in args from the command line:
+
+		 -s WxH  -- a size to run (repeatable); default
+		            320x240, 1280x720, 1920x1080, 3840x2160
+		 -n N    -- timed frames at each size
+		 -t      -- run the tracker in process()
+		 -V      -- ...and check its matches against
+		            BFMatcher's (implies -t)
+		 -A      -- ...and fail if its own code allocates
+		            after warm-up (implies -t)
+		 -L n    -- ...detecting every nth frame, following
+		            by optical flow between (implies -t)
+		 -f file -- frames from this recording, at its size
+		            (instead of -s)
+		 -g      -- upload frames through PBOs to a texture
+		 -j N    -- colour conversion threads
+		 -k name -- colour conversion code
+
+		 return 0 if all's well, -1 (after the usage message)
+		 if not
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: optarg, Bench_sizes
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+     17-Oct-26  -V, -f
+     17-Oct-26  -L
+     17-Oct-26  -A
+
+ ************************************************************************* */
+
+int parse_bench_args(int argc, char * argv[], Benchargs_t * args)
+{
+  int opt, i, unexpected;
+  Convertkernel_t kernel;
+
+  memset(args, 0, sizeof(*args));
+  args->frames = DEFAULT_BENCH_FRAMES;
+  args->convert_threads = -1;
+  args->convert_kernel = CONVERT_AUTO;
+
+  unexpected = 0;
+
+  while ((0 == unexpected) && (-1 != (opt = getopt(argc, argv, "s:n:tVAL:f:gj:k:"))))
+    {
+      switch (opt)
+	{
+	case 's':
+	  if ((MAX_BENCH_SIZES <= args->nsizes)
+	      || (2 != sscanf(optarg, "%dx%d", &(args->width[args->nsizes]),
+			      &(args->height[args->nsizes])))
+	      || (2 > args->width[args->nsizes])
+	      || (1 > args->height[args->nsizes])
+	      || (0 != (args->width[args->nsizes] & 1)))
+	    {
+	      fprintf(stderr, "size (-s) must be WxH, W even, at most %d of them\n",
+		      MAX_BENCH_SIZES);
+	      unexpected = 1;
+	    }
+	  else
+	    {
+	      args->nsizes++;
+	    }
+	  break;
+
+	case 'n':
+	  args->frames = atoi(optarg);
+	  if (1 > args->frames)
+	    {
+	      fprintf(stderr, "frames (-n) must be 1 or more\n");
+	      unexpected = 1;
+	    }
+	  break;
+
+	case 't':
+#ifdef	DEF_RGB
+	  args->track = 1;
+#else
+	  fprintf(stderr, "tracking (-t) needs the DEF_RGB build\n");
+	  unexpected = 1;
+#endif
+	  break;
+
+	case 'V':
+#ifdef	DEF_RGB
+	  args->track = 1;
+	  args->verify = 1;
+#else
+	  fprintf(stderr, "checking the matcher (-V) needs the DEF_RGB build\n");
+	  unexpected = 1;
+#endif
+	  break;
+
+	case 'A':
+#ifdef	DEF_RGB
+	  args->track = 1;
+	  args->check_allocs = 1;
+#else
+	  fprintf(stderr, "checking the tracker's allocations (-A) needs the"
+		  " DEF_RGB build\n");
+	  unexpected = 1;
+#endif
+	  break;
+
+	case 'L':
+#ifdef	DEF_RGB
+	  args->track = 1;
+	  args->flow_interval = atoi(optarg);
+	  if (0 > args->flow_interval)
+	    {
+	      fprintf(stderr, "detection interval (-L) must be 0 or more\n");
+	      unexpected = 1;
+	    }
+#else
+	  fprintf(stderr, "optical flow (-L) needs the DEF_RGB build\n");
+	  unexpected = 1;
+#endif
+	  break;
+
+	case 'f':
+	  strncpy(args->capture_file, optarg, MAX_DEVICENAME - 1);
+	  args->capture_file[MAX_DEVICENAME - 1] = '\0';
+	  break;
+
+	case 'g':
+	  args->gl_upload = 1;
+	  break;
+
+	case 'j':
+	  args->convert_threads = atoi(optarg);
+	  if (0 > args->convert_threads)
+	    {
+	      fprintf(stderr, "conversion threads (-j) must be 0 or more\n");
+	      unexpected = 1;
+	    }
+	  break;
+
+	case 'k':
+	  for (kernel = CONVERT_AUTO; kernel <= CONVERT_OPENCV;
+	       kernel = (Convertkernel_t)(kernel + 1))
+	    {
+	      if (0 == strcmp(optarg, convert_kernel_name(kernel)))
+		{
+		  break;
+		}
+	    }
+	  if (CONVERT_OPENCV < kernel)
+	    {
+	      fprintf(stderr, "conversion (-k) option '%s' not recognized\n",
+		      optarg);
+	      unexpected = 1;
+	    }
+	  args->convert_kernel = kernel;
+	  break;
+
+	default:
+	  unexpected = 1;
+	  break;
+	}
+    }
+
+  if ((0 == unexpected) && ('\0' != args->capture_file[0])
+      && (0 != args->nsizes))
+    {
+      fprintf(stderr, "a capture file (-f) has its own size: no -s\n");
+      unexpected = 1;
+    }
+
+  if (0 != unexpected)
+    {
+      fprintf(stderr, "Usage: %s [-s WxH]... [-n frames] [-t] [-V] [-A]"
+	      " [-L frames] [-f capturefile] [-g]\n"
+	      "         [-j nthreads]"
+	      " [-k auto | scalar | sse2 | avx2 | neon | opencv]\n",
+	      argv[0]);
+      fprintf(stderr, "   -s: image size to run, repeatable; default all of\n");
+      fprintf(stderr, "      ");
+      for (i = 0; i < N_BENCH_SIZES; i++)
+	{
+	  fprintf(stderr, " %dx%d", Bench_sizes[i].w, Bench_sizes[i].h);
+	}
+      fprintf(stderr, "\n");
+      fprintf(stderr, "   -n: timed frames at each size, default %d\n",
+	      DEFAULT_BENCH_FRAMES);
+      fprintf(stderr, "   -t: run the feature tracker in process() too\n");
+      fprintf(stderr, "   -V: ...and check its matches against BFMatcher's\n");
+      fprintf(stderr, "   -A: ...and fail if its own code allocates after"
+	      " warm-up\n");
+      fprintf(stderr, "   -L: ...detecting every frames'th frame, optical"
+	      " flow between\n");
+      fprintf(stderr, "   -f: frames from this recording (at its size),"
+	      " not a test pattern\n");
+      fprintf(stderr, "   -g: upload each frame through PBOs (needs a display)\n");
+      fprintf(stderr, "   -j: YUYV to RGB threads, default one per core\n");
+      fprintf(stderr, "   -k: YUYV to RGB conversion code, default auto\n");
+      return(-1);
+    }
+
+  if ('\0' != args->capture_file[0])
+    {
+      args->nsizes = 1; /* whatever size it is: run_bench finds out  */
+    }
+  else if (0 == args->nsizes)
+    {
+      for (i = 0; i < N_BENCH_SIZES; i++)
+	{
+	  args->width[i] = Bench_sizes[i].w;
+	  args->height[i] = Bench_sizes[i].h;
+	}
+      args->nsizes = N_BENCH_SIZES;
+    }
+
+  return(0);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  setup_bench_gl
+
+
+   USAGE:
+
+   int some_int;
+
+   some_int =  setup_bench_gl(&argc, argv);
+
+   returns: int
+
+   DESCRIPTION:
+                 get a GL context from a small GLUT window that's
+		 never shown, and set up GLEW in it.
+
+		 return 0 if all's well
+		       -1 if the PBO extension isn't there
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLUT still wants an X display, even for a hidden window
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int setup_bench_gl(int * argc, char * argv[])
+{
+  glutInit(argc, argv);
+  glutInitDisplayMode(GLUT_RGB | GLUT_DOUBLE);
+  glutInitWindowSize(64, 64);
+  (void)glutCreateWindow("glutcam_bench");
+  glutHideWindow();
+
+  glewInit();
+  if (!glewIsSupported("GL_ARB_pixel_buffer_object"))
+    {
+      fprintf(stderr, "Error: GL_ARB_pixel_buffer_object isn't supported\n");
+      return(-1);
+    }
+
+  return(0);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  run_bench
+
+
+   USAGE:
+
+   int some_int;
+   Benchargs_t args;
+
+   some_int =  run_bench(&args, 1280, 720);
+
+   returns: int
+
+   DESCRIPTION:
+                 set up a width x height YUYV test pattern (or play
+		 back args->capture_file, at its own size), run
+		 BENCH_WARMUP_FRAMES and then args->frames frames
+		 through bench_frame, and print frames per second,
+		 msec per frame and allocations per frame.
+		 stop_capture_source prints the stage latencies.
+
+		 with args->check_allocs, ask the tracker what its own
+		 code allocated after warm-up (tracker_allocations).
+
+		 return 0 if all's well
+		       -1 if the source, the pool or the PBOs couldn't
+		          be set up, or args->check_allocs is set and
+			  the tracker allocated (or nothing was counted)
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: Bench_allocs
+
+      modified: g_toProcess, g_verifyMatches, g_flowInterval
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+     17-Oct-26  capture files; verify the matcher
+     17-Oct-26  optical flow
+     17-Oct-26  check the tracker's allocations
+
+ ************************************************************************* */
+
+int run_bench(const Benchargs_t * args, int width, int height)
+{
+  Cmdargs_t argstruct;
+  Sourceparams_t sourceparams;
+  Workpool_t pool;
+  Pboring_t pbos;
+  GLuint texture;
+  unsigned char * rgb;
+  unsigned long long allocs;
+#ifdef	DEF_RGB
+  unsigned long long own_allocs, opencv_allocs;
+  unsigned int tracked;
+#endif
+  long long start_usec;
+  double seconds;
+  size_t rgbsize;
+  int i, retval;
+
+  memset(&argstruct, 0, sizeof(argstruct));
+  argstruct.source = TESTPATTERN;
+  argstruct.encoding = YUV422;
+  argstruct.image_width = width;
+  argstruct.image_height = height;
+  argstruct.testpattern_frames = BENCH_PATTERN_FRAMES;
+  if ('\0' != args->capture_file[0])
+    {
+      argstruct.source = FILESOURCE;
+      strcpy(argstruct.capture_file, args->capture_file);
+      argstruct.playback_fast = 1; /* the next as soon as one's released  */
+    }
+
+  memset(&sourceparams, 0, sizeof(sourceparams));
+  memset(&pool, 0, sizeof(pool));
+  memset(&pbos, 0, sizeof(pbos));
+  texture = 0;
+
+  if (((FILESOURCE == argstruct.source)
+       && (0 != init_capture_file(argstruct, &sourceparams)))
+      || ((TESTPATTERN == argstruct.source)
+	  && (0 != init_test_pattern(argstruct, &sourceparams))))
+    {
+      return(-1);
+    }
+  width = sourceparams.image_width;
+  height = sourceparams.image_height;
+#ifdef	DEF_RGB
+  g_verifyMatches = args->verify; /* before the tracker starts  */
+  g_flowInterval = args->flow_interval;
+#endif
+  sourceparams.threaded = 0;
+  sourceparams.convert_threads = (0 > args->convert_threads) ?
+    physical_core_count() : args->convert_threads;
+
+  /* the RGB frame is width * 3 bytes a row, padded to 4 like an  */
+  /* IplImage's widthStep  */
+  rgbsize = (size_t)((width * 3 + 3) & ~3) * height;
+  rgb = malloc(rgbsize);
+
+  if ((NULL == rgb) || (0 != start_capture_source(&sourceparams))
+#ifndef	DEF_RGB
+      /* process() converts on a pool of its own; without it we do  */
+      || (0 != start_workpool(&pool, sourceparams.convert_threads))
+#endif
+      )
+    {
+      fprintf(stderr, "Error: unable to set up %dx%d\n", width, height);
+      free(rgb);
+      return(-1);
+    }
+
+  if (0 != args->gl_upload)
+    {
+      glGenTextures(1, &texture);
+      glBindTexture(GL_TEXTURE_2D, texture);
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB,
+		   GL_UNSIGNED_BYTE, NULL);
+      if (0 != init_pboring(&pbos, DEFAULT_PBO_COUNT, rgbsize))
+	{
+	  fprintf(stderr, "Error: unable to set up PBOs\n");
+	  stop_workpool(&pool);
+	  (void)stop_capture_source(&sourceparams);
+	  free(rgb);
+	  return(-1);
+	}
+    }
+
+  g_toProcess = args->track;
+#ifdef	DEF_RGB
+  resetH();
+#endif
+
+  for (i = 0; i < BENCH_WARMUP_FRAMES; i++)
+    {
+      bench_frame(&sourceparams, &pool, &pbos, rgb, args->gl_upload);
+    }
+  if (0 != args->gl_upload)
+    {
+      glFinish();
+    }
+
+  reset_stage_stats();
+  allocs = __atomic_load_n(&Bench_allocs, __ATOMIC_RELAXED);
+  start_usec = monotonic_usec();
+
+  for (i = 0; i < args->frames; i++)
+    {
+      bench_frame(&sourceparams, &pool, &pbos, rgb, args->gl_upload);
+    }
+  if (0 != args->gl_upload)
+    {
+      glFinish(); /* count the uploads still in flight  */
+    }
+
+  seconds = (monotonic_usec() - start_usec) / 1e6;
+  allocs = __atomic_load_n(&Bench_allocs, __ATOMIC_RELAXED) - allocs;
+
+  fprintf(stderr, "\n%dx%d: %d frames in %.3f sec, %.1f fps, "
+	  "%.3f msec/frame, %.2f allocations/frame\n",
+	  width, height, args->frames, seconds, args->frames / seconds,
+	  1000.0 * seconds / args->frames,
+	  (double)allocs / args->frames);
+
+  if (0 != args->gl_upload)
+    {
+      fini_pboring(&pbos);
+      glDeleteTextures(1, &texture);
+    }
+  stop_workpool(&pool);
+  (void)stop_capture_source(&sourceparams); /* prints the stages  */
+
+  retval = 0;
+#ifdef	DEF_RGB
+  if (0 != args->check_allocs)
+    {
+      tracked = tracker_allocations(&own_allocs, &opencv_allocs);
+      if (0 == tracked)
+	{
+	  fprintf(stderr, "Error: no tracked frames after warm-up to count"
+		  " allocations on (-n too small?)\n");
+	  retval = -1;
+	}
+      else if (0 != own_allocs)
+	{
+	  fprintf(stderr, "Error: the tracker's own code allocated %llu times"
+		  " in %u frames after warm-up\n", own_allocs, tracked);
+	  retval = -1;
+	}
+      else
+	{
+	  fprintf(stderr, "tracker: its own code allocated nothing in %u"
+		  " frames; OpenCV's calls %.2f times a frame\n", tracked,
+		  (double)opencv_allocs / tracked);
+	}
+    }
+#endif
+
+  free(rgb);
+  free(sourceparams.testpattern.bufferarray);
+  free(sourceparams.captured.start);
+
+  return(retval);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  bench_frame
+
+
+   USAGE:
+
+   bench_frame(&sourceparams, &pool, &pbos, rgb, gl_upload);
+
+   returns: void
+
+   DESCRIPTION:
+                 push one test pattern frame through the pipeline:
+		 publish it to the ring, take it off, convert it to
+		 RGB (and track, if g_toProcess is set) and give it
+		 back.
+
+		 the RGB goes into rgb, or with gl_upload into the
+		 next mapped PBO, which is then uploaded to the bound
+		 texture, the way draw_video_frame does it.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void bench_frame(Sourceparams_t * sourceparams, Workpool_t * pool,
+		 Pboring_t * pbos, unsigned char * rgb, int gl_upload)
+{
+  Frameslot_t slot;
+  unsigned char * dst;
+  int nbytes;
+#ifndef	DEF_RGB
+  long long start;
+#endif
+
+  /* don't wait for the test pattern's next 30 fps tick  */
+  sourceparams->testpattern.next_frame_usec = 0;
+  (void)capture_video_frame(sourceparams, &nbytes);
+
+  if (0 != acquire_video_frame(sourceparams, &slot))
+    {
+      return;
+    }
+
+  dst = rgb;
+  if (0 != gl_upload)
+    {
+      dst = (unsigned char *)map_pbo(pbos);
+    }
+
+  if (NULL != dst)
+    {
+#ifdef	DEF_RGB
+      (void)pool; /* process() has its own  */
+      sourceparams->prgb->imageData = (char *)dst;
+      process((char *)slot.start, sourceparams->prgb);
+      if (0 != g_toProcess)
+	{
+	  finish_tracking(); /* every frame tracked, not just some  */
+	}
+#else
+      start = monotonic_usec();
+      convert_yuyv_to_rgb24_bands(pool, (const unsigned char *)slot.start,
+				  dst, sourceparams->image_width,
+				  sourceparams->image_height,
+				  (sourceparams->image_width * 3 + 3) & ~3);
+      (void)record_stage_since(STAGE_CONVERT, start);
+#endif
+    }
+
+  if (0 != gl_upload)
+    {
+      if (NULL != dst)
+	{
+	  unmap_pbo(pbos);
+	}
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, sourceparams->image_width,
+		      sourceparams->image_height, GL_RGB, GL_UNSIGNED_BYTE, 0);
+      finish_pbo_upload(pbos);
+    }
+
+  release_video_frame(sourceparams, &slot);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  malloc, calloc, realloc
+
+
+   USAGE:
+
+   (the C library and libstdc++ call these as usual)
+
+   returns: void *
+
+   DESCRIPTION:
+                 count the allocation in Bench_allocs and the calling
+		 thread's Thread_allocs, and hand it to glibc's
+		 allocator
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   glibc only. memalign and friends aren't counted.
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: Bench_allocs, Thread_allocs
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+     17-Oct-26  count per thread too
+
+ ************************************************************************* */
+
+void * malloc(size_t size)
+{
+  __atomic_fetch_add(&Bench_allocs, 1, __ATOMIC_RELAXED);
+  Thread_allocs++;
+  return(__libc_malloc(size));
+}
+
+void * calloc(size_t nmemb, size_t size)
+{
+  __atomic_fetch_add(&Bench_allocs, 1, __ATOMIC_RELAXED);
+  Thread_allocs++;
+  return(__libc_calloc(nmemb, size));
+}
+
+void * realloc(void * ptr, size_t size)
+{
+  __atomic_fetch_add(&Bench_allocs, 1, __ATOMIC_RELAXED);
+  Thread_allocs++;
+  return(__libc_realloc(ptr, size));
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  thread_allocations
+
+
+   USAGE:
+
+   unsigned long long before;
+
+   before = thread_allocations();
+   -- do something
+   fprintf(stderr, "%llu allocations\n", thread_allocations() - before);
+
+   returns: unsigned long long
+
+   DESCRIPTION:
+                 the heap allocations the calling thread has made so
+		 far. cvProcess.cpp's tracker uses it (it's a weak
+		 symbol there: glutcam doesn't have one) to count
+		 each stage's allocations.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: Thread_allocs
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+unsigned long long thread_allocations(void)
+{
+  return(Thread_allocs);
+}
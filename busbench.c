@@ -0,0 +1,743 @@
+/* *************************************************************************
+* NAME: glutcam/busbench.c
+*
+* DESCRIPTION:
+*
+* glutcam_busbench: measure the frame bus (framebus.c) with several
+* reader processes on one machine.
+*
+* by default this process is the producer: it publishes frames of a
+* given size at a given rate (or as fast as it can) on a bus of its
+* own, and forks the readers. with -a it's a single reader on the bus
+* of a running glutcam -B instead.
+*
+* each reader takes every frame it can, reads all of its pixels in
+* place (that's the zero copy part: the bus is mapped read only and
+* nothing is copied out) and checks that it was the frame it was
+* supposed to be, then reports:
+*
+* * frames read, missed (overwritten before the reader got to them)
+*   and torn (overwritten while the reader was reading them)
+* * end to end latency, from the frame's capture time (publish time
+*   here) until the reader has it, at the 50th and 99th percentile and
+*   the worst
+* * frames per second and GB/s read
+*
+* the producer reports what publishing cost it, which is what it
+* costs glutcam's capture side per frame.
+*
+* PROCESS:
+*
+* make glutcam_busbench
+* ./glutcam_busbench                    -- 4 readers, 1080p at 60 fps
+* ./glutcam_busbench -r 8 -f 0          -- 8 readers, flat out
+* ./glutcam -d /dev/video0 -B /tmp/cam.bus &
+* ./glutcam_busbench -a /tmp/cam.bus    -- read the camera's frames
+*
+* GLOBALS: none
+*
+* REFERENCES:
+*
+* LIMITATIONS:
+*
+* the content check only works on our own bus, and ignores the last
+* few bytes of a frame that isn't a multiple of 8 bytes.
+*
+* REVISION HISTORY:
+*
+*   STR                Description                          Author
+*
+*   17-Oct-26          initial coding
+*
+* TARGET: Linux C
+*
+* This software is in the public domain. if it breaks you get to keep
+* both pieces.
+*
+* ************************************************************************* */
+
+#include <stdio.h>
+#include <stdlib.h> /* malloc, free, atoi, qsort  */
+#include <string.h> /* memset, strncpy  */
+#include <unistd.h> /* getopt, fork, getpid, _exit  */
+#include <sys/types.h>
+#include <sys/wait.h> /* waitpid  */
+
+#include "glutcam.h"
+#include "framebus.h"
+#include "timeutil.h" /* monotonic_usec, sleep_until_usec  */
+
+/* BUSBENCH_PATTERNS - different frames the producer cycles through,  */
+/* so a reader can tell one from the next  */
+/* BUSBENCH_ATTACH_USEC - how long to wait for the readers to attach  */
+/* BUSBENCH_IDLE_USEC - a reader gives up after this long with no  */
+/* frames  */
+
+#define BUSBENCH_PATTERNS 4
+#define BUSBENCH_ATTACH_USEC 5000000
+#define BUSBENCH_IDLE_USEC 2000000
+#define DEFAULT_BUSBENCH_READERS 4
+#define DEFAULT_BUSBENCH_FRAMES 600
+#define DEFAULT_BUSBENCH_FPS 60
+
+extern char *optarg; /* declared in the C library for getopt  */
+
+/* local prototypes  */
+int parse_busbench_args(int argc, char * argv[], Busbenchargs_t * args);
+int run_bus_bench(const Busbenchargs_t * args);
+int run_bus_reader(const Busbenchargs_t * args, const char * path,
+		   int which, int check);
+uint64_t read_frame(const void * data, size_t length, uint64_t expected);
+uint64_t pattern_word(uint32_t frame);
+int compare_usec(const void * a, const void * b);
+/* end local prototypes  */
+
+
+
+/* *************************************************************************
+
+
+   NAME:  main
+
+
+   USAGE:
+
+   glutcam_busbench [-r readers] [-s WxH] [-n frames] [-f fps]
+                    [-a socket]
+
+   returns: int
+
+   DESCRIPTION:
+                 parse the command line, then either run the whole
+		 benchmark (producer and readers) or, with -a, read
+		 someone else's bus.
+
+		 return 0 if all's well, -1 if not
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int main(int argc, char * argv[])
+{
+  Busbenchargs_t args;
+
+  if (0 != parse_busbench_args(argc, argv, &args))
+    {
+      return(-1);
+    }
+
+  if ('\0' != args.attach[0])
+    {
+      return(run_bus_reader(&args, args.attach, 0, 0));
+    }
+
+  return(run_bus_bench(&args));
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  parse_busbench_args
+
+
+   USAGE:
+
+   int some_int;
+   Busbenchargs_t args;
+
+   some_int =  parse_busbench_args(argc, argv, &args);
+
+   if (0 == some_int)
+   -- run it
+   else
+   -- usage was printed
+
+   returns: int
+
+   DESCRIPTION:
+                 fill in args from the command line:
+
+		 -r N      -- reader processes
+		 -s WxH    -- frame size (YUYV)
+		 -n N      -- frames to publish (or read, with -a)
+		 -f N      -- frames per second, 0 for as fast as we can
+		 -a socket -- read a running glutcam's bus
+
+		 return 0 if all's well, -1 (after the usage message)
+		 if not
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: optarg
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int parse_busbench_args(int argc, char * argv[], Busbenchargs_t * args)
+{
+  int opt, unexpected;
+
+  memset(args, 0, sizeof(*args));
+  args->readers = DEFAULT_BUSBENCH_READERS;
+  args->width = 1920;
+  args->height = 1080;
+  args->frames = DEFAULT_BUSBENCH_FRAMES;
+  args->fps = DEFAULT_BUSBENCH_FPS;
+
+  unexpected = 0;
+
+  while ((0 == unexpected) && (-1 != (opt = getopt(argc, argv, "r:s:n:f:a:"))))
+    {
+      switch (opt)
+	{
+	case 'r':
+	  args->readers = atoi(optarg);
+	  if (1 > args->readers)
+	    {
+	      fprintf(stderr, "readers (-r) must be 1 or more\n");
+	      unexpected = 1;
+	    }
+	  break;
+
+	case 's':
+	  if ((2 != sscanf(optarg, "%dx%d", &(args->width), &(args->height)))
+	      || (2 > args->width) || (1 > args->height)
+	      || (0 != (args->width & 1)))
+	    {
+	      fprintf(stderr, "size (-s) must be WxH, W even\n");
+	      unexpected = 1;
+	    }
+	  break;
+
+	case 'n':
+	  args->frames = atoi(optarg);
+	  if (1 > args->frames)
+	    {
+	      fprintf(stderr, "frames (-n) must be 1 or more\n");
+	      unexpected = 1;
+	    }
+	  break;
+
+	case 'f':
+	  args->fps = atoi(optarg);
+	  if (0 > args->fps)
+	    {
+	      fprintf(stderr, "frame rate (-f) must be 0 or more\n");
+	      unexpected = 1;
+	    }
+	  break;
+
+	case 'a':
+	  strncpy(args->attach, optarg, MAX_DEVICENAME - 1);
+	  args->attach[MAX_DEVICENAME - 1] = '\0';
+	  break;
+
+	default:
+	  unexpected = 1;
+	  break;
+	}
+    }
+
+  if (0 != unexpected)
+    {
+      fprintf(stderr, "Usage: %s [-r readers] [-s WxH] [-n frames] [-f fps]"
+	      " [-a socket]\n", argv[0]);
+      fprintf(stderr, "   -r: reader processes, default %d\n",
+	      DEFAULT_BUSBENCH_READERS);
+      fprintf(stderr, "   -s: YUYV frame size, default 1920x1080\n");
+      fprintf(stderr, "   -n: frames to publish, default %d\n",
+	      DEFAULT_BUSBENCH_FRAMES);
+      fprintf(stderr, "   -f: frames per second, 0: as fast as we can;"
+	      " default %d\n", DEFAULT_BUSBENCH_FPS);
+      fprintf(stderr, "   -a: just read the bus glutcam -B is publishing"
+	      " on this socket\n");
+      return(-1);
+    }
+
+  return(0);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  run_bus_bench
+
+
+   USAGE:
+
+   int some_int;
+   Busbenchargs_t args;
+
+   some_int =  run_bus_bench(&args);
+
+   returns: int
+
+   DESCRIPTION:
+                 set up a bus for args->width x args->height YUYV
+		 frames, fork args->readers readers, wait for them to
+		 attach, then publish args->frames frames at args->fps
+		 (or flat out). close the bus, wait for the readers
+		 and say what publishing cost.
+
+		 frame n is filled with the 64 bit word
+		 pattern_word(n) over and over, so the readers can
+		 check they got the right frame.
+
+		 return 0 if every reader got every frame intact,
+		       -1 if not
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int run_bus_bench(const Busbenchargs_t * args)
+{
+  Sourceparams_t sourceparams;
+  Frameslot_t slot;
+  uint64_t * patterns[BUSBENCH_PATTERNS];
+  size_t frame_bytes, nwords, w;
+  long long start_usec, next_usec, publish_start_usec, publish_usec;
+  double seconds;
+  pid_t * pids;
+  int i, status, retval;
+
+  memset(&sourceparams, 0, sizeof(sourceparams));
+  sourceparams.image_width = args->width;
+  sourceparams.image_height = args->height;
+  sourceparams.encoding = YUV422;
+  frame_bytes = (size_t)args->width * args->height * 2;
+  sourceparams.captured.length = frame_bytes;
+  snprintf(sourceparams.framebus.path, MAX_DEVICENAME,
+	   "/tmp/glutcam_busbench.%d", (int)getpid());
+
+  nwords = frame_bytes / sizeof(uint64_t);
+  for (i = 0; i < BUSBENCH_PATTERNS; i++)
+    {
+      patterns[i] = (uint64_t *)malloc(frame_bytes + sizeof(uint64_t));
+      if (NULL == patterns[i])
+	{
+	  fprintf(stderr, "Error: no memory for %lu byte frames\n",
+		  (unsigned long)frame_bytes);
+	  return(-1);
+	}
+      for (w = 0; w < nwords; w++)
+	{
+	  patterns[i][w] = pattern_word((uint32_t)i);
+	}
+    }
+
+  if (-1 == start_framebus(&sourceparams))
+    {
+      return(-1);
+    }
+
+  printf("%d readers, %dx%d YUYV (%.2f MB), %d frames, ", args->readers,
+	 args->width, args->height, frame_bytes / 1e6, args->frames);
+  if (0 == args->fps)
+    {
+      printf("as fast as we can\n");
+    }
+  else
+    {
+      printf("%d fps\n", args->fps);
+    }
+  fflush(stdout);
+
+  pids = (pid_t *)malloc(args->readers * sizeof(pid_t));
+  for (i = 0; i < args->readers; i++)
+    {
+      pids[i] = fork();
+      if (0 == pids[i])
+	{
+	  _exit((0 == run_bus_reader(args, sourceparams.framebus.path, i, 1))
+		? 0 : 1);
+	}
+    }
+
+  start_usec = monotonic_usec();
+  while (((unsigned int)args->readers > accept_framebus_readers(&sourceparams))
+	 && (monotonic_usec() - start_usec < BUSBENCH_ATTACH_USEC))
+    {
+      sleep_until_usec(monotonic_usec() + 1000);
+    }
+
+  publish_usec = 0;
+  start_usec = monotonic_usec();
+  next_usec = start_usec;
+  for (i = 0; i < args->frames; i++)
+    {
+      if (0 < args->fps)
+	{
+	  sleep_until_usec(next_usec);
+	  next_usec += 1000000 / args->fps;
+	}
+      slot.index = i % BUSBENCH_PATTERNS;
+      slot.start = patterns[slot.index];
+      slot.length = frame_bytes;
+      slot.sequence = (unsigned int)i;
+      publish_start_usec = monotonic_usec();
+      slot.capture_usec = publish_start_usec;
+      publish_framebus_frame(&sourceparams, &slot);
+      publish_usec += monotonic_usec() - publish_start_usec;
+    }
+  seconds = (monotonic_usec() - start_usec) / 1e6;
+
+  stop_framebus(&sourceparams);
+
+  retval = 0;
+  for (i = 0; i < args->readers; i++)
+    {
+      if ((-1 == waitpid(pids[i], &status, 0)) || (!WIFEXITED(status))
+	  || (0 != WEXITSTATUS(status)))
+	{
+	  retval = -1;
+	}
+    }
+
+  printf("producer: %d frames in %.2f sec (%.1f fps), publish %.3f msec"
+	 " a frame (%.2f GB/s)\n", args->frames, seconds,
+	 args->frames / seconds, publish_usec / 1000.0 / args->frames,
+	 (0 < publish_usec) ?
+	 (double)frame_bytes * args->frames / (publish_usec * 1e3) : 0.0);
+
+  free(pids);
+  for (i = 0; i < BUSBENCH_PATTERNS; i++)
+    {
+      free(patterns[i]);
+    }
+
+  return(retval);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  run_bus_reader
+
+
+   USAGE:
+
+   int some_int;
+   Busbenchargs_t args;
+
+   some_int =  run_bus_reader(&args, path, which, check);
+
+   returns: int
+
+   DESCRIPTION:
+                 attach to the bus at path and read frames until the
+		 producer closes it, args->frames have been read, or
+		 nothing comes for BUSBENCH_IDLE_USEC. read every
+		 frame's pixels in place; if check is set, make sure
+		 they're the pattern run_bus_bench filled that frame
+		 with. then print what reader number which saw.
+
+		 return 0 if nothing was wrong (or torn, when paced:
+		   as fast as we can, a reader that falls a lap behind
+		   is expected to catch a frame being overwritten)
+		       -1 if something was, or we couldn't attach
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int run_bus_reader(const Busbenchargs_t * args, const char * path,
+		   int which, int check)
+{
+  Framebusreader_t reader;
+  Framebusframe_t frame;
+  long long * latency_usec;
+  long long first_usec, last_usec;
+  unsigned int nread, torn, wrong;
+  uint64_t difference;
+  double bytes, seconds;
+  int status;
+
+  if (-1 == attach_framebus(path, &reader))
+    {
+      return(-1);
+    }
+
+  latency_usec = (long long *)malloc(args->frames * sizeof(long long));
+  if (NULL == latency_usec)
+    {
+      detach_framebus(&reader);
+      return(-1);
+    }
+
+  nread = 0;
+  torn = 0;
+  wrong = 0;
+  bytes = 0;
+  first_usec = 0;
+  last_usec = 0;
+
+  while ((int)nread < args->frames)
+    {
+      status = next_framebus_frame(&reader, &frame, BUSBENCH_IDLE_USEC);
+      if (0 != status)
+	{
+	  break; /* closed, or nothing's coming  */
+	}
+
+      last_usec = monotonic_usec();
+      if (0 == nread)
+	{
+	  first_usec = last_usec;
+	}
+      latency_usec[nread++] = last_usec - frame.capture_usec;
+
+      difference = read_frame(frame.data, frame.length,
+			      pattern_word(frame.frame % BUSBENCH_PATTERNS));
+      bytes += frame.length;
+
+      if (!framebus_frame_intact(&reader, &frame))
+	{
+	  torn++;
+	}
+      else if ((0 != check) && (0 != difference))
+	{
+	  wrong++;
+	}
+    }
+
+  seconds = (last_usec - first_usec) / 1e6;
+  qsort(latency_usec, nread, sizeof(long long), compare_usec);
+
+  printf("reader %d: %u frames, %u missed, %u torn, %u wrong; latency"
+	 " p50 %.3f p99 %.3f max %.3f msec; %.1f fps, %.2f GB/s\n",
+	 which, nread, reader.missed, torn, wrong,
+	 (0 < nread) ? latency_usec[nread / 2] / 1000.0 : 0.0,
+	 (0 < nread) ? latency_usec[(nread * 99) / 100] / 1000.0 : 0.0,
+	 (0 < nread) ? latency_usec[nread - 1] / 1000.0 : 0.0,
+	 (0 < seconds) ? (nread - 1) / seconds : 0.0,
+	 (0 < seconds) ? bytes / seconds / 1e9 : 0.0);
+  fflush(stdout);
+
+  free(latency_usec);
+  detach_framebus(&reader);
+
+  return(((0 == wrong) && ((0 == torn) || (0 == args->fps))) ? 0 : -1);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  read_frame
+
+
+   USAGE:
+
+   uint64_t difference;
+   const void * data;
+   size_t length;
+
+   difference =  read_frame(data, length, pattern_word(n));
+
+   returns: uint64_t
+
+   DESCRIPTION:
+                 read every 64 bit word of the frame at data and
+		 return the bits that differ from expected in any of
+		 them: 0 if the frame is all expected.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   ignores length % 8 trailing bytes
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+uint64_t read_frame(const void * data, size_t length, uint64_t expected)
+{
+  const uint64_t * words;
+  uint64_t difference;
+  size_t i, nwords;
+
+  words = (const uint64_t *)data;
+  nwords = length / sizeof(uint64_t);
+  difference = 0;
+
+  for (i = 0; i < nwords; i++)
+    {
+      difference |= words[i] ^ expected;
+    }
+
+  return(difference);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  pattern_word
+
+
+   USAGE:
+
+   uint64_t word;
+
+   word =  pattern_word(n % BUSBENCH_PATTERNS);
+
+   returns: uint64_t
+
+   DESCRIPTION:
+                 the 64 bit word pattern n is filled with
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+uint64_t pattern_word(uint32_t frame)
+{
+  return(0x0101010101010101ULL * (frame + 1));
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  compare_usec
+
+
+   USAGE:
+
+   qsort(latencies, n, sizeof(long long), compare_usec);
+
+   returns: int
+
+   DESCRIPTION:
+                 qsort comparison for long longs, smallest first
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int compare_usec(const void * a, const void * b)
+{
+  long long first, second;
+
+  first = *(const long long *)a;
+  second = *(const long long *)b;
+
+  return((first > second) - (first < second));
+}
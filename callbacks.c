@@ -13,7 +13,20 @@
 *         and stores pointers to the displaydata and source param
 *         structures that the other call back functions need.
 *
-* 
+* setup_offscreen_callbacks stores the same pointers for drawing with
+*         no window, and draw_offscreen_frames stands in for glut's
+*         main loop there
+*
+* set_callback_sources stores the Sourceset_t the drawn source is one
+*         of; the others are kept drained, and 'c' switches between
+*         them
+*
+* with several sources, the textures have a tile for each (see
+*         setup_texture in display.c) and Draw uploads and draws
+*         them with draw_video_tiles: all of them in a grid (the
+*         mosaic, -M or 'm') or just the chosen one. in the mosaic
+*         'c' picks the tile the menu's processing applies to.
+*
 * GLOBALS:
 *
 * * callback - contains pointers to source and display data
@@ -40,6 +53,19 @@
 *   10-Jan-08 added documentation, histograms, laplacian     gpk
 *   26-Jan-08 test to make sure we don't divide by zero in   gpk
 *             draw_fps_symbology, calculate_histogram_data
+*   17-Oct-26 redraw when a frame arrives instead of on a
+*             timer; report capture to swap latency
+*   17-Oct-26 per-stage latency histograms, 's' and 'r' keys
+*   17-Oct-26 trace Draw and draw_video_frame
+*   17-Oct-26 draw offscreen, with no glut window
+*   17-Oct-26 more than one source: 'c' picks the one drawn
+*   17-Oct-26 mosaic: every source tiled, in one draw call, with
+*             its own shader processing ('m')
+*   17-Oct-26 the mosaic draws matched sets of frames with -Y
+*   17-Oct-26 show the tracker's frame rate
+*   17-Oct-26 's' prints the PBO timing too
+*   17-Oct-26 capture->swap latency only in the stage histogram
+*   17-Oct-26 the mosaic tracks only the chosen source
 *
 * TARGET: C
 *
@@ -54,7 +80,6 @@
 
 #include <GL/glew.h> 
 #include <GL/glut.h>
-#include <sys/ioctl.h>
 
 #include "glutcam.h"
 #include "display.h"
@@ -64,6 +89,13 @@
 #include "shader.h"
 #include "controls.h"
 #include "cvProcess.h"
+#include "capture.h" /* acquire_video_frame, release_video_frame  */
+#include "multicapture.h" /* poll_capture_sources, drain_capture_sources  */
+#include "framesync.h" /* acquire_synced_frames, flush_framesync  */
+#include "pboring.h" /* map_pbo, unmap_pbo, finish_pbo_upload, ...  */
+#include "timeutil.h" /* monotonic_usec  */
+#include "stagestats.h" /* record_stage_usec, report_stage_stats  */
+#include "trace.h" /* trace_begin, trace_end  */
 
 #include "callbacks.h"
 
@@ -102,6 +134,12 @@
 
 #define HISTOGRAM_SIZE 256 /* 256 64 */ 
 
+/* IDLE_WAIT_USEC - how long Idle sleeps waiting for a frame from  */
+/* the capture thread. it's also the most a keypress or menu event  */
+/* can be held up by the wait, so keep it short.   */
+
+#define IDLE_WAIT_USEC 5000
+
 
 /* pull in the check_error function   */
 
@@ -132,7 +170,8 @@ typedef enum menu_selection_e
 typedef struct callbacks_s
 {
   Displaydata_t * displaydata; /* information about the display  */
-  Sourceparams_t * sourceparams; /* information about the video source  */
+  Sourceparams_t * sourceparams; /* the video source being drawn  */
+  Sourceset_t * sourceset; /* every source, sourceparams among them  */
 } Callback_t;
 
 
@@ -145,7 +184,8 @@ typedef struct callbacks_s
 
         accessors:  Key, Draw, Idle, process_menu_selection
                      
-        modifiers: setup_glut_window_callbacks
+        modifiers: setup_glut_window_callbacks, setup_offscreen_callbacks,
+                   set_callback_sources, Key
                      
     */
 
@@ -163,7 +203,7 @@ static Callback_t callback;
 
         accessors: draw_histogram_symbology
                      
-        modifiers: draw_video_frame
+        modifiers: finish_upload_imaging
                      
     */
 
@@ -220,7 +260,8 @@ static int Recalculate_histogram = 1;
 	
         range of values: 0, 1
 
-        accessors: toggle_histogram, draw_video_frame
+        accessors: toggle_histogram, start_upload_imaging,
+                   finish_upload_imaging
                      
         modifiers: toggle_histogram
                      
@@ -238,7 +279,7 @@ static int Draw_histogram = 0;
 	
         range of values: 0, 1
 
-        accessors: draw_video_frame
+        accessors: start_upload_imaging, finish_upload_imaging
                      
         modifiers: process_menu_selection
                      
@@ -251,7 +292,6 @@ static int Convolve_laplacian = 0;
 /* local prototypes  */
 void Key(unsigned char key, int mouse_x, int mouse_y);
 void Draw(void);
-void * capture_video_frame(Sourceparams_t * sourceparams, int * framesize);
 void draw_video_frame(Sourceparams_t * sourceparams,
 		      Displaydata_t * displaydata);
 void dump_histogram(char * label, GLint histogram[], int size);
@@ -267,12 +307,23 @@ void setup_menu(void);
 void process_menu_selection(int selection);
 void toggle_histogram(void);
 void timer_fuction(int ignored);
+void note_swap_latency(const Frameslot_t * slot);
+void show_next_source(void);
+void toggle_mosaic(void);
+void draw_tiled_window(void);
+void draw_video_tiles(Sourceset_t * sourceset, Displaydata_t * displaydata,
+		      const void * frames[]);
+void start_upload_imaging(void);
+void finish_upload_imaging(void);
+int wait_for_drawn_frame(int wait_usec);
 void cleanup();
 /* end local prototypes  */
 
 void cleanup()
 {
-	glDeleteBuffersARB(1, callback.displaydata->pboIds);
+	fini_pboring(&(callback.displaydata->pbos));
+	fini_pboring(&(callback.displaydata->u_pbos));
+	fini_pboring(&(callback.displaydata->v_pbos));
   if( callback.displaydata->texture )
     free(callback.displaydata->texture);
 }
@@ -318,7 +369,7 @@ void cleanup()
 
       accessed: callback
 
-      modified: none
+      modified: callback ('c', 'm')
 
    FUNCTIONS CALLED:
 
@@ -328,6 +379,10 @@ void cleanup()
 
       2-Jan-08               initial coding                           gpk
       7-Jan-09  added code to decrement brightness                    gpk
+     17-Oct-26  's' prints the stage latencies, 'r' clears them
+     17-Oct-26  'c' draws the next source
+     17-Oct-26  'm' toggles the mosaic
+     17-Oct-26  's' prints the PBO timing too
       
  ************************************************************************* */
 
@@ -337,7 +392,7 @@ void Key(unsigned char key, int mouse_x, int mouse_y)
   switch (key)
     {
     case 27: /* escape  */
-      end_capture_display(callback.sourceparams,
+      end_capture_display(callback.sourceset,
 			  callback.displaydata);
       exit(0);
       break;
@@ -348,6 +403,24 @@ void Key(unsigned char key, int mouse_x, int mouse_y)
 #endif
       break;
 
+    case 's': /* stage latencies so far  */
+      report_stage_stats(stderr);
+      report_pbo_timing(&(callback.displaydata->pbos), stderr);
+      report_pbo_timing(&(callback.displaydata->u_pbos), stderr);
+      report_pbo_timing(&(callback.displaydata->v_pbos), stderr);
+      break;
+
+    case 'r': /* start the stage latencies over  */
+      reset_stage_stats();
+      break;
+
+    case 'c': /* the next camera  */
+      show_next_source();
+      break;
+
+    case 'm': /* all the cameras at once, or one  */
+      toggle_mosaic();
+      break;
 
     case 32: /* space  */
       /* do nothing. it appears that glut's not acting on redraws  */
@@ -365,6 +438,11 @@ void Key(unsigned char key, int mouse_x, int mouse_y)
       fprintf(stderr, " in %s.\n", __FILE__);
       fprintf(stderr, "Known keys are:\n");
       fprintf(stderr, "\t Escape -- exit\n");
+      fprintf(stderr, "\t t -- toggle feature tracking\n");
+      fprintf(stderr, "\t s -- print per-stage latencies\n");
+      fprintf(stderr, "\t r -- reset per-stage latencies\n");
+      fprintf(stderr, "\t c -- draw the next source (camera)\n");
+      fprintf(stderr, "\t m -- draw every source at once, or one\n");
       break;
     }
 
@@ -388,6 +466,17 @@ void Key(unsigned char key, int mouse_x, int mouse_y)
                 the glut library calls this function when it
 		needs to draw the window.
 
+		take the newest frame from the capture ring (older
+		ones are stale: acquire_video_frame drops them), draw
+		it, and give its buffer back to the source.
+
+		after the swap, note how long it's been since the
+		frame was captured. the wait in the ring and the swap
+		go into the stage histograms too.
+
+		with several sources the textures are tiled: that's
+		draw_tiled_window's job.
+
 		works by side effect.
 
    REFERENCES:
@@ -407,6 +496,12 @@ void Key(unsigned char key, int mouse_x, int mouse_y)
         STR                  Description of Revision                 Author
 
       2-Jan-08               initial coding                           gpk
+     17-Oct-26  take frames from sourceparams->ring
+     17-Oct-26  note capture to swap latency
+     17-Oct-26  record ring wait and swap stage latencies
+     17-Oct-26  trace the draw
+     17-Oct-26  swap_display_buffers, so it works offscreen too
+     17-Oct-26  draw_tiled_window for several sources
 
  ************************************************************************* */
 
@@ -415,91 +510,34 @@ void Draw(void)
   /* static int i = 0; */
   /*  fprintf(stderr, "frame %d\n", i++); */
 	Sourceparams_t *sourceparams = callback.sourceparams;
-	struct list_head *list = sourceparams->bufList.next;
-	if( list != &(sourceparams->bufList) ) {	//not empty
-#ifndef  DEF_RGB
-		sourceparams->captured.start = ((Videobuffer_t *)(list))->start;
-#endif
-    draw_video_frame(sourceparams, callback.displaydata);
-		draw_symbology(sourceparams, callback.displaydata);
+	Frameslot_t slot;
+	long long swap_start, draw_start, start;
 
-		glutSwapBuffers(); /* swap the buffers to show what we just drew  */
+	if (1 < callback.displaydata->tiles) {
+		draw_tiled_window();
+		return;
 	}
-}
-
-
-
-
-/* ************************************************************************* 
-
-
-   NAME:  capture_video_frame
-
-
-   USAGE: 
-
-   void * data;
-   Sourceparams_t * sourceparams;
-   int nbytesp;
 
-   some_void =  capture_video_frame(sourceparams, &nbytesp);
-
-   if (NULL != some_void)
-   -- data is ready: draw the video
-   else
-   -- data not ready
-   
-   returns: void *
-
-   DESCRIPTION:
-                 capture a video frame frame, storing the data in
-		 sourceparams->captured and storing the number of
-		 bytes captured in nbytesp.
-
-		 
-   REFERENCES:
-
-   LIMITATIONS:
-
-   GLOBAL VARIABLES:
-
-      accessed: none
-
-      modified: none
-
-   FUNCTIONS CALLED:
-
-   REVISION HISTORY:
-
-        STR                  Description of Revision                 Author
-
-      2-Jan-08               initial coding                           gpk
-
- ************************************************************************* */
+	draw_start = trace_begin();
+	if( 0==acquire_video_frame(sourceparams, &slot) ) {
+		record_stage_usec(STAGE_RING_WAIT,
+				  monotonic_usec() - slot.published_usec);
+		sourceparams->captured.start = slot.start;
+		start = trace_begin();
+		draw_video_frame(sourceparams, callback.displaydata);
+		trace_end("draw_video_frame", start);
+		/* the pixels are in the texture now: the source can refill it  */
+		release_video_frame(sourceparams, &slot);
+		Recalculate_histogram = 1;
+		draw_symbology(sourceparams, callback.displaydata);
 
-void * capture_video_frame(Sourceparams_t * sourceparams, int * nbytesp)
-{
-  void * retval;
-  
-  switch (sourceparams->source)
-    {
-    case TESTPATTERN:
-      retval = next_testpattern_frame(sourceparams, nbytesp);
-      break;
-      
-    case LIVESOURCE:
-      retval = next_device_frame(sourceparams, nbytesp);
-      break;
-      
-    default:
-      fprintf(stderr, "Error: %s doesn't have a case for encoding %d\n",
-	      __FUNCTION__, sourceparams->encoding);
-      fprintf(stderr, "add one and recompile\n");
-      abort();
-      break;
-    }
-  return(retval);
-  
+		swap_start = monotonic_usec();
+		/* swap the buffers to show what we just drew  */
+		swap_display_buffers(callback.displaydata);
+		record_stage_since(STAGE_SWAP, swap_start);
+		note_swap_latency(&slot);
+	}
+	trace_end("Draw", draw_start);
 }
 
 
@@ -554,6 +592,9 @@ void * capture_video_frame(Sourceparams_t * sourceparams, int * nbytesp)
         STR                  Description of Revision                 Author
 
       2-Jan-08               initial coding                           gpk
+     17-Oct-26  RGB frames go through the PBO ring
+     17-Oct-26  so do LUMA, YUV422 and each YUV420 plane
+     17-Oct-26  start_upload_imaging, finish_upload_imaging
 
  ************************************************************************* */
 
@@ -565,13 +606,7 @@ void draw_video_frame(Sourceparams_t * sourceparams,
 {
 
 	GLubyte *ptr;
-	struct list_head *list = sourceparams->bufList.next;
-	Videobuffer_t *myBuf;
-	struct v4l2_buffer buf;
 
-  static GLfloat laplacian[3][3] = { {-1.0f, -1.0f, -1.0f},
-				   {-1.0f, 8.0f, -1.0f },
-				   {-1.0f, -1.0f, -1.0f }};
   /* assign v0 through v3 as the vertices of the polygon we'll put  */
   /* the video onto.                                                */
   glColor4f(1.0, 1.0, 1.0, 1.0);
@@ -604,85 +639,48 @@ void draw_video_frame(Sourceparams_t * sourceparams,
       v_texture = u_texture + chroma_size;
       glActiveTexture(GL_TEXTURE2);
       glEnable(GL_TEXTURE_2D);
-      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, chroma_width,
-		  chroma_height, (GLenum)displaydata->pixelformat,
-		  GL_UNSIGNED_BYTE, v_texture);
+      upload_through_pbo(&(displaydata->v_pbos), v_texture,
+			 (size_t)chroma_size, chroma_width, chroma_height,
+			 (GLenum)displaydata->pixelformat);
 
       glActiveTexture(GL_TEXTURE1);
       glEnable(GL_TEXTURE_2D);
-      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, chroma_width,
-		  chroma_height, (GLenum)displaydata->pixelformat,
-		  GL_UNSIGNED_BYTE, u_texture);
+      upload_through_pbo(&(displaydata->u_pbos), u_texture,
+			 (size_t)chroma_size, chroma_width, chroma_height,
+			 (GLenum)displaydata->pixelformat);
       
     }
 
-  if (0 != Convolve_laplacian)
-    {
-      glConvolutionFilter2D(GL_CONVOLUTION_2D,
-			    GL_LUMINANCE, 3, 3,
-			    GL_LUMINANCE, GL_FLOAT, laplacian);
-      check_error("before CONVOLUTION");
-      glEnable(GL_CONVOLUTION_2D);
-      check_error("after CONVOLUTION" );
-    }
-
-  if (0 != Draw_histogram)
-     {
-       glHistogram(GL_HISTOGRAM, HISTOGRAM_SIZE, GL_LUMINANCE, GL_FALSE);
-       glEnable(GL_HISTOGRAM);
-     }
+  start_upload_imaging();
 
-  list_del(list);
-	myBuf = (Videobuffer_t *)list;
 #ifdef DEF_RGB
   glBindTexture(GL_TEXTURE_2D, displaydata->texturename); 
-  glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, displaydata->pboIds);
-        // map the buffer object into client's memory
-        // Note that glMapBufferARB() causes sync issue.
-        // If GPU is working with this buffer, glMapBufferARB() will wait(stall)
-        // for GPU to finish its job. To avoid waiting (stall), you can call
-        // first glBufferDataARB() with NULL pointer before glMapBufferARB().
-        // If you do that, the previous data in PBO will be discarded and
-        // glMapBufferARB() returns a new allocated pointer immediately
-        // even if GPU is still working with the previous data.
-  ptr = (GLubyte*)glMapBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, GL_WRITE_ONLY_ARB);
+        // map the next PBO in the ring: the GPU may still be reading
+        // the last frame out of the one before, see pboring.c
+  ptr = (GLubyte*)map_pbo(&(displaydata->pbos));
   if(ptr) {
             // update data directly on the mapped buffer
-	 myBuf->prgb->imageData = (unsigned char *)ptr;
-  	 process(myBuf->start, myBuf->prgb);
-	 glUnmapBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB); // release pointer to mapping buffer
+	 sourceparams->prgb->imageData = (char *)ptr;
+  	 process((char *)sourceparams->captured.start, sourceparams->prgb);
+	 unmap_pbo(&(displaydata->pbos)); // release pointer to mapping buffer
    }
 
   // copy pixels from PBO to texture object
   glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, sourceparams->image_width, sourceparams->image_height, GL_RGB, GL_UNSIGNED_BYTE, 0);
-  glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+  finish_pbo_upload(&(displaydata->pbos));
 
 
 #else //DEF_RGB
   glActiveTexture(GL_TEXTURE0);
 
-  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, sourceparams->image_width,
-		  sourceparams->image_height, (GLenum)displaydata->pixelformat,
-		  GL_UNSIGNED_BYTE, sourceparams->captured.start);
+  upload_through_pbo(&(displaydata->pbos), sourceparams->captured.start,
+		     (size_t)sourceparams->image_width *
+		     sourceparams->image_height * displaydata->bytes_per_pixel,
+		     sourceparams->image_width, sourceparams->image_height,
+		     (GLenum)displaydata->pixelformat);
 #endif  //DEF_RGB
- 	memset(&buf, 0, sizeof(buf));
-	buf.index = myBuf - sourceparams->buffers;
-	buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-	buf.memory = V4L2_MEMORY_MMAP;
-	ioctl(sourceparams->fd, VIDIOC_QBUF, &buf);
   
-  if (0 != Draw_histogram)
-    {
-      glGetHistogram(GL_HISTOGRAM, GL_TRUE, GL_LUMINANCE, GL_INT, Histogram);
-      glDisable(GL_HISTOGRAM);
-      /* dump_histogram("collected histogram", Histogram, HISTOGRAM_SIZE); */ 
-    }
-
-  if (0 != Convolve_laplacian)
-    {      
-      glDisable(GL_CONVOLUTION_2D);
-      check_error("disabling GL_CONVOLUTION_2D");
-    }
+  finish_upload_imaging();
 
   /* now draw the video texture on the rectangle.  */
   
@@ -843,6 +841,9 @@ void dump_histogram(char * label, GLint histogram[], int size)
 
 		 right now that's the number of frames/second
 
+		 offscreen there's no glut to draw the text (or keep
+		 the time) with, and no one to read it: leave it out.
+
    REFERENCES:
 
    LIMITATIONS:
@@ -860,6 +861,7 @@ void dump_histogram(char * label, GLint histogram[], int size)
         STR                  Description of Revision                 Author
 
       6-Jan-08               initial coding                           gpk
+     17-Oct-26  no frame rate text offscreen
 
  ************************************************************************* */
 /* ARGSUSED: arguments not used for now  */
@@ -867,7 +869,10 @@ void draw_symbology(Sourceparams_t * sourceparams,
 		      Displaydata_t * displaydata)
 {
   shader_off();
-  draw_fps_symbology(sourceparams, displaydata);
+  if (0 == displaydata->offscreen)
+    {
+      draw_fps_symbology(sourceparams, displaydata);
+    }
 
   if (0 != Draw_histogram)
     {
@@ -927,6 +932,8 @@ void draw_symbology(Sourceparams_t * sourceparams,
 
      10-Jan-08               initial coding                           gpk
      26-Jan-08 check elapsed time to make sure we don't divide by 0   gpk
+     17-Oct-26  show frames the driver dropped
+     17-Oct-26  and the tracker's rate, when it's on
      
  ************************************************************************* */
 
@@ -956,7 +963,16 @@ void draw_fps_symbology(Sourceparams_t * sourceparams,
 			last_time = time;
 		}
 	}
-	sprintf(frameratestring, "FPS capture/display:  %0.3f/%0.3f\n", sourceparams->fps, frames_sec);
+	sprintf(frameratestring, "FPS capture/display:  %0.3f/%0.3f  dropped: %u\n",
+		sourceparams->fps, frames_sec, sourceparams->dropped_frames);
+#ifdef	DEF_RGB
+	if (g_toProcess) {
+		/* the tracker keeps its own pace (cvProcess.cpp)  */
+		sprintf(frameratestring, "FPS capture/display/track:  "
+			"%0.3f/%0.3f/%0.3f  dropped: %u\n", sourceparams->fps,
+			frames_sec, tracker_fps(), sourceparams->dropped_frames);
+	}
+#endif
 	glPushMatrix();
 	{
 		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
@@ -1219,11 +1235,21 @@ void calculate_histogram_data(GLint histogram[], int histogram_size)
    DESCRIPTION:
                  glut calls this function when it's idle.
 
-		 this function tries to capture the next frame of
-		 data (from the test pattern or live source).
+		 if there's no capture thread, this function tries to
+		 capture the next frame of data (from the test pattern
+		 or live source, or all of them if there's more than
+		 one) and publishes it to the frame ring for Draw.
+
+		 if there is a capture thread, sleep (up to
+		 IDLE_WAIT_USEC) until it publishes a frame.
+
+		 either way, ask for a redraw only when there's a new
+		 frame to draw, and give back the frames of the
+		 sources that aren't being drawn.
 
-		 if it succeeds call glutPostRedisplay, telling
-		 glut to redraw the window.
+		 it isn't used for PACE_TIMER when a capture thread is
+		 running, unless there are other sources to give
+		 frames back to.
 
 		 works by side effect
 
@@ -1244,26 +1270,39 @@ void calculate_histogram_data(GLint histogram[], int histogram_size)
         STR                  Description of Revision                 Author
 
       2-Jan-08               initial coding                           gpk
+     17-Oct-26  wait for the capture thread; redraw on new frames
+     17-Oct-26  poll and drain every source in the set
+     17-Oct-26  wait for any source in the mosaic
 
  ************************************************************************* */
 
 void Idle(void)
 {
-  int framesize;
-  void * nextframe;
+  int wait_usec;
 
-  nextframe = capture_video_frame(callback.sourceparams, &framesize);
-
-  if (NULL != nextframe)
+  if (0 == callback.sourceparams->threaded)
     {
-//      glutPostRedisplay();
-      Recalculate_histogram = 1;
+      if (0 < poll_capture_sources(callback.sourceset))
+	{
+	  Recalculate_histogram = 1;
+	}
+      wait_usec = 0; /* we just looked  */
     }
   else
     {
-//      glutPostRedisplay();
-      /* show that we're idle (no data available)  */
-      /* fprintf(stderr, "Idle"); */
+      wait_usec = IDLE_WAIT_USEC;
+    }
+
+  /* the sources we aren't drawing need their buffers back too  */
+  if (0 == callback.displaydata->mosaic)
+    {
+      drain_capture_sources(callback.sourceset, callback.sourceparams);
+    }
+
+  if ((PACE_TIMER != callback.displaydata->pacing)
+      && (0 < wait_for_drawn_frame(wait_usec)))
+    {
+      glutPostRedisplay();
     }
 }
 
@@ -1294,7 +1333,11 @@ void Idle(void)
 
 		 Key to handle keypresses
 		 Draw to handle drawing the window
-		 Idle to be called when the process is idle
+		 Idle to be called when the process is idle: it
+		 captures frames or waits for the capture thread, and
+		 asks for a redraw when one arrives
+		 timer_fuction to redraw every 33 msec instead, if
+		 displaydata->pacing is PACE_TIMER
 
 		 setup_menu sets up the menu attached to the
 		 right mouse button.
@@ -1324,6 +1367,8 @@ void Idle(void)
       2-Jan-08               initial coding                           gpk
      24-Jan-09  added timer_funtion to see if the window will         gpk
                 redisplay without user intervention...
+     17-Oct-26  no idle function when capture is threaded
+     17-Oct-26  only use the timer for PACE_TIMER
  ************************************************************************* */
 
 void setup_glut_window_callbacks(Displaydata_t * displaydata,
@@ -1335,9 +1380,17 @@ void setup_glut_window_callbacks(Displaydata_t * displaydata,
 
   glutKeyboardFunc(Key);
   glutDisplayFunc(Draw);
-  glutIdleFunc(Idle);
+  if ((0 == sourceparams->threaded) || (PACE_TIMER != displaydata->pacing))
+    {
+      /* with a capture thread feeding the ring and a timer doing the  */
+      /* redraws, the idle function would only burn CPU.  */
+      glutIdleFunc(Idle);
+    }
   setup_menu();
-  glutTimerFunc(10, timer_fuction, 0);
+  if (PACE_TIMER == displaydata->pacing)
+    {
+      glutTimerFunc(10, timer_fuction, 0);
+    }
 }
 
 
@@ -1369,15 +1422,19 @@ void setup_glut_window_callbacks(Displaydata_t * displaydata,
 		 recognize, it spits out a warning and tells you
 		 it's ignoring it.
 
+		 with several sources, the colour and shader
+		 processing choices are the chosen source's ('c'):
+		 each tile of the mosaic keeps its own.
+
    REFERENCES:
 
    LIMITATIONS:
 
    GLOBAL VARIABLES:
 
-      accessed: none
+      accessed: callback
 
-      modified: Convolve_laplacian
+      modified: Convolve_laplacian, callback.displaydata tiles
 
    FUNCTIONS CALLED:
 
@@ -1389,39 +1446,51 @@ void setup_glut_window_callbacks(Displaydata_t * displaydata,
       3-Jan-08           added color_output options                   gpk
       6-Jan-08 added image processing options passthru, laplacian     gpk
      10-Jan-08 added convolution laplacian option                     gpk
+     17-Oct-26 colour and processing per tile
      
  ************************************************************************* */
 
 void process_menu_selection(int selection)
 {
+  Displaydata_t * displaydata;
+  int tile;
+
+  displaydata = callback.displaydata;
+  tile = callback.sourceparams->id;
+
   switch (selection)
     {
     case MENU_EXIT:
-       end_capture_display(callback.sourceparams,
+       end_capture_display(callback.sourceset,
 			  callback.displaydata);
       exit(0);
       break;
 
     case MENU_DISPLAY_GREYSCALE:
       color_output(0);
+      displaydata->tile_color[tile] = 0;
       break;
 
     case MENU_DISPLAY_COLOR:
        color_output(1);
+      displaydata->tile_color[tile] = 1;
       break;
 
     case MENU_PASSTHRU_PROCESSING:
       image_processing_algorithm(0);
+      displaydata->tile_processing[tile] = 0;
       Convolve_laplacian = 0;
       break;
 
     case MENU_SHADER_LAPLACIAN:
       image_processing_algorithm(1);
+      displaydata->tile_processing[tile] = 1;
       Convolve_laplacian = 0;
       break;
 
     case MENU_CONVOLUTION_LAPLACIAN:
       image_processing_algorithm(0); /* turn off shader laplacian  */
+      displaydata->tile_processing[tile] = 0;
       Convolve_laplacian = 1;
       break;
 
@@ -1635,3 +1704,1016 @@ void timer_fuction(int ignored)
 		glutTimerFunc(33, timer_fuction, 0);
 	}
 }
+
+
+
+/* ************************************************************************* 
+
+
+   NAME:  note_swap_latency
+
+
+   USAGE: 
+
+   Frameslot_t slot;
+
+   glutSwapBuffers();
+   note_swap_latency(&slot);
+
+   returns: void
+
+   DESCRIPTION:
+                 add the time from slot's capture (the driver's
+		 timestamp if it gave one) to now, just after the
+		 swap, to the capture->swap stage histogram.
+		 report_stage_stats prints it at exit, and 's' at
+		 any time.
+
+		 this is a stand-in for glass to glass latency: it
+		 leaves out the sensor exposure before the driver's
+		 timestamp and the scanout after the swap.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   with vsync the swap may return before the frame is actually
+   shown, so this can read a little low.
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+     17-Oct-26  add it to the capture->swap stage histogram
+     17-Oct-26  just the histogram: no periodic print
+
+ ************************************************************************* */
+
+void note_swap_latency(const Frameslot_t * slot)
+{
+  record_stage_usec(STAGE_CAPTURE_TO_SWAP,
+		    monotonic_usec() - slot->capture_usec);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  setup_offscreen_callbacks
+
+
+   USAGE:
+
+   Displaydata_t * displaydata;
+   Sourceparams_t * sourceparams;
+
+   setup_offscreen_callbacks(displaydata, sourceparams);
+
+   returns: void
+
+   DESCRIPTION:
+                 store pointers to the displaydata and sourceparams
+		 structures for Draw, the way
+		 setup_glut_window_callbacks does, without glut: there
+		 are no keys, menu or idle function offscreen, just
+		 draw_offscreen_frames.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: callback
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void setup_offscreen_callbacks(Displaydata_t * displaydata,
+			       Sourceparams_t * sourceparams)
+{
+  callback.displaydata = displaydata;
+  callback.sourceparams = sourceparams;
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  draw_offscreen_frames
+
+
+   USAGE:
+
+   int drawn;
+
+   setup_offscreen_callbacks(displaydata, sourceset->sources[0]);
+   set_callback_sources(sourceset);
+   start_capture_sources(sourceset);
+   drawn =  draw_offscreen_frames(nframes);
+
+   returns: int
+
+   DESCRIPTION:
+                 glut's main loop, offscreen: do what Idle does
+		 (capture a frame, or wait for the capture thread to
+		 publish one; keep the other sources drained) and
+		 Draw each new frame, until nframes have been drawn.
+
+		 in the mosaic each draw takes whatever frames the
+		 sources have: a frame here is a redraw.
+
+		 then print how long that took: frames per second,
+		 the average time in Draw (upload, shader, drawing
+		 and waiting for the GL to finish: the frame rate the
+		 GL side could keep up) and the CPU used, which on a
+		 software rasterizer includes the rendering.
+
+		 return the number of frames drawn
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   frames come at the source's rate, so the frame rate here is the
+   slower of the source and the GL side. the draw time is the GL
+   side's alone.
+
+   GLOBAL VARIABLES:
+
+      accessed: callback
+
+      modified: Recalculate_histogram
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+     17-Oct-26  poll and drain every source in the set
+     17-Oct-26  the mosaic; say how many sources
+
+ ************************************************************************* */
+
+int draw_offscreen_frames(int nframes)
+{
+  Sourceparams_t * sourceparams;
+  long long start_usec, draw_start_usec, draw_total_usec, draw_max_usec;
+  long long draw_usec;
+  double start_cpu, cpu_seconds, wall_seconds;
+  int drawn, wait_usec;
+
+  sourceparams = callback.sourceparams;
+  drawn = 0;
+  draw_total_usec = 0;
+  draw_max_usec = 0;
+  start_cpu = rusage_seconds();
+  start_usec = monotonic_usec();
+
+  while (drawn < nframes)
+    {
+      if (0 == sourceparams->threaded)
+	{
+	  if (0 < poll_capture_sources(callback.sourceset))
+	    {
+	      Recalculate_histogram = 1;
+	    }
+	  wait_usec = 0; /* we just looked  */
+	}
+      else
+	{
+	  wait_usec = IDLE_WAIT_USEC;
+	}
+      if (0 == callback.displaydata->mosaic)
+	{
+	  drain_capture_sources(callback.sourceset, sourceparams);
+	}
+
+      if (0 < wait_for_drawn_frame(wait_usec))
+	{
+	  draw_start_usec = monotonic_usec();
+	  Draw();
+	  draw_usec = monotonic_usec() - draw_start_usec;
+	  draw_total_usec += draw_usec;
+	  if (draw_usec > draw_max_usec)
+	    {
+	      draw_max_usec = draw_usec;
+	    }
+	  drawn++;
+	}
+    }
+
+  wall_seconds = (double)(monotonic_usec() - start_usec) / 1e6;
+  cpu_seconds = rusage_seconds() - start_cpu;
+
+  fprintf(stderr, "offscreen: %d frames %dx%d in %.2f sec (%.2f fps)\n",
+	  drawn, callback.displaydata->window_width,
+	  callback.displaydata->window_height, wall_seconds,
+	  drawn / wall_seconds);
+  if (1 < callback.displaydata->tiles)
+    {
+      fprintf(stderr, "  %d sources, %s\n", callback.displaydata->tiles,
+	      (0 != callback.displaydata->mosaic) ? "all tiled (mosaic)"
+	      : "one drawn");
+    }
+  fprintf(stderr, "  draw avg %.3f msec max %.3f msec (%.1f fps of GL)\n",
+	  draw_total_usec / 1000.0 / drawn, draw_max_usec / 1000.0,
+	  (0 < draw_total_usec) ? drawn * 1e6 / draw_total_usec : 0.0);
+  fprintf(stderr, "  cpu %.2f sec (%.1f%% of one core)\n",
+	  cpu_seconds, 100.0 * cpu_seconds / wall_seconds);
+
+  return(drawn);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  set_callback_sources
+
+
+   USAGE:
+
+   Sourceset_t * sourceset;
+
+   setup_glut_window_callbacks(displaydata, sourceset->sources[0]);
+   set_callback_sources(sourceset);
+
+   returns: void
+
+   DESCRIPTION:
+                 store the set of sources the one being drawn belongs
+		 to. Idle (or draw_offscreen_frames) polls all of them
+		 when nothing else captures them, and gives back the
+		 frames of the ones not being drawn; 'c' switches to
+		 the next one.
+
+		 with more than one source in a window, Idle is
+		 needed even for PACE_TIMER with capture threads, to
+		 do the giving back.
+
+		 works by side effect
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   the sources all have to have the drawn one's size and encoding:
+   they're drawn with the same textures and shader.
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: callback
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void set_callback_sources(Sourceset_t * sourceset)
+{
+  callback.sourceset = sourceset;
+
+  if ((1 < sourceset->nsources) && (0 == callback.displaydata->offscreen))
+    {
+      glutIdleFunc(Idle);
+    }
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  show_next_source
+
+
+   USAGE:
+
+   show_next_source();
+
+   returns: void
+
+   DESCRIPTION:
+                 draw the next source in the set from now on (after
+		 the last, the first again). its frames start going
+		 to Draw and the one that was drawn gets drained like
+		 the rest.
+
+		 the tracker starts over: the old frame's features
+		 mean nothing in another camera's picture.
+
+		 in the mosaic they're all drawn anyway: this picks
+		 the tile the menu's colour and processing apply to.
+
+		 works by side effect
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: callback
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+     17-Oct-26  in the mosaic, the tile the menu applies to
+
+ ************************************************************************* */
+
+void show_next_source(void)
+{
+  Sourceset_t * sourceset;
+  int next;
+
+  sourceset = callback.sourceset;
+  next = (callback.sourceparams->id + 1) % sourceset->nsources;
+  callback.sourceparams = sourceset->sources[next];
+#ifdef	DEF_RGB
+  resetH();
+#endif
+  fprintf(stderr, "%s source %d of %d\n",
+	  (0 != callback.displaydata->mosaic) ? "menu applies to" : "drawing",
+	  next + 1, sourceset->nsources);
+}
+
+
+
+
+/* *************************************************************************
+
+
+   NAME:  toggle_mosaic
+
+
+   USAGE:
+
+   toggle_mosaic();
+
+   returns: void
+
+   DESCRIPTION:
+                 switch between drawing every source at once, tiled
+		 (the mosaic), and drawing just the chosen one ('c').
+		 with only one source there's nothing to tile: say so.
+
+		 leaving the mosaic, give back the frames the sync
+		 stage is holding: nothing will match them up now.
+
+		 works by side effect
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: callback
+
+      modified: callback.displaydata->mosaic
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+     17-Oct-26  flush the sync stage
+
+ ************************************************************************* */
+
+void toggle_mosaic(void)
+{
+  Displaydata_t * displaydata;
+
+  displaydata = callback.displaydata;
+
+  if (2 > displaydata->tiles)
+    {
+      fprintf(stderr, "Warning: one source: no mosaic to draw\n");
+    }
+  else
+    {
+      displaydata->mosaic = (0 == displaydata->mosaic);
+      if (0 == displaydata->mosaic)
+	{
+	  flush_framesync(callback.sourceset);
+	}
+      fprintf(stderr, "drawing %s\n", (0 != displaydata->mosaic) ?
+	      "every source" : "one source");
+    }
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  draw_tiled_window
+
+
+   USAGE:
+
+   if (1 < callback.displaydata->tiles)
+     {
+       draw_tiled_window();
+     }
+
+   returns: void
+
+   DESCRIPTION:
+                 Draw, for several sources: take the newest frame of
+		 each source being drawn (all of them in the mosaic,
+		 or the chosen one), upload and draw them with
+		 draw_video_tiles, give the buffers back and swap.
+
+		 a source with no new frame keeps the picture it had
+		 in its tile: the frames don't wait for each other.
+		 unless there's a sync window (-Y): then the mosaic
+		 draws only sets of frames captured together
+		 (acquire_synced_frames), or nothing new at all.
+
+		 the ring wait and capture to swap latency of each
+		 frame go into the stage histograms.
+
+		 works by side effect
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: callback
+
+      modified: Recalculate_histogram
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+     17-Oct-26  synced sets of frames
+
+ ************************************************************************* */
+
+void draw_tiled_window(void)
+{
+  Sourceset_t * sourceset;
+  Frameslot_t slots[MAX_SOURCES];
+  const void * frames[MAX_SOURCES];
+  long long swap_start, draw_start, start;
+  int i, nframes, synced, got;
+
+  sourceset = callback.sourceset;
+  draw_start = trace_begin();
+
+  synced = ((0 != callback.displaydata->mosaic)
+	    && (0 != sourceset->sync.window_usec)
+	    && (0 == acquire_synced_frames(sourceset, slots)));
+
+  nframes = 0;
+  for (i = 0; i < MAX_SOURCES; i++)
+    {
+      frames[i] = NULL;
+      if (i >= sourceset->nsources)
+	{
+	  continue;
+	}
+
+      if (0 != synced)
+	{
+	  got = 1;
+	}
+      else if (0 != callback.displaydata->mosaic)
+	{
+	  /* with a sync window, the frames wait for a set  */
+	  got = ((0 == sourceset->sync.window_usec)
+		 && (0 == acquire_video_frame(sourceset->sources[i],
+					      &(slots[i]))));
+	}
+      else
+	{
+	  got = ((callback.sourceparams == sourceset->sources[i])
+		 && (0 == acquire_video_frame(sourceset->sources[i],
+					      &(slots[i]))));
+	}
+
+      if (0 != got)
+	{
+	  record_stage_usec(STAGE_RING_WAIT,
+			    monotonic_usec() - slots[i].published_usec);
+	  frames[i] = slots[i].start;
+	  nframes++;
+	}
+    }
+
+  if (0 < nframes)
+    {
+      start = trace_begin();
+      draw_video_tiles(sourceset, callback.displaydata, frames);
+      trace_end("draw_video_tiles", start);
+
+      /* the pixels are in the textures now: the sources can refill them  */
+      for (i = 0; i < sourceset->nsources; i++)
+	{
+	  if (NULL != frames[i])
+	    {
+	      release_video_frame(sourceset->sources[i], &(slots[i]));
+	    }
+	}
+      Recalculate_histogram = 1;
+      draw_symbology(callback.sourceparams, callback.displaydata);
+
+      swap_start = monotonic_usec();
+      swap_display_buffers(callback.displaydata);
+      record_stage_since(STAGE_SWAP, swap_start);
+      for (i = 0; i < sourceset->nsources; i++)
+	{
+	  if (NULL != frames[i])
+	    {
+	      note_swap_latency(&(slots[i]));
+	    }
+	}
+    }
+
+  trace_end("Draw", draw_start);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  draw_video_tiles
+
+
+   USAGE:
+
+   Sourceset_t * sourceset;
+   Displaydata_t * displaydata;
+   const void * frames[MAX_SOURCES];  -- NULL: no new frame
+
+   draw_video_tiles(sourceset, displaydata, frames);
+
+   returns: void
+
+   DESCRIPTION:
+                 draw_video_frame for several sources. each source
+		 has a tile of the textures (see setup_texture in
+		 display.c): tile i is rows i * texture_height on.
+
+		 upload: the new frames of all the sources go through
+		 one PBO map per plane (upload_tiles_through_pbo),
+		 each into its own tile.
+
+		 draw: a quad per tile, into a grid of cells in the
+		 window (the mosaic) or one quad filling it (just
+		 the chosen source), all in one glDrawArrays. each
+		 quad is the one draw_video_frame would draw, scaled
+		 into its cell, with texture coordinates moved to its
+		 tile. its color_output and image_processing ride in
+		 the secondary color so the shader does each tile
+		 its own way (per_tile_processing, shader.c).
+
+		 the tracker (process, cvProcess.cpp) follows only the
+		 chosen source, callback.sourceparams, and draws over
+		 its tile; the other tiles are just converted.
+
+		 works by side effect
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   the sources all have the same size and encoding (glutcam.c checks).
+   the shader laplacian reads a texel past the edge of a tile from
+   the next tile. the convolution laplacian and the histogram are for
+   all the tiles uploaded together.
+
+   GLOBAL VARIABLES:
+
+      accessed: callback
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+     17-Oct-26  track the chosen source only
+
+ ************************************************************************* */
+
+void draw_video_tiles(Sourceset_t * sourceset, Displaydata_t * displaydata,
+		      const void * frames[])
+{
+  GLfloat vertices[MAX_SOURCES * 4 * 3];
+  GLfloat texcoords[MAX_SOURCES * 4 * 2];
+  GLfloat flags[MAX_SOURCES * 4 * 3];
+  GLfloat * corners[4];
+  float * texcorners[4];
+  Sourceparams_t * sourceparams;
+  int i, j, k, first, last, cols, rows, col, row, ntiles, nquads;
+  int width, height, units;
+#ifdef	DEF_RGB
+  GLubyte * ptr;
+  size_t tile_bytes;
+#endif
+
+  sourceparams = sourceset->sources[0];
+  width = sourceparams->image_width;
+  height = sourceparams->image_height;
+  ntiles = displaydata->tiles;
+
+  glColor4f(1.0, 1.0, 1.0, 1.0);
+
+  check_error("before subtexture");
+
+  if (YUV420 == sourceparams->encoding)
+    {
+      const void * u_planes[MAX_SOURCES];
+      const void * v_planes[MAX_SOURCES];
+      int luma_size, chroma_size;
+
+      luma_size = width * height;
+      chroma_size = (width / 2) * (height / 2);
+      for (i = 0; i < ntiles; i++)
+	{
+	  u_planes[i] = NULL;
+	  v_planes[i] = NULL;
+	  if (NULL != frames[i])
+	    {
+	      u_planes[i] = (const char *)frames[i] + luma_size;
+	      v_planes[i] = (const char *)frames[i] + luma_size + chroma_size;
+	    }
+	}
+      glActiveTexture(GL_TEXTURE2);
+      glEnable(GL_TEXTURE_2D);
+      upload_tiles_through_pbo(&(displaydata->v_pbos), v_planes, ntiles,
+			       (size_t)chroma_size, width / 2, height / 2,
+			       displaydata->texture_height / 2,
+			       (GLenum)displaydata->pixelformat);
+
+      glActiveTexture(GL_TEXTURE1);
+      glEnable(GL_TEXTURE_2D);
+      upload_tiles_through_pbo(&(displaydata->u_pbos), u_planes, ntiles,
+			       (size_t)chroma_size, width / 2, height / 2,
+			       displaydata->texture_height / 2,
+			       (GLenum)displaydata->pixelformat);
+    }
+
+  start_upload_imaging();
+
+#ifdef DEF_RGB
+  glBindTexture(GL_TEXTURE_2D, displaydata->texturename);
+  tile_bytes = (size_t)width * height * 3;
+  ptr = (GLubyte *)map_pbo(&(displaydata->pbos));
+  if (NULL != ptr)
+    {
+      /* convert each new frame straight into its part of the PBO.  */
+      /* the tracker follows the chosen source only  */
+      for (i = 0; i < ntiles; i++)
+	{
+	  if (NULL != frames[i])
+	    {
+	      sourceset->sources[i]->prgb->imageData =
+		(char *)ptr + i * tile_bytes;
+	      if (callback.sourceparams == sourceset->sources[i])
+		{
+		  process((char *)frames[i], sourceset->sources[i]->prgb);
+		}
+	      else
+		{
+		  convert_frame((char *)frames[i], sourceset->sources[i]->prgb);
+		}
+	    }
+	}
+      unmap_pbo(&(displaydata->pbos));
+      for (i = 0; i < ntiles; i++)
+	{
+	  if (NULL != frames[i])
+	    {
+	      glTexSubImage2D(GL_TEXTURE_2D, 0, 0,
+			      i * displaydata->texture_height, width, height,
+			      GL_RGB, GL_UNSIGNED_BYTE,
+			      (const GLvoid *)(i * tile_bytes));
+	    }
+	}
+    }
+  finish_pbo_upload(&(displaydata->pbos));
+#else //DEF_RGB
+  glActiveTexture(GL_TEXTURE0);
+  upload_tiles_through_pbo(&(displaydata->pbos), frames, ntiles,
+			   (size_t)width * height *
+			   displaydata->bytes_per_pixel, width, height,
+			   displaydata->texture_height,
+			   (GLenum)displaydata->pixelformat);
+#endif  //DEF_RGB
+
+  finish_upload_imaging();
+
+  check_error("after subtexture");
+
+  /* lay out the quads: draw_video_frame's corners, scaled into a  */
+  /* cell of a cols x rows grid, row 0 at the top  */
+
+  if (0 != displaydata->mosaic)
+    {
+      first = 0;
+      last = ntiles - 1;
+      cols = 1;
+      while (cols * cols < ntiles)
+	{
+	  cols++; /* smallest square grid that holds them  */
+	}
+      rows = (ntiles + cols - 1) / cols;
+    }
+  else
+    {
+      first = callback.sourceparams->id;
+      last = first;
+      cols = 1;
+      rows = 1;
+    }
+
+  corners[0] = displaydata->v0;
+  corners[1] = displaydata->v1;
+  corners[2] = displaydata->v2;
+  corners[3] = displaydata->v3;
+  texcorners[0] = displaydata->t0;
+  texcorners[1] = displaydata->t1;
+  texcorners[2] = displaydata->t2;
+  texcorners[3] = displaydata->t3;
+
+  nquads = 0;
+  for (i = first; i <= last; i++)
+    {
+      col = (0 != displaydata->mosaic) ? (i % cols) : 0;
+      row = (0 != displaydata->mosaic) ? (i / cols) : 0;
+      for (j = 0; j < 4; j++)
+	{
+	  k = nquads * 4 + j;
+	  vertices[3 * k] = -1.0 + (corners[j][0] + 1.0 + 2.0 * col) / cols;
+	  vertices[3 * k + 1] = 1.0 - (1.0 - corners[j][1] + 2.0 * row) / rows;
+	  vertices[3 * k + 2] = corners[j][2];
+	  texcoords[2 * k] = texcorners[j][0];
+	  texcoords[2 * k + 1] = (i + texcorners[j][1]) / ntiles;
+	  flags[3 * k] = (GLfloat)displaydata->tile_color[i];
+	  flags[3 * k + 1] = (GLfloat)displaydata->tile_processing[i];
+	  flags[3 * k + 2] = 0.0;
+	}
+      nquads++;
+    }
+
+  /* YUV420 uses the same coordinates on all three texture units  */
+  units = (YUV420 == sourceparams->encoding) ? 3 : 1;
+
+  glPushMatrix();
+  glEnable(GL_TEXTURE_2D);
+  glClear(GL_COLOR_BUFFER_BIT);
+
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glVertexPointer(3, GL_FLOAT, 0, vertices);
+  glEnableClientState(GL_SECONDARY_COLOR_ARRAY);
+  glSecondaryColorPointer(3, GL_FLOAT, 0, flags);
+  for (j = 0; j < units; j++)
+    {
+      glClientActiveTexture(GL_TEXTURE0 + j);
+      glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+      glTexCoordPointer(2, GL_FLOAT, 0, texcoords);
+    }
+
+  glDrawArrays(GL_QUADS, 0, 4 * nquads);
+
+  for (j = units - 1; j >= 0; j--)
+    {
+      glClientActiveTexture(GL_TEXTURE0 + j);
+      glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    }
+  glDisableClientState(GL_SECONDARY_COLOR_ARRAY);
+  glDisableClientState(GL_VERTEX_ARRAY);
+
+  glDisable(GL_TEXTURE_2D);
+  glPopMatrix();
+  check_error("after draw_video_tiles");
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  start_upload_imaging
+
+
+   USAGE:
+
+   start_upload_imaging();
+   -- glTexSubImage2D the frame
+   finish_upload_imaging();
+
+   returns: void
+
+   DESCRIPTION:
+                 turn on the OpenGL imaging that works on pixels as
+		 they're uploaded: the convolution laplacian (menu)
+		 and the histogram, if they're wanted.
+
+		 finish_upload_imaging collects the histogram and
+		 turns them off again.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: Convolve_laplacian, Draw_histogram
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26  moved out of draw_video_frame
+
+ ************************************************************************* */
+
+void start_upload_imaging(void)
+{
+  static GLfloat laplacian[3][3] = { {-1.0f, -1.0f, -1.0f},
+				   {-1.0f, 8.0f, -1.0f },
+				   {-1.0f, -1.0f, -1.0f }};
+
+  if (0 != Convolve_laplacian)
+    {
+      glConvolutionFilter2D(GL_CONVOLUTION_2D,
+			    GL_LUMINANCE, 3, 3,
+			    GL_LUMINANCE, GL_FLOAT, laplacian);
+      check_error("before CONVOLUTION");
+      glEnable(GL_CONVOLUTION_2D);
+      check_error("after CONVOLUTION" );
+    }
+
+  if (0 != Draw_histogram)
+     {
+       glHistogram(GL_HISTOGRAM, HISTOGRAM_SIZE, GL_LUMINANCE, GL_FALSE);
+       glEnable(GL_HISTOGRAM);
+     }
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  finish_upload_imaging
+
+
+   USAGE:
+
+   start_upload_imaging();
+   -- glTexSubImage2D the frame
+   finish_upload_imaging();
+
+   returns: void
+
+   DESCRIPTION:
+                 after the upload: get the histogram of the pixels
+		 uploaded, if it was wanted, and turn off what
+		 start_upload_imaging turned on.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: Convolve_laplacian, Draw_histogram
+
+      modified: Histogram
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26  moved out of draw_video_frame
+
+ ************************************************************************* */
+
+void finish_upload_imaging(void)
+{
+  if (0 != Draw_histogram)
+    {
+      glGetHistogram(GL_HISTOGRAM, GL_TRUE, GL_LUMINANCE, GL_INT, Histogram);
+      glDisable(GL_HISTOGRAM);
+      /* dump_histogram("collected histogram", Histogram, HISTOGRAM_SIZE); */ 
+    }
+
+  if (0 != Convolve_laplacian)
+    {      
+      glDisable(GL_CONVOLUTION_2D);
+      check_error("disabling GL_CONVOLUTION_2D");
+    }
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  wait_for_drawn_frame
+
+
+   USAGE:
+
+   if (0 < wait_for_drawn_frame(wait_usec))
+   -- Draw has something new to draw
+
+   returns: int
+
+   DESCRIPTION:
+                 wait up to wait_usec for a new frame from the source
+		 being drawn, or in the mosaic from any of them.
+
+		 return > 0 if one came, 0 if not, -1 on error
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: callback
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int wait_for_drawn_frame(int wait_usec)
+{
+  if ((0 != callback.displaydata->mosaic) && (NULL != callback.sourceset))
+    {
+      return(wait_for_published_frames(callback.sourceset, wait_usec));
+    }
+
+  return(wait_for_published_frame(callback.sourceparams, wait_usec));
+}
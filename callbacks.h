@@ -22,6 +22,8 @@
 *   STR                Description                          Author
 *
 *    7-Jan-07          initial coding                        gpk
+*   17-Oct-26          setup_offscreen_callbacks, draw_offscreen_frames
+*   17-Oct-26          set_callback_sources
 *
 * TARGET:  C
 *
@@ -38,6 +40,10 @@ extern "C" {
 #endif	//__cplusplus
 void setup_glut_window_callbacks(Displaydata_t * displaydata,
 				       Sourceparams_t * sourceparams);
+void setup_offscreen_callbacks(Displaydata_t * displaydata,
+			       Sourceparams_t * sourceparams);
+void set_callback_sources(Sourceset_t * sourceset);
+int draw_offscreen_frames(int nframes);
 void cleanup();
 #ifdef	__cplusplus
 }
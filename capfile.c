@@ -0,0 +1,647 @@
+/* *************************************************************************
+* NAME: glutcam/capfile.c
+*
+* DESCRIPTION:
+*
+* play back a raw capture file as a video source (FILESOURCE), so a
+* tracking problem seen on a camera can be reproduced, and the
+* pipeline benchmarked, on the same frames every time.
+*
+* the file (see Capfileheader_t and Capfileindex_t in glutcam.h) is a
+* header, the frames' raw pixels, and an index giving each frame's
+* offset, length and capture time. we map the whole file read only
+* and publish pointers into it: no copies, and the page cache keeps
+* a file that fits in memory there from one run to the next.
+*
+* frames come out either at their recorded times (relative to the
+* first frame), or, with -F, one at a time as fast as the display
+* takes them: the next is published only when the last has been
+* released, so every frame is drawn once and in order. at the end of
+* the file playback starts over.
+*
+* PROCESS:
+*
+* see capfile.h
+*
+* GLOBALS: none
+*
+* REFERENCES: mmap(2), madvise(2)
+*
+* LIMITATIONS:
+*
+* the file has to fit in the address space (not a problem on 64 bit).
+*
+* files are read in the byte order they were written in.
+*
+* REVISION HISTORY:
+*
+*   STR                Description                          Author
+*
+*   17-Oct-26          initial coding
+*
+* TARGET: Linux C
+*
+* This software is in the public domain. if it breaks you get to keep
+* both pieces.
+*
+* ************************************************************************* */
+
+#include <stdio.h>
+#include <string.h> /* memcmp  */
+#include <fcntl.h> /* open  */
+#include <unistd.h> /* close  */
+#include <sys/mman.h> /* mmap, madvise  */
+#include <sys/stat.h> /* fstat  */
+
+#include "glutcam.h"
+#include "capture.h" /* publish_video_frame  */
+#include "testpattern.h" /* compute_bytes_per_frame  */
+#include "timeutil.h" /* monotonic_usec  */
+#include "capfile.h"
+
+/* CAPFILE_POLL_USEC - with fast playback, how long the capture  */
+/* thread sleeps between looks at whether the last frame's back  */
+/* CAPFILE_DEFAULT_FRAME_USEC - the frame interval to assume for a  */
+/* file with only one frame  */
+
+#define CAPFILE_POLL_USEC 200
+#define CAPFILE_DEFAULT_FRAME_USEC (1000000LL / 30)
+
+/* local prototypes  */
+int check_capture_file(const char * filename, const void * map,
+		       size_t maplength, int * frame_bytes);
+/* end local prototypes  */
+
+
+
+/* *************************************************************************
+
+
+   NAME:  init_capture_file
+
+
+   USAGE:
+
+   int some_int;
+   Cmdargs_t argstruct;
+   Sourceparams_t sourceparams;
+
+   some_int =  parse_command_line(argc, argv, &argstruct);
+   ...
+   some_int =  init_capture_file(argstruct, &sourceparams);
+
+   if (0 == some_int)
+   -- we're fine
+   else
+   -- fatal error and a warning has been printed
+
+   returns: int
+
+   DESCRIPTION:
+                 map argstruct.capture_file, check it, and set up
+		 sourceparams to play it back: source FILESOURCE,
+		 the image size and encoding the file was recorded
+		 with (the command line's -w, -h and -e don't apply),
+		 and sourceparams->capfile.
+
+		 captured.start points at the first frame until
+		 playback starts.
+
+		 return 0 on success
+		       -1 (and say why) on error
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   the RGB display converts YUYV (see process() in cvProcess.cpp),
+   so it only plays back YUV422 files.
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int init_capture_file(Cmdargs_t argstruct, Sourceparams_t * sourceparams)
+{
+  const Capfileheader_t * header;
+  Capfile_t * capfile;
+  struct stat filestat;
+  void * map;
+  int fd, frame_bytes;
+  long long span_usec;
+
+  fd = open(argstruct.capture_file, O_RDONLY | O_CLOEXEC);
+  if (-1 == fd)
+    {
+      perror(argstruct.capture_file);
+      return(-1);
+    }
+
+  if ((-1 == fstat(fd, &filestat))
+      || ((off_t)sizeof(Capfileheader_t) > filestat.st_size))
+    {
+      fprintf(stderr, "Error: %s is too short to be a capture file\n",
+	      argstruct.capture_file);
+      close(fd);
+      return(-1);
+    }
+
+  map = mmap(NULL, (size_t)filestat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd); /* the mapping keeps the file  */
+  if (MAP_FAILED == map)
+    {
+      perror("Error mapping the capture file");
+      return(-1);
+    }
+
+  if (-1 == check_capture_file(argstruct.capture_file, map,
+			       (size_t)filestat.st_size, &frame_bytes))
+    {
+      munmap(map, (size_t)filestat.st_size);
+      return(-1);
+    }
+
+  /* we read it front to back: ask for a generous readahead  */
+  (void)madvise(map, (size_t)filestat.st_size, MADV_SEQUENTIAL);
+
+  header = (const Capfileheader_t *)map;
+  capfile = &(sourceparams->capfile);
+  capfile->map = map;
+  capfile->maplength = (size_t)filestat.st_size;
+  capfile->index = (const Capfileindex_t *)((const char *)map +
+					    header->index_offset);
+  capfile->nframes = header->nframes;
+  capfile->current_frame = 0;
+  capfile->fast = argstruct.playback_fast;
+  capfile->outstanding = 0;
+  capfile->frames_played = 0;
+  capfile->passes = 0;
+
+  capfile->frame_usec = CAPFILE_DEFAULT_FRAME_USEC;
+  span_usec = capfile->index[capfile->nframes - 1].timestamp_usec -
+    capfile->index[0].timestamp_usec;
+  if ((1 < capfile->nframes) && (0 < span_usec))
+    {
+      capfile->frame_usec = span_usec / (capfile->nframes - 1);
+    }
+
+  sourceparams->source = FILESOURCE;
+  sourceparams->fd = -1; /* no device is the source of this  */
+#ifdef	DEF_RGB
+  sourceparams->encoding = argstruct.encoding;
+#else
+  sourceparams->encoding = (Encodingmethod_t)header->encoding;
+#endif
+  sourceparams->image_width = (int)header->width;
+  sourceparams->image_height = (int)header->height;
+  sourceparams->iomethod = IO_METHOD_USERPTR; /* access by following pointer */
+  sourceparams->buffercount = (int)header->nframes;
+  sourceparams->captured.start = (char *)map + capfile->index[0].offset;
+  sourceparams->captured.length = frame_bytes;
+
+  if ((argstruct.image_width != sourceparams->image_width)
+      || (argstruct.image_height != sourceparams->image_height))
+    {
+      fprintf(stderr, "Warning: %s was recorded at %dx%d: using that\n",
+	      argstruct.capture_file, sourceparams->image_width,
+	      sourceparams->image_height);
+    }
+
+  fprintf(stderr, "playing back %s: %u frames %dx%d, %.2f fps recorded%s\n",
+	  argstruct.capture_file, capfile->nframes, sourceparams->image_width,
+	  sourceparams->image_height, 1e6 / capfile->frame_usec,
+	  (0 != capfile->fast) ? ", played as fast as possible" : "");
+
+  return(0);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  check_capture_file
+
+
+   USAGE:
+
+   int status, frame_bytes;
+
+   status =  check_capture_file(filename, map, maplength, &frame_bytes);
+
+   returns: int
+
+   DESCRIPTION:
+                 check that the maplength bytes at map are a capture
+		 file we can play: the magic number and version, an
+		 image size and encoding we know, an index that's in
+		 the file, and every frame in the file and big enough
+		 for the image. store the bytes in an image in
+		 frame_bytes.
+
+		 return 0 if it's good
+		       -1 (and say what's wrong with filename) if not
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int check_capture_file(const char * filename, const void * map,
+		       size_t maplength, int * frame_bytes)
+{
+  const Capfileheader_t * header;
+  const Capfileindex_t * index;
+  unsigned int frame;
+
+  header = (const Capfileheader_t *)map;
+
+  if ((0 != memcmp(header->magic, CAPFILE_MAGIC, sizeof(header->magic)))
+      || (CAPFILE_VERSION != header->version)
+      || (sizeof(Capfileheader_t) > header->header_bytes))
+    {
+      fprintf(stderr, "Error: %s isn't a version %d capture file\n",
+	      filename, CAPFILE_VERSION);
+      return(-1);
+    }
+
+  switch (header->encoding)
+    {
+    case LUMA:
+    case YUV420:
+    case YUV422:
+    case RGB:
+      break;
+
+    default:
+      fprintf(stderr, "Error: %s has unknown encoding %u\n", filename,
+	      header->encoding);
+      return(-1);
+    }
+
+#ifdef	DEF_RGB
+  if (YUV422 != header->encoding)
+    {
+      fprintf(stderr, "Error: the RGB display only plays back YUV422 files\n");
+      return(-1);
+    }
+#endif
+
+  if ((0 == header->width) || (0 == header->height)
+      || (16384 < header->width) || (16384 < header->height))
+    {
+      fprintf(stderr, "Error: %s has a %ux%u image\n", filename,
+	      header->width, header->height);
+      return(-1);
+    }
+  *frame_bytes = compute_bytes_per_frame((int)header->width,
+					 (int)header->height,
+					 (Encodingmethod_t)header->encoding);
+
+  if ((0 == header->nframes)
+      || (0 != (header->index_offset % sizeof(uint64_t)))
+      || (header->index_offset > maplength)
+      || ((maplength - header->index_offset) / sizeof(Capfileindex_t)
+	  < header->nframes))
+    {
+      fprintf(stderr, "Error: %s has no frames, or its index is cut off\n",
+	      filename);
+      return(-1);
+    }
+
+  index = (const Capfileindex_t *)((const char *)map + header->index_offset);
+  for (frame = 0; frame < header->nframes; frame++)
+    {
+      if ((index[frame].length < (uint32_t)*frame_bytes)
+	  || (index[frame].offset > maplength)
+	  || (maplength - index[frame].offset < index[frame].length))
+	{
+	  fprintf(stderr, "Error: frame %u of %s is cut off\n", frame,
+		  filename);
+	  return(-1);
+	}
+    }
+
+  return(0);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  start_capture_file
+
+
+   USAGE:
+
+   int some_int;
+   Sourceparams_t * sourceparams;
+
+   some_int =  start_capture_file(sourceparams);
+
+   returns: int
+
+   DESCRIPTION:
+                 start playback at the first frame, which is due
+		 right away.
+
+		 return 0
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int start_capture_file(Sourceparams_t * sourceparams)
+{
+  Capfile_t * capfile;
+
+  capfile = &(sourceparams->capfile);
+  capfile->current_frame = 0;
+  capfile->outstanding = 0;
+  capfile->frames_played = 0;
+  capfile->passes = 0;
+  capfile->start_usec = monotonic_usec();
+  capfile->next_frame_usec = capfile->start_usec;
+
+  return(0);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  stop_capture_file
+
+
+   USAGE:
+
+   Sourceparams_t * sourceparams;
+
+   stop_capture_file(sourceparams);
+
+   returns: void
+
+   DESCRIPTION:
+                 say how much of the file was played, and unmap it.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   stop the capture thread first, and don't draw sourceparams'
+   frames after this.
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void stop_capture_file(Sourceparams_t * sourceparams)
+{
+  Capfile_t * capfile;
+
+  capfile = &(sourceparams->capfile);
+  if (NULL == capfile->map)
+    {
+      return;
+    }
+
+  fprintf(stderr, "played %u frames: %u times through the file and %u"
+	  " frames more\n", capfile->frames_played, capfile->passes,
+	  capfile->current_frame);
+
+  munmap(capfile->map, capfile->maplength);
+  capfile->map = NULL;
+  capfile->index = NULL;
+  sourceparams->captured.start = NULL;
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  next_capture_file_frame
+
+
+   USAGE:
+
+   void * image;
+   Sourceparams_t * sourceparams;
+   int nbytes;
+
+   image =  next_capture_file_frame(sourceparams, &nbytes);
+
+   returns: void *
+
+   DESCRIPTION:
+                 if the next frame is due, publish it to
+		 sourceparams->ring, pointing into the mapped file,
+		 and work out when the one after is due.
+
+		 recorded pacing: frame i is due its recorded time
+		 after frame 0 of this pass. if we've fallen behind,
+		 the next frame is due now, not in a burst to catch
+		 up. each pass starts a frame interval after the last
+		 one ended.
+
+		 fast pacing: a frame is due as soon as the one before
+		 it has been released.
+
+		 put the frame's bytes into nbytesp and return a
+		 pointer to it, or NULL if it isn't due yet.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   call from one thread (the capture thread, if there is one)
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+     17-Oct-26  pass on the recorded sequence number
+
+ ************************************************************************* */
+
+void * next_capture_file_frame(Sourceparams_t * sourceparams, int * nbytesp)
+{
+  Capfile_t * capfile;
+  const Capfileindex_t * entry;
+  long long now_usec;
+  Frameslot_t slot;
+
+  capfile = &(sourceparams->capfile);
+  now_usec = monotonic_usec();
+  *nbytesp = 0;
+
+  if (0 != capfile->fast)
+    {
+      if (0 < __atomic_load_n(&(capfile->outstanding), __ATOMIC_ACQUIRE))
+	{
+	  capfile->next_frame_usec = now_usec + CAPFILE_POLL_USEC;
+	  return(NULL); /* the display still has the last one  */
+	}
+    }
+  else if (now_usec < capfile->next_frame_usec)
+    {
+      return(NULL); /* not time yet  */
+    }
+
+  entry = &(capfile->index[capfile->current_frame]);
+  slot.index = (int)capfile->current_frame;
+  slot.start = (char *)capfile->map + entry->offset;
+  slot.length = entry->length;
+  slot.capture_usec = now_usec;
+  slot.sequence = entry->sequence;
+
+  capfile->current_frame++;
+  capfile->frames_played++;
+  if (capfile->nframes == capfile->current_frame)
+    {
+      capfile->current_frame = 0;
+      capfile->passes++;
+      capfile->start_usec = now_usec + capfile->frame_usec;
+    }
+
+  if (0 != capfile->fast)
+    {
+      capfile->next_frame_usec = now_usec;
+    }
+  else
+    {
+      capfile->next_frame_usec = capfile->start_usec +
+	(capfile->index[capfile->current_frame].timestamp_usec -
+	 capfile->index[0].timestamp_usec);
+      if (capfile->next_frame_usec < now_usec)
+	{
+	  /* we fell behind; don't try to catch up with a burst  */
+	  capfile->start_usec += now_usec - capfile->next_frame_usec;
+	  capfile->next_frame_usec = now_usec;
+	}
+    }
+
+  /* count it before publishing: the display may release it  */
+  /* before publish_video_frame returns  */
+  __atomic_fetch_add(&(capfile->outstanding), 1, __ATOMIC_RELAXED);
+  (void)publish_video_frame(sourceparams, &slot);
+
+  *nbytesp = (int)slot.length;
+  return(slot.start);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  release_capture_file_frame
+
+
+   USAGE:
+
+   Sourceparams_t * sourceparams;
+   Frameslot_t slot;
+
+   release_capture_file_frame(sourceparams, &slot);
+
+   returns: void
+
+   DESCRIPTION:
+                 the display is done with slot: with fast playback,
+		 that lets the next frame go.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void release_capture_file_frame(Sourceparams_t * sourceparams,
+				Frameslot_t * slot)
+{
+  (void)slot;
+
+  __atomic_fetch_sub(&(sourceparams->capfile.outstanding), 1,
+		     __ATOMIC_RELEASE);
+}
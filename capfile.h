@@ -0,0 +1,60 @@
+/* *************************************************************************
+* NAME: glutcam/capfile.h
+*
+* DESCRIPTION:
+*
+* this is the header file for the functions exported from capfile.c
+*
+* PROCESS:
+*
+* init_capture_file maps a raw capture file and points sourceparams
+*   at it (source FILESOURCE), the way init_test_pattern does
+*
+* start_capture_file / stop_capture_file start and end playback
+*
+* next_capture_file_frame publishes the next frame to sourceparams->ring
+*   when it's due, and release_capture_file_frame is told when the
+*   display is done with it
+*
+* GLOBALS: none
+*
+* REFERENCES:
+*
+* LIMITATIONS:
+*
+* REVISION HISTORY:
+*
+*   STR                Description                          Author
+*
+*   17-Oct-26          initial coding
+*
+* TARGET: Linux C
+*
+* This software is in the public domain. if it breaks you get to keep
+* both pieces.
+*
+* ************************************************************************* */
+
+#ifndef	__CAPFILE_H__
+#define	__CAPFILE_H__
+
+#include "glutcam.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+extern int init_capture_file(Cmdargs_t argstruct,
+			     Sourceparams_t * sourceparams);
+extern int start_capture_file(Sourceparams_t * sourceparams);
+extern void stop_capture_file(Sourceparams_t * sourceparams);
+extern void * next_capture_file_frame(Sourceparams_t * sourceparams,
+				      int * nbytesp);
+extern void release_capture_file_frame(Sourceparams_t * sourceparams,
+				       Frameslot_t * slot);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	//__CAPFILE_H__
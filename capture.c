@@ -0,0 +1,1451 @@
+/* *************************************************************************
+* NAME: glutcam/capture.c
+*
+* DESCRIPTION:
+*
+* this code moves frames from the image source (test pattern or V4L2
+* device) to the display.
+*
+* frames travel through sourceparams->ring, a lock-free single-producer
+* single-consumer queue (see framering.c). the producer is either
+*
+* * the GLUT idle function, which polls the source (the original way:
+*   it keeps one core busy polling), or
+*
+* * a dedicated capture thread that sleeps in select() on the V4L2
+*   file descriptor (or until the next test pattern frame is due) and
+*   publishes each frame as it arrives.
+*
+* the consumer is always the thread that draws (Draw in callbacks.c or
+* run_headless_capture here). it gives each frame back to the source
+* with release_video_frame when it's done with the data.
+*
+* PROCESS:
+*
+* see capture.h
+*
+* GLOBALS: none
+*
+* REFERENCES:
+*
+* LIMITATIONS:
+*
+* REVISION HISTORY:
+*
+*   STR                Description                          Author
+*
+*   17-Oct-26          initial coding; start_capture_source,
+*                      stop_capture_source moved here from
+*                      display.c, capture_video_frame from
+*                      callbacks.c
+*   17-Oct-26          share device buffers through dmabuf.c
+*   17-Oct-26          wake the display through an eventfd
+*   17-Oct-26          per-stage latency histograms
+*   17-Oct-26          name the capture trace track, finish the trace
+*   17-Oct-26          export rusage_seconds
+*   17-Oct-26          play back capture files (FILESOURCE)
+*   17-Oct-26          record frames to disk (recorder.c)
+*   17-Oct-26          publish frames on the frame bus (framebus.c)
+*   17-Oct-26          finish_capture_source; headless runs take a
+*                      Sourceset_t (multicapture.c)
+*   17-Oct-26          headless runs can take matched sets of frames
+*                      (framesync.c)
+*   17-Oct-26          hold buffers dmabuf clients are reading
+*   17-Oct-26          requeue released buffers in every capture mode
+*
+* TARGET: Linux C, pthreads
+*
+* This software is in the public domain. if it breaks you get to keep
+* both pieces.
+*
+* ************************************************************************* */
+
+#include <stdio.h>
+#include <stdlib.h> /* abort  */
+#include <string.h> /* memset  */
+#include <pthread.h>
+#include <sys/time.h> /* getrusage  */
+#include <sys/resource.h> /* getrusage  */
+#include <stdint.h> /* uint64_t  */
+#include <sys/eventfd.h> /* eventfd  */
+#include <poll.h> /* poll  */
+#include <unistd.h> /* read, write, close  */
+
+#include "glutcam.h"
+#include "capabilities.h"
+#include "testpattern.h" /* start_testpattern, next_testpattern_frame  */
+#include "capfile.h" /* start_capture_file, next_capture_file_frame, ...  */
+#include "device.h" /* start_capture_device, next_device_frame, ...  */
+#include "cvProcess.h" /* init_process, fini_process  */
+#include "dmabuf.h" /* start_dmabuf_server, serve_dmabuf_frame, ...  */
+#include "recorder.h" /* start_recorder, record_video_frame, ...  */
+#include "framebus.h" /* start_framebus, publish_framebus_frame, ...  */
+#include "multicapture.h" /* start_capture_sources, poll_capture_sources  */
+#include "framesync.h" /* acquire_synced_frames  */
+#include "framering.h"
+#include "timeutil.h"
+#include "stagestats.h"
+#include "trace.h" /* trace_thread_name, stop_trace  */
+#include "capture.h"
+
+/* CAPTURE_WAIT_USEC - how long the capture thread waits in select  */
+/* for a frame before checking whether it's been asked to stop.  */
+/* must be under a second (it goes into a struct timeval tv_usec).  */
+
+#define CAPTURE_WAIT_USEC 100000
+
+/* FPS_INTERVAL_USEC - how often sourceparams->fps is recomputed  */
+
+#define FPS_INTERVAL_USEC 5000000LL
+
+/* HEADLESS_DISPLAY_USEC - how often the headless consumer takes a  */
+/* frame. this matches the 33 msec redisplay timer in callbacks.c  */
+/* so the numbers are comparable to the windowed program.  */
+
+#define HEADLESS_DISPLAY_USEC 33333LL
+
+/* local prototypes  */
+int start_capture_thread(Sourceparams_t * sourceparams);
+void stop_capture_thread(Sourceparams_t * sourceparams);
+void * capture_thread_main(void * arg);
+void update_capture_fps(Sourceparams_t * sourceparams, long long now_usec);
+/* end local prototypes  */
+
+
+
+/* *************************************************************************
+
+
+   NAME:  start_capture_source
+
+
+   USAGE:
+
+   int some_int;
+   Sourceparams_t * sourceparams;
+
+   some_int =  start_capture_source(sourceparams);
+
+   if (0 == some_int)
+   -- we're okay
+   else
+   -- handle an error
+
+   returns: int
+
+   DESCRIPTION:
+                 start the capture source (test pattern or
+		 V4L2 device).
+
+		 in the case of a test pattern, this doesn't mean much
+		 in the case of a physical device this tells it to
+		 start producing data.
+
+		 if sourceparams->threaded is set, also start the
+		 capture thread that feeds sourceparams->ring, unless
+		 sourceparams->epoll_capture says a Sourceset_t's
+		 epoll thread is going to do it (multicapture.c).
+
+		 sourceparams->frame_event_fd is set up so the display
+		 can sleep until a frame is published
+		 (wait_for_published_frame).
+
+		 if the device's buffers were exported as dmabuf,
+		 start sharing them; if that doesn't work we just
+		 don't share.
+
+		 if sourceparams->recorder.path is set, start
+		 recording to it (see recorder.c).
+
+		 if sourceparams->framebus.path is set, publish
+		 frames on a frame bus there (see framebus.c); if
+		 that doesn't work we carry on without.
+
+		 if this function doesn't recognize the source,
+		 it will print an error message and abort so
+		 you can add the case statement.
+
+		 return 0 if all's well
+		       -1 on error starting the source
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+      4-Jan-08               initial coding                           gpk
+     17-Oct-26  moved from display.c; set up the frame ring,
+                start the capture thread
+     17-Oct-26  start the dmabuf server
+     17-Oct-26  reset the dropped frame count
+     17-Oct-26  create frame_event_fd
+     17-Oct-26  FILESOURCE
+     17-Oct-26  start the recorder
+     17-Oct-26  start the frame bus
+     17-Oct-26  no thread of its own for epoll_capture
+
+ ************************************************************************* */
+
+int start_capture_source(Sourceparams_t * sourceparams)
+{
+  int retval;
+
+  init_framering(&(sourceparams->ring));
+  sourceparams->have_sequence = 0;
+  sourceparams->dropped_frames = 0;
+  sourceparams->fps_frames = 0;
+  sourceparams->fps_start_usec = 0;
+
+  sourceparams->frame_event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (-1 == sourceparams->frame_event_fd)
+    {
+      perror("Error creating frame event");
+      return(-1);
+    }
+
+  if (0 == init_process(sourceparams))
+    {
+      fprintf(stderr, "Error: unable to set up frame processing\n");
+      return(-1);
+    }
+
+  switch (sourceparams->source)
+    {
+    case TESTPATTERN:
+      retval = start_testpattern(sourceparams);
+      break;
+
+    case FILESOURCE:
+      retval = start_capture_file(sourceparams);
+      break;
+
+    case LIVESOURCE:
+      retval = start_capture_device(sourceparams);
+      if ((0 == retval) && (0 < sourceparams->dmabuf.nfds))
+	{
+	  (void)start_dmabuf_server(sourceparams);
+	}
+      break;
+
+    default:
+      fprintf(stderr, "Error: %s doesn't have a case for source %d\n",
+	      __FUNCTION__, sourceparams->source);
+      fprintf(stderr, "add one and recompile\n");
+      abort();
+      break;
+    }
+
+  if ((0 == retval) && ('\0' != sourceparams->recorder.path[0]))
+    {
+      retval = start_recorder(sourceparams);
+    }
+
+  if ((0 == retval) && ('\0' != sourceparams->framebus.path[0]))
+    {
+      (void)start_framebus(sourceparams);
+    }
+
+  if ((0 == retval) && (0 != sourceparams->threaded)
+      && (0 == sourceparams->epoll_capture))
+    {
+      retval = start_capture_thread(sourceparams);
+    }
+
+  return(retval);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  stop_capture_source
+
+
+   USAGE:
+
+   int some_int;
+   Sourceparams_t * sourceparams;
+
+   some_int =  stop_capture_source(sourceparams);
+
+   if (0 == some_int)
+   -- we're okay
+   else
+   -- handle an error
+
+   returns: int
+
+   DESCRIPTION:
+                 stop the capture thread (if there is one), then the
+		 capture source, finish the recording and close the
+		 frame bus if there are any, print the per-stage latencies
+		 (see stagestats.c) for the run and finish the trace
+		 if there is one.
+
+		 in the case of a test pattern, this doesn't mean much
+		 in the case of a physical device this tells it to
+		 stop producing data.
+
+		 if this function doesn't recognize the source,
+		 it will print an error message and abort so
+		 you can add the case statement.
+
+		 return 0 if all's well
+		       -1 on error stopping the source
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+      4-Jan-08               initial coding                           gpk
+      3-Feb-08 added retval from testpattern as well                  gpk
+     17-Oct-26  moved from display.c; stop the capture thread first
+     17-Oct-26  stop the dmabuf server
+     17-Oct-26  close frame_event_fd
+     17-Oct-26  print the stage latencies
+     17-Oct-26  finish the trace
+     17-Oct-26  FILESOURCE
+     17-Oct-26  stop the recorder
+     17-Oct-26  close the frame bus
+     17-Oct-26  the source itself is stopped by finish_capture_source
+
+ ************************************************************************* */
+
+int stop_capture_source(Sourceparams_t * sourceparams)
+{
+  int retval;
+
+  retval = finish_capture_source(sourceparams);
+
+  report_stage_stats(stderr);
+  stop_trace();
+
+  return(retval);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  finish_capture_source
+
+
+   USAGE:
+
+   int some_int;
+   Sourceparams_t * sourceparams;
+
+   some_int =  finish_capture_source(sourceparams);
+
+   returns: int
+
+   DESCRIPTION:
+                 stop_capture_source without the stage latency report
+		 or the end of the trace: stop the capture thread (if
+		 there is one), the source, its recording and frame
+		 bus. stop_capture_sources (multicapture.c) calls it
+		 for each source, then reports once for all of them.
+
+		 return 0 if all's well
+		       -1 on error stopping the source
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26  taken from stop_capture_source
+
+ ************************************************************************* */
+
+int finish_capture_source(Sourceparams_t * sourceparams)
+{
+  int retval;
+
+  stop_capture_thread(sourceparams);
+
+  switch (sourceparams->source)
+    {
+    case TESTPATTERN:
+      /* there is no "stop test pattern"  */
+      retval = 0; /* this is to make the optimizer happy  */
+      break;
+
+    case FILESOURCE:
+      stop_capture_file(sourceparams);
+      retval = 0;
+      break;
+
+    case LIVESOURCE:
+       retval = stop_capture_device(sourceparams);
+       stop_dmabuf_server(sourceparams);
+      break;
+
+    default:
+      fprintf(stderr, "Error: %s doesn't have a case for source %d\n",
+	      __FUNCTION__, sourceparams->source);
+      fprintf(stderr, "add one and recompile\n");
+      retval = 0; /* this is to make the optimizer happy  */
+      abort();
+      break;
+    }
+
+  fini_process(sourceparams);
+  stop_recorder(sourceparams);
+  stop_framebus(sourceparams);
+
+  close(sourceparams->frame_event_fd);
+  sourceparams->frame_event_fd = -1;
+
+  return(retval);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  capture_video_frame
+
+
+   USAGE:
+
+   void * data;
+   Sourceparams_t * sourceparams;
+   int nbytesp;
+
+   some_void =  capture_video_frame(sourceparams, &nbytesp);
+
+   if (NULL != some_void)
+   -- data is ready: draw the video
+   else
+   -- data not ready
+
+   returns: void *
+
+   DESCRIPTION:
+                 capture whatever video frames are ready and publish
+		 them to sourceparams->ring. return the last one and
+		 store the number of bytes captured in nbytesp.
+
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+      2-Jan-08               initial coding                           gpk
+     17-Oct-26  moved here from callbacks.c
+     17-Oct-26  FILESOURCE
+     17-Oct-26  requeue buffers dmabuf clients released
+
+ ************************************************************************* */
+
+void * capture_video_frame(Sourceparams_t * sourceparams, int * nbytesp)
+{
+  void * retval;
+
+  switch (sourceparams->source)
+    {
+    case TESTPATTERN:
+      retval = next_testpattern_frame(sourceparams, nbytesp);
+      break;
+
+    case FILESOURCE:
+      retval = next_capture_file_frame(sourceparams, nbytesp);
+      break;
+
+    case LIVESOURCE:
+      requeue_released_buffers(sourceparams);
+      retval = next_device_frame(sourceparams, nbytesp);
+      break;
+
+    default:
+      fprintf(stderr, "Error: %s doesn't have a case for source %d\n",
+	      __FUNCTION__, sourceparams->source);
+      fprintf(stderr, "add one and recompile\n");
+      abort();
+      break;
+    }
+  return(retval);
+
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  publish_video_frame
+
+
+   USAGE:
+
+   int some_int;
+   Sourceparams_t * sourceparams;
+   Frameslot_t slot;
+
+   slot.index = ...; slot.start = ...; slot.length = ...;
+   some_int =  publish_video_frame(sourceparams, &slot);
+
+   returns: int
+
+   DESCRIPTION:
+                 timestamp the frame in slot and put it in
+		 sourceparams->ring for the display side. count it
+		 toward the capture frame rate in sourceparams->fps.
+
+		 if the device's buffers are shared, tell the other
+		 processes about the frame first. if we're recording,
+		 the recorder gets a copy, and so does the frame bus
+		 if there is one.
+
+		 bump sourceparams->frame_event_fd so a display
+		 waiting in wait_for_published_frame wakes up.
+
+		 if the display has fallen so far behind that the ring
+		 is full, give the frame straight back to the source.
+
+		 return 0 if the frame was published
+		       -1 if it was dropped
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   call this only from the producer (idle function or capture thread)
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+     17-Oct-26  announce the frame to dmabuf clients
+     17-Oct-26  signal frame_event_fd
+     17-Oct-26  record the dequeue stage latency
+     17-Oct-26  copy the frame for the recorder
+     17-Oct-26  and the frame bus
+
+ ************************************************************************* */
+
+int publish_video_frame(Sourceparams_t * sourceparams, Frameslot_t * slot)
+{
+  int retval;
+
+  uint64_t one;
+
+  slot->published_usec = monotonic_usec();
+  if (0 == slot->capture_usec)
+    {
+      slot->capture_usec = slot->published_usec;
+    }
+  record_stage_usec(STAGE_DEQUEUE, slot->published_usec - slot->capture_usec);
+  update_capture_fps(sourceparams, slot->published_usec);
+  serve_dmabuf_frame(sourceparams, slot);
+  record_video_frame(sourceparams, slot);
+  publish_framebus_frame(sourceparams, slot);
+
+  retval = framering_push(&(sourceparams->ring), slot);
+
+  if (-1 == retval)
+    {
+      release_video_frame(sourceparams, slot);
+    }
+  else
+    {
+      /* the counter only overflows if nobody reads it for 2^64  */
+      /* frames, so this write never blocks  */
+      one = 1;
+      (void)write(sourceparams->frame_event_fd, &one, sizeof(one));
+    }
+
+  return(retval);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  acquire_video_frame
+
+
+   USAGE:
+
+   Sourceparams_t * sourceparams;
+   Frameslot_t slot;
+
+   if (0 == acquire_video_frame(sourceparams, &slot))
+   {
+     -- use slot.start, slot.length
+     release_video_frame(sourceparams, &slot);
+   }
+
+   returns: int
+
+   DESCRIPTION:
+                 take the newest captured frame out of sourceparams->ring.
+		 anything older is stale by now: hand those frames
+		 straight back to the source without drawing them.
+
+		 return 0 if there was one
+		       -1 if no frame is waiting
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   call this only from the consumer (the drawing thread)
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int acquire_video_frame(Sourceparams_t * sourceparams, Frameslot_t * slot)
+{
+  Frameslot_t newer;
+
+  if (-1 == framering_pop(&(sourceparams->ring), slot))
+    {
+      return(-1);
+    }
+
+  while (0 == framering_pop(&(sourceparams->ring), &newer))
+    {
+      release_video_frame(sourceparams, slot);
+      *slot = newer;
+    }
+
+  return(0);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  release_video_frame
+
+
+   USAGE:
+
+   Sourceparams_t * sourceparams;
+   Frameslot_t slot;
+
+   release_video_frame(sourceparams, &slot);
+
+   returns: void
+
+   DESCRIPTION:
+                 give the buffer behind slot back to the source so it
+		 can be filled again. for a device that means queueing
+		 it back up with the driver, once any dmabuf client
+		 reading it is done too; test pattern frames never
+		 change so there's nothing to do. a capture file
+		 being played as fast as possible can send the next
+		 frame.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+     17-Oct-26  FILESOURCE
+     17-Oct-26  wait for dmabuf clients
+
+ ************************************************************************* */
+
+void release_video_frame(Sourceparams_t * sourceparams, Frameslot_t * slot)
+{
+  switch (sourceparams->source)
+    {
+    case TESTPATTERN:
+      break;
+
+    case FILESOURCE:
+      release_capture_file_frame(sourceparams, slot);
+      break;
+
+    case LIVESOURCE:
+      if (0 == defer_dmabuf_release(sourceparams, slot->index))
+	{
+	  (void)requeue_device_buffer(sourceparams, slot->index);
+	}
+      break;
+
+    default:
+      fprintf(stderr, "Error: %s doesn't have a case for source %d\n",
+	      __FUNCTION__, sourceparams->source);
+      fprintf(stderr, "add one and recompile\n");
+      abort();
+      break;
+    }
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  requeue_released_buffers
+
+
+   USAGE:
+
+   Sourceparams_t * sourceparams;
+
+   requeue_released_buffers(sourceparams);
+
+   returns: void
+
+   DESCRIPTION:
+                 give the driver back the buffers release_video_frame
+		 held for dmabuf clients that have since let go of
+		 them (collect_dmabuf_releases).
+
+		 whatever dequeues the device's frames calls this
+		 before it looks for the next one: the capture thread,
+		 capture_video_frame when the display polls, and the
+		 epoll capture thread. without it each client would
+		 get one frame and its buffer would be lost to the
+		 driver.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   call this only from the producer (idle function or capture thread)
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26  taken from capture_thread_main
+
+ ************************************************************************* */
+
+void requeue_released_buffers(Sourceparams_t * sourceparams)
+{
+  int freed[MAX_VIDEO_BUFFERS];
+  int nfreed, i;
+
+  nfreed = collect_dmabuf_releases(sourceparams, freed, MAX_VIDEO_BUFFERS);
+  for (i = 0; i < nfreed; i++)
+    {
+      (void)requeue_device_buffer(sourceparams, freed[i]);
+    }
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  wait_for_published_frame
+
+
+   USAGE:
+
+   Sourceparams_t * sourceparams;
+
+   if (0 < wait_for_published_frame(sourceparams, 5000))
+   -- acquire_video_frame will find one
+
+   returns: int
+
+   DESCRIPTION:
+                 sleep until the capture side publishes a frame or
+		 useconds go by. frames published since the last call
+		 count too, so a frame can't slip in unnoticed between
+		 drawing and waiting.
+
+		 return 1 if frames were published
+		        0 on timeout
+		       -1 on error
+
+   REFERENCES: eventfd(2)
+
+   LIMITATIONS:
+
+   call this only from the consumer (the drawing thread)
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int wait_for_published_frame(Sourceparams_t * sourceparams, int useconds)
+{
+  struct pollfd pollfd;
+  uint64_t count;
+  int status;
+
+  pollfd.fd = sourceparams->frame_event_fd;
+  pollfd.events = POLLIN;
+  pollfd.revents = 0;
+
+  status = poll(&pollfd, 1, (useconds + 999) / 1000);
+
+  if (-1 == status)
+    {
+      perror("Error waiting for a frame");
+      return(-1);
+    }
+
+  if (0 == status)
+    {
+      return(0);
+    }
+
+  /* reading resets the count  */
+  if ((ssize_t)sizeof(count) != read(sourceparams->frame_event_fd, &count,
+				      sizeof(count)))
+    {
+      return(0);
+    }
+
+  return(1);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  start_capture_thread
+
+
+   USAGE:
+
+   int some_int;
+   Sourceparams_t * sourceparams;
+
+   some_int =  start_capture_thread(sourceparams);
+
+   returns: int
+
+   DESCRIPTION:
+                 start a thread that runs capture_thread_main,
+		 publishing frames into sourceparams->ring.
+
+		 return 0 if all's well
+		       -1 if the thread couldn't be created
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int start_capture_thread(Sourceparams_t * sourceparams)
+{
+  int status, retval;
+
+  __atomic_store_n(&(sourceparams->capture_running), 1, __ATOMIC_RELEASE);
+
+  status = pthread_create(&(sourceparams->capture_thread), NULL,
+			  capture_thread_main, sourceparams);
+
+  if (0 != status)
+    {
+      fprintf(stderr, "Error: unable to start capture thread (%d)\n", status);
+      sourceparams->capture_running = 0;
+      retval = -1;
+    }
+  else
+    {
+      retval = 0;
+    }
+
+  return(retval);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  stop_capture_thread
+
+
+   USAGE:
+
+   Sourceparams_t * sourceparams;
+
+   stop_capture_thread(sourceparams);
+
+   returns: void
+
+   DESCRIPTION:
+                 ask the capture thread to stop and wait for it.
+		 it notices within CAPTURE_WAIT_USEC.
+		 does nothing if the thread isn't running.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void stop_capture_thread(Sourceparams_t * sourceparams)
+{
+  if (0 != __atomic_exchange_n(&(sourceparams->capture_running), 0,
+			       __ATOMIC_ACQ_REL))
+    {
+      pthread_join(sourceparams->capture_thread, NULL);
+    }
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  capture_thread_main
+
+
+   USAGE:
+
+   pthread_create(&thread, NULL, capture_thread_main, sourceparams);
+
+   returns: void *
+
+   DESCRIPTION:
+                 the body of the capture thread.
+
+		 for a device, block in select() until the driver has a
+		 filled buffer, then dequeue everything that's ready
+		 into the ring.
+
+		 for a test pattern, sleep until the next frame is due
+		 and publish it.
+
+		 loop until sourceparams->capture_running is cleared.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+     17-Oct-26  name the trace track
+     17-Oct-26  FILESOURCE
+     17-Oct-26  one track per source
+     17-Oct-26  requeue buffers dmabuf clients released
+
+ ************************************************************************* */
+
+void * capture_thread_main(void * arg)
+{
+  Sourceparams_t * sourceparams;
+  char name[TRACE_NAME_LENGTH];
+  int nbytes, ready;
+
+  sourceparams = (Sourceparams_t *)arg;
+  if (0 == sourceparams->id)
+    {
+      trace_thread_name("capture");
+    }
+  else
+    {
+      snprintf(name, sizeof(name), "capture %d", sourceparams->id);
+      trace_thread_name(name);
+    }
+
+  while (0 != __atomic_load_n(&(sourceparams->capture_running),
+			      __ATOMIC_ACQUIRE))
+    {
+      switch (sourceparams->source)
+	{
+	case TESTPATTERN:
+	  sleep_until_usec(sourceparams->testpattern.next_frame_usec);
+	  (void)next_testpattern_frame(sourceparams, &nbytes);
+	  break;
+
+	case FILESOURCE:
+	  sleep_until_usec(sourceparams->capfile.next_frame_usec);
+	  (void)next_capture_file_frame(sourceparams, &nbytes);
+	  break;
+
+	case LIVESOURCE:
+	  /* after the wait, so a client done with its frame meanwhile  */
+	  /* is sent the one that woke us  */
+	  ready = wait_for_device_frame(sourceparams, CAPTURE_WAIT_USEC);
+	  requeue_released_buffers(sourceparams);
+	  if (0 < ready)
+	    {
+	      (void)next_device_frame(sourceparams, &nbytes);
+	    }
+	  break;
+
+	default:
+	  fprintf(stderr, "Error: %s doesn't have a case for source %d\n",
+		  __FUNCTION__, sourceparams->source);
+	  fprintf(stderr, "add one and recompile\n");
+	  abort();
+	  break;
+	}
+    }
+
+  return(NULL);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  update_capture_fps
+
+
+   USAGE:
+
+   Sourceparams_t * sourceparams;
+
+   update_capture_fps(sourceparams, monotonic_usec());
+
+   returns: void
+
+   DESCRIPTION:
+                 count one captured frame. every FPS_INTERVAL_USEC
+		 recompute sourceparams->fps from the frames counted
+		 since the last update.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26  taken from the counters in next_device_frame
+
+ ************************************************************************* */
+
+void update_capture_fps(Sourceparams_t * sourceparams, long long now_usec)
+{
+  long long elapsed_usec;
+
+  if (0 == sourceparams->fps_start_usec)
+    {
+      sourceparams->fps_start_usec = now_usec;
+      sourceparams->fps_frames = 0;
+    }
+  else
+    {
+      sourceparams->fps_frames++;
+      elapsed_usec = now_usec - sourceparams->fps_start_usec;
+
+      if (FPS_INTERVAL_USEC <= elapsed_usec)
+	{
+	  sourceparams->fps = (float)sourceparams->fps_frames * 1000000.0f /
+	    (float)elapsed_usec;
+	  sourceparams->fps_frames = 0;
+	  sourceparams->fps_start_usec = now_usec;
+	}
+    }
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  rusage_seconds
+
+
+   USAGE:
+
+   double cpu_seconds;
+
+   cpu_seconds = rusage_seconds();
+
+   returns: double
+
+   DESCRIPTION:
+                 return the user + system CPU time this process has
+		 used so far, in seconds (all threads).
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+double rusage_seconds(void)
+{
+  struct rusage usage;
+
+  getrusage(RUSAGE_SELF, &usage);
+
+  return((double)usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+	 (double)usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  run_headless_capture
+
+
+   USAGE:
+
+   int some_int;
+   Sourceset_t * sourceset;
+   int nframes;
+
+   some_int =  run_headless_capture(sourceset, nframes);
+
+   returns: int
+
+   DESCRIPTION:
+                 run the capture side of the program with no window
+		 until nframes frames have been taken off each
+		 source's ring, then print how much CPU that cost and
+		 how long frames waited between capture and "display".
+
+		 the consumer behaves like the windowed program: every
+		 HEADLESS_DISPLAY_USEC it takes one frame from each
+		 source. between frames it either polls the sources
+		 the way the GLUT idle function does (threaded clear)
+		 or sleeps while the capture threads work (threaded
+		 set, or the set's epoll thread). run it each way to
+		 compare.
+
+		 with more than one source, each gets a line of its
+		 own in the report. with a sync window
+		 (sourceset->sync) it takes a set of frames captured
+		 together instead, or nothing if none is ready.
+
+		 return 0 if all's well
+		       -1 if the sources couldn't be started
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   with a sync window narrower than the sources ever get, no set
+   comes together and it runs until it's killed.
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+     17-Oct-26  report frames the driver dropped
+     17-Oct-26  every source in a Sourceset_t
+     17-Oct-26  take synced sets
+
+ ************************************************************************* */
+
+int run_headless_capture(Sourceset_t * sourceset, int nframes)
+{
+  Sourceparams_t * sourceparams;
+  int displayed, i;
+  int taken[MAX_SOURCES], got[MAX_SOURCES];
+  unsigned int captured, captured_total, taken_total;
+  long long start_usec, next_display_usec, now_usec, latency_usec;
+  long long latency_total_usec[MAX_SOURCES], latency_max_usec[MAX_SOURCES];
+  long long latency_sum_usec, latency_worst_usec;
+  double start_cpu, cpu_seconds, wall_seconds;
+  Frameslot_t slots[MAX_SOURCES];
+
+  if (-1 == start_capture_sources(sourceset))
+    {
+      fprintf(stderr, "Error: unable to start capture source\n");
+      return(-1);
+    }
+
+  memset(taken, 0, sizeof(taken));
+  memset(latency_total_usec, 0, sizeof(latency_total_usec));
+  memset(latency_max_usec, 0, sizeof(latency_max_usec));
+  displayed = 0;
+  start_cpu = rusage_seconds();
+  start_usec = monotonic_usec();
+  next_display_usec = start_usec + HEADLESS_DISPLAY_USEC;
+
+  while (displayed < nframes)
+    {
+      if (0 != sourceset->sources[0]->threaded)
+	{
+	  sleep_until_usec(next_display_usec);
+	}
+      else
+	{
+	  /* what the idle function does: poll until it's time to draw  */
+	  (void)poll_capture_sources(sourceset);
+	}
+
+      now_usec = monotonic_usec();
+      if (now_usec < next_display_usec)
+	{
+	  continue;
+	}
+      next_display_usec += HEADLESS_DISPLAY_USEC;
+
+      if (0 != sourceset->sync.window_usec)
+	{
+	  got[0] = (0 == acquire_synced_frames(sourceset, slots));
+	  for (i = 1; i < sourceset->nsources; i++)
+	    {
+	      got[i] = got[0];
+	    }
+	}
+      else
+	{
+	  for (i = 0; i < sourceset->nsources; i++)
+	    {
+	      got[i] = (0 == acquire_video_frame(sourceset->sources[i],
+						 &(slots[i])));
+	    }
+	}
+
+      displayed = nframes;
+      for (i = 0; i < sourceset->nsources; i++)
+	{
+	  sourceparams = sourceset->sources[i];
+	  if (0 != got[i])
+	    {
+	      latency_usec = now_usec - slots[i].published_usec;
+	      latency_total_usec[i] += latency_usec;
+	      if (latency_usec > latency_max_usec[i])
+		{
+		  latency_max_usec[i] = latency_usec;
+		}
+	      release_video_frame(sourceparams, &(slots[i]));
+	      taken[i]++;
+	    }
+	  if (taken[i] < displayed)
+	    {
+	      displayed = taken[i]; /* done when the slowest one is  */
+	    }
+	}
+    }
+
+  wall_seconds = (double)(monotonic_usec() - start_usec) / 1e6;
+  cpu_seconds = rusage_seconds() - start_cpu;
+
+  (void)stop_capture_sources(sourceset);
+
+  captured_total = 0;
+  taken_total = 0;
+  latency_sum_usec = 0;
+  latency_worst_usec = 0;
+  for (i = 0; i < sourceset->nsources; i++)
+    {
+      sourceparams = sourceset->sources[i];
+      captured = sourceparams->ring.head; /* every frame pushed, thread's gone  */
+      captured_total += captured;
+      taken_total += taken[i];
+      latency_sum_usec += latency_total_usec[i];
+      if (latency_max_usec[i] > latency_worst_usec)
+	{
+	  latency_worst_usec = latency_max_usec[i];
+	}
+      if (1 < sourceset->nsources)
+	{
+	  fprintf(stderr, "source %d: captured %u frames (%.2f fps), latency"
+		  " avg %.2f msec max %.2f msec", i, captured,
+		  captured / wall_seconds,
+		  (0 < taken[i]) ?
+		  latency_total_usec[i] / 1000.0 / taken[i] : 0.0,
+		  latency_max_usec[i] / 1000.0);
+	  if (LIVESOURCE == sourceparams->source)
+	    {
+	      fprintf(stderr, ", driver dropped %u",
+		      sourceparams->dropped_frames);
+	    }
+	  fprintf(stderr, "\n");
+	}
+    }
+
+  sourceparams = sourceset->sources[0];
+  fprintf(stderr, "headless: %d frames in %.2f sec, %s capture\n",
+	  displayed, wall_seconds,
+	  (0 != sourceset->epoll) ? "epoll" :
+	  (0 != sourceparams->threaded) ? "threaded" : "polled");
+  fprintf(stderr, "  captured %u frames (%.2f fps)\n",
+	  captured_total, captured_total / wall_seconds);
+  if ((1 == sourceset->nsources) && (LIVESOURCE == sourceparams->source))
+    {
+      fprintf(stderr, "  driver dropped %u frames with %d buffers\n",
+	      sourceparams->dropped_frames, sourceparams->buffercount);
+    }
+  fprintf(stderr, "  cpu %.2f sec (%.1f%% of one core)\n",
+	  cpu_seconds, 100.0 * cpu_seconds / wall_seconds);
+  fprintf(stderr, "  capture->display latency avg %.2f msec max %.2f msec\n",
+	  (0 < taken_total) ? latency_sum_usec / 1000.0 / taken_total : 0.0,
+	  latency_worst_usec / 1000.0);
+
+  return(0);
+}
@@ -0,0 +1,92 @@
+/* ************************************************************************* 
+* NAME: glutcam/capture.h
+*
+* DESCRIPTION:
+*
+* this is the header file for the functions exported from capture.c
+*
+* PROCESS:
+*
+* start_capture_source / stop_capture_source start and stop the test
+*   pattern or V4L2 device, and the capture thread if sourceparams->threaded
+*
+* finish_capture_source is stop_capture_source without the stage
+*   latency report and the end of the trace, for stopping one source
+*   of several (multicapture.c)
+*
+* capture_video_frame pulls whatever frames the source has ready into
+*   sourceparams->ring (called from the GLUT idle function when we're
+*   not threaded)
+*
+* publish_video_frame is how the sources put a frame into the ring
+*
+* acquire_video_frame / release_video_frame are how the display side
+*   takes a frame out of the ring and gives it back to the source
+*
+* requeue_released_buffers gives the driver back the buffers dmabuf
+*   clients are done with (called by whatever dequeues device frames)
+*
+* wait_for_published_frame lets the display side sleep until there's
+*   a frame to take
+*
+* run_headless_capture runs the capture side of a Sourceset_t with no
+*   window and reports CPU use and capture to display latency
+*
+* rusage_seconds is the process's CPU time so far, for reports like
+*   that one
+*
+* GLOBALS: none
+*
+* REFERENCES:
+*
+* LIMITATIONS:
+*
+* REVISION HISTORY:
+*
+*   STR                Description                          Author
+*
+*   17-Oct-26          initial coding
+*   17-Oct-26          wait_for_published_frame
+*   17-Oct-26          export rusage_seconds
+*   17-Oct-26          finish_capture_source; run_headless_capture
+*                      takes a Sourceset_t
+*   17-Oct-26          requeue_released_buffers
+*
+* TARGET: Linux C
+*
+* This software is in the public domain. if it breaks you get to keep
+* both pieces.
+*
+* ************************************************************************* */
+
+#ifndef	__CAPTURE_H__
+#define	__CAPTURE_H__
+
+#include "glutcam.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+extern int start_capture_source(Sourceparams_t * sourceparams);
+extern int stop_capture_source(Sourceparams_t * sourceparams);
+extern int finish_capture_source(Sourceparams_t * sourceparams);
+extern void * capture_video_frame(Sourceparams_t * sourceparams,
+				  int * nbytesp);
+extern int publish_video_frame(Sourceparams_t * sourceparams,
+			       Frameslot_t * slot);
+extern int acquire_video_frame(Sourceparams_t * sourceparams,
+			       Frameslot_t * slot);
+extern void release_video_frame(Sourceparams_t * sourceparams,
+				Frameslot_t * slot);
+extern void requeue_released_buffers(Sourceparams_t * sourceparams);
+extern int wait_for_published_frame(Sourceparams_t * sourceparams,
+				    int useconds);
+extern int run_headless_capture(Sourceset_t * sourceset, int nframes);
+extern double rusage_seconds(void);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	//__CAPTURE_H__
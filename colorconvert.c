@@ -0,0 +1,1476 @@
+/* *************************************************************************
+* NAME: glutcam/colorconvert.c
+*
+* DESCRIPTION:
+*
+* YUYV (YUV 4:2:2 packed) to RGB24 conversion, in plain C and in SIMD
+* kernels for SSE2, AVX2 and NEON, with the kernel picked at run time.
+*
+* all the kernels use the same 16 bit fixed point arithmetic (7 bits
+* of fraction) so they agree with the scalar version byte for byte:
+*
+*   Y, U, V clamped to the BT.601 ranges 16..235 and 16..240
+*   y' = (Y - 16) * 149 + 64                   (149/128 ~ 1.164)
+*   R  = (y' + 204 * (V - 128)) >> 7
+*   G  = (y' -  50 * (U - 128) - 104 * (V - 128)) >> 7
+*   B  = (y' + 258 * (U - 128)) >> 7
+*
+* each clamped to 0..255. with the inputs clamped every product fits
+* in 16 bits; a sum can overflow only when it's going to clamp to 255,
+* and the SIMD code adds with signed saturation so that still works.
+*
+* the x86 kernels write with non-temporal (streaming) stores when the
+* destination is 16 byte aligned. the destination is normally a mapped
+* pixel buffer object, which is write-combined memory that the CPU
+* never reads back, so going around the cache is a win.
+*
+* PROCESS:
+*
+* see colorconvert.h
+*
+* GLOBALS: none
+*
+* REFERENCES: ITU-R BT.601
+*
+* LIMITATIONS:
+*
+* REVISION HISTORY:
+*
+*   STR                Description                          Author
+*
+*   17-Oct-26          initial coding
+*   17-Oct-26          convert in bands on a worker pool
+*   17-Oct-26          trace each band
+*
+* TARGET: Linux C (gcc: target attributes, __builtin_cpu_supports)
+*
+* This software is in the public domain. if it breaks you get to keep
+* both pieces.
+*
+* ************************************************************************* */
+
+#include <stdio.h>
+#include <stdlib.h> /* malloc, free  */
+#include <string.h> /* memcmp  */
+#include <stdint.h> /* uintptr_t  */
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HAVE_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define HAVE_NEON_KERNEL
+#include <arm_neon.h>
+#if defined(__arm__)
+#include <sys/auxv.h> /* getauxval  */
+#include <asm/hwcap.h> /* HWCAP_NEON  */
+#endif
+#endif
+
+#include "glutcam.h"
+#include "workpool.h"
+#include "colorconvert.h"
+#include "trace.h" /* trace_begin, trace_end  */
+
+/* fixed point coefficients: see the description above  */
+
+#define CC_Y_SCALE 149
+#define CC_RV 204
+#define CC_GU (-50)
+#define CC_GV (-104)
+#define CC_BU 258
+#define CC_ROUND 64
+#define CC_SHIFT 7
+
+#define CC_Y_MIN 16
+#define CC_Y_MAX 235
+#define CC_C_MIN 16
+#define CC_C_MAX 240
+
+/* CHECK_PIXELS - how many pixels select_convert_kernel feeds the SIMD  */
+/* kernel and the scalar one to compare them. odd multiple of 2 so     */
+/* the kernels' leftover-pixel code gets run too.                       */
+
+#define CHECK_PIXELS 8190
+
+/* BANDS_PER_THREAD - split the image into this many bands per worker  */
+/* so one that gets descheduled doesn't leave the rest waiting.         */
+
+#define BANDS_PER_THREAD 2
+
+typedef void (*Convertfunc_t)(const unsigned char * yuyv,
+			      unsigned char * rgb, int npixels);
+
+/* Convertbands_t - what convert_band needs to find its rows  */
+
+typedef struct convertbands_s {
+  const unsigned char * yuyv;
+  unsigned char * rgb;
+  int width;
+  int height;
+  int rgbstride; /* bytes from one RGB row to the next  */
+  int band_rows; /* rows in every band but maybe the last  */
+} Convertbands_t;
+
+/* local prototypes  */
+unsigned char clamp_channel(int value);
+int clamp_input(int value, int lo, int hi);
+#ifdef	HAVE_X86_KERNELS
+void convert_yuyv_to_rgb24_sse2(const unsigned char * yuyv,
+				unsigned char * rgb, int npixels);
+void convert_yuyv_to_rgb24_avx2(const unsigned char * yuyv,
+				unsigned char * rgb, int npixels);
+#endif
+#ifdef	HAVE_NEON_KERNEL
+void convert_yuyv_to_rgb24_neon(const unsigned char * yuyv,
+				unsigned char * rgb, int npixels);
+#endif
+int kernel_supported(Convertkernel_t kernel);
+Convertfunc_t kernel_function(Convertkernel_t kernel);
+int check_convert_kernel(Convertfunc_t func);
+void convert_band(void * arg, int band);
+/* end local prototypes  */
+
+static Convertkernel_t Kernel_in_use = CONVERT_SCALAR;
+static Convertfunc_t Convert_func = convert_yuyv_to_rgb24_scalar;
+
+
+
+/* *************************************************************************
+
+
+   NAME:  select_convert_kernel
+
+
+   USAGE:
+
+   Convertkernel_t kernel;
+
+   kernel =  select_convert_kernel(CONVERT_AUTO);
+
+   returns: Convertkernel_t
+
+   DESCRIPTION:
+                 make requested the kernel that convert_yuyv_to_rgb24
+		 uses.
+
+		 CONVERT_AUTO picks the fastest one this CPU runs.
+		 if the requested kernel isn't built in or the CPU
+		 can't run it, say so and fall back to CONVERT_AUTO.
+
+		 before a SIMD kernel is used, run it on a test
+		 pattern and compare against the scalar version. if
+		 they don't match, complain and use the scalar one.
+
+		 CONVERT_OPENCV is only recorded: process() in
+		 cvProcess.cpp checks for it and calls cvCvtColor.
+		 anyone else calling convert_yuyv_to_rgb24 gets the
+		 best kernel.
+
+		 return the kernel that was settled on
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   call this before the capture starts: it isn't thread safe.
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: Kernel_in_use, Convert_func
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+Convertkernel_t select_convert_kernel(Convertkernel_t requested)
+{
+  static const Convertkernel_t preferred[] = {CONVERT_AVX2, CONVERT_SSE2,
+					      CONVERT_NEON, CONVERT_SCALAR};
+  Convertkernel_t kernel;
+  unsigned int i;
+
+  if ((CONVERT_AUTO != requested) && (0 == kernel_supported(requested)))
+    {
+      fprintf(stderr, "colour conversion kernel %s isn't available here,"
+	      " picking one\n", convert_kernel_name(requested));
+      requested = CONVERT_AUTO;
+    }
+
+  kernel = CONVERT_SCALAR;
+  for (i = 0; i < sizeof(preferred) / sizeof(preferred[0]); i++)
+    {
+      if (kernel_supported(preferred[i]))
+	{
+	  kernel = preferred[i];
+	  break;
+	}
+    }
+
+  if ((CONVERT_AUTO != requested) && (CONVERT_OPENCV != requested))
+    {
+      kernel = requested;
+    }
+
+  if ((CONVERT_SCALAR != kernel)
+      && (0 != check_convert_kernel(kernel_function(kernel))))
+    {
+      fprintf(stderr, "Error: %s colour conversion doesn't match the"
+	      " scalar version, using scalar\n", convert_kernel_name(kernel));
+      kernel = CONVERT_SCALAR;
+    }
+
+  Convert_func = kernel_function(kernel);
+  Kernel_in_use = (CONVERT_OPENCV == requested) ? CONVERT_OPENCV : kernel;
+
+  return(Kernel_in_use);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  convert_kernel_in_use
+
+
+   USAGE:
+
+   if (CONVERT_OPENCV == convert_kernel_in_use())
+   -- use cvCvtColor
+
+   returns: Convertkernel_t
+
+   DESCRIPTION:
+                 return the kernel select_convert_kernel settled on
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: Kernel_in_use
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+Convertkernel_t convert_kernel_in_use(void)
+{
+  return(Kernel_in_use);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  convert_kernel_name
+
+
+   USAGE:
+
+   const char * name;
+
+   name =  convert_kernel_name(CONVERT_SSE2);
+
+   returns: const char *
+
+   DESCRIPTION:
+                 return the name of kernel as the -k option spells it
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+const char * convert_kernel_name(Convertkernel_t kernel)
+{
+  const char * retval;
+
+  switch (kernel)
+    {
+    case CONVERT_AUTO:
+      retval = "auto";
+      break;
+
+    case CONVERT_SCALAR:
+      retval = "scalar";
+      break;
+
+    case CONVERT_SSE2:
+      retval = "sse2";
+      break;
+
+    case CONVERT_AVX2:
+      retval = "avx2";
+      break;
+
+    case CONVERT_NEON:
+      retval = "neon";
+      break;
+
+    case CONVERT_OPENCV:
+      retval = "opencv";
+      break;
+
+    default:
+      retval = "unknown";
+      break;
+    }
+
+  return(retval);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  convert_yuyv_to_rgb24
+
+
+   USAGE:
+
+   const unsigned char * yuyv;
+   unsigned char * rgb;
+   int npixels;
+
+   convert_yuyv_to_rgb24(yuyv, rgb, npixels);
+
+   returns: void
+
+   DESCRIPTION:
+                 convert npixels pixels (2 * npixels bytes) of YUYV at
+		 yuyv into 3 * npixels bytes of RGB at rgb with the
+		 kernel select_convert_kernel picked.
+
+		 rows don't matter: as long as neither buffer has
+		 padding at the end of a row, a whole image (or any
+		 run of whole rows) is one call.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   npixels must be even
+
+   GLOBAL VARIABLES:
+
+      accessed: Convert_func
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void convert_yuyv_to_rgb24(const unsigned char * yuyv, unsigned char * rgb,
+			   int npixels)
+{
+  Convert_func(yuyv, rgb, npixels);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  convert_yuyv_to_rgb24_bands
+
+
+   USAGE:
+
+   Workpool_t pool;
+   const unsigned char * yuyv;
+   unsigned char * rgb;
+   int width, height, rgbstride;
+
+   convert_yuyv_to_rgb24_bands(&pool, yuyv, rgb, width, height, rgbstride);
+
+   returns: void
+
+   DESCRIPTION:
+                 convert a width x height YUYV image at yuyv into RGB24
+		 at rgb, whose rows start rgbstride bytes apart.
+
+		 the image is cut into horizontal bands,
+		 BANDS_PER_THREAD per worker in pool, and each worker
+		 writes its bands straight into rgb. returns when the
+		 whole image is done.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   width must be even
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void convert_yuyv_to_rgb24_bands(Workpool_t * pool, const unsigned char * yuyv,
+				 unsigned char * rgb, int width, int height,
+				 int rgbstride)
+{
+  Convertbands_t bands;
+  int nbands;
+
+  nbands = pool->nthreads * BANDS_PER_THREAD;
+  if (nbands < 1)
+    {
+      nbands = 1;
+    }
+  if (nbands > height)
+    {
+      nbands = height;
+    }
+  if (nbands < 1)
+    {
+      return; /* no rows  */
+    }
+
+  bands.yuyv = yuyv;
+  bands.rgb = rgb;
+  bands.width = width;
+  bands.height = height;
+  bands.rgbstride = rgbstride;
+  bands.band_rows = (height + nbands - 1) / nbands;
+  nbands = (height + bands.band_rows - 1) / bands.band_rows;
+
+  run_workpool(pool, convert_band, &bands, nbands);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  convert_band
+
+
+   USAGE:
+
+   run_workpool(pool, convert_band, &bands, nbands);
+
+   returns: void
+
+   DESCRIPTION:
+                 convert rows band * band_rows up to the next band (or
+		 the bottom of the image). if the RGB rows aren't
+		 padded that's one call for the whole band, otherwise
+		 one per row.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+     17-Oct-26  trace the band
+
+ ************************************************************************* */
+
+void convert_band(void * arg, int band)
+{
+  const Convertbands_t * bands;
+  const unsigned char * src;
+  unsigned char * dst;
+  int first, nrows, row;
+  long long start;
+
+  start = trace_begin();
+  bands = (const Convertbands_t *)arg;
+
+  first = band * bands->band_rows;
+  nrows = bands->height - first;
+  if (nrows > bands->band_rows)
+    {
+      nrows = bands->band_rows;
+    }
+
+  src = bands->yuyv + (size_t)first * bands->width * 2;
+  dst = bands->rgb + (size_t)first * bands->rgbstride;
+
+  if (bands->rgbstride == bands->width * 3)
+    {
+      Convert_func(src, dst, bands->width * nrows);
+    }
+  else
+    {
+      for (row = 0; row < nrows; row++)
+	{
+	  Convert_func(src, dst, bands->width);
+	  src += bands->width * 2;
+	  dst += bands->rgbstride;
+	}
+    }
+
+  trace_end("convert band", start);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  clamp_channel
+
+
+   USAGE:
+
+   unsigned char c;
+
+   c =  clamp_channel(sum);
+
+   returns: unsigned char
+
+   DESCRIPTION:
+                 shift the fraction out of value and clamp it to
+		 0..255: what the SIMD kernels do with srai_epi16 and
+		 packus_epi16.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+unsigned char clamp_channel(int value)
+{
+  value >>= CC_SHIFT;
+
+  if (value > 255)
+    {
+      value = 255;
+    }
+  else if (value < 0)
+    {
+      value = 0;
+    }
+
+  return((unsigned char)value);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  clamp_input
+
+
+   USAGE:
+
+   int y;
+
+   y =  clamp_input(yuyv[0], CC_Y_MIN, CC_Y_MAX);
+
+   returns: int
+
+   DESCRIPTION:
+                 return value limited to lo..hi
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int clamp_input(int value, int lo, int hi)
+{
+  if (value < lo)
+    {
+      value = lo;
+    }
+  else if (value > hi)
+    {
+      value = hi;
+    }
+
+  return(value);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  convert_yuyv_to_rgb24_scalar
+
+
+   USAGE:
+
+   convert_yuyv_to_rgb24_scalar(yuyv, rgb, npixels);
+
+   returns: void
+
+   DESCRIPTION:
+                 the reference conversion: plain C, a pixel pair at a
+		 time. the SIMD kernels use it for leftover pixels at
+		 the end.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   npixels must be even
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void convert_yuyv_to_rgb24_scalar(const unsigned char * yuyv,
+				  unsigned char * rgb, int npixels)
+{
+  int i, u, v, y, ruv, guv, buv;
+
+  for (i = 0; i < npixels; i += 2)
+    {
+      u = clamp_input(yuyv[1], CC_C_MIN, CC_C_MAX) - 128;
+      v = clamp_input(yuyv[3], CC_C_MIN, CC_C_MAX) - 128;
+      ruv = CC_RV * v;
+      guv = CC_GU * u + CC_GV * v;
+      buv = CC_BU * u;
+
+      y = (clamp_input(yuyv[0], CC_Y_MIN, CC_Y_MAX) - 16) * CC_Y_SCALE
+	+ CC_ROUND;
+      rgb[0] = clamp_channel(y + ruv);
+      rgb[1] = clamp_channel(y + guv);
+      rgb[2] = clamp_channel(y + buv);
+
+      y = (clamp_input(yuyv[2], CC_Y_MIN, CC_Y_MAX) - 16) * CC_Y_SCALE
+	+ CC_ROUND;
+      rgb[3] = clamp_channel(y + ruv);
+      rgb[4] = clamp_channel(y + guv);
+      rgb[5] = clamp_channel(y + buv);
+
+      yuyv += 4;
+      rgb += 6;
+    }
+}
+
+
+
+#ifdef	HAVE_X86_KERNELS
+
+/* yuyv_to_rgb_epi16 - the arithmetic for 8 pixels: y holds 8 lumas,   */
+/* u and v the chroma for each pixel (pairs already duplicated), all   */
+/* as 16 bit. returns R, G and B as 16 bit in r, g and b, not clamped  */
+/* to 8 bits yet.                                                       */
+
+static inline void yuyv_to_rgb_epi16(__m128i y, __m128i u, __m128i v,
+				     __m128i * r, __m128i * g, __m128i * b)
+{
+  const __m128i c128 = _mm_set1_epi16(128);
+
+  y = _mm_add_epi16(_mm_mullo_epi16(_mm_sub_epi16(y, _mm_set1_epi16(16)),
+				    _mm_set1_epi16(CC_Y_SCALE)),
+		    _mm_set1_epi16(CC_ROUND));
+  u = _mm_sub_epi16(u, c128);
+  v = _mm_sub_epi16(v, c128);
+
+  *r = _mm_srai_epi16(_mm_adds_epi16(y, _mm_mullo_epi16(v, _mm_set1_epi16(CC_RV))),
+		      CC_SHIFT);
+  *g = _mm_srai_epi16(_mm_adds_epi16(y, _mm_add_epi16(
+			  _mm_mullo_epi16(u, _mm_set1_epi16(CC_GU)),
+			  _mm_mullo_epi16(v, _mm_set1_epi16(CC_GV)))),
+		      CC_SHIFT);
+  *b = _mm_srai_epi16(_mm_adds_epi16(y, _mm_mullo_epi16(u, _mm_set1_epi16(CC_BU))),
+		      CC_SHIFT);
+}
+
+
+
+/* split_yuyv_sse2 - 16 bytes of YUYV (8 pixels) into Y, U and V as    */
+/* 16 bit, clamped to their legal ranges, with each U and V repeated   */
+/* for the two pixels sharing it                                       */
+
+static inline void split_yuyv_sse2(__m128i src, __m128i * y, __m128i * u,
+				   __m128i * v)
+{
+  __m128i uv;
+
+  src = _mm_max_epu8(_mm_min_epu8(src, _mm_set1_epi16((CC_C_MAX << 8)
+						      | CC_Y_MAX)),
+		     _mm_set1_epi16((CC_C_MIN << 8) | CC_Y_MIN));
+  *y = _mm_and_si128(src, _mm_set1_epi16(0x00ff));
+  uv = _mm_srli_epi16(src, 8); /* u0 v0 u1 v1 u2 v2 u3 v3  */
+  *u = _mm_shufflehi_epi16(_mm_shufflelo_epi16(uv, _MM_SHUFFLE(2, 2, 0, 0)),
+			   _MM_SHUFFLE(2, 2, 0, 0));
+  *v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(uv, _MM_SHUFFLE(3, 3, 1, 1)),
+			   _MM_SHUFFLE(3, 3, 1, 1));
+}
+
+
+
+/* pack_rgbx_sse2 - squeeze 4 RGBX pixels (X = 0) into 12 RGB bytes at  */
+/* the bottom of the register; the top 4 bytes come out 0.             */
+
+static inline __m128i pack_rgbx_sse2(__m128i p)
+{
+  __m128i c;
+
+  /* within each 64 bits: R0 G0 B0 0 R1 G1 B1 0 -> R0 G0 B0 R1 G1 B1 0 0  */
+  c = _mm_or_si128(_mm_and_si128(p, _mm_set_epi32(0, 0x00ffffff,
+						   0, 0x00ffffff)),
+		   _mm_and_si128(_mm_srli_epi64(p, 8),
+				 _mm_set_epi32(0x0000ffff, 0xff000000,
+					       0x0000ffff, 0xff000000)));
+
+  /* then close the 2 byte gap between the 64 bit halves  */
+  return(_mm_or_si128(_mm_move_epi64(c),
+		      _mm_slli_si128(_mm_unpackhi_epi64(c, _mm_setzero_si128()),
+				     6)));
+}
+
+
+
+/* store_rgb24_sse2 - interleave 16 R, G and B bytes into 48 bytes of  */
+/* RGB24 at dst. stream says dst is 16 byte aligned and we should      */
+/* bypass the cache.                                                   */
+
+static inline void store_rgb24_sse2(unsigned char * dst, __m128i r, __m128i g,
+				    __m128i b, int stream)
+{
+  const __m128i zero = _mm_setzero_si128();
+  __m128i rg, bx, q0, q1, q2, q3, out0, out1, out2;
+
+  rg = _mm_unpacklo_epi8(r, g);
+  bx = _mm_unpacklo_epi8(b, zero);
+  q0 = pack_rgbx_sse2(_mm_unpacklo_epi16(rg, bx));
+  q1 = pack_rgbx_sse2(_mm_unpackhi_epi16(rg, bx));
+  rg = _mm_unpackhi_epi8(r, g);
+  bx = _mm_unpackhi_epi8(b, zero);
+  q2 = pack_rgbx_sse2(_mm_unpacklo_epi16(rg, bx));
+  q3 = pack_rgbx_sse2(_mm_unpackhi_epi16(rg, bx));
+
+  out0 = _mm_or_si128(q0, _mm_slli_si128(q1, 12));
+  out1 = _mm_or_si128(_mm_srli_si128(q1, 4), _mm_slli_si128(q2, 8));
+  out2 = _mm_or_si128(_mm_srli_si128(q2, 8), _mm_slli_si128(q3, 4));
+
+  if (stream)
+    {
+      _mm_stream_si128((__m128i *)dst, out0);
+      _mm_stream_si128((__m128i *)(dst + 16), out1);
+      _mm_stream_si128((__m128i *)(dst + 32), out2);
+    }
+  else
+    {
+      _mm_storeu_si128((__m128i *)dst, out0);
+      _mm_storeu_si128((__m128i *)(dst + 16), out1);
+      _mm_storeu_si128((__m128i *)(dst + 32), out2);
+    }
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  convert_yuyv_to_rgb24_sse2
+
+
+   USAGE:
+
+   convert_yuyv_to_rgb24_sse2(yuyv, rgb, npixels);
+
+   returns: void
+
+   DESCRIPTION:
+                 SSE2 kernel: 16 pixels (32 bytes in, 48 out) a
+		 loop. SSE2 has no byte shuffle, so the RGB24
+		 interleave is done with unpacks, 64 bit shifts and
+		 masks. leftovers go through the scalar code.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void convert_yuyv_to_rgb24_sse2(const unsigned char * yuyv,
+				unsigned char * rgb, int npixels)
+{
+  __m128i y, u, v, ra, ga, ba, rb, gb, bb;
+  int i, stream;
+
+  stream = (0 == ((uintptr_t)rgb & 15));
+
+  for (i = 0; i + 16 <= npixels; i += 16)
+    {
+      split_yuyv_sse2(_mm_loadu_si128((const __m128i *)yuyv), &y, &u, &v);
+      yuyv_to_rgb_epi16(y, u, v, &ra, &ga, &ba);
+      split_yuyv_sse2(_mm_loadu_si128((const __m128i *)(yuyv + 16)),
+		      &y, &u, &v);
+      yuyv_to_rgb_epi16(y, u, v, &rb, &gb, &bb);
+
+      store_rgb24_sse2(rgb, _mm_packus_epi16(ra, rb), _mm_packus_epi16(ga, gb),
+		       _mm_packus_epi16(ba, bb), stream);
+
+      yuyv += 32;
+      rgb += 48;
+    }
+
+  if (stream)
+    {
+      _mm_sfence(); /* streaming stores are weakly ordered  */
+    }
+
+  convert_yuyv_to_rgb24_scalar(yuyv, rgb, npixels - i);
+}
+
+
+
+/* Rgb24_shuffle - pshufb masks that take 16 bytes of one channel to   */
+/* its places in each of the three 16 byte blocks of RGB24 output.     */
+/* [block][channel][byte]; 0x80 zeroes the byte.                       */
+
+static const unsigned char Rgb24_shuffle[3][3][16] __attribute__((aligned(16))) = {
+  { {0x00, 0x80, 0x80, 0x01, 0x80, 0x80, 0x02, 0x80,
+     0x80, 0x03, 0x80, 0x80, 0x04, 0x80, 0x80, 0x05},
+    {0x80, 0x00, 0x80, 0x80, 0x01, 0x80, 0x80, 0x02,
+     0x80, 0x80, 0x03, 0x80, 0x80, 0x04, 0x80, 0x80},
+    {0x80, 0x80, 0x00, 0x80, 0x80, 0x01, 0x80, 0x80,
+     0x02, 0x80, 0x80, 0x03, 0x80, 0x80, 0x04, 0x80} },
+  { {0x80, 0x80, 0x06, 0x80, 0x80, 0x07, 0x80, 0x80,
+     0x08, 0x80, 0x80, 0x09, 0x80, 0x80, 0x0a, 0x80},
+    {0x05, 0x80, 0x80, 0x06, 0x80, 0x80, 0x07, 0x80,
+     0x80, 0x08, 0x80, 0x80, 0x09, 0x80, 0x80, 0x0a},
+    {0x80, 0x05, 0x80, 0x80, 0x06, 0x80, 0x80, 0x07,
+     0x80, 0x80, 0x08, 0x80, 0x80, 0x09, 0x80, 0x80} },
+  { {0x80, 0x0b, 0x80, 0x80, 0x0c, 0x80, 0x80, 0x0d,
+     0x80, 0x80, 0x0e, 0x80, 0x80, 0x0f, 0x80, 0x80},
+    {0x80, 0x80, 0x0b, 0x80, 0x80, 0x0c, 0x80, 0x80,
+     0x0d, 0x80, 0x80, 0x0e, 0x80, 0x80, 0x0f, 0x80},
+    {0x0a, 0x80, 0x80, 0x0b, 0x80, 0x80, 0x0c, 0x80,
+     0x80, 0x0d, 0x80, 0x80, 0x0e, 0x80, 0x80, 0x0f} }
+};
+
+
+
+/* store_rgb24_ssse3 - store_rgb24_sse2 with pshufb doing the          */
+/* interleave: 3 shuffles and 2 ORs per 16 output bytes.               */
+
+__attribute__((target("ssse3")))
+static inline void store_rgb24_ssse3(unsigned char * dst, __m128i r,
+				     __m128i g, __m128i b, int stream)
+{
+  const __m128i * mask;
+  __m128i out;
+  int block;
+
+  mask = (const __m128i *)Rgb24_shuffle;
+  for (block = 0; block < 3; block++)
+    {
+      out = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r, mask[0]),
+				      _mm_shuffle_epi8(g, mask[1])),
+			 _mm_shuffle_epi8(b, mask[2]));
+      if (stream)
+	{
+	  _mm_stream_si128((__m128i *)(dst + 16 * block), out);
+	}
+      else
+	{
+	  _mm_storeu_si128((__m128i *)(dst + 16 * block), out);
+	}
+      mask += 3;
+    }
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  convert_yuyv_to_rgb24_avx2
+
+
+   USAGE:
+
+   convert_yuyv_to_rgb24_avx2(yuyv, rgb, npixels);
+
+   returns: void
+
+   DESCRIPTION:
+                 AVX2 kernel: 32 pixels (64 bytes in, 96 out) a loop.
+		 the arithmetic runs 16 pixels to a register; the
+		 interleave is pshufb on each 128 bit half.
+		 leftovers go through the scalar code.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+__attribute__((target("avx2")))
+void convert_yuyv_to_rgb24_avx2(const unsigned char * yuyv,
+				unsigned char * rgb, int npixels)
+{
+  const __m256i lo8 = _mm256_set1_epi16(0x00ff);
+  const __m256i inmax = _mm256_set1_epi16((CC_C_MAX << 8) | CC_Y_MAX);
+  const __m256i inmin = _mm256_set1_epi16((CC_C_MIN << 8) | CC_Y_MIN);
+  const __m256i c16 = _mm256_set1_epi16(16);
+  const __m256i c128 = _mm256_set1_epi16(128);
+  const __m256i yscale = _mm256_set1_epi16(CC_Y_SCALE);
+  const __m256i round = _mm256_set1_epi16(CC_ROUND);
+  const __m256i rv = _mm256_set1_epi16(CC_RV);
+  const __m256i gu = _mm256_set1_epi16(CC_GU);
+  const __m256i gv = _mm256_set1_epi16(CC_GV);
+  const __m256i bu = _mm256_set1_epi16(CC_BU);
+  __m256i src, y, uv, u, v, r[2], g[2], b[2], r8, g8, b8;
+  int i, half, stream;
+
+  stream = (0 == ((uintptr_t)rgb & 15));
+
+  for (i = 0; i + 32 <= npixels; i += 32)
+    {
+      for (half = 0; half < 2; half++)
+	{
+	  src = _mm256_loadu_si256((const __m256i *)(yuyv + 32 * half));
+	  src = _mm256_max_epu8(_mm256_min_epu8(src, inmax), inmin);
+	  y = _mm256_and_si256(src, lo8);
+	  uv = _mm256_srli_epi16(src, 8);
+	  u = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(uv,
+					_MM_SHUFFLE(2, 2, 0, 0)),
+				     _MM_SHUFFLE(2, 2, 0, 0));
+	  v = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(uv,
+					_MM_SHUFFLE(3, 3, 1, 1)),
+				     _MM_SHUFFLE(3, 3, 1, 1));
+
+	  y = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_sub_epi16(y, c16),
+						  yscale), round);
+	  u = _mm256_sub_epi16(u, c128);
+	  v = _mm256_sub_epi16(v, c128);
+
+	  r[half] = _mm256_srai_epi16(_mm256_adds_epi16(y,
+					 _mm256_mullo_epi16(v, rv)), CC_SHIFT);
+	  g[half] = _mm256_srai_epi16(_mm256_adds_epi16(y,
+					 _mm256_add_epi16(_mm256_mullo_epi16(u, gu),
+							  _mm256_mullo_epi16(v, gv))),
+				      CC_SHIFT);
+	  b[half] = _mm256_srai_epi16(_mm256_adds_epi16(y,
+					 _mm256_mullo_epi16(u, bu)), CC_SHIFT);
+	}
+
+      /* packus works within 128 bit lanes, which leaves the pixels  */
+      /* in 64 bit groups ordered 0 2 1 3: put them back.            */
+      r8 = _mm256_permute4x64_epi64(_mm256_packus_epi16(r[0], r[1]),
+				    _MM_SHUFFLE(3, 1, 2, 0));
+      g8 = _mm256_permute4x64_epi64(_mm256_packus_epi16(g[0], g[1]),
+				    _MM_SHUFFLE(3, 1, 2, 0));
+      b8 = _mm256_permute4x64_epi64(_mm256_packus_epi16(b[0], b[1]),
+				    _MM_SHUFFLE(3, 1, 2, 0));
+
+      store_rgb24_ssse3(rgb, _mm256_castsi256_si128(r8),
+			_mm256_castsi256_si128(g8),
+			_mm256_castsi256_si128(b8), stream);
+      store_rgb24_ssse3(rgb + 48, _mm256_extracti128_si256(r8, 1),
+			_mm256_extracti128_si256(g8, 1),
+			_mm256_extracti128_si256(b8, 1), stream);
+
+      yuyv += 64;
+      rgb += 96;
+    }
+
+  if (stream)
+    {
+      _mm_sfence(); /* streaming stores are weakly ordered  */
+    }
+
+  convert_yuyv_to_rgb24_scalar(yuyv, rgb, npixels - i);
+}
+
+#endif	/* HAVE_X86_KERNELS  */
+
+
+
+#ifdef	HAVE_NEON_KERNEL
+
+/* *************************************************************************
+
+
+   NAME:  convert_yuyv_to_rgb24_neon
+
+
+   USAGE:
+
+   convert_yuyv_to_rgb24_neon(yuyv, rgb, npixels);
+
+   returns: void
+
+   DESCRIPTION:
+                 NEON kernel: 16 pixels a loop. vld4 splits the YUYV
+		 into even Y, U, odd Y and V; the even and odd results
+		 are zipped back together and vst3 interleaves RGB.
+		 leftovers go through the scalar code.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   no non-temporal stores on this path.
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void convert_yuyv_to_rgb24_neon(const unsigned char * yuyv,
+				unsigned char * rgb, int npixels)
+{
+  const int16x8_t c16 = vdupq_n_s16(16);
+  const int16x8_t c128 = vdupq_n_s16(128);
+  const int16x8_t round = vdupq_n_s16(CC_ROUND);
+  const uint8x8_t ymin = vdup_n_u8(CC_Y_MIN);
+  const uint8x8_t ymax = vdup_n_u8(CC_Y_MAX);
+  const uint8x8_t cmin = vdup_n_u8(CC_C_MIN);
+  const uint8x8_t cmax = vdup_n_u8(CC_C_MAX);
+  uint8x8x4_t src;
+  uint8x8x2_t r, g, b;
+  uint8x16x3_t out;
+  int16x8_t u, v, ruv, guv, buv, ye, yo;
+  int i;
+
+  for (i = 0; i + 16 <= npixels; i += 16)
+    {
+      src = vld4_u8(yuyv);
+      src.val[0] = vmax_u8(vmin_u8(src.val[0], ymax), ymin);
+      src.val[1] = vmax_u8(vmin_u8(src.val[1], cmax), cmin);
+      src.val[2] = vmax_u8(vmin_u8(src.val[2], ymax), ymin);
+      src.val[3] = vmax_u8(vmin_u8(src.val[3], cmax), cmin);
+
+      u = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(src.val[1])), c128);
+      v = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(src.val[3])), c128);
+      ruv = vmulq_n_s16(v, CC_RV);
+      guv = vaddq_s16(vmulq_n_s16(u, CC_GU), vmulq_n_s16(v, CC_GV));
+      buv = vmulq_n_s16(u, CC_BU);
+
+      ye = vaddq_s16(vmulq_n_s16(vsubq_s16(vreinterpretq_s16_u16(
+				     vmovl_u8(src.val[0])), c16), CC_Y_SCALE),
+		     round);
+      yo = vaddq_s16(vmulq_n_s16(vsubq_s16(vreinterpretq_s16_u16(
+				     vmovl_u8(src.val[2])), c16), CC_Y_SCALE),
+		     round);
+
+      r = vzip_u8(vqmovun_s16(vshrq_n_s16(vqaddq_s16(ye, ruv), CC_SHIFT)),
+		  vqmovun_s16(vshrq_n_s16(vqaddq_s16(yo, ruv), CC_SHIFT)));
+      g = vzip_u8(vqmovun_s16(vshrq_n_s16(vqaddq_s16(ye, guv), CC_SHIFT)),
+		  vqmovun_s16(vshrq_n_s16(vqaddq_s16(yo, guv), CC_SHIFT)));
+      b = vzip_u8(vqmovun_s16(vshrq_n_s16(vqaddq_s16(ye, buv), CC_SHIFT)),
+		  vqmovun_s16(vshrq_n_s16(vqaddq_s16(yo, buv), CC_SHIFT)));
+
+      out.val[0] = vcombine_u8(r.val[0], r.val[1]);
+      out.val[1] = vcombine_u8(g.val[0], g.val[1]);
+      out.val[2] = vcombine_u8(b.val[0], b.val[1]);
+      vst3q_u8(rgb, out);
+
+      yuyv += 32;
+      rgb += 48;
+    }
+
+  convert_yuyv_to_rgb24_scalar(yuyv, rgb, npixels - i);
+}
+
+#endif	/* HAVE_NEON_KERNEL  */
+
+
+
+/* *************************************************************************
+
+
+   NAME:  kernel_supported
+
+
+   USAGE:
+
+   if (kernel_supported(CONVERT_AVX2))
+   -- it's built in and this CPU can run it
+
+   returns: int
+
+   DESCRIPTION:
+                 return 1 if kernel was compiled in and the CPU we're
+		 running on has the instructions it needs, else 0.
+		 CONVERT_SCALAR is always there; CONVERT_OPENCV is
+		 there if we were built with OpenCV (DEF_RGB).
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int kernel_supported(Convertkernel_t kernel)
+{
+  int retval;
+
+  switch (kernel)
+    {
+    case CONVERT_SCALAR:
+      retval = 1;
+      break;
+
+    case CONVERT_SSE2:
+#ifdef	HAVE_X86_KERNELS
+      retval = __builtin_cpu_supports("sse2");
+#else
+      retval = 0;
+#endif
+      break;
+
+    case CONVERT_AVX2:
+#ifdef	HAVE_X86_KERNELS
+      retval = __builtin_cpu_supports("avx2");
+#else
+      retval = 0;
+#endif
+      break;
+
+    case CONVERT_NEON:
+#if defined(HAVE_NEON_KERNEL) && defined(__arm__)
+      retval = (0 != (getauxval(AT_HWCAP) & HWCAP_NEON));
+#elif defined(HAVE_NEON_KERNEL)
+      retval = 1; /* aarch64 always has it  */
+#else
+      retval = 0;
+#endif
+      break;
+
+    case CONVERT_OPENCV:
+#ifdef	DEF_RGB
+      retval = 1;
+#else
+      retval = 0;
+#endif
+      break;
+
+    case CONVERT_AUTO:
+    default:
+      retval = 0;
+      break;
+    }
+
+  return(retval);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  kernel_function
+
+
+   USAGE:
+
+   Convertfunc_t func;
+
+   func =  kernel_function(CONVERT_SSE2);
+
+   returns: Convertfunc_t
+
+   DESCRIPTION:
+                 return the function that implements kernel. anything
+		 not compiled in gets the scalar version.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+     17-Oct-26  every kernel listed in the switch
+
+ ************************************************************************* */
+
+Convertfunc_t kernel_function(Convertkernel_t kernel)
+{
+  Convertfunc_t retval;
+
+  switch (kernel)
+    {
+    case CONVERT_SSE2:
+#ifdef	HAVE_X86_KERNELS
+      retval = convert_yuyv_to_rgb24_sse2;
+#else
+      retval = convert_yuyv_to_rgb24_scalar;
+#endif
+      break;
+
+    case CONVERT_AVX2:
+#ifdef	HAVE_X86_KERNELS
+      retval = convert_yuyv_to_rgb24_avx2;
+#else
+      retval = convert_yuyv_to_rgb24_scalar;
+#endif
+      break;
+
+    case CONVERT_NEON:
+#ifdef	HAVE_NEON_KERNEL
+      retval = convert_yuyv_to_rgb24_neon;
+#else
+      retval = convert_yuyv_to_rgb24_scalar;
+#endif
+      break;
+
+    case CONVERT_AUTO:
+    case CONVERT_SCALAR:
+    case CONVERT_OPENCV:
+    default:
+      retval = convert_yuyv_to_rgb24_scalar;
+      break;
+    }
+
+  return(retval);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  check_convert_kernel
+
+
+   USAGE:
+
+   if (0 == check_convert_kernel(func))
+   -- func matches the scalar code
+
+   returns: int
+
+   DESCRIPTION:
+                 run func and the scalar code on CHECK_PIXELS pixels of
+		 pseudo-random YUYV (every value of Y, U and V turns
+		 up) and compare. the output goes to an odd address
+		 so the unaligned store path is what gets checked;
+		 the aligned one differs only in the store.
+
+		 return 0 if they match
+		       -1 if they don't (or we couldn't get memory)
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int check_convert_kernel(Convertfunc_t func)
+{
+  unsigned char * yuyv;
+  unsigned char * expected;
+  unsigned char * got;
+  unsigned int seed;
+  int i, retval;
+
+  yuyv = (unsigned char *)malloc(CHECK_PIXELS * 2);
+  expected = (unsigned char *)malloc(CHECK_PIXELS * 3);
+  got = (unsigned char *)malloc(CHECK_PIXELS * 3 + 1);
+
+  if ((NULL == yuyv) || (NULL == expected) || (NULL == got))
+    {
+      retval = -1;
+    }
+  else
+    {
+      seed = 1;
+      for (i = 0; i < CHECK_PIXELS * 2; i++)
+	{
+	  seed = seed * 1103515245u + 12345u;
+	  yuyv[i] = (unsigned char)(seed >> 16);
+	}
+
+      convert_yuyv_to_rgb24_scalar(yuyv, expected, CHECK_PIXELS);
+      func(yuyv, got + 1, CHECK_PIXELS);
+
+      retval = (0 == memcmp(expected, got + 1, CHECK_PIXELS * 3)) ? 0 : -1;
+    }
+
+  free(yuyv);
+  free(expected);
+  free(got);
+
+  return(retval);
+}
@@ -0,0 +1,72 @@
+/* *************************************************************************
+* NAME: glutcam/colorconvert.h
+*
+* DESCRIPTION:
+*
+* this is the header file for the functions exported from colorconvert.c
+*
+* PROCESS:
+*
+* select_convert_kernel picks the YUYV->RGB24 kernel to use (or the
+*   best one this CPU supports for CONVERT_AUTO), checks it against the
+*   scalar version and returns the one it settled on
+*
+* convert_kernel_in_use / convert_kernel_name report the choice
+*
+* convert_yuyv_to_rgb24 converts npixels pixels of packed YUYV into
+*   packed RGB24 with the selected kernel
+*
+* convert_yuyv_to_rgb24_bands converts a whole image, split into bands
+*   of rows shared out over a worker pool
+*
+* convert_yuyv_to_rgb24_scalar is the plain C reference. every SIMD
+*   kernel produces exactly the same bytes it does.
+*
+* GLOBALS: none
+*
+* REFERENCES: ITU-R BT.601
+*
+* LIMITATIONS:
+*
+* npixels must be even: YUYV pixels come in pairs.
+*
+* REVISION HISTORY:
+*
+*   STR                Description                          Author
+*
+*   17-Oct-26          initial coding
+*   17-Oct-26          convert_yuyv_to_rgb24_bands
+*
+* TARGET: Linux C
+*
+* This software is in the public domain. if it breaks you get to keep
+* both pieces.
+*
+* ************************************************************************* */
+
+#ifndef	__COLORCONVERT_H__
+#define	__COLORCONVERT_H__
+
+#include "glutcam.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+extern Convertkernel_t select_convert_kernel(Convertkernel_t requested);
+extern Convertkernel_t convert_kernel_in_use(void);
+extern const char * convert_kernel_name(Convertkernel_t kernel);
+extern void convert_yuyv_to_rgb24(const unsigned char * yuyv,
+				  unsigned char * rgb, int npixels);
+extern void convert_yuyv_to_rgb24_bands(Workpool_t * pool,
+					const unsigned char * yuyv,
+					unsigned char * rgb, int width,
+					int height, int rgbstride);
+extern void convert_yuyv_to_rgb24_scalar(const unsigned char * yuyv,
+					 unsigned char * rgb, int npixels);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	//__COLORCONVERT_H__
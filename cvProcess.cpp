@@ -5,40 +5,193 @@
 #include "opencv2/features2d/features2d.hpp"
 #include "opencv2/objdetect/objdetect.hpp"
 #include <vector>
+#include <algorithm>
+#include <functional>
 
 using namespace cv;
 
 #endif
 
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
 #include "cvProcess.h"
+#include "colorconvert.h"
+#include "featurematch.h"
+#include "workpool.h"
+#include "timeutil.h"
+#include "stagestats.h"
+#include "trace.h"
 using namespace std;
 
 int g_toProcess = 0;
+#ifdef	DEF_RGB
+int g_verifyMatches = 0; //check every match against BFMatcher's
+int g_flowInterval = 0; //>1: detect every nth frame, optical flow between
+#endif
 
 #ifdef	DEF_RGB
 
+//TRACKER_RATE_USEC - how often the tracker frame rate is recomputed
+#define TRACKER_RATE_USEC 5000000LL
+
 static IplImage *pyuv;
-static BriefDescriptorExtractor brief(32);
-static vector<DMatch> matches;
-static BFMatcher desc_matcher(NORM_HAMMING);
-static vector<Point2f> train_pts, query_pts;
-static vector<KeyPoint> train_kpts, query_kpts;
-static vector<unsigned char> match_mask;
-static bool ref_live = true;
-static Mat gray, train_desc, query_desc;
+static Workpool_t convert_pool;
+static int process_users; //sources between init_process and fini_process
 const int DESIRED_FTRS = 500;
-static GridAdaptedFeatureDetector detector(new FastFeatureDetector(10, true), DESIRED_FTRS, 4, 4);
-static Mat H_prev = Mat::eye(3, 3, CV_32FC1);
+//TRACKER_MAX_FTRS - keypoints a frame's buffers are sized for; more
+//than that still works, the first such frame allocates
+const int TRACKER_MAX_FTRS = 2 * DESIRED_FTRS;
+//TRACKER_WARMUP_FRAMES - tracked frames before allocations are counted
+const unsigned int TRACKER_WARMUP_FRAMES = 20;
+//the grid detect_features spreads DESIRED_FTRS over, GridAdaptedFeatureDetector's
+const int TRACKER_GRID_COLS = 4, TRACKER_GRID_ROWS = 4;
+const int TRACKER_GRID_CELLS = TRACKER_GRID_COLS * TRACKER_GRID_ROWS;
+//a cell's FAST threshold starts at FAST_START_THRESHOLD (what the
+//whole frame used to get) and moves between the other two
+const int FAST_START_THRESHOLD = 10, FAST_MIN_THRESHOLD = 4, FAST_MAX_THRESHOLD = 80;
+//FAST's circle, and the border it doesn't score. a cell is read
+//FAST_MARGIN past its edges: far enough that the pixels just outside
+//it get scores for non-maximum suppression to compare against
+const int FAST_RADIUS = 3;
+const int FAST_MARGIN = FAST_RADIUS + 1;
+//optical flow (g_flowInterval) runs on the grey frame scaled by
+//FLOW_SCALE, in FLOW_WINDOW pixel windows, FLOW_LEVELS pyramid levels up
+const double FLOW_SCALE = 0.5;
+const int FLOW_WINDOW = 11, FLOW_LEVELS = 2;
+
+//the tracker's own: only tracker_main touches these
+static BriefDescriptorExtractor brief(32);
+static BFMatcher desc_matcher(NORM_HAMMING); //only to check against (g_verifyMatches)
+static Workpool_t detect_pool; //FAST, a cell a job
+
+//one cell of the detection grid: its part of the frame, its FAST
+//threshold and what the last frame's FAST found there
+struct Detectcell {
+  Rect area;
+  int threshold;
+  int found; //before keeping the best
+  vector<KeyPoint> kpts;
+  vector<float> responses; //scratch for picking the best
+};
+
+//the frame cut into cells, each detected on its own (detect_cell),
+//all at once on detect_pool
+struct Detectgrid {
+  Detectcell cells[TRACKER_GRID_CELLS];
+  int width, height; //the frame size the cells were laid out for
+  int per_cell; //keypoints a cell keeps
+  const Mat *gray; //the frame, while detect_pool works on it
+};
+
+//everything the tracker keeps from frame to frame, allocated once
+//(init_tracker_context) and reused: this frame's keypoints and
+//descriptors are kpts[cur], desc[cur] and the last frame's the other
+//pair, so moving on to the next frame is flipping cur, not copying.
+//H is H_prev, Hinv its inverse, row major.
+struct Trackercontext {
+  vector<KeyPoint> kpts[2];
+  Mat desc[2];
+  int cur;
+  Detectgrid detect;
+  vector<KeyPoint> test_kpts; //this frame's keypoints warped back by Hinv
+  vector<DMatch> matches;
+  vector<Point2f> train_pts, query_pts;
+  vector<unsigned char> match_mask;
+  Featuregrid_t grid; //last frame's keypoints by position, to match in
+  vector<float> query_xy, train_xy; //x, y pairs for match_features_windowed
+  vector<Featurematch_t> fmatches;
+  vector<DMatch> ref_matches; //BFMatcher's, when verifying
+  vector<unsigned char> maskbuf; //under the windowed matching mask
+  double H[9], Hinv[9];
+  //optical flow between detections (g_flowInterval)
+  int since_detect; //frames since the last detection, counting it
+  bool need_detect; //H was lost: detect the next frame, whatever
+  Mat small[2]; //the frame scaled by FLOW_SCALE (a pyramid may keep it)
+  vector<Mat> pyr[2]; //...and its pyramid; slots as kpts
+  vector<Point2f> flow_from, flow_to;
+  vector<unsigned char> flow_status;
+  vector<float> flow_err;
+  Mat flow_desc[2]; //followed keypoints' descriptors: desc[i] is rows of it
+};
+static Trackercontext ctx;
 
+//heap allocations so far on the calling thread, where the program
+//counts them (glutcam_bench does, see bench.c); the tracker adds up
+//each stage's. not linked in anywhere else
+extern "C" unsigned long long thread_allocations(void) __attribute__((weak));
+enum { ALLOC_DETECT, ALLOC_DESCRIBE, ALLOC_MATCH, ALLOC_HOMOGRAPHY, ALLOC_FLOW, ALLOC_OWN, N_ALLOC_STAGES };
+static unsigned long long stage_allocs[N_ALLOC_STAGES];
+static unsigned int alloc_frames;
+//g_verifyMatches: frames checked, and those whose matches weren't BFMatcher's
+static unsigned int verify_frames, verify_mismatches;
+//tracked frames that were detected, and followed by optical flow
+static unsigned int frames_detected, frames_followed;
+
+//what the tracker found in a frame, for the display to draw over
+//whatever frame it's showing
+struct Trackresult {
+  vector<KeyPoint> train_kpts, query_kpts, test_kpts;
+  vector<DMatch> matches; //empty: too few to draw
+  vector<unsigned char> match_mask;
+};
+
+//the tracker thread and what it shares with process(), all under
+//tracker_lock: process() leaves the newest grey frame in tracker_in
+//(replacing one the tracker hasn't got to: it skips frames when it's
+//behind) and the tracker swaps its results into published
+static pthread_t tracker_thread;
+static pthread_mutex_t tracker_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t tracker_wake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t tracker_idle = PTHREAD_COND_INITIALIZER;
+static bool tracker_running, tracker_has_frame, tracker_busy, tracker_reset;
+static Mat tracker_in;
+static Trackresult published;
+static unsigned int frames_offered, frames_skipped, frames_tracked;
+static unsigned int rate_frames;
+static long long tracker_start_usec, rate_start_usec;
+static float tracker_rate;
+static Mat offer; //process()'s: the grey frame before it's handed over
+
+static void *tracker_main(void *arg);
+static void track_frame(const Mat &gray, Trackresult &result);
+static void draw_track_result(const Trackresult &result, Mat &frame);
+static void swap_results(Trackresult &a, Trackresult &b);
+static void init_tracker_context(void);
+static void reset_homography(void);
+static void detect_features(const Mat &gray, vector<KeyPoint> &kpts);
+static void layout_detect_grid(Detectgrid &grid, int width, int height);
+static void detect_cell(void *arg, int job);
+static bool follow_features(const vector<KeyPoint> &train, const Mat &train_desc,
+                            vector<KeyPoint> &query, Mat &query_desc);
+static bool match_windowed(const vector<KeyPoint> &query, const Mat &query_desc,
+                           const vector<KeyPoint> &train, const Mat &train_desc);
+static void verify_matches(const vector<KeyPoint> &query, const Mat &query_desc,
+                           const vector<KeyPoint> &train, const Mat &train_desc);
+static unsigned long long count_allocations(int stage, unsigned long long since);
+
+//the display asks; the tracker resets H before its next frame. what
+//it found so far, and the frame it hasn't got to, may be another
+//source's (show_next_source): they're dropped
 void resetH()
 {
-        H_prev = Mat::eye(3, 3, CV_32FC1);
+  pthread_mutex_lock(&tracker_lock);
+  tracker_reset = true;
+  tracker_has_frame = false;
+  published.train_kpts.clear();
+  published.query_kpts.clear();
+  published.test_kpts.clear();
+  published.matches.clear();
+  published.match_mask.clear();
+  pthread_mutex_unlock(&tracker_lock);
 }
 
 namespace
 {
     void drawMatchesRelative(const vector<KeyPoint>& train, const vector<KeyPoint>& query,
-        std::vector<cv::DMatch>& matches, Mat& img, const vector<unsigned char>& mask = vector<
+        const std::vector<cv::DMatch>& matches, Mat& img, const vector<unsigned char>& mask = vector<
         unsigned char> ())
     {
         for (int i = 0; i < (int)matches.size(); i++)
@@ -55,37 +208,73 @@ namespace
         }
     }
 
-    //Takes a descriptor and turns it into an xy point
-    void keypoints2points(const vector<KeyPoint>& in, vector<Point2f>& out)
+    //Uses homography H (row major) to warp keypoints to their new planar
+    //position: perspectiveTransform, without the Mats around it
+    void warpKeypoints(const double H[9], const vector<KeyPoint>& in, vector<KeyPoint>& out)
     {
-        out.clear();
-        out.reserve(in.size());
+        out.resize(in.size());
         for (size_t i = 0; i < in.size(); ++i)
         {
-            out.push_back(in[i].pt);
+            double x = in[i].pt.x, y = in[i].pt.y;
+            double w = H[6] * x + H[7] * y + H[8];
+
+            w = (fabs(w) > DBL_EPSILON) ? 1.0 / w : 0.0;
+            out[i] = KeyPoint(Point2f((float)((H[0] * x + H[1] * y + H[2]) * w),
+                                      (float)((H[3] * x + H[4] * y + H[5]) * w)), 1);
         }
     }
 
-    //Takes an xy point and appends that to a keypoint structure
-    void points2keypoints(const vector<Point2f>& in, vector<KeyPoint>& out)
+    //windowedMatchingMask, into mask (a header over buf) instead of a
+    //new Mat: query i may match train j only if they're within
+    //maxDeltaX, maxDeltaY of each other
+    void windowedMask(const vector<KeyPoint>& query, const vector<KeyPoint>& train,
+        float maxDeltaX, float maxDeltaY, vector<unsigned char>& buf, Mat& mask)
     {
-        out.clear();
-        out.reserve(in.size());
-        for (size_t i = 0; i < in.size(); ++i)
+        int n1 = (int)query.size(), n2 = (int)train.size();
+
+        if (0 == n1 || 0 == n2)
         {
-            out.push_back(KeyPoint(in[i], 1));
+            mask = Mat();
+            return;
+        }
+        if (buf.size() < (size_t)n1 * n2)
+            buf.resize((size_t)n1 * n2);
+        mask = Mat(n1, n2, CV_8UC1, &buf[0]);
+        for (int i = 0; i < n1; i++)
+        {
+            unsigned char *row = &buf[(size_t)i * n2];
+            for (int j = 0; j < n2; j++)
+            {
+                row[j] = fabs(train[j].pt.x - query[i].pt.x) < maxDeltaX &&
+                    fabs(train[j].pt.y - query[i].pt.y) < maxDeltaY;
+            }
         }
     }
 
-    //Uses computed homography H to warp original input points to new planar position
-    void warpKeypoints(const Mat& H, const vector<KeyPoint>& in, vector<KeyPoint>& out)
+    //the inverse of 3x3 H (row major), by cofactors; the identity if H
+    //is singular
+    void invert3x3(const double H[9], double out[9])
     {
-        vector<Point2f> pts;
-        keypoints2points(in, pts);
-        vector<Point2f> pts_w(pts.size());
-        Mat m_pts_w(pts_w);
-        perspectiveTransform(Mat(pts), m_pts_w, H);
-        points2keypoints(pts_w, out);
+        double det = H[0] * (H[4] * H[8] - H[5] * H[7])
+            - H[1] * (H[3] * H[8] - H[5] * H[6])
+            + H[2] * (H[3] * H[7] - H[4] * H[6]);
+
+        if (fabs(det) <= DBL_EPSILON)
+        {
+            for (int i = 0; i < 9; i++)
+                out[i] = (0 == i % 4) ? 1.0 : 0.0;
+            return;
+        }
+        det = 1.0 / det;
+        out[0] = (H[4] * H[8] - H[5] * H[7]) * det;
+        out[1] = (H[2] * H[7] - H[1] * H[8]) * det;
+        out[2] = (H[1] * H[5] - H[2] * H[4]) * det;
+        out[3] = (H[5] * H[6] - H[3] * H[8]) * det;
+        out[4] = (H[0] * H[8] - H[2] * H[6]) * det;
+        out[5] = (H[2] * H[3] - H[0] * H[5]) * det;
+        out[6] = (H[3] * H[7] - H[4] * H[6]) * det;
+        out[7] = (H[1] * H[6] - H[0] * H[7]) * det;
+        out[8] = (H[0] * H[4] - H[1] * H[3]) * det;
     }
 
     //Converts matching indices to xy points
@@ -114,41 +303,577 @@ namespace
     }
 }
 
+//turn yuv into rgb in prgb, and nothing else: the mosaic's tiles
+//other than the chosen one, which the tracker doesn't follow
+void convert_frame(char *yuvData, IplImage *prgb)
+{
+  long long t = monotonic_usec();
+
+  if( CONVERT_OPENCV == convert_kernel_in_use() ) {
+    pyuv->imageData = yuvData;
+    cvCvtColor(pyuv, prgb, CV_YUV2RGB_YUYV);
+  } else {
+    //bands converted by convert_pool, straight into the mapped PBO
+    convert_yuyv_to_rgb24_bands(&convert_pool, (const unsigned char *)yuvData,
+                                (unsigned char *)prgb->imageData,
+                                prgb->width, prgb->height, prgb->widthStep);
+  }
+  record_stage_since(STAGE_CONVERT, t);
+}
+
+//convert_frame, then hand the frame to the tracker. there's one
+//tracker, so only one source's frames go through here at a time
 void process(char *yuvData, IplImage *prgb)
 {
-  //turn yuv into rgb in prgb
-  pyuv->imageData = yuvData;        
-  cvCvtColor(pyuv, prgb, CV_YUV2RGB_YUYV);
-  if( !g_toProcess ) return;
-  
+  convert_frame(yuvData, prgb);
+  if( !g_toProcess || !tracker_running ) return;
+
+  //hand the tracker this frame, in grey, and draw what it last found
+  //over it: the display never waits for the tracking itself
   Mat frame(prgb);
-  cvtColor(frame, gray, CV_RGB2GRAY);
+  cvtColor(frame, offer, CV_RGB2GRAY);
+
+  pthread_mutex_lock(&tracker_lock);
+  std::swap(offer, tracker_in);
+  if( tracker_has_frame ) frames_skipped++; //it never got to that one
+  tracker_has_frame = true;
+  frames_offered++;
+  pthread_cond_signal(&tracker_wake);
+  draw_track_result(published, frame);
+  pthread_mutex_unlock(&tracker_lock);
+}
+
+//the tracker thread: track the newest frame process() left, publish
+//the results, wait for the next one. runs at whatever rate tracking
+//allows, independent of the display's
+static void *tracker_main(void *arg)
+{
+  Mat gray;
+  Trackresult result;
+  long long now;
+
+  (void)arg;
+  trace_thread_name("tracker");
+  pthread_mutex_lock(&tracker_lock);
+  while( tracker_running ) {
+    if( !tracker_has_frame ) {
+      pthread_cond_wait(&tracker_wake, &tracker_lock);
+      continue;
+    }
+    std::swap(gray, tracker_in);
+    tracker_has_frame = false;
+    tracker_busy = true;
+    if( tracker_reset ) {
+      reset_homography();
+      tracker_reset = false;
+    }
+    pthread_mutex_unlock(&tracker_lock);
+
+    track_frame(gray, result);
+
+    pthread_mutex_lock(&tracker_lock);
+    if( !tracker_reset ) swap_results(result, published); //else it's stale
+    frames_tracked++;
+    tracker_busy = false;
+    pthread_cond_broadcast(&tracker_idle);
+    now = monotonic_usec();
+    if( TRACKER_RATE_USEC <= now - rate_start_usec ) {
+      tracker_rate = rate_frames * 1e6f / (float)(now - rate_start_usec);
+      rate_frames = 0;
+      rate_start_usec = now;
+    }
+    rate_frames++;
+  }
+  pthread_mutex_unlock(&tracker_lock);
+  return NULL;
+}
+
+//FAST, BRIEF, windowed matching against the last frame and RANSAC
+//for the homography between them; what to draw goes in result.
+//with g_flowInterval, only every nth frame (or the one after H is
+//lost) is detected: the ones between follow the last frame's
+//keypoints by optical flow, and RANSAC goes from where they were to
+//where they went, the same way.
+//all in ctx's buffers: after the first few frames nothing here
+//allocates (OpenCV's detector, BRIEF, optical flow and findHomography
+//still do, inside; count_allocations says how much)
+static void track_frame(const Mat &gray, Trackresult &result)
+{
+  long long t = monotonic_usec();
+  unsigned long long a = count_allocations(-1, 0);
+  vector<KeyPoint> &query_kpts = ctx.kpts[ctx.cur];
+  vector<KeyPoint> &train_kpts = ctx.kpts[1 - ctx.cur];
+  Mat &query_desc = ctx.desc[ctx.cur];
+  Mat &train_desc = ctx.desc[1 - ctx.cur];
+  bool followed = false;
 
-  detector.detect(gray, query_kpts); //Find interest points
-  brief.compute(gray, query_kpts, query_desc); //Compute brief descriptors at each keypoint location
+  result.test_kpts.clear();
+  result.matches.clear();
+  if( 1 < g_flowInterval ) {
+    //every frame's pyramid: the next frame may follow from this one
+    resize(gray, ctx.small[ctx.cur], Size(), FLOW_SCALE, FLOW_SCALE, INTER_AREA);
+    buildOpticalFlowPyramid(ctx.small[ctx.cur], ctx.pyr[ctx.cur], Size(FLOW_WINDOW, FLOW_WINDOW), FLOW_LEVELS);
+    if( !ctx.need_detect && ctx.since_detect < g_flowInterval )
+      followed = follow_features(train_kpts, train_desc, query_kpts, query_desc);
+    t = record_stage_since(STAGE_FLOW, t);
+    a = count_allocations(ALLOC_FLOW, a);
+  } else ctx.pyr[ctx.cur].clear();
+
+  if( followed ) {
+    ctx.since_detect++;
+    frames_followed++;
+    warpKeypoints(ctx.Hinv, query_kpts, ctx.test_kpts);
+  } else {
+    ctx.since_detect = 1;
+    ctx.need_detect = false;
+    frames_detected++;
+    detect_features(gray, query_kpts); //Find interest points
+    t = record_stage_since(STAGE_DETECT, t);
+    a = count_allocations(ALLOC_DETECT, a);
+    brief.compute(gray, query_kpts, query_desc); //Compute brief descriptors at each keypoint location
+    t = record_stage_since(STAGE_DESCRIBE, t);
+    a = count_allocations(ALLOC_DESCRIBE, a);
+  }
+  if (!followed && !train_kpts.empty()) {
+    warpKeypoints(ctx.Hinv, query_kpts, ctx.test_kpts);
+    a = count_allocations(ALLOC_OWN, a);
+    if( !match_windowed(ctx.test_kpts, query_desc, train_kpts, train_desc) ) {
+      Mat mask; //not BRIEF-32 as we know it: OpenCV's way
+      windowedMask(ctx.test_kpts, train_kpts, 25, 25, ctx.maskbuf, mask);
+      desc_matcher.match(query_desc, train_desc, ctx.matches, mask);
+    }
+    t = record_stage_since(STAGE_MATCH, t);
+    a = count_allocations(ALLOC_MATCH, a);
+    if( g_verifyMatches ) { //not timed or counted
+      verify_matches(ctx.test_kpts, query_desc, train_kpts, train_desc);
+      t = monotonic_usec();
+      a = count_allocations(-1, a);
+    }
+  }
   if (!train_kpts.empty()) {
-    vector<KeyPoint> test_kpts;
-    warpKeypoints(H_prev.inv(), query_kpts, test_kpts);
-    Mat mask = windowedMatchingMask(test_kpts, train_kpts, 25, 25);
-    desc_matcher.match(query_desc, train_desc, matches, mask);
-    drawKeypoints(frame, test_kpts, frame, Scalar(255, 0, 0), DrawMatchesFlags::DRAW_OVER_OUTIMG);
-    matches2points(train_kpts, query_kpts, matches, train_pts, query_pts);
-
-    if (matches.size() > 5) {
-      Mat H = findHomography(train_pts, query_pts, RANSAC, 4, match_mask);
-      if (countNonZero(Mat(match_mask)) > 15) {
-        H_prev = H;
-      } else resetH();
-      drawMatchesRelative(train_kpts, query_kpts, matches, frame, match_mask);
-    } else resetH();
+    matches2points(train_kpts, query_kpts, ctx.matches, ctx.train_pts, ctx.query_pts);
+    result.test_kpts = ctx.test_kpts;
+
+    if (ctx.matches.size() > 5) {
+      a = count_allocations(ALLOC_OWN, a);
+      Mat H = findHomography(ctx.train_pts, ctx.query_pts, RANSAC, 4, ctx.match_mask);
+      record_stage_since(STAGE_HOMOGRAPHY, t);
+      a = count_allocations(ALLOC_HOMOGRAPHY, a);
+      if (countNonZero(Mat(ctx.match_mask)) > 15 && !H.empty()) {
+        for (int i = 0; i < 9; i++)
+          ctx.H[i] = H.at<double>(i / 3, i % 3);
+        invert3x3(ctx.H, ctx.Hinv);
+      } else reset_homography();
+      result.train_kpts = train_kpts;
+      result.query_kpts = query_kpts;
+      result.matches = ctx.matches;
+      result.match_mask = ctx.match_mask;
+    } else reset_homography();
   } else {
-    H_prev = Mat::eye(3, 3, CV_32FC1);
-    Mat out;
-    drawKeypoints(gray, query_kpts, out);
-    frame = out;
+    reset_homography();
   }
-  train_kpts = query_kpts;
-  query_desc.copyTo(train_desc);
+  ctx.cur = 1 - ctx.cur; //this frame's keypoints are the next one's train
+  count_allocations(ALLOC_OWN, a);
+  if( TRACKER_WARMUP_FRAMES <= frames_tracked ) alloc_frames++;
+}
+
+//pyramidal Lucas-Kanade from the last frame's keypoints to this
+//frame, on the FLOW_SCALE pyramids. the ones it follows (still in the
+//frame) are this frame's keypoints, keep the descriptors they were
+//detected with and are matched to where they came from, so
+//matches2points and findHomography take it from there.
+//false if there's nothing to follow, or no pyramid to follow it in
+static bool follow_features(const vector<KeyPoint> &train, const Mat &train_desc,
+                            vector<KeyPoint> &query, Mat &query_desc)
+{
+  const vector<Mat> &prev = ctx.pyr[1 - ctx.cur], &next = ctx.pyr[ctx.cur];
+  Mat &store = ctx.flow_desc[ctx.cur];
+  int n = (int)train.size(), kept = 0;
+  float width = (float)(ctx.small[ctx.cur].cols / FLOW_SCALE);
+  float height = (float)(ctx.small[ctx.cur].rows / FLOW_SCALE);
+  size_t row_bytes;
+
+  if( 0 == n || n != train_desc.rows || prev.empty() || next.empty()
+      || prev[0].rows != next[0].rows || prev[0].cols != next[0].cols )
+    return false;
+
+  ctx.flow_from.resize(n);
+  for (int i = 0; i < n; i++)
+    ctx.flow_from[i] = Point2f((float)(train[i].pt.x * FLOW_SCALE), (float)(train[i].pt.y * FLOW_SCALE));
+  calcOpticalFlowPyrLK(prev, next, ctx.flow_from, ctx.flow_to, ctx.flow_status, ctx.flow_err,
+                       Size(FLOW_WINDOW, FLOW_WINDOW), FLOW_LEVELS);
+
+  //the descriptors go in this slot's store, a frame's worth at a time
+  if( store.rows < n || store.cols != train_desc.cols || store.type() != train_desc.type() )
+    store.create(std::max(n, TRACKER_MAX_FTRS), train_desc.cols, train_desc.type());
+  row_bytes = (size_t)train_desc.cols * train_desc.elemSize();
+  query.clear();
+  ctx.matches.clear();
+  for (int i = 0; i < n; i++) {
+    KeyPoint kp = train[i];
+
+    if( !ctx.flow_status[i] ) continue;
+    kp.pt = Point2f((float)(ctx.flow_to[i].x / FLOW_SCALE), (float)(ctx.flow_to[i].y / FLOW_SCALE));
+    if( kp.pt.x < 0 || kp.pt.y < 0 || kp.pt.x >= width || kp.pt.y >= height ) continue;
+    query.push_back(kp);
+    memcpy(store.ptr(kept), train_desc.ptr(i), row_bytes);
+    ctx.matches.push_back(DMatch(kept, i, 0.f));
+    kept++;
+  }
+  query_desc = store.rowRange(0, kept);
+  return true;
+}
+
+//GridAdaptedFeatureDetector(FAST, DESIRED_FTRS, 4, 4), with the cells
+//detected in parallel on detect_pool and each cell's FAST threshold
+//following its scene: lowered while it finds fewer than it keeps,
+//raised while it finds more than twice that, ready for the next
+//frame. the cells go into kpts in order, so the result doesn't
+//depend on which thread did what. (count_allocations only sees this
+//thread: what FAST allocates on the workers isn't in it)
+static void detect_features(const Mat &gray, vector<KeyPoint> &kpts)
+{
+  Detectgrid &grid = ctx.detect;
+
+  if( gray.cols != grid.width || gray.rows != grid.height )
+    layout_detect_grid(grid, gray.cols, gray.rows);
+  grid.gray = &gray;
+  run_workpool(&detect_pool, detect_cell, &grid, TRACKER_GRID_CELLS);
+  grid.gray = NULL;
+
+  kpts.clear();
+  for (int c = 0; c < TRACKER_GRID_CELLS; c++) {
+    Detectcell &cell = grid.cells[c];
+    int step = cell.threshold / 8 + 1;
+
+    kpts.insert(kpts.end(), cell.kpts.begin(), cell.kpts.end());
+    if( cell.found < grid.per_cell )
+      cell.threshold = std::max(FAST_MIN_THRESHOLD, cell.threshold - step);
+    else if( cell.found > 2 * grid.per_cell )
+      cell.threshold = std::min(FAST_MAX_THRESHOLD, cell.threshold + step);
+  }
+}
+
+//cells of (nearly) equal area, as GridAdaptedFeatureDetector cuts
+//them, each starting at FAST_START_THRESHOLD
+static void layout_detect_grid(Detectgrid &grid, int width, int height)
+{
+  grid.width = width;
+  grid.height = height;
+  grid.per_cell = DESIRED_FTRS / TRACKER_GRID_CELLS;
+  for (int r = 0; r < TRACKER_GRID_ROWS; r++) {
+    for (int c = 0; c < TRACKER_GRID_COLS; c++) {
+      Detectcell &cell = grid.cells[r * TRACKER_GRID_COLS + c];
+      int x0 = c * width / TRACKER_GRID_COLS, x1 = (c + 1) * width / TRACKER_GRID_COLS;
+      int y0 = r * height / TRACKER_GRID_ROWS, y1 = (r + 1) * height / TRACKER_GRID_ROWS;
+
+      cell.area = Rect(x0, y0, x1 - x0, y1 - y0);
+      cell.threshold = FAST_START_THRESHOLD;
+      cell.found = 0;
+      cell.kpts.clear();
+      cell.kpts.reserve(4 * grid.per_cell);
+      cell.responses.reserve(4 * grid.per_cell);
+    }
+  }
+}
+
+//detect_pool's job: FAST on one cell, read FAST_MARGIN past its edges
+//so corners on the cell's border are found (and suppressed) as they
+//would be in the whole frame; keep the ones in the cell, and of
+//those the per_cell strongest (and any tied with the weakest of
+//them, as KeyPointsFilter::retainBest does), in the order FAST gave
+static void detect_cell(void *arg, int job)
+{
+  Detectgrid &grid = *(Detectgrid *)arg;
+  Detectcell &cell = grid.cells[job];
+  const Rect &a = cell.area;
+  int x0 = std::max(0, a.x - FAST_MARGIN), y0 = std::max(0, a.y - FAST_MARGIN);
+  int x1 = std::min(grid.width, a.x + a.width + FAST_MARGIN);
+  int y1 = std::min(grid.height, a.y + a.height + FAST_MARGIN);
+  size_t i, kept;
+
+  cell.kpts.clear();
+  if( 0 >= a.width || 0 >= a.height ) {
+    cell.found = 0;
+    return;
+  }
+  FAST((*grid.gray)(Rect(x0, y0, x1 - x0, y1 - y0)), cell.kpts, cell.threshold, true);
+
+  kept = 0;
+  for (i = 0; i < cell.kpts.size(); i++) {
+    KeyPoint kp = cell.kpts[i];
+
+    kp.pt.x += x0;
+    kp.pt.y += y0;
+    if( kp.pt.x >= a.x && kp.pt.x < a.x + a.width
+        && kp.pt.y >= a.y && kp.pt.y < a.y + a.height )
+      cell.kpts[kept++] = kp;
+  }
+  cell.kpts.resize(kept);
+  cell.found = (int)kept;
+
+  if( cell.found > grid.per_cell ) {
+    float weakest;
+
+    cell.responses.resize(kept);
+    for (i = 0; i < kept; i++)
+      cell.responses[i] = cell.kpts[i].response;
+    std::nth_element(cell.responses.begin(), cell.responses.begin() + grid.per_cell - 1,
+                     cell.responses.end(), std::greater<float>());
+    weakest = cell.responses[grid.per_cell - 1];
+    kept = 0;
+    for (i = 0; i < cell.kpts.size(); i++)
+      if( cell.kpts[i].response >= weakest )
+        cell.kpts[kept++] = cell.kpts[i];
+    cell.kpts.resize(kept);
+  }
+}
+
+//each of query's BRIEF-32 descriptors matched to the closest of
+//train's within 25 pixels (match_features_windowed: a grid and SIMD
+//Hamming distances instead of the N x M mask and distances), into
+//ctx.matches, as BFMatcher would have: same matches, same order.
+//false if the descriptors aren't the kind it takes
+static bool match_windowed(const vector<KeyPoint> &query, const Mat &query_desc,
+                           const vector<KeyPoint> &train, const Mat &train_desc)
+{
+  int nquery = query_desc.rows, ntrain = train_desc.rows, n;
+
+  ctx.matches.clear();
+  if( 0 == nquery || 0 == ntrain ) return true;
+  if( CV_8U != query_desc.depth() || CV_8U != train_desc.depth()
+      || BRIEF_BYTES != query_desc.cols * query_desc.channels()
+      || BRIEF_BYTES != train_desc.cols * train_desc.channels()
+      || !query_desc.isContinuous() || !train_desc.isContinuous()
+      || (int)query.size() != nquery || (int)train.size() != ntrain )
+    return false;
+
+  ctx.query_xy.resize(2 * nquery);
+  ctx.train_xy.resize(2 * ntrain);
+  ctx.fmatches.resize(nquery);
+  for (int i = 0; i < nquery; i++) {
+    ctx.query_xy[2 * i] = query[i].pt.x;
+    ctx.query_xy[2 * i + 1] = query[i].pt.y;
+  }
+  for (int i = 0; i < ntrain; i++) {
+    ctx.train_xy[2 * i] = train[i].pt.x;
+    ctx.train_xy[2 * i + 1] = train[i].pt.y;
+  }
+  n = match_features_windowed(&ctx.grid, &ctx.query_xy[0], query_desc.ptr<unsigned char>(0),
+                              nquery, &ctx.train_xy[0], train_desc.ptr<unsigned char>(0),
+                              ntrain, 25, 25, &ctx.fmatches[0]);
+  if( 0 > n ) return false;
+  for (int i = 0; i < n; i++)
+    ctx.matches.push_back(DMatch(ctx.fmatches[i].query, ctx.fmatches[i].train,
+                                 (float)ctx.fmatches[i].distance));
+  return true;
+}
+
+//match the old way too, windowedMask and BFMatcher, and complain if
+//the answer isn't exactly ctx.matches
+static void verify_matches(const vector<KeyPoint> &query, const Mat &query_desc,
+                           const vector<KeyPoint> &train, const Mat &train_desc)
+{
+  Mat mask;
+  size_t i;
+
+  windowedMask(query, train, 25, 25, ctx.maskbuf, mask);
+  desc_matcher.match(query_desc, train_desc, ctx.ref_matches, mask);
+  verify_frames++;
+  for (i = 0; i < ctx.ref_matches.size() && i < ctx.matches.size(); i++)
+    if( ctx.ref_matches[i].queryIdx != ctx.matches[i].queryIdx
+        || ctx.ref_matches[i].trainIdx != ctx.matches[i].trainIdx
+        || ctx.ref_matches[i].distance != ctx.matches[i].distance )
+      break;
+  if( i < ctx.ref_matches.size() || i < ctx.matches.size() ) {
+    if( 0 == verify_mismatches++ )
+      fprintf(stderr, "Error: tracker frame %u: %u matches, BFMatcher %u,"
+              " first difference at %u\n", frames_tracked,
+              (unsigned int)ctx.matches.size(), (unsigned int)ctx.ref_matches.size(),
+              (unsigned int)i);
+  }
+}
+
+//buffers for TRACKER_MAX_FTRS keypoints, so a frame doesn't have to
+//grow them. (BRIEF makes new descriptor Mats every time: nothing to
+//size for it)
+static void init_tracker_context(void)
+{
+  for (int i = 0; i < 2; i++) {
+    ctx.kpts[i].clear();
+    ctx.kpts[i].reserve(TRACKER_MAX_FTRS);
+    ctx.desc[i].release();
+  }
+  ctx.cur = 0;
+  ctx.detect.width = ctx.detect.height = 0; //laid out on the first frame
+  ctx.test_kpts.reserve(TRACKER_MAX_FTRS);
+  ctx.since_detect = 0;
+  ctx.flow_from.reserve(TRACKER_MAX_FTRS);
+  ctx.flow_to.reserve(TRACKER_MAX_FTRS);
+  ctx.flow_status.reserve(TRACKER_MAX_FTRS);
+  ctx.flow_err.reserve(TRACKER_MAX_FTRS);
+  for (int i = 0; i < 2; i++) {
+    ctx.pyr[i].clear();
+    ctx.flow_desc[i].release();
+  }
+  ctx.matches.reserve(TRACKER_MAX_FTRS);
+  ctx.train_pts.reserve(TRACKER_MAX_FTRS);
+  ctx.query_pts.reserve(TRACKER_MAX_FTRS);
+  ctx.match_mask.reserve(TRACKER_MAX_FTRS);
+  ctx.query_xy.reserve(2 * TRACKER_MAX_FTRS);
+  ctx.train_xy.reserve(2 * TRACKER_MAX_FTRS);
+  ctx.fmatches.reserve(TRACKER_MAX_FTRS);
+  if( g_verifyMatches ) {
+    ctx.ref_matches.reserve(TRACKER_MAX_FTRS);
+    ctx.maskbuf.resize((size_t)TRACKER_MAX_FTRS * TRACKER_MAX_FTRS);
+  }
+  reset_homography();
+  memset(stage_allocs, 0, sizeof(stage_allocs));
+  alloc_frames = 0;
+  verify_frames = verify_mismatches = 0;
+  frames_detected = frames_followed = 0;
+}
+
+//H_prev back to the identity; with the tracking lost, the next frame
+//is detected rather than followed
+static void reset_homography(void)
+{
+  ctx.need_detect = true;
+  for (int i = 0; i < 9; i++)
+    ctx.H[i] = ctx.Hinv[i] = (0 == i % 4) ? 1.0 : 0.0;
+}
+
+//charge the allocations since since to stage (-1: nobody), once
+//warmed up; returns the count now
+static unsigned long long count_allocations(int stage, unsigned long long since)
+{
+  unsigned long long now;
+
+  if( !thread_allocations ) return 0;
+  now = thread_allocations();
+  if( 0 <= stage && TRACKER_WARMUP_FRAMES <= frames_tracked )
+    stage_allocs[stage] += now - since;
+  return now;
+}
+
+//the published results, over the frame being displayed
+static void draw_track_result(const Trackresult &result, Mat &frame)
+{
+  if( !result.test_kpts.empty() )
+    drawKeypoints(frame, result.test_kpts, frame, Scalar(255, 0, 0), DrawMatchesFlags::DRAW_OVER_OUTIMG);
+  if( !result.matches.empty() )
+    drawMatchesRelative(result.train_kpts, result.query_kpts, result.matches, frame, result.match_mask);
+}
+
+//wait for the tracker to publish what it makes of the last frame
+//process() gave it: for benchmarks, which want every frame tracked
+void finish_tracking(void)
+{
+  pthread_mutex_lock(&tracker_lock);
+  while( tracker_running && (tracker_has_frame || tracker_busy) )
+    pthread_cond_wait(&tracker_idle, &tracker_lock);
+  pthread_mutex_unlock(&tracker_lock);
+}
+
+//publish by swapping: the vectors trade buffers, nothing's copied
+static void swap_results(Trackresult &a, Trackresult &b)
+{
+  a.train_kpts.swap(b.train_kpts);
+  a.query_kpts.swap(b.query_kpts);
+  a.test_kpts.swap(b.test_kpts);
+  a.matches.swap(b.matches);
+  a.match_mask.swap(b.match_mask);
+}
+
+//the tracked frames counted after warm-up (0 if none were, or nothing
+//counts), and the allocations on the tracker thread over them: own in
+//its own code (matching and the rest), opencv inside OpenCV's calls
+//(detector, BRIEF, optical flow, findHomography). glutcam_bench -A
+//fails on own
+unsigned int tracker_allocations(unsigned long long *own, unsigned long long *opencv)
+{
+  *own = stage_allocs[ALLOC_MATCH] + stage_allocs[ALLOC_OWN];
+  *opencv = stage_allocs[ALLOC_DETECT] + stage_allocs[ALLOC_DESCRIBE] +
+    stage_allocs[ALLOC_HOMOGRAPHY] + stage_allocs[ALLOC_FLOW];
+  return thread_allocations ? alloc_frames : 0;
+}
+
+//frames tracked a second, over the last TRACKER_RATE_USEC
+float tracker_fps(void)
+{
+  return tracker_rate;
+}
+
+//start the tracker thread and its detect_pool; 0 if they're running
+static int start_tracker(void)
+{
+  if( start_workpool(&detect_pool, physical_core_count()) ) return -1;
+  tracker_running = true;
+  tracker_has_frame = tracker_busy = false;
+  tracker_reset = true;
+  frames_offered = frames_skipped = frames_tracked = rate_frames = 0;
+  tracker_rate = 0;
+  tracker_start_usec = rate_start_usec = monotonic_usec();
+  init_tracker_context();
+  fprintf(stderr, "tracker: %s hamming distances\n",
+          hamming_kernel_name(select_hamming_kernel(HAMMING_AUTO)));
+  if( pthread_create(&tracker_thread, NULL, tracker_main, NULL) ) {
+    perror("Error: unable to start the tracker thread");
+    tracker_running = false;
+    stop_workpool(&detect_pool);
+    return -1;
+  }
+  return 0;
+}
+
+//stop the tracker thread and say how it kept up with the display
+static void stop_tracker(void)
+{
+  double seconds;
+  int detect_threads = detect_pool.nthreads;
+
+  if( !tracker_running ) return;
+  pthread_mutex_lock(&tracker_lock);
+  tracker_running = false;
+  pthread_cond_signal(&tracker_wake);
+  pthread_cond_broadcast(&tracker_idle);
+  pthread_mutex_unlock(&tracker_lock);
+  pthread_join(tracker_thread, NULL);
+  stop_workpool(&detect_pool);
+
+  seconds = (monotonic_usec() - tracker_start_usec) / 1e6;
+  if( frames_offered && 0 < seconds )
+    fprintf(stderr, "tracker: %u of %u frames displayed tracked (%u skipped),"
+            " display %.2f fps, tracker %.2f fps\n", frames_tracked,
+            frames_offered, frames_skipped, frames_offered / seconds,
+            frames_tracked / seconds);
+  if( thread_allocations && alloc_frames )
+    fprintf(stderr, "tracker: heap allocations a frame (%u after %u warm-up):"
+            " detect %.2f describe %.2f match %.2f homography %.2f"
+            " flow %.2f tracker %.2f\n", alloc_frames, TRACKER_WARMUP_FRAMES,
+            (double)stage_allocs[ALLOC_DETECT] / alloc_frames,
+            (double)stage_allocs[ALLOC_DESCRIBE] / alloc_frames,
+            (double)stage_allocs[ALLOC_MATCH] / alloc_frames,
+            (double)stage_allocs[ALLOC_HOMOGRAPHY] / alloc_frames,
+            (double)stage_allocs[ALLOC_FLOW] / alloc_frames,
+            (double)stage_allocs[ALLOC_OWN] / alloc_frames);
+  if( frames_followed )
+    fprintf(stderr, "tracker: %u frames detected, %u followed by optical flow"
+            " (detecting every %d)\n", frames_detected, frames_followed, g_flowInterval);
+  if( verify_frames )
+    fprintf(stderr, "tracker: matches checked against BFMatcher on %u frames,"
+            " %u differed\n", verify_frames, verify_mismatches);
+  if( ctx.detect.width ) {
+    int lo = FAST_MAX_THRESHOLD, hi = FAST_MIN_THRESHOLD;
+
+    for (int c = 0; c < TRACKER_GRID_CELLS; c++) {
+      lo = std::min(lo, ctx.detect.cells[c].threshold);
+      hi = std::max(hi, ctx.detect.cells[c].threshold);
+    }
+    fprintf(stderr, "tracker: FAST on %d cells, %d threads, thresholds %d to %d\n",
+            TRACKER_GRID_CELLS, detect_threads, lo, hi);
+  }
+  free_featuregrid(&ctx.grid);
 }
 #endif	//DEF_RGB
 
@@ -156,28 +881,33 @@ void process(char *yuvData, IplImage *prgb)
  * In : w x h rectangle image size 
  * Ret : 0 - failure
  *       otherwise successful
+ * Both images are headers only: their imageData is pointed at the
+ * captured frame and the mapped PBO each time process() runs.
+ * Also starts sourceparams->convert_threads colour conversion workers
+ * and the tracker thread.
+ * With several sources each gets its own prgb; the first one in
+ * starts the workers (and sizes pyuv), the last one out stops them.
+ * The tracker is shared too: it follows one source, whichever the
+ * display calls process() for (the others only convert_frame).
  */
 int init_process(Sourceparams_t *sourceparams)
 {
 #ifdef	DEF_RGB
-  int i;
-
-  pyuv = NULL;
-  for( i=0; i<sourceparams->buffercount; ++i) {
-    sourceparams->buffers[i].prgb = cvCreateImage(
-      cvSize(sourceparams->image_width, sourceparams->image_height), IPL_DEPTH_8U, 3);
-    if( !sourceparams->buffers[i].prgb ) { //failure
-release:
-      while( --i>=0 ) {
-        cvReleaseImage(&(sourceparams->buffers[i].prgb));
-        sourceparams->buffers[i].prgb = NULL;
-      }
-      return 0;
+  CvSize size = cvSize(sourceparams->image_width, sourceparams->image_height);
+
+  sourceparams->prgb = cvCreateImageHeader(size, IPL_DEPTH_8U, 3);
+  if( 0==process_users++ ) {
+    pyuv = cvCreateImageHeader(size, IPL_DEPTH_8U, 2);
+    if( pyuv && (start_workpool(&convert_pool, sourceparams->convert_threads)
+                 || start_tracker()) ) {
+      stop_workpool(&convert_pool);
+      cvReleaseImageHeader(&pyuv);
     }
   }
-	pyuv = cvCreateImage(cvSize(sourceparams->image_width, sourceparams->image_height),
-          IPL_DEPTH_8U, 2);
-  if( !pyuv ) goto release;
+  if( !sourceparams->prgb || !pyuv ) { //failure
+    fini_process(sourceparams);
+    return 0;
+  }
 #endif	//DEF_RGB
   return 1;
 }
@@ -185,15 +915,14 @@ release:
 
 void fini_process(Sourceparams_t *sourceparams)
 {
-#ifdef	DEFF_RGB
-  int i;
-  if( pyuv ) {
-    cvReleaseImage(&pyuv);
-    for( i=0; i<sourceparams->buffercount; ++i) {
-      cvReleaseImage(&(sourceparams->buffers[i].prgb));
-      sourceparams->buffers[i].prgb = NULL;
+#ifdef	DEF_RGB
+  if( sourceparams->prgb ) cvReleaseImageHeader(&sourceparams->prgb);
+  if( 0<process_users && 0==--process_users ) {
+    if( pyuv ) {
+      stop_tracker();
+      stop_workpool(&convert_pool);
+      cvReleaseImageHeader(&pyuv);
     }
   }
 #endif	//DEF_RGB
 }
-
@@ -14,10 +14,19 @@ int init_process(Sourceparams_t *sourceparams);
 void fini_process(Sourceparams_t *sourceparams);
 #ifdef	DEF_RGB
 void process(char *yuvData, IplImage *prgb);
+void convert_frame(char *yuvData, IplImage *prgb);
+float tracker_fps(void);
+void finish_tracking(void);
+unsigned int tracker_allocations(unsigned long long *own,
+                                 unsigned long long *opencv);
 #endif
 void resetH(void);
 
 extern int g_toProcess;
+#ifdef	DEF_RGB
+extern int g_verifyMatches;
+extern int g_flowInterval;
+#endif
 
 #ifdef __cplusplus
 }
@@ -59,7 +59,7 @@
 #include <fcntl.h> /* open   */
 #include <sys/ioctl.h> /* ioctl  */
 #include <errno.h> /* EINTR  */
-#include <sys/mman.h> /* mmap  */
+#include <sys/mman.h> /* mmap, munmap  */
 #include "glutcam.h"
 #include "capabilities.h"
 #include "controls.h" /* describe_device_controls  */
@@ -68,7 +68,8 @@
 #include <GL/glut.h>
 
 #include "device.h"
-#include "cvProcess.h"
+#include "capture.h" /* publish_video_frame  */
+#include "trace.h" /* trace_begin, trace_end  */
 
 /* ERRSTRINGLEN - max length of generated error string  */
 
@@ -90,6 +91,12 @@
 
 #define DATA_TIMEOUT_INTERVAL (1000000.0 / 15.0)
 
+/* HUGEPAGE_SIZE - the user pointer buffer pool is rounded up to this  */
+/* when it's allocated from huge pages (-H). 2MB is the default huge  */
+/* page size on x86-64 and arm.  */
+
+#define HUGEPAGE_SIZE (2 * 1024 * 1024)
+
 extern "C" {
 
 /* local prototypes  */
@@ -116,19 +123,29 @@ int init_mmap_io(Sourceparams_t * sourceparams,
 __u32 encoding_format(Encodingmethod_t encoding);
 char * get_encoding_string(Encodingmethod_t encoding);
 int mmap_io_buffers(Sourceparams_t * sourceparams);
-int request_video_buffer_access(int device_fd, enum v4l2_memory memory);
+int export_dmabuf_buffers(Sourceparams_t * sourceparams);
+int request_video_buffer_access(int device_fd, enum v4l2_memory memory,
+				int count);
+int allocate_buffer_table(Sourceparams_t * sourceparams, int buffercount);
+void count_dropped_frames(Sourceparams_t * sourceparams,
+			  unsigned int sequence);
 int request_and_mmap_io_buffers(Sourceparams_t * sourceparams);
 int init_userptr_io(Sourceparams_t * sourceparams,
 		    Videocapabilities_t * capabilities);
 int userspace_buffer_mode(Sourceparams_t * sourceparams);
+void free_userspace_buffers(Sourceparams_t * sourceparams);
 int enqueue_mmap_buffers(Sourceparams_t * sourceparams);
 int start_streaming(Sourceparams_t * sourceparams);
 int stop_streaming(Sourceparams_t * sourceparams);
 int enqueue_userpointer_buffers(Sourceparams_t * sourceparams);
 int read_video_frame(int fd, Videobuffer_t * buffer);
-int harvest_mmap_device_buffer(Sourceparams_t * sourceparams);
+int harvest_mmap_device_buffer(Sourceparams_t * sourceparams,
+			       Frameslot_t * slot);
 int wait_for_input(int fd, int useconds);
-int harvest_userptr_device_buffer(Sourceparams_t * sourceparams);
+int harvest_userptr_device_buffer(Sourceparams_t * sourceparams,
+				  Frameslot_t * slot);
+size_t device_image_size(Sourceparams_t * sourceparams);
+long long buffer_timestamp_usec(const struct v4l2_buffer * buf);
 /* end local prototypes  */
 
 
@@ -211,6 +228,11 @@ int init_source_device(Cmdargs_t argstruct, Sourceparams_t * sourceparams,
       sourceparams->encoding = argstruct.encoding;
       sourceparams->image_width = argstruct.image_width;
       sourceparams->image_height = argstruct.image_height;
+      strncpy(sourceparams->dmabuf.path, argstruct.dmabuf_socket,
+	      MAX_DEVICENAME);
+      sourceparams->want_userptr = argstruct.userptr_io;
+      sourceparams->hugepages = argstruct.hugepages;
+      sourceparams->requested_buffers = argstruct.video_buffers;
 
       /* start here  */
       /* now allocate a buffer to hold the data we read from  */
@@ -549,7 +571,8 @@ int get_device_capabilities(char * devicename, int device_fd,
 		 iomethod this program will use to talk to it.
 
 		 we'll try streaming first because it's more efficient.
-		 if streaming is available, set the iomethod to be mmap.
+		 if streaming is available, set the iomethod to be mmap,
+		 or user pointer if sourceparams->want_userptr is set.
 		 if streaming isn't available, check for read and set
 		 iomethod for that.
 
@@ -567,6 +590,7 @@ int get_device_capabilities(char * devicename, int device_fd,
    LIMITATIONS:
 
    I don't think we can tell from capabilities if user pointer IO is supported.
+   (set_io_method falls back to mmap if the driver turns it down.)
    Both are streaming types; the difference between them is that with
    IO_METHOD_MMAP, the video buffers are in the kernelspace driver. With
    IO_METHOD_USERPTR, the user-space process that wants the data provides
@@ -591,6 +615,7 @@ int get_device_capabilities(char * devicename, int device_fd,
         STR                  Description of Revision                 Author
 
       5-Jan-08               initial coding                           gpk
+     17-Oct-26  user pointer if asked for
 
  ************************************************************************* */
 
@@ -606,7 +631,12 @@ void select_io_method(Sourceparams_t * sourceparams,
 
   capture_capabilties = &(capabilities->capture);
 
-  if (V4L2_CAP_STREAMING & capture_capabilties->capabilities)
+  if ((V4L2_CAP_STREAMING & capture_capabilties->capabilities)
+      && (0 != sourceparams->want_userptr))
+    {
+      sourceparams->iomethod = IO_METHOD_USERPTR;
+    }
+  else if (V4L2_CAP_STREAMING & capture_capabilties->capabilities)
     {
       sourceparams->iomethod = IO_METHOD_MMAP;
     }
@@ -648,6 +678,7 @@ void select_io_method(Sourceparams_t * sourceparams,
 		 (sourceparams->source) and if live, what the input
 		 method is, create a buffer for the input data
 		 and point sourceparams->captured.start at that buffer
+		 (a capture file is already mapped: nothing to do)
 
 		 if this function doesn't recognize the input method,
 		    print a warning to stderr and abort.
@@ -672,6 +703,7 @@ void select_io_method(Sourceparams_t * sourceparams,
         STR                  Description of Revision                 Author
 
      5-Jan-08               initial coding                           gpk
+     17-Oct-26  capture files are already mapped
 
  ************************************************************************* */
 
@@ -683,6 +715,11 @@ int connect_source_buffers(Sourceparams_t * sourceparams)
     {
       retval = allocate_capture_buffer(sourceparams);
     }
+  else if (FILESOURCE == sourceparams->source)
+    {
+      /* init_capture_file pointed captured.start at the first frame  */
+      retval = 0;
+    }
   else /* source is LIVESOURCE  */
     {
       switch(sourceparams->iomethod)
@@ -1483,7 +1520,7 @@ char * get_encoding_string(Encodingmethod_t encoding)
 		    space to get the data.
 		the userptr method tells the driver to store the data in
 		    the process' own memory space directly. (not all drivers
-		    can do userptr.)
+		    can do userptr: if this one can't, we use mmap.)
 
 		if the switch statement is not kept up to date,
 		   the default case will catch and remind the user
@@ -1515,6 +1552,7 @@ char * get_encoding_string(Encodingmethod_t encoding)
         STR                  Description of Revision                 Author
 
       7-Jan-07               initial coding                           gpk
+     17-Oct-26  fall back to mmap if user pointer fails
 
  ************************************************************************* */
 
@@ -1533,6 +1571,12 @@ int set_io_method(Sourceparams_t * sourceparams,
       break;
     case IO_METHOD_USERPTR:
       retval = init_userptr_io(sourceparams, capabilities);
+      if (-1 == retval)
+	{
+	  fprintf(stderr, "Warning: user pointer I/O failed; using mmap\n");
+	  sourceparams->iomethod = IO_METHOD_MMAP;
+	  retval = init_mmap_io(sourceparams, capabilities);
+	}
       break;
       
     default:
@@ -1577,11 +1621,12 @@ int set_io_method(Sourceparams_t * sourceparams,
 		 of read io. if not, complain and tell what modes it
 		 is capable of.
 
-		 if it is capable of read io, allocate a buffer in
-		 sourceparams->buffers[0] of the correct size.
+		 if it is capable of read io, make a one entry
+		 sourceparams->buffers table and allocate a buffer of
+		 the correct size in sourceparams->buffers[0].
 
-		 return -1 if the device can't do read io or if malloc
-		         runs out of memory
+		 return -1 if the device can't do read io or if we
+		         run out of memory
 			 0 if all's well.
    REFERENCES:
 
@@ -1600,6 +1645,7 @@ int set_io_method(Sourceparams_t * sourceparams,
         STR                  Description of Revision                 Author
 
       7-Jan-07               initial coding                           gpk
+     17-Oct-26  allocate the buffer table first
 
  ************************************************************************* */
 
@@ -1616,10 +1662,13 @@ int init_read_io(Sourceparams_t * sourceparams,
     }
   else
     {
-      /* allocate a single buffer in user space (malloc)  */
+      /* allocate a single buffer in user space (mmap)  */
       
-      sourceparams->buffercount = 1;
-      status = userspace_buffer_mode(sourceparams);
+      status = allocate_buffer_table(sourceparams, 1);
+      if (0 == status)
+	{
+	  status = userspace_buffer_mode(sourceparams);
+	}
       
       if (-1 == status)
 	{
@@ -1755,6 +1804,8 @@ int init_mmap_io(Sourceparams_t * sourceparams,
         STR                  Description of Revision                 Author
 
       7-Jan-07               initial coding                           gpk
+     17-Oct-26  ask for sourceparams->requested_buffers; allocate the
+                buffer table
 
  ************************************************************************* */
 
@@ -1764,7 +1815,8 @@ int request_and_mmap_io_buffers(Sourceparams_t * sourceparams)
 
   /* find out how many buffers are available for mmap access  */
   buffercount = request_video_buffer_access(sourceparams->fd,
-					    V4L2_MEMORY_MMAP);
+					    V4L2_MEMORY_MMAP,
+					    sourceparams->requested_buffers);
   
   if (-1 == buffercount) /* mmap not supported  */
     {
@@ -1778,7 +1830,7 @@ int request_and_mmap_io_buffers(Sourceparams_t * sourceparams)
 	{
 	  fprintf(stderr, "Error: couldn't get enough video buffers from");
 	  fprintf(stderr, "  the video device. Requested %d, would have ",
-		  MAX_VIDEO_BUFFERS);
+		  sourceparams->requested_buffers);
 	  fprintf(stderr, "settled for 2, got %d\n", buffercount);
 	  retval = -1; /* error  */
 	}
@@ -1786,12 +1838,27 @@ int request_and_mmap_io_buffers(Sourceparams_t * sourceparams)
 	{
 	  /* we got at least two buffers; call mmap so we can  */
 	  /* get access to them from user space.   */
-	  sourceparams->buffercount = buffercount;
-	  retval = mmap_io_buffers(sourceparams);
+	  retval = allocate_buffer_table(sourceparams, buffercount);
+	  if (0 == retval)
+	    {
+	      retval = mmap_io_buffers(sourceparams);
+	    }
 
 	  /* now sourceparams->buffers[0..buffercount -1] point  */
 	  /* to the device's video buffers, so we can get video  */
 	  /* data from them.   */
+
+	  /* if we were asked to share them, export them as well.  */
+	  /* if that fails we still have the mmap-ed buffers.  */
+	  if ((0 == retval) && ('\0' != sourceparams->dmabuf.path[0]))
+	    {
+	      if (-1 == export_dmabuf_buffers(sourceparams))
+		{
+		  fprintf(stderr, "Warning: can't export video buffers as ");
+		  fprintf(stderr, "dmabuf; not sharing them on %s\n",
+			  sourceparams->dmabuf.path);
+		}
+	    }
 	}
 
     }
@@ -1813,8 +1880,9 @@ int request_and_mmap_io_buffers(Sourceparams_t * sourceparams)
    int some_int;
    int device_fd = open("/dev/video");
    enum v4l2_memory memory; -- V4L2_MEMORY_MMAP or V4L2_MEMORY_USERPTR
+   int count;
 
-   some_int =  request_video_buffer_access(device_fd, memory);
+   some_int =  request_video_buffer_access(device_fd, memory, count);
 
    if (-1 == some_int)
    -- handle error
@@ -1825,8 +1893,9 @@ int request_and_mmap_io_buffers(Sourceparams_t * sourceparams)
    returns: int
 
    DESCRIPTION:
-                 use VIDIOC_REQBUFS to find out if we can get access to the
-		 device's buffers in the given mode.
+                 use VIDIOC_REQBUFS to find out if we can get access to
+		 count of the device's buffers in the given mode. the
+		 driver may give us fewer (or, if it needs them, more).
 
 		 return -1 if that mode is not supported
 		       else N for the number of buffers we can access
@@ -1848,10 +1917,12 @@ int request_and_mmap_io_buffers(Sourceparams_t * sourceparams)
         STR                  Description of Revision                 Author
 
       7-Jan-07               initial coding                           gpk
+     17-Oct-26  take the count to ask for
 
  ************************************************************************* */
 
-int request_video_buffer_access(int device_fd, enum v4l2_memory memory)
+int request_video_buffer_access(int device_fd, enum v4l2_memory memory,
+				int count)
 {
   struct v4l2_requestbuffers request;
   int status, retval;
@@ -1861,10 +1932,10 @@ int request_video_buffer_access(int device_fd, enum v4l2_memory memory)
   
   memset(&request, 0, sizeof(request));
 
-  /* ask for MAX_VIDEO_BUFFERS for video capture: we may not  */
+  /* ask for count buffers for video capture: we may not  */
   /* get all the ones we ask for  */
 
-  request.count = MAX_VIDEO_BUFFERS;
+  request.count = (unsigned int)count;
   request.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
   request.memory = memory;
 
@@ -1906,6 +1977,98 @@ int request_video_buffer_access(int device_fd, enum v4l2_memory memory)
 
 
 
+/* ************************************************************************* 
+
+
+   NAME:  allocate_buffer_table
+
+
+   USAGE: 
+
+   int some_int;
+   Sourceparams_t * sourceparams;
+   int buffercount;
+   
+   some_int =  allocate_buffer_table(sourceparams, buffercount);
+
+   if (-1 == some_int)
+   -- handle error
+   
+   returns: int
+
+   DESCRIPTION:
+                 make sourceparams->buffers big enough for the
+		 buffercount buffers the driver gave us, and set
+		 sourceparams->buffercount.
+
+		 return 0 if all's well
+		       -1 if there are more than MAX_VIDEO_BUFFERS
+		          or calloc fails
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int allocate_buffer_table(Sourceparams_t * sourceparams, int buffercount)
+{
+  int i;
+
+  if (MAX_VIDEO_BUFFERS < buffercount)
+    {
+      fprintf(stderr, "Error: the driver gave us %d video buffers; ",
+	      buffercount);
+      fprintf(stderr, "we can handle at most %d\n", MAX_VIDEO_BUFFERS);
+      return(-1);
+    }
+
+  free(sourceparams->buffers);
+  sourceparams->buffers = (Videobuffer_t *)calloc(buffercount,
+						  sizeof(Videobuffer_t));
+
+  if (NULL == sourceparams->buffers)
+    {
+      fprintf(stderr, "Error: unable to allocate %d video buffer entries\n",
+	      buffercount);
+      sourceparams->buffercount = 0;
+      return(-1);
+    }
+
+  for (i = 0; i < buffercount; i++)
+    {
+      sourceparams->buffers[i].dmabuf_fd = -1;
+    }
+
+  sourceparams->buffercount = buffercount;
+
+  if (buffercount != sourceparams->requested_buffers)
+    {
+      fprintf(stderr, "asked for %d video buffers, got %d\n",
+	      sourceparams->requested_buffers, buffercount);
+    }
+
+  return(0);
+}
+
+
+
+
+
 /* ************************************************************************* 
 
 
@@ -1969,7 +2132,6 @@ int mmap_io_buffers(Sourceparams_t * sourceparams)
   status = 0;
   retval = 0;
   
-  INIT_LIST_HEAD(&sourceparams->bufList);
   for (i = 0; (i < sourceparams->buffercount) && (0 == status); i++)
     {
       memset(&buf, 0, sizeof(buf));
@@ -1996,7 +2158,6 @@ int mmap_io_buffers(Sourceparams_t * sourceparams)
 	    {
 	      sourceparams->buffers[i].length = buf.length;
 	      sourceparams->buffers[i].start = mmapped_buffer;
-              INIT_LIST_HEAD(&(sourceparams->buffers[i].list));
 	    }
 	  else
 	    {
@@ -2014,6 +2175,129 @@ int mmap_io_buffers(Sourceparams_t * sourceparams)
 
 
 
+/* ************************************************************************* 
+
+
+   NAME:  export_dmabuf_buffers
+
+
+   USAGE: 
+
+   int some_int;
+   Sourceparams_t * sourceparams;
+   
+   some_int =  export_dmabuf_buffers(sourceparams);
+
+   if (-1 == some_int)
+   -- buffers aren't exported; carry on with mmap
+   
+   returns: int
+
+   DESCRIPTION:
+                 after mmap_io_buffers, use VIDIOC_EXPBUF to get a
+		 dmabuf file descriptor for each of the buffers and
+		 put it in sourceparams->buffers[i].dmabuf_fd.
+		 record the format the buffers hold in
+		 sourceparams->dmabuf so it can be passed on with
+		 them.
+
+		 all or nothing: if any buffer can't be exported,
+		 close the ones that were and leave
+		 sourceparams->dmabuf.nfds at 0.
+
+		 return 0 if all's well
+		       -1 if the driver (or kernel headers) can't do it
+			  
+   REFERENCES: V4L2 spec, "Streaming I/O (DMA buffer importing)",
+               VIDIOC_EXPBUF
+
+   LIMITATIONS:
+
+   single-planar capture only
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int export_dmabuf_buffers(Sourceparams_t * sourceparams)
+{
+#ifdef VIDIOC_EXPBUF
+  int i, status;
+  struct v4l2_exportbuffer expbuf;
+  struct v4l2_format format;
+
+  sourceparams->dmabuf.nfds = 0;
+
+  memset(&format, 0, sizeof(format));
+  format.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+
+  if (-1 == xioctl(sourceparams->fd, VIDIOC_G_FMT, &format))
+    {
+      perror("Error getting the format of the buffers to export");
+      return(-1);
+    }
+
+  status = 0;
+
+  for (i = 0; (i < sourceparams->buffercount) && (0 == status); i++)
+    {
+      memset(&expbuf, 0, sizeof(expbuf));
+      expbuf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+      expbuf.index = (unsigned int)i;
+      expbuf.flags = O_RDONLY | O_CLOEXEC;
+
+      status = xioctl(sourceparams->fd, VIDIOC_EXPBUF, &expbuf);
+
+      if (-1 == status)
+	{
+	  perror("Error exporting video buffer with VIDIOC_EXPBUF");
+	}
+      else
+	{
+	  sourceparams->buffers[i].dmabuf_fd = expbuf.fd;
+	}
+    }
+
+  if (-1 == status)
+    {
+      /* i is one past the buffer that failed  */
+      for (i = i - 2; 0 <= i; i--)
+	{
+	  close(sourceparams->buffers[i].dmabuf_fd);
+	}
+      return(-1);
+    }
+
+  sourceparams->dmabuf.nfds = sourceparams->buffercount;
+  sourceparams->dmabuf.width = format.fmt.pix.width;
+  sourceparams->dmabuf.height = format.fmt.pix.height;
+  sourceparams->dmabuf.fourcc = format.fmt.pix.pixelformat;
+  sourceparams->dmabuf.bytesperline = format.fmt.pix.bytesperline;
+
+  return(0);
+#else
+  fprintf(stderr, "Error: built without VIDIOC_EXPBUF\n");
+  sourceparams->dmabuf.nfds = 0;
+  return(-1);
+#endif /* VIDIOC_EXPBUF  */
+}
+
+
+
+
+
 /* ************************************************************************* 
 
 
@@ -2070,6 +2354,8 @@ int mmap_io_buffers(Sourceparams_t * sourceparams)
         STR                  Description of Revision                 Author
 
       7-Jan-07               initial coding                           gpk
+     17-Oct-26  ask for sourceparams->requested_buffers; allocate the
+                buffer table
 
  ************************************************************************* */
 
@@ -2089,7 +2375,8 @@ int init_userptr_io(Sourceparams_t * sourceparams,
     {
       /* okay, how many buffers do we have to work with  */
       buffercount = request_video_buffer_access(sourceparams->fd,
-						V4L2_MEMORY_USERPTR);
+						V4L2_MEMORY_USERPTR,
+						sourceparams->requested_buffers);
       if(-1 == buffercount) /* error  */
 	{
 	  retval = -1; /* ioctl fails  */
@@ -2098,15 +2385,18 @@ int init_userptr_io(Sourceparams_t * sourceparams,
 	{
 	  fprintf(stderr, "Error: couldn't get enough video buffers from");
 	  fprintf(stderr, "  the video device. Requested %d, would have ",
-		  MAX_VIDEO_BUFFERS);
+		  sourceparams->requested_buffers);
 	  fprintf(stderr, "settled for 2, got %d\n", buffercount);
 	  retval = -1;
 	}
       else
 	{
-	  /* okay, malloc space for those buffers  */
-	  sourceparams->buffercount = buffercount;
-	  retval = userspace_buffer_mode(sourceparams);
+	  /* okay, allocate space for those buffers  */
+	  retval = allocate_buffer_table(sourceparams, buffercount);
+	  if (0 == retval)
+	    {
+	      retval = userspace_buffer_mode(sourceparams);
+	    }
 	}
     }
   
@@ -2133,16 +2423,28 @@ int init_userptr_io(Sourceparams_t * sourceparams,
    returns: int
 
    DESCRIPTION:
-                 malloc sourceparams->buffercount buffer and
+                 allocate sourceparams->buffercount page-aligned
+		 buffers, all from one anonymous mapping, and
 		 connect them to sourceparams->buffers[*].start
 		 and sourceparams->buffers[*].length
 
+		 if sourceparams->hugepages is set, try to map the
+		 pool from huge pages first (fewer TLB misses when the
+		 converter walks a frame); if there aren't any, use
+		 ordinary pages.
+
+		 the pool is kept in sourceparams->userptr_pool and
+		 userptr_pool_size for free_userspace_buffers.
+
 		 return 0 if all's well
 		       -1 on error
    REFERENCES:
 
    LIMITATIONS:
 
+   huge pages have to be reserved first, eg
+   echo 16 > /proc/sys/vm/nr_hugepages
+
    GLOBAL VARIABLES:
 
       accessed: none
@@ -2156,43 +2458,192 @@ int init_userptr_io(Sourceparams_t * sourceparams,
         STR                  Description of Revision                 Author
 
       7-Jan-07               initial coding                           gpk
+     17-Oct-26  one page-aligned pool, optionally huge pages
+     17-Oct-26  remember the pool so it can be unmapped
 
  ************************************************************************* */
 
 int userspace_buffer_mode(Sourceparams_t * sourceparams)
 {
-  int i, imagesize, retval;
-  void * buffer;
-  char errstring[ERRSTRINGLEN];
+  int i;
+  size_t imagesize, buffersize, poolsize, mapsize, pagesize;
+  unsigned char * pool;
 
-  /* figure out how big an image is  */
-  
-  imagesize = compute_bytes_per_frame(sourceparams->image_width,
-				      sourceparams->image_height,
-				      sourceparams->encoding);
+  /* figure out how big an image is, rounded up to whole pages so  */
+  /* every buffer starts on a page boundary.  */
 
-  retval = 0;
-  
-  for (i = 0; (i < sourceparams->buffercount) && (0 == retval); i++)
-    {
-      buffer = malloc(imagesize);
+  imagesize = device_image_size(sourceparams);
+  pagesize = (size_t)sysconf(_SC_PAGESIZE);
+  buffersize = (imagesize + pagesize - 1) & ~(pagesize - 1);
+  poolsize = buffersize * sourceparams->buffercount;
+
+  free_userspace_buffers(sourceparams);
+  pool = (unsigned char *)MAP_FAILED;
 
-      if (NULL != buffer)
+#ifdef MAP_HUGETLB
+  if (0 != sourceparams->hugepages)
+    {
+      mapsize = (poolsize + HUGEPAGE_SIZE - 1) & ~((size_t)HUGEPAGE_SIZE - 1);
+      pool = (unsigned char *)mmap(NULL, mapsize, PROT_READ | PROT_WRITE,
+				   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+				   -1, 0);
+      if (MAP_FAILED == pool)
 	{
-	  sourceparams->buffers[i].start = buffer;
-	  sourceparams->buffers[i].length = imagesize;
+	  perror("Warning: no huge pages for video buffers");
 	}
-      else
-	{
-	  retval = -1; /* error  */
-	  sprintf(errstring,
-		  "Error: failed to allocate %d bytes for video buffer",
-		  imagesize);
-	  perror(errstring);
-	}
-     
     }
-  return(retval);
+#endif /* MAP_HUGETLB  */
+
+  if (MAP_FAILED == pool)
+    {
+      mapsize = poolsize;
+      pool = (unsigned char *)mmap(NULL, mapsize, PROT_READ | PROT_WRITE,
+				   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+
+  if (MAP_FAILED == pool)
+    {
+      fprintf(stderr, "Error: failed to allocate %lu bytes for video buffers",
+	      (unsigned long)poolsize);
+      perror(" ");
+      return(-1);
+    }
+
+  sourceparams->userptr_pool = pool;
+  sourceparams->userptr_pool_size = mapsize;
+
+  for (i = 0; i < sourceparams->buffercount; i++)
+    {
+      sourceparams->buffers[i].start = pool + i * buffersize;
+      sourceparams->buffers[i].length = buffersize;
+    }
+
+  return(0);
+}
+
+
+
+/* ************************************************************************* 
+
+
+   NAME:  free_userspace_buffers
+
+
+   USAGE: 
+
+   Sourceparams_t * sourceparams;
+
+   free_userspace_buffers(sourceparams);
+
+   returns: void
+
+   DESCRIPTION:
+                 unmap the pool userspace_buffer_mode made, if
+		 there is one, and forget the buffers in it
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   the driver mustn't have any of the buffers: stop streaming first
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void free_userspace_buffers(Sourceparams_t * sourceparams)
+{
+  int i;
+
+  if (NULL == sourceparams->userptr_pool)
+    {
+      return;
+    }
+
+  munmap(sourceparams->userptr_pool, sourceparams->userptr_pool_size);
+  sourceparams->userptr_pool = NULL;
+  sourceparams->userptr_pool_size = 0;
+
+  for (i = 0; i < sourceparams->buffercount; i++)
+    {
+      sourceparams->buffers[i].start = NULL;
+      sourceparams->buffers[i].length = 0;
+    }
+}
+
+
+
+/* ************************************************************************* 
+
+
+   NAME:  device_image_size
+
+
+   USAGE: 
+
+   size_t imagesize;
+   Sourceparams_t * sourceparams;
+
+   imagesize =  device_image_size(sourceparams);
+
+   returns: size_t
+
+   DESCRIPTION:
+                 the bytes the driver needs for one image: its
+		 sizeimage if it'll tell us (it may pad the lines),
+		 or what compute_bytes_per_frame says if that's more.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+size_t device_image_size(Sourceparams_t * sourceparams)
+{
+  struct v4l2_format format;
+  size_t imagesize;
+
+  imagesize = (size_t)compute_bytes_per_frame(sourceparams->image_width,
+					      sourceparams->image_height,
+					      sourceparams->encoding);
+
+  memset(&format, 0, sizeof(format));
+  format.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+
+  if ((0 == xioctl(sourceparams->fd, VIDIOC_G_FMT, &format))
+      && (imagesize < format.fmt.pix.sizeimage))
+    {
+      imagesize = format.fmt.pix.sizeimage;
+    }
+
+  return(imagesize);
 }
 
 
@@ -2413,7 +2864,6 @@ int start_streaming(Sourceparams_t * sourceparams)
   enum v4l2_buf_type type;
   int status;
 
-  init_process(sourceparams);
   type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
   
   status = xioctl(sourceparams->fd, VIDIOC_STREAMON, &type);
@@ -2485,7 +2935,6 @@ int stop_streaming(Sourceparams_t * sourceparams)
     {
       perror("Error stopping streaming with VIDIOC_STREAMOFF");
     }
-  fini_process(sourceparams);
 
   return(status);
 }
@@ -2513,7 +2962,7 @@ int stop_streaming(Sourceparams_t * sourceparams)
 
 		 if the driver supplies data to buffers in user process
 		 space (ie not kernel space) we'd use IO_METHOD_USERPTR
-		 and queue up buffers allocated with malloc. this is
+		 and queue up buffers from userspace_buffer_mode. this is
 		 where we handle that case. in particular, the driver
 		 needs to know the start and length of the buffer.
 		 (we get buf.m.userptr back in harvest_userptr_device_buffer
@@ -2537,6 +2986,7 @@ int stop_streaming(Sourceparams_t * sourceparams)
         STR                  Description of Revision                 Author
 
       5-Jan-08               initial coding                           gpk
+     17-Oct-26  set buf.index: the driver hands it back on DQBUF
 
  ************************************************************************* */
 
@@ -2553,13 +3003,14 @@ int enqueue_userpointer_buffers(Sourceparams_t * sourceparams)
       memset(&buf, 0, sizeof(buf));
       buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
       buf.memory = V4L2_MEMORY_USERPTR;
+      buf.index = (unsigned int)i;
       buf.m.userptr = (unsigned long)(sourceparams->buffers[i].start);
       buf.length = sourceparams->buffers[i].length;
       status =   xioctl (sourceparams->fd, VIDIOC_QBUF, &buf);
     }
   if (-1 == status)
     {
-      perror("Error enqueueing mmap-ed buffers with VIDIOC_QBUF");
+      perror("Error enqueueing user pointer buffers with VIDIOC_QBUF");
     }
   
   return(status);
@@ -2588,7 +3039,9 @@ int enqueue_userpointer_buffers(Sourceparams_t * sourceparams)
    returns: int
 
    DESCRIPTION:
-                 tell the device to stop supplying data
+                 tell the device to stop supplying data. read and
+		 user pointer buffers are unmapped: the driver's
+		 given them all back.
 
    REFERENCES:
 
@@ -2607,6 +3060,8 @@ int enqueue_userpointer_buffers(Sourceparams_t * sourceparams)
         STR                  Description of Revision                 Author
 
       5-Jan-08               initial coding                           gpk
+     17-Oct-26  unmap the user pointer buffers
+     17-Oct-26  and the read buffer
 
  ************************************************************************* */
 
@@ -2620,11 +3075,16 @@ int stop_capture_device(Sourceparams_t * sourceparams)
     case IO_METHOD_READ:
       retval = 0;
       /* no stop function for this; just don't read anymore  */
+      free_userspace_buffers(sourceparams);
+      break;
+      
+    case IO_METHOD_MMAP:
+      retval = stop_streaming(sourceparams);
       break;
       
-    case IO_METHOD_MMAP: /* fallthrough  */         
     case IO_METHOD_USERPTR:
       retval = stop_streaming(sourceparams);
+      free_userspace_buffers(sourceparams);
       break;
       
     default:
@@ -2656,17 +3116,19 @@ int stop_capture_device(Sourceparams_t * sourceparams)
    image =  next_device_frame(sourceparams, &nbytesp);
 
    if (NULL != image)
-   -- there is nbytesp worth of data in sourceparams->captured.start
+   -- the most recent of the frames we got has nbytesp worth of data
    
    returns: void *
 
    DESCRIPTION:
-                 collect the next image from the source.
+                 collect every image the device has ready and publish
+		 each one to sourceparams->ring.
 
-		 if we're reading, just read
+		 return the last one collected (NULL if there were none)
 
 		 if we're doing IO_METHOD_MMAP or IO_METHOD_USERPTR
-		    collect the ready buffer
+		    collect the ready buffers. either way the frame is
+		    passed on where the driver put it, not copied.
 
 		 if this function doesn't recognize the given iomethod
 		    print an error message and abort.
@@ -2689,6 +3151,10 @@ int stop_capture_device(Sourceparams_t * sourceparams)
         STR                  Description of Revision                 Author
 
       5-Jan-08               initial coding                           gpk
+     17-Oct-26  publish frames to sourceparams->ring instead of
+                bufList; frame rate is counted by publish_video_frame
+     17-Oct-26  IO_METHOD_USERPTR
+     17-Oct-26  trace each harvest and publish
 
  ************************************************************************* */
 
@@ -2698,9 +3164,8 @@ void * next_device_frame(Sourceparams_t * sourceparams, int * nbytesp)
   int nbytes, getMore;
   void *datap = NULL;
   int data_ready;
-	static unsigned totalFrm=0, thisFrm=0;
-	static int startTime=0, prevTime, msgTime;
-	int curTime;
+  Frameslot_t slot;
+  long long start;
 
 	for( *nbytesp=0, getMore = 1; getMore; ) {
 		data_ready = wait_for_input(sourceparams->fd , 1);
@@ -2711,29 +3176,25 @@ void * next_device_frame(Sourceparams_t * sourceparams, int * nbytesp)
 			}
 			getMore = 0;
 		} else {
+			start = trace_begin();
 			switch (sourceparams->iomethod) {
 			case IO_METHOD_MMAP:
-				nbytes = harvest_mmap_device_buffer(sourceparams);
+				nbytes = harvest_mmap_device_buffer(sourceparams, &slot);
 				if (0 < nbytes) {
-					if( 1==totalFrm && 0==startTime ) {
-						startTime = glutGet(GLUT_ELAPSED_TIME);
-						prevTime = startTime;
-						msgTime = startTime + 5*1000;
-					} else {
-						++thisFrm;
-						curTime = glutGet(GLUT_ELAPSED_TIME);
-						if( curTime>=msgTime ) {
-							sourceparams->fps = (float)thisFrm*1000/(curTime-prevTime);
-							prevTime = curTime;
-							msgTime = prevTime + 5*1000;
-							thisFrm = 0;
-						}
-					}
+					datap = slot.start;
+					*nbytesp = nbytes;
+					(void)publish_video_frame(sourceparams, &slot);
 	    			} else {
-					if( 0==nbytesp ) { //never got a frame
-						datap = NULL;
-						*nbytesp = nbytes;
-					}
+					getMore = 0;
+				}
+				break;
+			case IO_METHOD_USERPTR:
+				nbytes = harvest_userptr_device_buffer(sourceparams, &slot);
+				if (0 < nbytes) {
+					datap = slot.start;
+					*nbytesp = nbytes;
+					(void)publish_video_frame(sourceparams, &slot);
+				} else {
 					getMore = 0;
 				}
 				break;
@@ -2745,6 +3206,7 @@ void * next_device_frame(Sourceparams_t * sourceparams, int * nbytesp)
 				abort();
 				break;
 			}
+			trace_end("harvest", start);
 		}
 	}
 
@@ -2754,6 +3216,138 @@ void * next_device_frame(Sourceparams_t * sourceparams, int * nbytesp)
 
 
 
+/* ************************************************************************* 
+
+
+   NAME:  wait_for_device_frame
+
+
+   USAGE: 
+
+   Sourceparams_t * sourceparams;
+   int nbytes;
+
+   if (0 < wait_for_device_frame(sourceparams, 100000))
+     next_device_frame(sourceparams, &nbytes);
+   
+   returns: int
+
+   DESCRIPTION:
+                 block until the device has a frame for us or useconds
+		 (less than one second) go by. unlike the idle function
+		 this doesn't use any CPU while it waits.
+
+		 return 1 if a frame is ready
+		        0 on timeout
+		       -1 on error
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int wait_for_device_frame(Sourceparams_t * sourceparams, int useconds)
+{
+  return(wait_for_input(sourceparams->fd, useconds));
+}
+
+
+
+
+/* ************************************************************************* 
+
+
+   NAME:  requeue_device_buffer
+
+
+   USAGE: 
+
+   int some_int;
+   Sourceparams_t * sourceparams;
+   Frameslot_t slot;
+   
+   some_int =  requeue_device_buffer(sourceparams, slot.index);
+
+   returns: int
+
+   DESCRIPTION:
+                 give buffer index back to the driver so it can be
+		 filled with another frame. the display side calls this
+		 (through release_video_frame) once it's done with the
+		 data.
+
+		 return 0 if all's well
+		       -1 on error
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26  taken from the end of draw_video_frame
+     17-Oct-26  user pointer buffers too
+
+ ************************************************************************* */
+
+int requeue_device_buffer(Sourceparams_t * sourceparams, int index)
+{
+  struct v4l2_buffer buf;
+  int status;
+
+  memset(&buf, 0, sizeof(buf));
+  buf.index = (unsigned int)index;
+  buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+
+  if (IO_METHOD_USERPTR == sourceparams->iomethod)
+    {
+      buf.memory = V4L2_MEMORY_USERPTR;
+      buf.m.userptr = (unsigned long)(sourceparams->buffers[index].start);
+      buf.length = sourceparams->buffers[index].length;
+    }
+  else
+    {
+      buf.memory = V4L2_MEMORY_MMAP;
+    }
+
+  status = xioctl(sourceparams->fd, VIDIOC_QBUF, &buf);
+
+  if (-1 == status)
+    {
+      perror("Error requeueing video buffer with VIDIOC_QBUF");
+    }
+
+  return(status);
+}
+
+
+
+
 /* ************************************************************************* 
 
 
@@ -2832,14 +3426,16 @@ int read_video_frame(int fd, Videobuffer_t * buffer)
 
    int some_int;
    Sourceparams_t * sourceparams;
+   Frameslot_t slot;
    
-   some_int =  harvest_mmap_device_buffer(sourceparams);
+   some_int =  harvest_mmap_device_buffer(sourceparams, &slot);
 
    returns: int
 
    DESCRIPTION:
                  take a filled buffer of video data off the queue and
-		 copy the data into sourceparams->captured.start.
+		 describe it in slot. the buffer stays ours until it's
+		 handed back with requeue_device_buffer.
 
 		 returns the #bytes of data
 		         -1 on error
@@ -2862,22 +3458,33 @@ int read_video_frame(int fd, Videobuffer_t * buffer)
       5-Jan-08               initial coding                           gpk
       1-Feb-08  added print statements to make it easier to explore   gpk
                 new drivers and errors they return. 
+     17-Oct-26  fill in a Frameslot_t instead of adding to bufList
+     17-Oct-26  count dropped frames
+     17-Oct-26  pass on the driver's timestamp
+     17-Oct-26  and its sequence number
+     17-Oct-26  keep both with the buffer (Videobuffer_t) too
 		
  ************************************************************************* */
 #if	1
-int harvest_mmap_device_buffer(Sourceparams_t * sourceparams)
+int harvest_mmap_device_buffer(Sourceparams_t * sourceparams,
+			       Frameslot_t * slot)
 {
 	struct v4l2_buffer buf;
-	Videobuffer_t *myBuf;
 
 	memset(&buf, 0, sizeof(buf));
 	buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
 	buf.memory = V4L2_MEMORY_MMAP;
 
 	if( 0==xioctl (sourceparams->fd, VIDIOC_DQBUF, &buf) ) {
-		myBuf = &(sourceparams->buffers[buf.index]);
-		list_add_tail(&myBuf->list, &sourceparams->bufList);    
-		return 1;
+		count_dropped_frames(sourceparams, buf.sequence);
+		slot->index = (int)buf.index;
+		slot->capture_usec = buffer_timestamp_usec(&buf);
+		slot->sequence = buf.sequence;
+		slot->start = sourceparams->buffers[buf.index].start;
+		slot->length = sourceparams->captured.length;
+		sourceparams->buffers[buf.index].timestamp_usec = slot->capture_usec;
+		sourceparams->buffers[buf.index].sequence = buf.sequence;
+		return (int)slot->length;
 	}
 
 	return -1;
@@ -3060,14 +3667,17 @@ int wait_for_input(int fd, int useconds)
 
    int some_int;
    Sourceparams_t * sourceparams;
+   Frameslot_t slot;
 
-   some_int =  harvest_userptr_device_buffer(sourceparams);
+   some_int =  harvest_userptr_device_buffer(sourceparams, &slot);
 
    returns: int
 
    DESCRIPTION:
                  take a filled buffer of video data off the queue and
-                 copy the data into sourceparams->captured.start.
+		 describe it in slot. like harvest_mmap_device_buffer
+		 there's no copy: the buffer stays ours until it's
+		 handed back with requeue_device_buffer.
 
 		 returns the #bytes of data
 		         -1 on error
@@ -3089,15 +3699,20 @@ int wait_for_input(int fd, int useconds)
         STR                  Description of Revision                 Author
 
       5-Jan-08               initial coding                           gpk
+     17-Oct-26  fill in a Frameslot_t instead of copying the frame
+     17-Oct-26  count dropped frames
+     17-Oct-26  pass on the driver's timestamp
+     17-Oct-26  and its sequence number
+     17-Oct-26  keep both with the buffer (Videobuffer_t) too
+     17-Oct-26  the frame is as long as the driver says it is
 
  ************************************************************************* */
 
-int harvest_userptr_device_buffer(Sourceparams_t * sourceparams)
+int harvest_userptr_device_buffer(Sourceparams_t * sourceparams,
+				  Frameslot_t * slot)
 {
- 
   int retval, status;
   struct v4l2_buffer buf;
-  void * image_source;
   
   memset(&buf, 0, sizeof(buf));
 
@@ -3120,49 +3735,160 @@ int harvest_userptr_device_buffer(Sourceparams_t * sourceparams)
 	case EIO: /* fallthrough  */
 	  /* transient [?] error  */
 	default:
-	  perror("Error dequeueing mmap-ed buffer from device");
+	  perror("Error dequeueing user pointer buffer from device");
 	  retval = -1;
 	  break;
 	}	  
     }
   else
     {
-      /* copy the data from the buffer to sourceparams->captured  */
+      /* the data is already where we want it: just say where  */
+
+      count_dropped_frames(sourceparams, buf.sequence);
+      slot->index = (int)buf.index;
+      slot->capture_usec = buffer_timestamp_usec(&buf);
+      slot->sequence = buf.sequence;
+      slot->start = (void *)(buf.m.userptr);
+      slot->length = buf.bytesused;
+      if (buf.index < (unsigned int)sourceparams->buffercount)
+	{
+	  sourceparams->buffers[buf.index].timestamp_usec = slot->capture_usec;
+	  sourceparams->buffers[buf.index].sequence = buf.sequence;
+	}
+      retval = (int)slot->length;
+    }
 
-      image_source = (void *)(buf.m.userptr);
-      
-      memcpy(sourceparams->captured.start, image_source,
-	     sourceparams->captured.length);
+  return(retval);
+}
 
-      /* queue the buffer back up again  */
-      
-      status = xioctl (sourceparams->fd, VIDIOC_QBUF, &buf);
 
-      if (-1 == status)
-	{
-	  /* error re-queueing the buffer  */
-	  switch(errno)
-	    {
-	    case EAGAIN:
-	      /* nonblocking and no data ready  */
-	      retval = 0;
-	      break;
-	      
-	    case EIO: /* fallthrough  */
-	      /* transient [?] error  */
-	    default:
-	      perror("Error requeueing mmap-ed buffer from device");
-	      retval = -1;
-	      break;
-	    }	 
-	}
-      else
+
+
+/* ************************************************************************* 
+
+
+   NAME:  count_dropped_frames
+
+
+   USAGE: 
+
+   Sourceparams_t * sourceparams;
+   struct v4l2_buffer buf;
+
+   -- after VIDIOC_DQBUF
+   count_dropped_frames(sourceparams, buf.sequence);
+
+   returns: void
+
+   DESCRIPTION:
+                 the driver numbers the frames it captures. if the
+		 frame we just got isn't the one after the last one,
+		 the driver dropped the ones in between (usually
+		 because all the buffers were still queued up with us).
+		 add them to sourceparams->dropped_frames.
+
+   REFERENCES: V4L2 spec, struct v4l2_buffer
+
+   LIMITATIONS:
+
+   drivers that don't fill in sequence leave it at 0, so nothing
+   looks dropped.
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void count_dropped_frames(Sourceparams_t * sourceparams, unsigned int sequence)
+{
+  unsigned int gap;
+
+  if (0 != sourceparams->have_sequence)
+    {
+      gap = sequence - sourceparams->last_sequence - 1;
+
+      /* a sequence that goes backwards (driver restarted counting)  */
+      /* isn't a drop  */
+      if ((0 < gap) && (gap < 0x80000000u))
 	{
-	  retval = sourceparams->captured.length;
+	  sourceparams->dropped_frames += gap;
 	}
-
     }
 
-  return(retval);
+  sourceparams->last_sequence = sequence;
+  sourceparams->have_sequence = 1;
 }
 
+
+
+
+/* ************************************************************************* 
+
+
+   NAME:  buffer_timestamp_usec
+
+
+   USAGE: 
+
+   long long capture_usec;
+   struct v4l2_buffer buf;
+
+   -- after VIDIOC_DQBUF
+   capture_usec =  buffer_timestamp_usec(&buf);
+
+   returns: long long
+
+   DESCRIPTION:
+                 the time the driver stamped on buf, in microseconds
+		 of CLOCK_MONOTONIC (what monotonic_usec uses), so it
+		 can be compared with our own times.
+
+		 return 0 if the driver's timestamp isn't from the
+		 monotonic clock (older drivers use the wall clock):
+		 publish_video_frame then uses the time it published
+		 the frame instead.
+
+   REFERENCES: V4L2 spec, V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+long long buffer_timestamp_usec(const struct v4l2_buffer * buf)
+{
+#ifdef V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC
+  if (V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC
+      == (buf->flags & V4L2_BUF_FLAG_TIMESTAMP_MASK))
+    {
+      return((long long)buf->timestamp.tv_sec * 1000000LL
+	     + buf->timestamp.tv_usec);
+    }
+#endif /* V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC  */
+
+  return(0);
+}
@@ -56,6 +56,8 @@ extern int connect_source_buffers(Sourceparams_t * sourceparams);
 extern int start_capture_device(Sourceparams_t * sourceparams);
 extern int stop_capture_device(Sourceparams_t * sourceparams);
 extern void * next_device_frame(Sourceparams_t * sourceparams, int * nbytesp);
+extern int wait_for_device_frame(Sourceparams_t * sourceparams, int useconds);
+extern int requeue_device_buffer(Sourceparams_t * sourceparams, int index);
 
 #ifdef	__cplusplus
 }
@@ -16,6 +16,11 @@
 *
 * capture_and_display
 *
+* capture_and_draw_offscreen (instead of capture_and_display when
+* displaydata->offscreen: no window, no X server)
+*
+* swap_display_buffers
+*
 * end_capture_display
 *
 * describe_captured_pixels
@@ -34,6 +39,9 @@
 *    7-Jan-07          initial coding                        gpk
 *    3-Feb-08  put return value in stop_capture_source for   gpk
 *              test pattern case
+*   17-Oct-26  offscreen display (offscreen.c)
+*   17-Oct-26  start, stop and draw a Sourceset_t (multicapture.c)
+*   17-Oct-26  textures with a tile for each source, for the mosaic
 *
 * TARGET: C
 *
@@ -47,6 +55,7 @@
 #include <string.h> /* memset  */
 
 #include <GL/glew.h> 
+#include <GL/glxew.h> /* glXSwapInterval*  */
 #include <GL/glut.h>
 
 
@@ -54,10 +63,12 @@
 #include "capabilities.h"
 #include "testpattern.h" /* start_testpattern  */
 
-#include "device.h" /*  start_capture_device, stop_capture_device */
+#include "multicapture.h" /*  start_capture_sources, stop_capture_sources */
 #include "shader.h" /* setup_shader  */
 
 #include "callbacks.h" /* setup_glut_window_callbacks  */
+#include "pboring.h" /* init_pboring  */
+#include "offscreen.h" /* create_offscreen_context, ...  */
 
 #include "display.h"
 
@@ -96,11 +107,13 @@ int setup_capture_display_window(Displaydata_t * displaydata,
 void create_glut_window(Displaydata_t * displaydata,
 				 int * argc, char * argv[]);
 int test_ogl_features(void);
+void set_swap_interval(Pacing_t pacing);
 
 char * select_shader_file (Sourceparams_t * sourceparams);
 int init_ogl_video(Displaydata_t * displaydata, Sourceparams_t * sourceparams);
 
 int setup_texture(Displaydata_t * displaydata, Sourceparams_t * sourceparams);
+int check_texture_size(Displaydata_t * displaydata);
 int compute_texture_dimension(int dimension);
 int bytes_per_pixel(Encodingmethod_t encoding);
 void setup_texture_unit(GLenum texture_unit, int texture_width,
@@ -109,8 +122,6 @@ void setup_texture_unit(GLenum texture_unit, int texture_width,
 			GLenum pixelformat);
 GLint texture_internal_format(Encodingmethod_t encoding);
 GLenum texture_pixel_format(Encodingmethod_t encoding);
-int start_capture_source(Sourceparams_t * sourceparams);
-int stop_capture_source(Sourceparams_t * sourceparams);
 
 /* end local prototypes  */
 
@@ -252,6 +263,11 @@ int setup_capture_display(Sourceparams_t * sourceparams,
 		   the source video is encoded
 		 * texture coordinates to display just the part of
 		   the texture that contains the video.
+		 * with several sources (displaydata->tiles), each
+		   gets a tile of the textures, one above the other;
+		   they start out in color with no image processing.
+		   the texture coordinates are for one tile: see
+		   draw_video_tiles in callbacks.c
 
 		 modifies structure pointed to by displaydata
    REFERENCES:
@@ -271,6 +287,7 @@ int setup_capture_display(Sourceparams_t * sourceparams,
         STR                  Description of Revision                 Author
 
       4-Jan-08               initial coding                           gpk
+     17-Oct-26  a tile for each source
 
  ************************************************************************* */
 
@@ -278,6 +295,18 @@ int setup_display_params(Sourceparams_t * sourceparams,
 			 Displaydata_t * displaydata)
 {
 	float dW, dH;
+	int i;
+
+  if (1 > displaydata->tiles)
+    {
+      displaydata->tiles = 1;
+    }
+  for (i = 0; i < MAX_SOURCES; i++)
+    {
+      displaydata->tile_color[i] = 1;
+      displaydata->tile_processing[i] = 0;
+    }
+
   displaydata->texture_width =
     compute_texture_dimension(sourceparams->image_width);
   
@@ -464,7 +493,8 @@ int compute_texture_dimension(int dimension)
 
 		 this uses the glut library to create an OpenGL window,
 		 then tests the features that the installed OpenGL
-		 implementation supports.
+		 implementation supports and sets how swaps line up
+		 with vertical retrace for displaydata->pacing.
 
 		 if we have the features we need, then set up the
 		 callback functions that the glut library will use
@@ -475,6 +505,12 @@ int compute_texture_dimension(int dimension)
 		 operations must take place after the call to
 		 create_glut_window.
 
+		 if displaydata->offscreen, there's no window: make an
+		 offscreen context (offscreen.c) instead, and a
+		 framebuffer object the window's size to draw into.
+		 Draw is called from draw_offscreen_frames rather than
+		 glut.
+
 		 returns 0 on success
 		         -1 on error
 
@@ -495,6 +531,8 @@ int compute_texture_dimension(int dimension)
         STR                  Description of Revision                 Author
 
       4-Jan-08               initial coding                           gpk
+     17-Oct-26  set the swap interval
+     17-Oct-26  offscreen context and framebuffer
 
  ************************************************************************* */
 
@@ -505,6 +543,24 @@ int setup_capture_display_window(Displaydata_t * displaydata,
   int status, retval;
 
 
+  if (0 != displaydata->offscreen)
+    {
+      if (-1 == create_offscreen_context(displaydata))
+	{
+	  return(-1);
+	}
+
+      status = test_ogl_features();
+      if ((-1 == status) || (-1 == setup_offscreen_framebuffer(displaydata)))
+	{
+	  destroy_offscreen_context(displaydata);
+	  return(-1);
+	}
+
+      setup_offscreen_callbacks(displaydata, sourceparams);
+      return(0);
+    }
+
   create_glut_window(displaydata, argc, argv);
   
   
@@ -516,6 +572,7 @@ int setup_capture_display_window(Displaydata_t * displaydata,
     }
   else
     {
+      set_swap_interval(displaydata->pacing);
       setup_glut_window_callbacks(displaydata, sourceparams);
       retval = 0;
     }
@@ -525,6 +582,106 @@ int setup_capture_display_window(Displaydata_t * displaydata,
 
 
 
+/* ************************************************************************* 
+
+
+   NAME:  set_swap_interval
+
+
+   USAGE: 
+
+   Displaydata_t * displaydata;
+
+   set_swap_interval(displaydata->pacing);
+
+   returns: void
+
+   DESCRIPTION:
+                 PACE_VSYNC: make glutSwapBuffers wait for the
+		 vertical retrace, so each frame goes up whole, at
+		 the display's rate.
+
+		 PACE_EVENT: don't wait: show a frame as soon as it's
+		 drawn (it may tear).
+
+		 PACE_TIMER: leave it the way the driver has it (see
+		 __GL_SYNC_TO_VBLANK in glutcam.c).
+
+		 use whichever of the GLX swap control extensions is
+		 there; if none is, say so and leave it alone.
+
+   REFERENCES: GLX_EXT_swap_control, GLX_MESA_swap_control,
+               GLX_SGI_swap_control
+
+   LIMITATIONS:
+
+   GLX_SGI_swap_control can't turn waiting off.
+
+   call after glewInit (in test_ogl_features)
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void set_swap_interval(Pacing_t pacing)
+{
+  int interval;
+
+  switch (pacing)
+    {
+    case PACE_VSYNC:
+      interval = 1;
+      break;
+
+    case PACE_EVENT:
+      interval = 0;
+      break;
+
+    case PACE_TIMER:
+      return;
+
+    default:
+      fprintf(stderr, "Error: %s doesn't have a case for pacing %d\n",
+	      __FUNCTION__, pacing);
+      fprintf(stderr, "add one and recompile\n");
+      abort();
+      break;
+    }
+
+  if (GLXEW_EXT_swap_control)
+    {
+      glXSwapIntervalEXT(glXGetCurrentDisplay(), glXGetCurrentDrawable(),
+			 interval);
+    }
+  else if (GLXEW_MESA_swap_control)
+    {
+      glXSwapIntervalMESA((unsigned int)interval);
+    }
+  else if (GLXEW_SGI_swap_control && (0 < interval))
+    {
+      glXSwapIntervalSGI(interval);
+    }
+  else
+    {
+      fprintf(stderr, "Warning: can't set the swap interval to %d here\n",
+	      interval);
+    }
+}
+
+
+
 /* ************************************************************************* 
 
 
@@ -824,16 +981,16 @@ char * select_shader_file (Sourceparams_t * sourceparams)
    USAGE: 
 
     
-   Sourceparams_t * sourceparams;
+   Sourceset_t * sourceset;
 
-   capture_and_display(sourceparams);
+   capture_and_display(sourceset);
 
    returns: void
 
    DESCRIPTION:
                  capture and display the image data
 
-		 this starts the image source then
+		 this starts the image sources then
 		 passes control to the glut library by
 		 calling glutMainLoop. After this, the
 		 glut library can call the functions we registered
@@ -859,14 +1016,16 @@ char * select_shader_file (Sourceparams_t * sourceparams)
 
       4-Jan-08               initial coding                           gpk
      24-Jan-09           added keypress prompt                        gpk
+     17-Oct-26  every source in a Sourceset_t
  ************************************************************************* */
 
-void capture_and_display(Sourceparams_t * sourceparams)
+void capture_and_display(Sourceset_t * sourceset)
 {
 
   int status;
   
-  status = start_capture_source(sourceparams);
+  set_callback_sources(sourceset);
+  status = start_capture_sources(sourceset);
 
   if (-1 == status)
     {
@@ -876,7 +1035,138 @@ void capture_and_display(Sourceparams_t * sourceparams)
     {
       fprintf(stderr, "\nPress a key in the display window\n");
       glutMainLoop();
-      status = stop_capture_source(sourceparams);
+      status = stop_capture_sources(sourceset);
+      cleanup();
+    }
+}
+
+
+
+/* ************************************************************************* 
+
+
+   NAME:  capture_and_draw_offscreen
+
+
+   USAGE: 
+
+   int status;
+   Sourceset_t * sourceset;
+   Displaydata_t * displaydata;
+
+   displaydata->offscreen = 1;
+   if (0 == setup_capture_display(sourceset->sources[0], displaydata,
+                                  &argc, argv))
+     {
+       status =  capture_and_draw_offscreen(sourceset, displaydata,
+                                            nframes);
+     }
+
+   returns: int
+
+   DESCRIPTION:
+                 capture_and_display with no window: start the
+		 sources, draw nframes offscreen (and report the
+		 throughput, see draw_offscreen_frames), stop the
+		 sources and tear the offscreen context down.
+
+		 return 0 if all's well
+		       -1 if the sources wouldn't start
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+     17-Oct-26  every source in a Sourceset_t
+
+ ************************************************************************* */
+
+int capture_and_draw_offscreen(Sourceset_t * sourceset,
+			       Displaydata_t * displaydata, int nframes)
+{
+  int retval;
+
+  set_callback_sources(sourceset);
+  if (-1 == start_capture_sources(sourceset))
+    {
+      fprintf(stderr, "Error: unable to start capture device\n");
+      retval = -1;
+    }
+  else
+    {
+      (void)draw_offscreen_frames(nframes);
+      (void)stop_capture_sources(sourceset);
+      cleanup();
+      retval = 0;
+    }
+
+  destroy_offscreen_context(displaydata);
+
+  return(retval);
+}
+
+
+
+/* ************************************************************************* 
+
+
+   NAME:  swap_display_buffers
+
+
+   USAGE: 
+
+   Displaydata_t * displaydata;
+
+   swap_display_buffers(displaydata);
+
+   returns: void
+
+   DESCRIPTION:
+                 show what we just drew: glutSwapBuffers for a window,
+		 swap_offscreen_buffers offscreen.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void swap_display_buffers(Displaydata_t * displaydata)
+{
+  if (0 != displaydata->offscreen)
+    {
+      swap_offscreen_buffers(displaydata);
+    }
+  else
+    {
+      glutSwapBuffers();
     }
 }
  
@@ -931,6 +1221,8 @@ void capture_and_display(Sourceparams_t * sourceparams)
         STR                  Description of Revision                 Author
 
       4-Jan-08               initial coding                           gpk
+     17-Oct-26  swap_display_buffers
+     17-Oct-26  check_texture_size
 
  ************************************************************************* */
 
@@ -942,13 +1234,89 @@ int init_ogl_video(Displaydata_t * displaydata, Sourceparams_t * sourceparams)
   glClear(GL_COLOR_BUFFER_BIT);
   
   glFinish(); 
-  glutSwapBuffers();
+  swap_display_buffers(displaydata);
   
-  status = setup_texture(displaydata, sourceparams);
+  status = check_texture_size(displaydata);
+
+  if (0 == status)
+    {
+      status = setup_texture(displaydata, sourceparams);
+    }
 
   return(status);
 }
 
+
+
+
+/* ************************************************************************* 
+
+
+   NAME:  check_texture_size
+
+
+   USAGE: 
+
+   int some_int;
+   Displaydata_t * displaydata;
+   
+   some_int =  check_texture_size(displaydata);
+
+   if (0 == some_int)
+   -- setup_texture can make the textures
+   else
+   -- they'd be too big for this OpenGL
+ 
+   returns: int
+
+   DESCRIPTION:
+                 the textures are displaydata->tiles images tall
+		 (see setup_texture). make sure this OpenGL can have
+		 a texture that big; say so if it can't.
+
+		 return 0 if it can
+		       -1 if it can't
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int check_texture_size(Displaydata_t * displaydata)
+{
+  GLint max_size;
+  int height;
+
+  max_size = 0;
+  glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+  height = displaydata->texture_height * displaydata->tiles;
+
+  if ((height > max_size) || (displaydata->texture_width > max_size))
+    {
+      fprintf(stderr, "Error: %d sources need a %dx%d texture; ",
+	      displaydata->tiles, displaydata->texture_width, height);
+      fprintf(stderr, "this OpenGL only goes to %d\n", (int)max_size);
+      return(-1);
+    }
+
+  return(0);
+}
+
  
 
 
@@ -986,6 +1354,14 @@ int init_ogl_video(Displaydata_t * displaydata, Sourceparams_t * sourceparams)
 		 in the case of YUV420 (a planar format) we need three
 		 texture units: one for each of the U, V, and Y components.
 		 
+		 frames are uploaded through displaydata->pbo_count
+		 pixel buffer objects (see pboring.c), a set for each
+		 plane.
+
+		 with several sources each texture (and PBO) is
+		 displaydata->tiles times as tall: a tile for each
+		 source, stacked, so every source is drawn from the
+		 same texture units in the same pass.
 		 
 
    REFERENCES:
@@ -1005,6 +1381,9 @@ int init_ogl_video(Displaydata_t * displaydata, Sourceparams_t * sourceparams)
         STR                  Description of Revision                 Author
 
       4-Jan-08               initial coding                           gpk
+     17-Oct-26  ring of PBOs instead of one
+     17-Oct-26  PBO rings for the U and V planes too
+     17-Oct-26  displaydata->tiles tiles in each texture
 
  ************************************************************************* */
 
@@ -1023,7 +1402,7 @@ int setup_texture(Displaydata_t * displaydata, Sourceparams_t * sourceparams)
   displaydata->bytes_per_pixel = bytes_per_pixel(sourceparams->encoding);
 
   texture_size = displaydata->texture_width * displaydata->texture_height *
-	displaydata->bytes_per_pixel;
+	displaydata->bytes_per_pixel * displaydata->tiles;
   
   /* if we have a planar encoding, add extra memory for the other  */
   /* planes. if we do all planes in one malloc the memory will be  */
@@ -1034,7 +1413,7 @@ int setup_texture(Displaydata_t * displaydata, Sourceparams_t * sourceparams)
     {
       luma_size = texture_size;
       chroma_width = displaydata->texture_width / 2;
-      chroma_height  = displaydata->texture_height / 2;
+      chroma_height  = displaydata->texture_height * displaydata->tiles / 2;
       chroma_size = texture_size / 4;
       texture_size = luma_size + 2 * chroma_size;
     }
@@ -1096,6 +1475,8 @@ int setup_texture(Displaydata_t * displaydata, Sourceparams_t * sourceparams)
 	  displaydata->v_texturename = 0;
 	  displaydata->v_texture_unit = 0;
 	  displaydata->u_texture_unit = 0;
+	  memset(&(displaydata->u_pbos), 0, sizeof(displaydata->u_pbos));
+	  memset(&(displaydata->v_pbos), 0, sizeof(displaydata->v_pbos));
 	  
 	}
 
@@ -1108,15 +1489,32 @@ int setup_texture(Displaydata_t * displaydata, Sourceparams_t * sourceparams)
       glGenTextures(1, &(displaydata->texturename));
       check_error("after glGenTextures");
       
-      glGenBuffersARB(1, &displaydata->pboIds);
-      glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, displaydata->pboIds);
-      glBufferDataARB(GL_PIXEL_UNPACK_BUFFER_ARB, texture_size, 0, GL_STREAM_DRAW_ARB);
-      glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+      /* YUV420 gets a ring for each plane so they upload separately  */
+      if (YUV420 == sourceparams->encoding)
+	{
+	  status = init_pboring(&(displaydata->pbos), displaydata->pbo_count,
+				(size_t)luma_size);
+	  if (0 == status)
+	    {
+	      status = init_pboring(&(displaydata->u_pbos),
+				    displaydata->pbo_count, (size_t)chroma_size);
+	    }
+	  if (0 == status)
+	    {
+	      status = init_pboring(&(displaydata->v_pbos),
+				    displaydata->pbo_count, (size_t)chroma_size);
+	    }
+	}
+      else
+	{
+	  status = init_pboring(&(displaydata->pbos), displaydata->pbo_count,
+				(size_t)texture_size);
+	}
 
 
       setup_texture_unit(GL_TEXTURE0,
 			 displaydata->texture_width,
-			 displaydata->texture_height,
+			 displaydata->texture_height * displaydata->tiles,
 			 displaydata->texturename, displaydata->texture,
 			 internal_format, pixelformat);
       
@@ -1126,8 +1524,6 @@ int setup_texture(Displaydata_t * displaydata, Sourceparams_t * sourceparams)
       /* setting the intensities (Y component) to zero -> black  */
       
       memset(displaydata->texture, 0, texture_size);
-
-      status = 0; /* okay  */
     }
   return(status);
 }
@@ -1476,173 +1872,6 @@ GLenum texture_pixel_format(Encodingmethod_t encoding)
 
 
 
-/* ************************************************************************* 
-
-
-   NAME:  start_capture_source
-
-
-   USAGE: 
-
-   int some_int;
-   Sourceparams_t * sourceparams;
-   
-   some_int =  start_capture_source(sourceparams);
-
-   if (0 == some_int)
-   -- we're okay
-   else
-   -- handle an error
-   returns: int
-
-   DESCRIPTION:
-                 start the capture source (test pattern or
-		 V4L2 device).
-
-		 in the case of a test pattern, this doesn't mean much
-
-		 in the case of a physical device this tells it to
-		 start producing data.
-
-		 if this function doesn't recognize the source,
-		 it will print an error message and abort so
-		 you can add the case statement.
-
-		 return 0 if all's well
-		       -1 on error starting the source
-		       
-
-   REFERENCES:
-
-   LIMITATIONS:
-
-   GLOBAL VARIABLES:
-
-      accessed: none
-
-      modified: none
-
-   FUNCTIONS CALLED:
-
-   REVISION HISTORY:
-
-        STR                  Description of Revision                 Author
-
-      4-Jan-08               initial coding                           gpk
-
- ************************************************************************* */
-
-int start_capture_source(Sourceparams_t * sourceparams)
-{
-  int retval;
-  
-  switch (sourceparams->source)
-    {
-    case TESTPATTERN:
-      retval = start_testpattern(sourceparams);
-      break;
-
-    case LIVESOURCE:
-      retval = start_capture_device(sourceparams);
-      break;
-
-    default:
-      fprintf(stderr, "Error: %s doesn't have a case for source %d\n",
-	      __FUNCTION__, sourceparams->source);
-      fprintf(stderr, "add one and recompile\n");
-      abort();
-      break;
-    }
-  return(retval);
-}
-
-
-
-
-/* ************************************************************************* 
-
-
-   NAME:  stop_capture_source
-
-
-   USAGE: 
-
-   int some_int;
-   Sourceparams_t * sourceparams;
-
-   some_int =  stop_capture_source(sourceparams);
-
-   if (0 == some_int)
-   -- we're okay
-   else
-   -- handle an error
-   returns: int
-
-   DESCRIPTION:
-                 stop the capture source
-
-		 in the case of a test pattern, this doesn't mean much
-
-		 in the case of a physical device this tells it to
-		 stop producing data.
-		 
-		 if this function doesn't recognize the source,
-		 it will print an error message and abort so
-		 you can add the case statement.
-
-		 return 0 if all's well
-		       -1 on error starting the source
-
-   REFERENCES:
-
-   LIMITATIONS:
-
-   GLOBAL VARIABLES:
-
-      accessed: none
-
-      modified: none
-
-   FUNCTIONS CALLED:
-
-   REVISION HISTORY:
-
-        STR                  Description of Revision                 Author
-
-      4-Jan-08               initial coding                           gpk
-      3-Feb-08 added retval from testpattern as well                  gpk
- ************************************************************************* */
-
-int stop_capture_source(Sourceparams_t * sourceparams)
-{
-  int retval;
-  
-  switch (sourceparams->source)
-    {
-    case TESTPATTERN:
-      /* there is no "stop test pattern"  */
-      retval = 0; /* this is to make the optimizer happy  */
-      break;
-
-    case LIVESOURCE:
-       retval = stop_capture_device(sourceparams);
-       cleanup();
-      break;
-
-    default:
-      fprintf(stderr, "Error: %s doesn't have a case for source %d\n",
-	      __FUNCTION__, sourceparams->source);
-      fprintf(stderr, "add one and recompile\n");
-      retval = 0; /* this is to make the optimizer happy  */
-      abort();
-      break;
-    }
-  return(retval);
-}
-
-
-
-
 /* ************************************************************************* 
 
 
@@ -1652,18 +1881,18 @@ int stop_capture_source(Sourceparams_t * sourceparams)
    USAGE: 
 
     
-   Sourceparams_t * sourceparams;
+   Sourceset_t * sourceset;
    
    Displaydata_t * displaydata;
    
-   end_capture_display(sourceparams, displaydata);
+   end_capture_display(sourceset, displaydata);
 
    returns: void
 
    DESCRIPTION:
-                 end the use of the source. (probably because the
+                 end the use of the sources. (probably because the
 		 program is exiting.) right now this is the same
-		 as stop_capture_source
+		 as stop_capture_sources
 
    REFERENCES:
 
@@ -1682,30 +1911,15 @@ int stop_capture_source(Sourceparams_t * sourceparams)
         STR                  Description of Revision                 Author
 
       4-Jan-08               initial coding                           gpk
+     17-Oct-26  call stop_capture_source so the capture thread stops too
+     17-Oct-26  stop every source in the set
 
  ************************************************************************* */
 
-void end_capture_display(Sourceparams_t * sourceparams,
+void end_capture_display(Sourceset_t * sourceset,
 			 Displaydata_t * displaydata)
 {
-   switch (sourceparams->source)
-    {
-    case TESTPATTERN:
-      /* there is no "stop test pattern"  */
-      break;
-
-    case LIVESOURCE:
-      (void) stop_capture_device(sourceparams);
-      break;
-
-    default:
-      fprintf(stderr, "Error: %s doesn't have a case for source %d\n",
-	      __FUNCTION__, sourceparams->source);
-      fprintf(stderr, "add one and recompile\n");
-      abort();
-      break;
-    } 
-
+  (void) stop_capture_sources(sourceset);
 }
 
 
@@ -18,6 +18,9 @@
 *   STR                Description                          Author
 *
 *    7-Jan-07          initial coding                        gpk
+*   17-Oct-26          capture_and_draw_offscreen, swap_display_buffers
+*   17-Oct-26          capture_and_display, capture_and_draw_offscreen
+*                      and end_capture_display take a Sourceset_t
 *
 * TARGET: C
 *
@@ -31,10 +34,16 @@ extern int setup_capture_display(Sourceparams_t * sourceparams,
 				 int * argc, char * argv[]);
 
 
-extern void capture_and_display(Sourceparams_t * sourceparams);
+extern void capture_and_display(Sourceset_t * sourceset);
 
+extern int capture_and_draw_offscreen(Sourceset_t * sourceset,
+				      Displaydata_t * displaydata,
+				      int nframes);
 
-extern void end_capture_display(Sourceparams_t * sourceparams,
+extern void swap_display_buffers(Displaydata_t * displaydata);
+
+
+extern void end_capture_display(Sourceset_t * sourceset,
 				Displaydata_t * displaydata);
 
 extern void describe_captured_pixels(char * label,
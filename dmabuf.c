@@ -0,0 +1,1113 @@
+/* *************************************************************************
+* NAME: glutcam/dmabuf.c
+*
+* DESCRIPTION:
+*
+* share the capture device's buffers with other processes without
+* copying the frames. device.c exports each buffer as a dmabuf file
+* descriptor; here we pass those descriptors to whoever connects to
+* a unix socket (SCM_RIGHTS), then send each client a short message
+* per frame saying which buffer it's in.
+*
+* a client reads one frame at a time and sends DMABUF_MSG_RELEASE when
+* it's done. until then the driver can't have that buffer back:
+* release_video_frame asks defer_dmabuf_release first, and whatever
+* dequeues the device's frames (requeue_released_buffers in capture.c)
+* requeues the buffer once collect_dmabuf_releases says the last
+* client let go of it. a client is sent no new frames while it holds
+* one: it always reads a whole frame, frames published while it's
+* busy pass it by, and each client keeps at most one buffer from the
+* driver.
+*
+* the socket is SOCK_SEQPACKET so every Dmabufmsg_t arrives whole,
+* and non-blocking so a stuck client can't stall capture: if its
+* socket is full it just misses frames.
+*
+* PROCESS:
+*
+* see dmabuf.h
+*
+* GLOBALS: none
+*
+* REFERENCES:
+*
+* LIMITATIONS:
+*
+* start, serve, collect and stop are called from the capture side
+* only; defer_dmabuf_release from whichever thread releases frames.
+* held[] and deferred[] are shared between them under dmabuf.lock.
+*
+* a device needs a buffer per client on top of what glutcam itself
+* keeps (-b), or a client holding a frame can leave the driver short.
+*
+* REVISION HISTORY:
+*
+*   STR                Description                          Author
+*
+*   17-Oct-26          initial coding
+*   17-Oct-26          clients release the frames they read
+*
+* TARGET: Linux C
+*
+* This software is in the public domain. if it breaks you get to keep
+* both pieces.
+*
+* ************************************************************************* */
+
+#define _GNU_SOURCE /* accept4  */
+#include <stdio.h>
+#include <string.h> /* memset, memcpy, strncpy  */
+#include <errno.h>
+#include <unistd.h> /* close, unlink  */
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "glutcam.h"
+#include "dmabuf.h"
+
+/* MAX_PASSED_FDS - the most buffers we'll pass in one message  */
+
+#define MAX_PASSED_FDS 64
+
+/* local prototypes  */
+void accept_dmabuf_clients(Sourceparams_t * sourceparams);
+int send_dmabuf_buffers(Sourceparams_t * sourceparams, int client);
+void drop_dmabuf_client(Dmabufserver_t * server, int which);
+int dmabuf_buffer_held(const Dmabufserver_t * server, int index);
+int set_socket_path(struct sockaddr_un * address, const char * path);
+/* end local prototypes  */
+
+
+
+/* *************************************************************************
+
+
+   NAME:  start_dmabuf_server
+
+
+   USAGE:
+
+   int some_int;
+   Sourceparams_t * sourceparams;
+
+   some_int =  start_dmabuf_server(sourceparams);
+
+   if (0 == some_int)
+   -- clients can connect to sourceparams->dmabuf.path
+   else
+   -- carry on without sharing
+
+   returns: int
+
+   DESCRIPTION:
+                 if the device's buffers were exported, listen for
+		 consumers on sourceparams->dmabuf.path, replacing any
+		 socket a previous run left there.
+
+		 return 0 if all's well
+		       -1 if there's nothing to share or the socket
+		          can't be set up
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int start_dmabuf_server(Sourceparams_t * sourceparams)
+{
+  Dmabufserver_t * server;
+  struct sockaddr_un address;
+  int fd;
+
+  server = &(sourceparams->dmabuf);
+  server->running = 0;
+  server->nclients = 0;
+  server->sequence = 0;
+
+  if ((0 == server->nfds) || (MAX_PASSED_FDS < server->nfds))
+    {
+      return(-1);
+    }
+
+  if (-1 == set_socket_path(&address, server->path))
+    {
+      fprintf(stderr, "Error: dmabuf socket name %s is too long\n",
+	      server->path);
+      return(-1);
+    }
+
+  fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+  if (-1 == fd)
+    {
+      perror("Error creating dmabuf socket");
+      return(-1);
+    }
+
+  (void)unlink(server->path);
+
+  if ((-1 == bind(fd, (struct sockaddr *)&address, sizeof(address)))
+      || (-1 == listen(fd, MAX_DMABUF_CLIENTS)))
+    {
+      perror("Error listening on dmabuf socket");
+      close(fd);
+      return(-1);
+    }
+
+  memset(server->deferred, 0, sizeof(server->deferred));
+  pthread_mutex_init(&(server->lock), NULL);
+  server->listen_fd = fd;
+  server->running = 1;
+
+  fprintf(stderr, "sharing %d %ux%u buffers on %s\n", server->nfds,
+	  server->width, server->height, server->path);
+
+  return(0);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  serve_dmabuf_frame
+
+
+   USAGE:
+
+   Sourceparams_t * sourceparams;
+   Frameslot_t slot;
+
+   serve_dmabuf_frame(sourceparams, &slot);
+
+   returns: void
+
+   DESCRIPTION:
+                 take on any clients waiting to connect, then tell
+		 every client that a frame of slot->length bytes is in
+		 buffer slot->index. each client that's told holds
+		 the buffer until it sends DMABUF_MSG_RELEASE.
+
+		 a client still holding an earlier frame, or whose
+		 socket is full, misses this frame; one that has hung
+		 up is dropped.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   slot->index has to be a device buffer
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+     17-Oct-26  skip clients holding a frame; send the capture time
+
+ ************************************************************************* */
+
+void serve_dmabuf_frame(Sourceparams_t * sourceparams,
+			const Frameslot_t * slot)
+{
+  Dmabufserver_t * server;
+  Dmabufmsg_t msg;
+  int i;
+
+  server = &(sourceparams->dmabuf);
+
+  if (0 == server->running)
+    {
+      return;
+    }
+
+  pthread_mutex_lock(&(server->lock));
+
+  accept_dmabuf_clients(sourceparams);
+
+  memset(&msg, 0, sizeof(msg));
+  msg.type = DMABUF_MSG_FRAME;
+  msg.index = (unsigned int)slot->index;
+  msg.length = (unsigned int)slot->length;
+  msg.width = server->width;
+  msg.height = server->height;
+  msg.fourcc = server->fourcc;
+  msg.bytesperline = server->bytesperline;
+  msg.sequence = server->sequence++;
+  msg.timestamp_usec = slot->capture_usec;
+
+  /* go backwards so dropping a client doesn't skip the next one.  */
+  /* a client we send to holds nothing, so dropping it frees nothing  */
+  for (i = server->nclients - 1; 0 <= i; i--)
+    {
+      if (-1 != server->held[i])
+	{
+	  continue;
+	}
+
+      if (-1 != send(server->clients[i], &msg, sizeof(msg),
+		     MSG_DONTWAIT | MSG_NOSIGNAL))
+	{
+	  server->held[i] = slot->index;
+	}
+      else if ((EAGAIN != errno) && (EWOULDBLOCK != errno))
+	{
+	  drop_dmabuf_client(server, i);
+	}
+    }
+
+  pthread_mutex_unlock(&(server->lock));
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  defer_dmabuf_release
+
+
+   USAGE:
+
+   Sourceparams_t * sourceparams;
+   Frameslot_t slot;
+
+   if (0 == defer_dmabuf_release(sourceparams, slot.index))
+   -- give the buffer back to the driver now
+
+   returns: int
+
+   DESCRIPTION:
+                 we're done with buffer index. if a client is still
+		 reading it, note that it's to go back to the driver
+		 when the client releases it (collect_dmabuf_releases
+		 says when).
+
+		 return 1 if a client holds the buffer
+		        0 if it can be requeued now
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int defer_dmabuf_release(Sourceparams_t * sourceparams, int index)
+{
+  Dmabufserver_t * server;
+  int held;
+
+  server = &(sourceparams->dmabuf);
+
+  if ((0 == server->running) || (0 > index) || (server->nfds <= index))
+    {
+      return(0);
+    }
+
+  pthread_mutex_lock(&(server->lock));
+  held = dmabuf_buffer_held(server, index);
+  if (0 != held)
+    {
+      server->deferred[index] = 1;
+    }
+  pthread_mutex_unlock(&(server->lock));
+
+  return(held);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  collect_dmabuf_releases
+
+
+   USAGE:
+
+   int n, i;
+   Sourceparams_t * sourceparams;
+   int freed[MAX_VIDEO_BUFFERS];
+
+   n =  collect_dmabuf_releases(sourceparams, freed, MAX_VIDEO_BUFFERS);
+   for (i = 0; i < n; i++)
+   -- give buffer freed[i] back to the driver
+
+   returns: int
+
+   DESCRIPTION:
+                 read the DMABUF_MSG_RELEASE messages clients have
+		 sent, without waiting for more. a client that has
+		 hung up releases what it held and is dropped.
+
+		 the buffers that were only waiting on those clients
+		 (see defer_dmabuf_release) go in
+		 freed[0...maxfreed - 1].
+
+		 return the number of buffers stored in freed
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   a release for a buffer the client wasn't sent is ignored. maxfreed
+   has to be at least MAX_DMABUF_CLIENTS, or a buffer can be lost to
+   the driver for good.
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int collect_dmabuf_releases(Sourceparams_t * sourceparams, int * freed,
+			    int maxfreed)
+{
+  Dmabufserver_t * server;
+  Dmabufmsg_t msg;
+  ssize_t nread;
+  int i, index, nfreed;
+
+  server = &(sourceparams->dmabuf);
+
+  if (0 == server->running)
+    {
+      return(0);
+    }
+
+  nfreed = 0;
+
+  pthread_mutex_lock(&(server->lock));
+
+  for (i = server->nclients - 1; 0 <= i; i--)
+    {
+      index = -1;
+
+      while (0 < (nread = recv(server->clients[i], &msg, sizeof(msg),
+			       MSG_DONTWAIT)))
+	{
+	  if (((ssize_t)sizeof(msg) == nread)
+	      && (DMABUF_MSG_RELEASE == msg.type)
+	      && ((unsigned int)server->held[i] == msg.index))
+	    {
+	      index = server->held[i];
+	      server->held[i] = -1;
+	    }
+	}
+
+      if ((0 == nread) || ((EAGAIN != errno) && (EWOULDBLOCK != errno)))
+	{
+	  if (-1 != server->held[i])
+	    {
+	      index = server->held[i];
+	    }
+	  drop_dmabuf_client(server, i);
+	}
+
+      if ((-1 != index) && (0 != server->deferred[index])
+	  && (0 == dmabuf_buffer_held(server, index)) && (nfreed < maxfreed))
+	{
+	  server->deferred[index] = 0;
+	  freed[nfreed++] = index;
+	}
+    }
+
+  pthread_mutex_unlock(&(server->lock));
+
+  return(nfreed);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  stop_dmabuf_server
+
+
+   USAGE:
+
+   Sourceparams_t * sourceparams;
+
+   stop_dmabuf_server(sourceparams);
+
+   returns: void
+
+   DESCRIPTION:
+                 hang up on every client, stop listening, remove the
+		 socket and close the exported buffers. safe to call
+		 if the server never started.
+
+		 clients keep whatever buffers they were given; the
+		 memory goes away when the last of them closes its
+		 copy. buffers still waiting on a client aren't
+		 requeued: capture has stopped.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void stop_dmabuf_server(Sourceparams_t * sourceparams)
+{
+  Dmabufserver_t * server;
+  int i;
+
+  server = &(sourceparams->dmabuf);
+
+  if (0 != server->running)
+    {
+      while (0 < server->nclients)
+	{
+	  drop_dmabuf_client(server, server->nclients - 1);
+	}
+
+      close(server->listen_fd);
+      (void)unlink(server->path);
+      pthread_mutex_destroy(&(server->lock));
+      server->running = 0;
+    }
+
+  for (i = 0; i < server->nfds; i++)
+    {
+      close(sourceparams->buffers[i].dmabuf_fd);
+      sourceparams->buffers[i].dmabuf_fd = -1;
+    }
+  server->nfds = 0;
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  connect_dmabuf_server
+
+
+   USAGE:
+
+   int fd;
+
+   fd =  connect_dmabuf_server("/tmp/glutcam.sock");
+
+   if (-1 == fd)
+   -- handle an error
+
+   returns: int
+
+   DESCRIPTION:
+                 the consumer's end: connect to a glutcam sharing its
+		 buffers on path. the first message that arrives on
+		 the returned socket is DMABUF_MSG_BUFFERS.
+
+		 return the socket, or -1 on error
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int connect_dmabuf_server(const char * path)
+{
+  struct sockaddr_un address;
+  int fd;
+
+  if (-1 == set_socket_path(&address, path))
+    {
+      return(-1);
+    }
+
+  fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+
+  if (-1 == fd)
+    {
+      perror("Error creating dmabuf client socket");
+      return(-1);
+    }
+
+  if (-1 == connect(fd, (struct sockaddr *)&address, sizeof(address)))
+    {
+      perror("Error connecting to dmabuf socket");
+      close(fd);
+      return(-1);
+    }
+
+  return(fd);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  receive_dmabuf_message
+
+
+   USAGE:
+
+   int nfds;
+   int fd;
+   Dmabufmsg_t msg;
+   int fds[MAX_VIDEO_BUFFERS];
+
+   nfds =  receive_dmabuf_message(fd, &msg, fds, MAX_VIDEO_BUFFERS);
+
+   returns: int
+
+   DESCRIPTION:
+                 the consumer's end: wait for the next message on fd
+		 and put it in msg. any file descriptors that came
+		 with it go in fds[0...maxfds - 1]; ones that don't
+		 fit are closed.
+
+		 return the number of file descriptors stored in fds
+		       -1 on error or if the server hung up
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+     17-Oct-26  a reset is a hang up
+
+ ************************************************************************* */
+
+int receive_dmabuf_message(int fd, Dmabufmsg_t * msg, int * fds, int maxfds)
+{
+  struct msghdr header;
+  struct iovec iov;
+  struct cmsghdr * cmsg;
+  union {
+    char buf[CMSG_SPACE(MAX_PASSED_FDS * sizeof(int))];
+    struct cmsghdr align;
+  } control;
+  int passed[MAX_PASSED_FDS];
+  ssize_t nread;
+  int i, npassed, nstored;
+
+  memset(&header, 0, sizeof(header));
+  iov.iov_base = msg;
+  iov.iov_len = sizeof(*msg);
+  header.msg_iov = &iov;
+  header.msg_iovlen = 1;
+  header.msg_control = control.buf;
+  header.msg_controllen = sizeof(control.buf);
+
+  nread = recvmsg(fd, &header, MSG_CMSG_CLOEXEC);
+
+  /* a server that hangs up with our last release unread resets  */
+  if ((ssize_t)sizeof(*msg) != nread)
+    {
+      if ((-1 == nread) && (ECONNRESET != errno))
+	{
+	  perror("Error reading dmabuf socket");
+	}
+      return(-1);
+    }
+
+  npassed = 0;
+  for (cmsg = CMSG_FIRSTHDR(&header); NULL != cmsg;
+       cmsg = CMSG_NXTHDR(&header, cmsg))
+    {
+      if ((SOL_SOCKET == cmsg->cmsg_level) && (SCM_RIGHTS == cmsg->cmsg_type))
+	{
+	  npassed = (int)((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+	  memcpy(passed, CMSG_DATA(cmsg), npassed * sizeof(int));
+	}
+    }
+
+  nstored = 0;
+  for (i = 0; i < npassed; i++)
+    {
+      if (nstored < maxfds)
+	{
+	  fds[nstored++] = passed[i];
+	}
+      else
+	{
+	  close(passed[i]);
+	}
+    }
+
+  return(nstored);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  release_dmabuf_frame
+
+
+   USAGE:
+
+   int fd;
+   Dmabufmsg_t msg;
+
+   -- msg is a DMABUF_MSG_FRAME from receive_dmabuf_message
+   -- read the frame in fds[msg.index], then
+   if (-1 == release_dmabuf_frame(fd, &msg))
+   -- the server's gone
+
+   returns: int
+
+   DESCRIPTION:
+                 the consumer's end: tell the server we're done with
+		 the frame described by msg. no more frames arrive
+		 until we do.
+
+		 return 0 if all's well
+		       -1 on error
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   don't touch the buffer afterwards: the driver may be refilling it
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int release_dmabuf_frame(int fd, const Dmabufmsg_t * frame)
+{
+  Dmabufmsg_t msg;
+
+  memset(&msg, 0, sizeof(msg));
+  msg.type = DMABUF_MSG_RELEASE;
+  msg.index = frame->index;
+  msg.sequence = frame->sequence;
+
+  if ((ssize_t)sizeof(msg) != send(fd, &msg, sizeof(msg), MSG_NOSIGNAL))
+    {
+      return(-1);
+    }
+
+  return(0);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  accept_dmabuf_clients
+
+
+   USAGE:
+
+   accept_dmabuf_clients(sourceparams);
+
+   returns: void
+
+   DESCRIPTION:
+                 take on every client waiting to connect and send it
+		 the buffers. turn away any beyond MAX_DMABUF_CLIENTS.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void accept_dmabuf_clients(Sourceparams_t * sourceparams)
+{
+  Dmabufserver_t * server;
+  int client;
+
+  server = &(sourceparams->dmabuf);
+
+  while (-1 != (client = accept4(server->listen_fd, NULL, NULL,
+				 SOCK_NONBLOCK | SOCK_CLOEXEC)))
+    {
+      if (MAX_DMABUF_CLIENTS <= server->nclients)
+	{
+	  fprintf(stderr, "Warning: already %d dmabuf clients; refusing another\n",
+		  server->nclients);
+	  close(client);
+	}
+      else if (-1 == send_dmabuf_buffers(sourceparams, client))
+	{
+	  close(client);
+	}
+      else
+	{
+	  server->held[server->nclients] = -1;
+	  server->clients[server->nclients++] = client;
+	}
+    }
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  send_dmabuf_buffers
+
+
+   USAGE:
+
+   int some_int;
+
+   some_int =  send_dmabuf_buffers(sourceparams, client);
+
+   returns: int
+
+   DESCRIPTION:
+                 send client a DMABUF_MSG_BUFFERS message carrying
+		 the exported buffers in index order
+
+		 return 0 if all's well
+		       -1 on error
+
+   REFERENCES: unix(7), cmsg(3)
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int send_dmabuf_buffers(Sourceparams_t * sourceparams, int client)
+{
+  Dmabufserver_t * server;
+  Dmabufmsg_t msg;
+  struct msghdr header;
+  struct iovec iov;
+  struct cmsghdr * cmsg;
+  union {
+    char buf[CMSG_SPACE(MAX_PASSED_FDS * sizeof(int))];
+    struct cmsghdr align;
+  } control;
+  int fds[MAX_PASSED_FDS];
+  int i;
+
+  server = &(sourceparams->dmabuf);
+
+  memset(&msg, 0, sizeof(msg));
+  msg.type = DMABUF_MSG_BUFFERS;
+  msg.count = (unsigned int)server->nfds;
+  msg.length = (unsigned int)sourceparams->buffers[0].length;
+  msg.width = server->width;
+  msg.height = server->height;
+  msg.fourcc = server->fourcc;
+  msg.bytesperline = server->bytesperline;
+
+  for (i = 0; i < server->nfds; i++)
+    {
+      fds[i] = sourceparams->buffers[i].dmabuf_fd;
+    }
+
+  memset(&header, 0, sizeof(header));
+  memset(&control, 0, sizeof(control));
+  iov.iov_base = &msg;
+  iov.iov_len = sizeof(msg);
+  header.msg_iov = &iov;
+  header.msg_iovlen = 1;
+  header.msg_control = control.buf;
+  header.msg_controllen = CMSG_SPACE(server->nfds * sizeof(int));
+
+  cmsg = CMSG_FIRSTHDR(&header);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(server->nfds * sizeof(int));
+  memcpy(CMSG_DATA(cmsg), fds, server->nfds * sizeof(int));
+
+  if ((ssize_t)sizeof(msg) != sendmsg(client, &header, MSG_NOSIGNAL))
+    {
+      perror("Error sending buffers to dmabuf client");
+      return(-1);
+    }
+
+  return(0);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  drop_dmabuf_client
+
+
+   USAGE:
+
+   drop_dmabuf_client(server, i);
+
+   returns: void
+
+   DESCRIPTION:
+                 close server->clients[which] and close up the gap.
+		 whatever it held is the caller's to requeue.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void drop_dmabuf_client(Dmabufserver_t * server, int which)
+{
+  close(server->clients[which]);
+  server->nclients--;
+  server->clients[which] = server->clients[server->nclients];
+  server->held[which] = server->held[server->nclients];
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  dmabuf_buffer_held
+
+
+   USAGE:
+
+   if (0 != dmabuf_buffer_held(server, index))
+   -- a client is reading buffer index
+
+   returns: int
+
+   DESCRIPTION:
+                 return 1 if some client holds buffer index, 0 if not
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   call it with server->lock held
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int dmabuf_buffer_held(const Dmabufserver_t * server, int index)
+{
+  int i;
+
+  for (i = 0; i < server->nclients; i++)
+    {
+      if (index == server->held[i])
+	{
+	  return(1);
+	}
+    }
+
+  return(0);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  set_socket_path
+
+
+   USAGE:
+
+   struct sockaddr_un address;
+
+   if (0 == set_socket_path(&address, path))
+   -- bind or connect to address
+
+   returns: int
+
+   DESCRIPTION:
+                 fill in address for the unix socket at path
+
+		 return 0 if all's well
+		       -1 if path is too long to fit
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int set_socket_path(struct sockaddr_un * address, const char * path)
+{
+  memset(address, 0, sizeof(*address));
+  address->sun_family = AF_UNIX;
+
+  if (sizeof(address->sun_path) <= strlen(path))
+    {
+      return(-1);
+    }
+
+  strncpy(address->sun_path, path, sizeof(address->sun_path) - 1);
+
+  return(0);
+}
@@ -0,0 +1,94 @@
+/* *************************************************************************
+* NAME: glutcam/dmabuf.h
+*
+* DESCRIPTION:
+*
+* this is the header file for the functions exported from dmabuf.c
+*
+* PROCESS:
+*
+* capture side (device.c exports the buffers with VIDIOC_EXPBUF first):
+*
+* start_dmabuf_server listens on sourceparams->dmabuf.path
+*
+* serve_dmabuf_frame takes on any new clients and tells every client
+*   not still reading a frame which buffer the new frame is in.
+*   publish_video_frame calls it.
+*
+* defer_dmabuf_release: release_video_frame asks it before giving a
+*   buffer back to the driver; 1 means a client still holds it
+*
+* collect_dmabuf_releases reads the clients' releases and says which
+*   deferred buffers can go back to the driver now.
+*   requeue_released_buffers (capture.c) calls it before every look
+*   for a device frame, threaded, polled or epoll.
+*
+* stop_dmabuf_server hangs up on the clients, removes the socket and
+*   closes the exported buffers
+*
+* consumer side (another process; glutcam_dmabufclient is one):
+*
+*   fd = connect_dmabuf_server(path);
+*   n = receive_dmabuf_message(fd, &msg, fds, MAX_VIDEO_BUFFERS);
+*     -- msg.type is DMABUF_MSG_BUFFERS, fds[0...n - 1] are the buffers
+*   loop
+*     receive_dmabuf_message(fd, &msg, NULL, 0);
+*     -- msg.type is DMABUF_MSG_FRAME, the frame is in fds[msg.index]
+*     release_dmabuf_frame(fd, &msg);
+*
+*   a consumer can mmap fds[i] read-only, or hand it to
+*   eglCreateImageKHR(EGL_LINUX_DMA_BUF_EXT) with msg.width,
+*   msg.height, msg.fourcc (as a DRM fourcc) and msg.bytesperline
+*   to texture from it without a copy.
+*
+* GLOBALS: none
+*
+* REFERENCES: unix(7) SCM_RIGHTS, EGL_EXT_image_dma_buf_import
+*
+* LIMITATIONS:
+*
+* a consumer gets no more frames until it releases the one it has,
+* and that buffer stays out of the driver's hands meanwhile: a slow
+* consumer misses frames, and with too few buffers (-b) can make the
+* driver drop some.
+*
+* REVISION HISTORY:
+*
+*   STR                Description                          Author
+*
+*   17-Oct-26          initial coding
+*   17-Oct-26          release messages
+*
+* TARGET: Linux C
+*
+* This software is in the public domain. if it breaks you get to keep
+* both pieces.
+*
+* ************************************************************************* */
+
+#ifndef	__DMABUF_H__
+#define	__DMABUF_H__
+
+#include "glutcam.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+extern int start_dmabuf_server(Sourceparams_t * sourceparams);
+extern void serve_dmabuf_frame(Sourceparams_t * sourceparams,
+			       const Frameslot_t * slot);
+extern int defer_dmabuf_release(Sourceparams_t * sourceparams, int index);
+extern int collect_dmabuf_releases(Sourceparams_t * sourceparams,
+				   int * freed, int maxfreed);
+extern void stop_dmabuf_server(Sourceparams_t * sourceparams);
+extern int connect_dmabuf_server(const char * path);
+extern int receive_dmabuf_message(int fd, Dmabufmsg_t * msg, int * fds,
+				  int maxfds);
+extern int release_dmabuf_frame(int fd, const Dmabufmsg_t * frame);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	//__DMABUF_H__
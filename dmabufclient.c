@@ -0,0 +1,894 @@
+/* *************************************************************************
+* NAME: glutcam/dmabufclient.c
+*
+* DESCRIPTION:
+*
+* glutcam_dmabufclient: a consumer of the buffers glutcam -x shares
+* (dmabuf.c), and a check that what it reads is what was captured.
+*
+* by default it runs its own mock device: this process stands in for
+* the capture side, with memfd buffers in place of the driver's
+* dmabufs, and forks a consumer. each frame it publishes is stamped
+* so the consumer can tell if it's whole: the first 64 bit word is
+* the frame's capture time, the rest is pattern_word(sequence) over
+* and over. the mock driver refills the buffer it got back last
+* first, the worst case for a consumer that's still reading one, and
+* the consumer takes -u microseconds over each frame, between the two
+* halves, to give it every chance to tear.
+*
+* the consumer checks every word of every frame and the timestamp
+* that came with it, releases the frame and reports:
+*
+* * frames read, and frames that went by while it was reading
+* * frames that were wrong: torn, overwritten, or with a timestamp
+*   that isn't their capture time
+*
+* with -a it's just the consumer, on the socket of a running glutcam
+* -x: it maps the real device's buffers, reads every byte of each
+* frame it's sent and checks the messages make sense, but it can't
+* know what the pixels should be.
+*
+* PROCESS:
+*
+* make glutcam_dmabufclient
+* ./glutcam_dmabufclient                  -- mock device, slow consumer
+* ./glutcam_dmabufclient -b 2 -f 0        -- no buffer to spare, flat out
+* ./glutcam -d /dev/video0 -x /tmp/cam.sock &
+* ./glutcam_dmabufclient -a /tmp/cam.sock -- read the camera's frames
+*
+* and the same with the capture thread (-T) and the epoll thread (-E):
+* however the frames are captured, the consumer should read nearly
+* every one of them, not just the first
+*
+* ./glutcam -d /dev/video0 -x /tmp/cam.sock -n 300 -T &
+* ./glutcam_dmabufclient -a /tmp/cam.sock
+* ./glutcam -d /dev/video0 -x /tmp/cam.sock -n 300 -E &
+* ./glutcam_dmabufclient -a /tmp/cam.sock
+*
+* GLOBALS: none
+*
+* REFERENCES:
+*
+* LIMITATIONS:
+*
+* the content check ignores the last few bytes of a frame that isn't
+* a multiple of 8 bytes. the mock device needs memfd_create (Linux
+* 3.17, glibc 2.27).
+*
+* REVISION HISTORY:
+*
+*   STR                Description                          Author
+*
+*   17-Oct-26          initial coding
+*   17-Oct-26          runs for each way of capturing
+*
+* TARGET: Linux C
+*
+* This software is in the public domain. if it breaks you get to keep
+* both pieces.
+*
+* ************************************************************************* */
+
+#define _GNU_SOURCE /* memfd_create  */
+#include <stdio.h>
+#include <stdlib.h> /* atoi  */
+#include <string.h> /* memset, strncpy  */
+#include <unistd.h> /* getopt, fork, pipe, ftruncate, _exit  */
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/mman.h> /* mmap, memfd_create  */
+#include <sys/wait.h> /* waitpid  */
+#include <linux/videodev2.h> /* V4L2_PIX_FMT_YUYV  */
+
+#include "glutcam.h"
+#include "dmabuf.h"
+#include "timeutil.h" /* monotonic_usec, sleep_until_usec  */
+
+/* DMABUFCLIENT_STALL_USEC - the mock device gives up after this  */
+/* long without a free buffer  */
+/* DEFAULT_DMABUFCLIENT_READ_USEC - over two frames at 60 fps: long  */
+/* enough for the buffer to be refilled under the consumer if the  */
+/* release messages didn't hold it back  */
+
+#define DMABUFCLIENT_STALL_USEC 2000000
+#define DEFAULT_DMABUFCLIENT_BUFFERS 4
+#define DEFAULT_DMABUFCLIENT_FRAMES 300
+#define DEFAULT_DMABUFCLIENT_FPS 60
+#define DEFAULT_DMABUFCLIENT_READ_USEC 40000
+
+extern char *optarg; /* declared in the C library for getopt  */
+
+/* local prototypes  */
+int parse_dmabufclient_args(int argc, char * argv[],
+			    Dmabufclientargs_t * args);
+int run_mock_device(const Dmabufclientargs_t * args);
+int run_dmabuf_consumer(const Dmabufclientargs_t * args, const char * path,
+			int check, int ready_fd);
+void stamp_frame(void * data, size_t length, unsigned int sequence,
+		 long long capture_usec);
+size_t check_frame(const void * data, size_t from, size_t to,
+		   unsigned int sequence, long long capture_usec);
+uint64_t pattern_word(unsigned int sequence);
+/* end local prototypes  */
+
+
+
+/* *************************************************************************
+
+
+   NAME:  main
+
+
+   USAGE:
+
+   glutcam_dmabufclient [-b buffers] [-s WxH] [-n frames] [-f fps]
+                        [-u usec] [-a socket]
+
+   returns: int
+
+   DESCRIPTION:
+                 parse the command line, then either run the mock
+		 device with a consumer checking its frames or, with
+		 -a, consume a running glutcam's frames.
+
+		 return 0 if all's well, -1 if not
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int main(int argc, char * argv[])
+{
+  Dmabufclientargs_t args;
+
+  if (0 != parse_dmabufclient_args(argc, argv, &args))
+    {
+      return(-1);
+    }
+
+  if ('\0' != args.attach[0])
+    {
+      return(run_dmabuf_consumer(&args, args.attach, 0, -1));
+    }
+
+  return(run_mock_device(&args));
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  parse_dmabufclient_args
+
+
+   USAGE:
+
+   int some_int;
+   Dmabufclientargs_t args;
+
+   some_int =  parse_dmabufclient_args(argc, argv, &args);
+
+   if (0 == some_int)
+   -- run it
+   else
+   -- usage was printed
+
+   returns: int
+
+   DESCRIPTION:
+                 fill in args from the command line:
+
+		 -b N      -- the mock device's buffers
+		 -s WxH    -- frame size (YUYV)
+		 -n N      -- frames to publish (or read, with -a)
+		 -f N      -- frames per second, 0 for as fast as we can
+		 -u N      -- microseconds the consumer spends per frame
+		 -a socket -- consume a running glutcam's buffers
+
+		 return 0 if all's well, -1 (after the usage message)
+		 if not
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: optarg
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int parse_dmabufclient_args(int argc, char * argv[],
+			    Dmabufclientargs_t * args)
+{
+  int opt, unexpected;
+
+  memset(args, 0, sizeof(*args));
+  args->buffers = DEFAULT_DMABUFCLIENT_BUFFERS;
+  args->width = 640;
+  args->height = 480;
+  args->frames = DEFAULT_DMABUFCLIENT_FRAMES;
+  args->fps = DEFAULT_DMABUFCLIENT_FPS;
+  args->read_usec = DEFAULT_DMABUFCLIENT_READ_USEC;
+
+  unexpected = 0;
+
+  while ((0 == unexpected)
+	 && (-1 != (opt = getopt(argc, argv, "b:s:n:f:u:a:"))))
+    {
+      switch (opt)
+	{
+	case 'b':
+	  args->buffers = atoi(optarg);
+	  if ((2 > args->buffers) || (MAX_VIDEO_BUFFERS < args->buffers))
+	    {
+	      fprintf(stderr, "buffers (-b) must be 2 to %d\n",
+		      MAX_VIDEO_BUFFERS);
+	      unexpected = 1;
+	    }
+	  break;
+
+	case 's':
+	  if ((2 != sscanf(optarg, "%dx%d", &(args->width), &(args->height)))
+	      || (2 > args->width) || (1 > args->height)
+	      || (0 != (args->width & 1)))
+	    {
+	      fprintf(stderr, "size (-s) must be WxH, W even\n");
+	      unexpected = 1;
+	    }
+	  break;
+
+	case 'n':
+	  args->frames = atoi(optarg);
+	  if (1 > args->frames)
+	    {
+	      fprintf(stderr, "frames (-n) must be 1 or more\n");
+	      unexpected = 1;
+	    }
+	  break;
+
+	case 'f':
+	  args->fps = atoi(optarg);
+	  if (0 > args->fps)
+	    {
+	      fprintf(stderr, "frame rate (-f) must be 0 or more\n");
+	      unexpected = 1;
+	    }
+	  break;
+
+	case 'u':
+	  args->read_usec = atoi(optarg);
+	  if (0 > args->read_usec)
+	    {
+	      fprintf(stderr, "read time (-u) must be 0 or more\n");
+	      unexpected = 1;
+	    }
+	  break;
+
+	case 'a':
+	  strncpy(args->attach, optarg, MAX_DEVICENAME - 1);
+	  args->attach[MAX_DEVICENAME - 1] = '\0';
+	  break;
+
+	default:
+	  unexpected = 1;
+	  break;
+	}
+    }
+
+  if (0 != unexpected)
+    {
+      fprintf(stderr, "Usage: %s [-b buffers] [-s WxH] [-n frames] [-f fps]"
+	      " [-u usec] [-a socket]\n", argv[0]);
+      fprintf(stderr, "   -b: mock device buffers, default %d\n",
+	      DEFAULT_DMABUFCLIENT_BUFFERS);
+      fprintf(stderr, "   -s: YUYV frame size, default 640x480\n");
+      fprintf(stderr, "   -n: frames to publish, default %d\n",
+	      DEFAULT_DMABUFCLIENT_FRAMES);
+      fprintf(stderr, "   -f: frames per second, 0: as fast as we can;"
+	      " default %d\n", DEFAULT_DMABUFCLIENT_FPS);
+      fprintf(stderr, "   -u: microseconds the consumer takes per frame,"
+	      " default %d\n", DEFAULT_DMABUFCLIENT_READ_USEC);
+      fprintf(stderr, "   -a: just consume the frames glutcam -x is"
+	      " sharing on this socket\n");
+      return(-1);
+    }
+
+  return(0);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  run_mock_device
+
+
+   USAGE:
+
+   int some_int;
+   Dmabufclientargs_t args;
+
+   some_int =  run_mock_device(&args);
+
+   returns: int
+
+   DESCRIPTION:
+                 share args->buffers memfd buffers through a dmabuf
+		 server of our own, fork a consumer, wait for it to
+		 connect, then publish args->frames stamped frames
+		 at args->fps (or flat out) the way the capture side
+		 does: serve the frame, then release the one before
+		 it through defer_dmabuf_release, and only refill a
+		 buffer once it's free. hang up, and wait for the
+		 consumer's verdict.
+
+		 return 0 if the consumer read frames and every one
+		          was intact,
+		       -1 if not
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int run_mock_device(const Dmabufclientargs_t * args)
+{
+  Sourceparams_t sourceparams;
+  Videobuffer_t buffers[MAX_VIDEO_BUFFERS];
+  Frameslot_t slot;
+  int freelist[MAX_VIDEO_BUFFERS];
+  int freed[MAX_VIDEO_BUFFERS];
+  int ready[2];
+  size_t frame_bytes;
+  long long next_usec, stall_usec;
+  char byte;
+  pid_t pid;
+  int i, n, nfree, previous, frame, status, stalls;
+
+  memset(&sourceparams, 0, sizeof(sourceparams));
+  memset(buffers, 0, sizeof(buffers));
+  sourceparams.buffers = buffers;
+  sourceparams.buffercount = args->buffers;
+  frame_bytes = (size_t)args->width * args->height * 2;
+
+  for (i = 0; i < args->buffers; i++)
+    {
+      buffers[i].dmabuf_fd = memfd_create("glutcam_dmabufclient",
+					  MFD_CLOEXEC);
+      if ((-1 == buffers[i].dmabuf_fd)
+	  || (-1 == ftruncate(buffers[i].dmabuf_fd, (off_t)frame_bytes)))
+	{
+	  perror("Error creating mock device buffer");
+	  return(-1);
+	}
+      buffers[i].length = frame_bytes;
+      buffers[i].start = mmap(NULL, frame_bytes, PROT_READ | PROT_WRITE,
+			      MAP_SHARED, buffers[i].dmabuf_fd, 0);
+      if (MAP_FAILED == buffers[i].start)
+	{
+	  perror("Error mapping mock device buffer");
+	  return(-1);
+	}
+      sourceparams.dmabuf.nfds = i + 1;
+    }
+
+  snprintf(sourceparams.dmabuf.path, MAX_DEVICENAME,
+	   "/tmp/glutcam_dmabufclient.%d", (int)getpid());
+  sourceparams.dmabuf.width = (unsigned int)args->width;
+  sourceparams.dmabuf.height = (unsigned int)args->height;
+  sourceparams.dmabuf.fourcc = V4L2_PIX_FMT_YUYV;
+  sourceparams.dmabuf.bytesperline = (unsigned int)args->width * 2;
+
+  if ((-1 == start_dmabuf_server(&sourceparams)) || (-1 == pipe(ready)))
+    {
+      stop_dmabuf_server(&sourceparams);
+      return(-1);
+    }
+
+  printf("mock device: %d buffers of %dx%d YUYV, %d frames, ",
+	 args->buffers, args->width, args->height, args->frames);
+  if (0 == args->fps)
+    {
+      printf("as fast as we can; ");
+    }
+  else
+    {
+      printf("%d fps; ", args->fps);
+    }
+  printf("consumer takes %d usec a frame\n", args->read_usec);
+  fflush(stdout);
+
+  pid = fork();
+  if (0 == pid)
+    {
+      close(ready[0]);
+      _exit((0 == run_dmabuf_consumer(args, sourceparams.dmabuf.path, 1,
+				       ready[1])) ? 0 : 1);
+    }
+  close(ready[1]);
+
+  /* once it's said it's connected, the first frame takes it on  */
+  if (1 != read(ready[0], &byte, 1))
+    {
+      fprintf(stderr, "Error: the consumer didn't connect\n");
+    }
+  close(ready[0]);
+
+  /* the mock driver hands out the buffer it got back last first  */
+  for (nfree = 0; nfree < args->buffers; nfree++)
+    {
+      freelist[nfree] = nfree;
+    }
+
+  previous = -1;
+  stalls = 0;
+  stall_usec = 0;
+  next_usec = monotonic_usec();
+  frame = 0;
+  while (frame < args->frames)
+    {
+      n = collect_dmabuf_releases(&sourceparams, freed, MAX_VIDEO_BUFFERS);
+      for (i = 0; i < n; i++)
+	{
+	  freelist[nfree++] = freed[i];
+	}
+
+      if (0 == nfree)
+	{
+	  if (0 == stall_usec)
+	    {
+	      stall_usec = monotonic_usec();
+	      stalls++;
+	    }
+	  else if (DMABUFCLIENT_STALL_USEC < monotonic_usec() - stall_usec)
+	    {
+	      fprintf(stderr, "Error: no buffer came back for %d usec\n",
+		      DMABUFCLIENT_STALL_USEC);
+	      break;
+	    }
+	  sleep_until_usec(monotonic_usec() + 100);
+	  continue;
+	}
+      stall_usec = 0;
+
+      slot.index = freelist[--nfree];
+      slot.start = buffers[slot.index].start;
+      slot.length = frame_bytes;
+      slot.sequence = (unsigned int)frame;
+      slot.capture_usec = monotonic_usec();
+      stamp_frame(slot.start, slot.length, slot.sequence, slot.capture_usec);
+      slot.published_usec = monotonic_usec();
+      serve_dmabuf_frame(&sourceparams, &slot);
+
+      /* the display's done with the frame before: give it back  */
+      if ((-1 != previous)
+	  && (0 == defer_dmabuf_release(&sourceparams, previous)))
+	{
+	  freelist[nfree++] = previous;
+	}
+      previous = slot.index;
+      frame++;
+
+      if (0 < args->fps)
+	{
+	  next_usec += 1000000 / args->fps;
+	  sleep_until_usec(next_usec);
+	}
+    }
+
+  stop_dmabuf_server(&sourceparams);
+  for (i = 0; i < args->buffers; i++)
+    {
+      munmap(buffers[i].start, frame_bytes);
+    }
+
+  if ((pid != waitpid(pid, &status, 0)) || !WIFEXITED(status))
+    {
+      status = 1;
+    }
+  else
+    {
+      status = WEXITSTATUS(status);
+    }
+
+  printf("mock device: %d frames published, ran out of buffers %d times\n",
+	 frame, stalls);
+
+  return(((0 == status) && (frame == args->frames)) ? 0 : -1);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  run_dmabuf_consumer
+
+
+   USAGE:
+
+   int some_int;
+   Dmabufclientargs_t args;
+
+   some_int =  run_dmabuf_consumer(&args, path, check, ready_fd);
+
+   returns: int
+
+   DESCRIPTION:
+                 connect to the dmabuf server on path, say so by
+		 writing a byte to ready_fd (unless it's -1), map the
+		 buffers it sends, then read frames until it hangs
+		 up or (with -a) args->frames have been read.
+
+		 every byte of each frame is read, half of it
+		 args->read_usec after the other half. if check is
+		 set the frame has to be stamped as stamp_frame
+		 does; either way its message has to make sense.
+		 each frame is released once it's been read.
+
+		 return 0 if frames were read and none was bad,
+		       -1 if not
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int run_dmabuf_consumer(const Dmabufclientargs_t * args, const char * path,
+			int check, int ready_fd)
+{
+  Dmabufmsg_t msg;
+  int fds[MAX_VIDEO_BUFFERS];
+  void * maps[MAX_VIDEO_BUFFERS];
+  size_t buffer_bytes, half, wrong;
+  long long now_usec;
+  unsigned int last_sequence;
+  int fd, nfds, i, nread, nmissed, nbad;
+
+  fd = connect_dmabuf_server(path);
+
+  if (0 <= ready_fd)
+    {
+      (void)write(ready_fd, "r", 1);
+      close(ready_fd);
+    }
+
+  if (-1 == fd)
+    {
+      return(-1);
+    }
+
+  nfds = receive_dmabuf_message(fd, &msg, fds, MAX_VIDEO_BUFFERS);
+
+  if ((1 > nfds) || (DMABUF_MSG_BUFFERS != msg.type)
+      || ((unsigned int)nfds != msg.count))
+    {
+      fprintf(stderr, "Error: expected the buffers, got type %u with %d fds\n",
+	      msg.type, nfds);
+      close(fd);
+      return(-1);
+    }
+
+  buffer_bytes = msg.length;
+  printf("consumer: %d buffers of %lu bytes, %ux%u, %u bytes a line\n",
+	 nfds, (unsigned long)buffer_bytes, msg.width, msg.height,
+	 msg.bytesperline);
+
+  for (i = 0; i < nfds; i++)
+    {
+      maps[i] = mmap(NULL, buffer_bytes, PROT_READ, MAP_SHARED, fds[i], 0);
+      if (MAP_FAILED == maps[i])
+	{
+	  perror("Error mapping a shared buffer");
+	  close(fd);
+	  return(-1);
+	}
+    }
+
+  nread = 0;
+  nmissed = 0;
+  nbad = 0;
+  last_sequence = 0;
+  while ((0 != check) || (nread < args->frames))
+    {
+      if (-1 == receive_dmabuf_message(fd, &msg, NULL, 0))
+	{
+	  break; /* hung up  */
+	}
+
+      now_usec = monotonic_usec();
+      if ((DMABUF_MSG_FRAME != msg.type) || ((unsigned int)nfds <= msg.index)
+	  || (buffer_bytes < msg.length) || (0 == msg.timestamp_usec)
+	  || (now_usec < msg.timestamp_usec)
+	  || ((0 < nread) && (msg.sequence <= last_sequence)))
+	{
+	  fprintf(stderr, "consumer: bad message: type %u index %u length %u"
+		  " sequence %u\n", msg.type, msg.index, msg.length,
+		  msg.sequence);
+	  nbad++;
+	  if (DMABUF_MSG_FRAME != msg.type)
+	    {
+	      continue;
+	    }
+	}
+      else
+	{
+	  if (0 < nread)
+	    {
+	      nmissed += (int)(msg.sequence - last_sequence - 1);
+	    }
+
+	  half = (msg.length / 2) & ~(sizeof(uint64_t) - 1);
+	  wrong = check_frame(maps[msg.index], 0, half, msg.sequence,
+			      msg.timestamp_usec);
+	  if (0 < args->read_usec)
+	    {
+	      sleep_until_usec(monotonic_usec() + args->read_usec);
+	    }
+	  wrong += check_frame(maps[msg.index], half, msg.length, msg.sequence,
+			       msg.timestamp_usec);
+
+	  if ((0 != check) && (0 != wrong))
+	    {
+	      fprintf(stderr, "consumer: frame %u in buffer %u has %lu bad"
+		      " words\n", msg.sequence, msg.index,
+		      (unsigned long)wrong);
+	      nbad++;
+	    }
+	}
+
+      last_sequence = msg.sequence;
+      nread++;
+
+      if (-1 == release_dmabuf_frame(fd, &msg))
+	{
+	  break;
+	}
+    }
+
+  for (i = 0; i < nfds; i++)
+    {
+      munmap(maps[i], buffer_bytes);
+      close(fds[i]);
+    }
+  close(fd);
+
+  printf("consumer: %d frames read, %d went by while reading, %d bad\n",
+	 nread, nmissed, nbad);
+  fflush(stdout);
+
+  return(((0 < nread) && (0 == nbad)) ? 0 : -1);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  stamp_frame
+
+
+   USAGE:
+
+   stamp_frame(data, length, sequence, capture_usec);
+
+   returns: void
+
+   DESCRIPTION:
+                 fill a frame so check_frame can tell it's whole:
+		 capture_usec in the first 64 bit word,
+		 pattern_word(sequence) in the rest
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void stamp_frame(void * data, size_t length, unsigned int sequence,
+		 long long capture_usec)
+{
+  uint64_t * words;
+  uint64_t pattern;
+  size_t i, nwords;
+
+  words = (uint64_t *)data;
+  nwords = length / sizeof(uint64_t);
+  pattern = pattern_word(sequence);
+
+  words[0] = (uint64_t)capture_usec;
+  for (i = 1; i < nwords; i++)
+    {
+      words[i] = pattern;
+    }
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  check_frame
+
+
+   USAGE:
+
+   size_t wrong;
+
+   wrong =  check_frame(data, from, to, sequence, capture_usec);
+
+   returns: size_t
+
+   DESCRIPTION:
+                 read the 64 bit words in bytes from...to - 1 of a
+		 frame and count the ones that aren't what
+		 stamp_frame put there. from and to are multiples of
+		 8 (to is rounded down).
+
+		 every word is read even when the frame isn't ours,
+		 so it's what a real consumer costs.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+size_t check_frame(const void * data, size_t from, size_t to,
+		   unsigned int sequence, long long capture_usec)
+{
+  const volatile uint64_t * words;
+  uint64_t pattern;
+  size_t i, last, wrong;
+
+  words = (const volatile uint64_t *)data;
+  last = to / sizeof(uint64_t);
+  pattern = pattern_word(sequence);
+  wrong = 0;
+
+  i = from / sizeof(uint64_t);
+  if ((0 == i) && (i < last))
+    {
+      wrong += (words[0] != (uint64_t)capture_usec);
+      i++;
+    }
+
+  for (; i < last; i++)
+    {
+      wrong += (words[i] != pattern);
+    }
+
+  return(wrong);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  pattern_word
+
+
+   USAGE:
+
+   uint64_t word;
+
+   word =  pattern_word(sequence);
+
+   returns: uint64_t
+
+   DESCRIPTION:
+                 the word frame sequence is filled with. no two of
+		 255 frames in a row share one.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+uint64_t pattern_word(unsigned int sequence)
+{
+  return(0x0101010101010101ULL * ((sequence % 255) + 1));
+}
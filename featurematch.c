@@ -0,0 +1,1299 @@
+/* *************************************************************************
+* NAME: glutcam/featurematch.c
+*
+* DESCRIPTION:
+*
+* match the tracker's BRIEF descriptors (cvProcess.cpp) from one frame
+* to the last: for each query keypoint, the train keypoint within a
+* window around it (25x25 pixels, where the last homography says it
+* should be) with the fewest differing bits.
+*
+* this is what windowedMatchingMask and BFMatcher(NORM_HAMMING) did,
+* without the N x M mask or the N x M distances. the train keypoints
+* are bucketed into a grid of window-sized cells (a counting sort);
+* a keypoint within the window of a query is in one of the 3x3 cells
+* around the query's, so only those are looked at, and only the ones
+* actually inside the window have their distance computed.
+*
+* the distance is a popcount of the XOR of two 32 byte descriptors,
+* in plain C or with POPCNT, AVX2 (a nibble lookup with vpshufb) or
+* NEON (vcnt), the kernel picked at run time and checked against the
+* plain C one, the way colorconvert.c picks its kernels.
+*
+* the result is the same as BFMatcher's, match for match: ties go to
+* the lowest train index, and a query with nothing in its window gets
+* no match.
+*
+* PROCESS:
+*
+* see featurematch.h
+*
+* GLOBALS: none
+*
+* REFERENCES:
+*
+* Calonder et al., BRIEF: Binary Robust Independent Elementary
+*   Features, ECCV 2010
+* Mula, Kurz, Lemire, Faster Population Counts Using AVX2
+*   Instructions, 2016
+*
+* LIMITATIONS:
+*
+* the descriptors must be BRIEF_BYTES long, one after another.
+*
+* REVISION HISTORY:
+*
+*   STR                Description                          Author
+*
+*   17-Oct-26          initial coding
+*
+* TARGET: Linux C (gcc: target attributes, __builtin_cpu_supports)
+*
+* This software is in the public domain. if it breaks you get to keep
+* both pieces.
+*
+* ************************************************************************* */
+
+#include <stdio.h>
+#include <stdlib.h> /* realloc, free  */
+#include <string.h> /* memcpy, memset  */
+#include <stdint.h> /* uint64_t  */
+#include <math.h> /* fabsf, floorf  */
+#include <limits.h> /* INT_MAX  */
+
+#if defined(__x86_64__)
+#define HAVE_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define HAVE_NEON_KERNEL
+#include <arm_neon.h>
+#if defined(__arm__)
+#include <sys/auxv.h> /* getauxval  */
+#include <asm/hwcap.h> /* HWCAP_NEON  */
+#endif
+#endif
+
+#include "glutcam.h"
+#include "featurematch.h"
+
+/* CHECK_DESCRIPTORS - how many pseudo-random descriptors  */
+/* select_hamming_kernel compares the kernels on  */
+
+#define CHECK_DESCRIPTORS 257
+
+/* MAX_GRID_CELLS - cap on the grid, for keypoints spread very wide  */
+/* (a homography gone wrong): past it the cells just get bigger  */
+
+#define MAX_GRID_CELLS 65536
+
+typedef void (*Hammingfunc_t)(const unsigned char * query,
+			      const unsigned char * train,
+			      const int * candidates, int ncandidates,
+			      int * distances);
+
+/* local prototypes  */
+void hamming_distances_scalar(const unsigned char * query,
+			      const unsigned char * train,
+			      const int * candidates, int ncandidates,
+			      int * distances);
+void hamming_distances_popcnt(const unsigned char * query,
+			      const unsigned char * train,
+			      const int * candidates, int ncandidates,
+			      int * distances);
+void hamming_distances_avx2(const unsigned char * query,
+			    const unsigned char * train,
+			    const int * candidates, int ncandidates,
+			    int * distances);
+void hamming_distances_neon(const unsigned char * query,
+			    const unsigned char * train,
+			    const int * candidates, int ncandidates,
+			    int * distances);
+int hamming_kernel_supported(Hammingkernel_t kernel);
+Hammingfunc_t hamming_kernel_function(Hammingkernel_t kernel);
+int check_hamming_kernel(Hammingfunc_t func);
+int grow_featuregrid(Featuregrid_t * grid, int ncells, int npoints);
+int bucket_train_keypoints(Featuregrid_t * grid, const float * train_xy,
+			   int ntrain, float max_dx, float max_dy);
+/* end local prototypes  */
+
+static Hammingkernel_t Hamming_in_use = HAMMING_SCALAR;
+static Hammingfunc_t Hamming_func = hamming_distances_scalar;
+
+
+
+/* *************************************************************************
+
+
+   NAME:  select_hamming_kernel
+
+
+   USAGE:
+
+   Hammingkernel_t kernel;
+
+   kernel =  select_hamming_kernel(HAMMING_AUTO);
+
+   returns: Hammingkernel_t
+
+   DESCRIPTION:
+                 make requested the kernel match_features_windowed
+		 counts bits with.
+
+		 HAMMING_AUTO picks the fastest one this CPU runs.
+		 if the requested kernel isn't built in or the CPU
+		 can't run it, say so and fall back to HAMMING_AUTO.
+
+		 before a SIMD kernel is used, run it on pseudo-random
+		 descriptors and compare against the scalar version.
+		 if they don't agree, complain and use the scalar one.
+
+		 return the kernel that was settled on
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   call this before the tracker starts: it isn't thread safe.
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: Hamming_in_use, Hamming_func
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+Hammingkernel_t select_hamming_kernel(Hammingkernel_t requested)
+{
+  static const Hammingkernel_t preferred[] = {HAMMING_AVX2, HAMMING_POPCNT,
+					      HAMMING_NEON, HAMMING_SCALAR};
+  Hammingkernel_t kernel;
+  unsigned int i;
+
+  if ((HAMMING_AUTO != requested) && (0 == hamming_kernel_supported(requested)))
+    {
+      fprintf(stderr, "hamming distance kernel %s isn't available here,"
+	      " picking one\n", hamming_kernel_name(requested));
+      requested = HAMMING_AUTO;
+    }
+
+  kernel = HAMMING_SCALAR;
+  if (HAMMING_AUTO != requested)
+    {
+      kernel = requested;
+    }
+  else
+    {
+      for (i = 0; i < sizeof(preferred) / sizeof(preferred[0]); i++)
+	{
+	  if (hamming_kernel_supported(preferred[i]))
+	    {
+	      kernel = preferred[i];
+	      break;
+	    }
+	}
+    }
+
+  if ((HAMMING_SCALAR != kernel)
+      && (0 != check_hamming_kernel(hamming_kernel_function(kernel))))
+    {
+      fprintf(stderr, "Error: %s hamming distances don't match the"
+	      " scalar version, using scalar\n", hamming_kernel_name(kernel));
+      kernel = HAMMING_SCALAR;
+    }
+
+  Hamming_func = hamming_kernel_function(kernel);
+  Hamming_in_use = kernel;
+
+  return(Hamming_in_use);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  hamming_kernel_name
+
+
+   USAGE:
+
+   const char * name;
+
+   name =  hamming_kernel_name(hamming_kernel_in_use());
+
+   returns: const char *
+
+   DESCRIPTION:
+                 return the name of kernel, for reports
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+const char * hamming_kernel_name(Hammingkernel_t kernel)
+{
+  const char * retval;
+
+  switch (kernel)
+    {
+    case HAMMING_AUTO:
+      retval = "auto";
+      break;
+
+    case HAMMING_SCALAR:
+      retval = "scalar";
+      break;
+
+    case HAMMING_POPCNT:
+      retval = "popcnt";
+      break;
+
+    case HAMMING_AVX2:
+      retval = "avx2";
+      break;
+
+    case HAMMING_NEON:
+      retval = "neon";
+      break;
+
+    default:
+      retval = "unknown";
+      break;
+    }
+
+  return(retval);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  hamming_kernel_in_use
+
+
+   USAGE:
+
+   Hammingkernel_t kernel;
+
+   kernel =  hamming_kernel_in_use();
+
+   returns: Hammingkernel_t
+
+   DESCRIPTION:
+                 return the kernel select_hamming_kernel settled on
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: Hamming_in_use
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+Hammingkernel_t hamming_kernel_in_use(void)
+{
+  return(Hamming_in_use);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  match_features_windowed
+
+
+   USAGE:
+
+   int nmatches;
+   Featuregrid_t grid;  -- zeroed before the first use
+   Featurematch_t matches[nquery];
+
+   nmatches =  match_features_windowed(&grid, query_xy, query_desc,
+                                       nquery, train_xy, train_desc,
+                                       ntrain, 25, 25, matches);
+
+   returns: int
+
+   DESCRIPTION:
+                 for each query keypoint (x, y at query_xy[2 * i],
+		 query_xy[2 * i + 1]; descriptor BRIEF_BYTES at
+		 query_desc + i * BRIEF_BYTES), find the train
+		 keypoint with |dx| < max_dx and |dy| < max_dy whose
+		 descriptor differs in the fewest bits. ties go to
+		 the lower train index.
+
+		 put them in matches in query order; a query with no
+		 train keypoint in its window gets none.
+
+		 grid holds the train keypoints bucketed by cell; its
+		 arrays grow as needed and are reused, so once they're
+		 big enough this doesn't allocate.
+
+		 return the number of matches
+		       -1 if there wasn't memory for the grid
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   one thread at a time per grid
+
+   GLOBAL VARIABLES:
+
+      accessed: Hamming_func
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int match_features_windowed(Featuregrid_t * grid, const float * query_xy,
+			    const unsigned char * query_desc, int nquery,
+			    const float * train_xy,
+			    const unsigned char * train_desc, int ntrain,
+			    float max_dx, float max_dy,
+			    Featurematch_t * matches)
+{
+  int i, j, k, col, row, col0, col1, row0, row1, cell, ncandidates;
+  int nmatches, best, best_distance;
+  float qx, qy, right, bottom, cellx, celly;
+
+  if ((0 >= nquery) || (0 >= ntrain))
+    {
+      return(0);
+    }
+
+  if (-1 == bucket_train_keypoints(grid, train_xy, ntrain, max_dx, max_dy))
+    {
+      return(-1);
+    }
+
+  right = grid->left + grid->cols * grid->cell_width;
+  bottom = grid->top + grid->rows * grid->cell_height;
+  nmatches = 0;
+
+  for (i = 0; i < nquery; i++)
+    {
+      qx = query_xy[2 * i];
+      qy = query_xy[2 * i + 1];
+
+      /* nothing near: and this way a NaN doesn't get any further  */
+      if (!((qx > grid->left - max_dx) && (qx < right + max_dx)
+	    && (qy > grid->top - max_dy) && (qy < bottom + max_dy)))
+	{
+	  continue;
+	}
+
+      cellx = floorf((qx - grid->left) / grid->cell_width);
+      celly = floorf((qy - grid->top) / grid->cell_height);
+      col = (int)cellx;
+      row = (int)celly;
+      col0 = (0 < col) ? col - 1 : 0;
+      col1 = (col + 1 < grid->cols) ? col + 1 : grid->cols - 1;
+      row0 = (0 < row) ? row - 1 : 0;
+      row1 = (row + 1 < grid->rows) ? row + 1 : grid->rows - 1;
+
+      /* the train keypoints really in the window, cells around  */
+      ncandidates = 0;
+      for (row = row0; row <= row1; row++)
+	{
+	  for (cell = row * grid->cols + col0;
+	       cell <= row * grid->cols + col1; cell++)
+	    {
+	      for (k = grid->cell_start[cell]; k < grid->cell_start[cell + 1];
+		   k++)
+		{
+		  j = grid->order[k];
+		  if ((fabsf(train_xy[2 * j] - qx) < max_dx)
+		      && (fabsf(train_xy[2 * j + 1] - qy) < max_dy))
+		    {
+		      grid->candidates[ncandidates++] = j;
+		    }
+		}
+	    }
+	}
+
+      if (0 == ncandidates)
+	{
+	  continue;
+	}
+
+      Hamming_func(query_desc + (size_t)i * BRIEF_BYTES, train_desc,
+		   grid->candidates, ncandidates, grid->distances);
+
+      best = -1;
+      best_distance = INT_MAX;
+      for (k = 0; k < ncandidates; k++)
+	{
+	  if ((grid->distances[k] < best_distance)
+	      || ((grid->distances[k] == best_distance)
+		  && (grid->candidates[k] < best)))
+	    {
+	      best_distance = grid->distances[k];
+	      best = grid->candidates[k];
+	    }
+	}
+
+      matches[nmatches].query = i;
+      matches[nmatches].train = best;
+      matches[nmatches].distance = best_distance;
+      nmatches++;
+    }
+
+  return(nmatches);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  free_featuregrid
+
+
+   USAGE:
+
+   Featuregrid_t grid;
+
+   free_featuregrid(&grid);
+
+   returns: void
+
+   DESCRIPTION:
+                 free what match_features_windowed allocated in grid
+		 and zero it, ready to be used again.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void free_featuregrid(Featuregrid_t * grid)
+{
+  free(grid->cell_start);
+  free(grid->order);
+  free(grid->cell_of);
+  free(grid->candidates);
+  free(grid->distances);
+  memset(grid, 0, sizeof(*grid));
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  hamming_distances_scalar
+
+
+   USAGE:
+
+   hamming_distances_scalar(query, train, candidates, ncandidates,
+                            distances);
+
+   returns: void
+
+   DESCRIPTION:
+                 distances[k] = the number of bits that differ
+		 between the BRIEF_BYTES descriptor at query and the
+		 one at train + candidates[k] * BRIEF_BYTES.
+
+		 plain C: the reference the other kernels are checked
+		 against.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void hamming_distances_scalar(const unsigned char * query,
+			      const unsigned char * train,
+			      const int * candidates, int ncandidates,
+			      int * distances)
+{
+  uint64_t q[BRIEF_BYTES / 8], t[BRIEF_BYTES / 8];
+  int k, w, bits;
+
+  memcpy(q, query, BRIEF_BYTES);
+
+  for (k = 0; k < ncandidates; k++)
+    {
+      memcpy(t, train + (size_t)candidates[k] * BRIEF_BYTES, BRIEF_BYTES);
+      bits = 0;
+      for (w = 0; w < BRIEF_BYTES / 8; w++)
+	{
+	  bits += __builtin_popcountll(q[w] ^ t[w]);
+	}
+      distances[k] = bits;
+    }
+}
+
+
+
+#ifdef	HAVE_X86_KERNELS
+
+/* *************************************************************************
+
+
+   NAME:  hamming_distances_popcnt
+
+
+   USAGE:
+
+   hamming_distances_popcnt(query, train, candidates, ncandidates,
+                            distances);
+
+   returns: void
+
+   DESCRIPTION:
+                 hamming_distances_scalar with the POPCNT
+		 instruction: four 64 bit XORs and counts a
+		 descriptor.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   x86-64 CPUs with POPCNT (Nehalem, Barcelona and later)
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+__attribute__((target("popcnt")))
+void hamming_distances_popcnt(const unsigned char * query,
+			      const unsigned char * train,
+			      const int * candidates, int ncandidates,
+			      int * distances)
+{
+  uint64_t q[BRIEF_BYTES / 8], t[BRIEF_BYTES / 8];
+  int k;
+
+  memcpy(q, query, BRIEF_BYTES);
+
+  for (k = 0; k < ncandidates; k++)
+    {
+      memcpy(t, train + (size_t)candidates[k] * BRIEF_BYTES, BRIEF_BYTES);
+      distances[k] = (int)(_mm_popcnt_u64(q[0] ^ t[0])
+			   + _mm_popcnt_u64(q[1] ^ t[1])
+			   + _mm_popcnt_u64(q[2] ^ t[2])
+			   + _mm_popcnt_u64(q[3] ^ t[3]));
+    }
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  hamming_distances_avx2
+
+
+   USAGE:
+
+   hamming_distances_avx2(query, train, candidates, ncandidates,
+                          distances);
+
+   returns: void
+
+   DESCRIPTION:
+                 hamming_distances_scalar with AVX2: a whole
+		 descriptor is one register. the XOR's bits are
+		 counted a nibble at a time with a 16 entry table
+		 (vpshufb) and the byte counts summed with vpsadbw.
+
+   REFERENCES: Mula, Kurz, Lemire
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+__attribute__((target("avx2")))
+void hamming_distances_avx2(const unsigned char * query,
+			    const unsigned char * train,
+			    const int * candidates, int ncandidates,
+			    int * distances)
+{
+  const __m256i nibble_bits = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3,
+					       1, 2, 2, 3, 2, 3, 3, 4,
+					       0, 1, 1, 2, 1, 2, 2, 3,
+					       1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i low_nibble = _mm256_set1_epi8(0x0f);
+  __m256i q, x, counts, sums;
+  __m128i half;
+  int k;
+
+  q = _mm256_loadu_si256((const __m256i *)query);
+
+  for (k = 0; k < ncandidates; k++)
+    {
+      x = _mm256_xor_si256(q, _mm256_loadu_si256((const __m256i *)
+						 (train + (size_t)candidates[k]
+						  * BRIEF_BYTES)));
+      counts = _mm256_add_epi8(_mm256_shuffle_epi8(nibble_bits,
+						   _mm256_and_si256(x, low_nibble)),
+			       _mm256_shuffle_epi8(nibble_bits,
+						   _mm256_and_si256(_mm256_srli_epi16(x, 4),
+								    low_nibble)));
+      /* four 64 bit sums of 8 byte counts each  */
+      sums = _mm256_sad_epu8(counts, _mm256_setzero_si256());
+      half = _mm_add_epi64(_mm256_castsi256_si128(sums),
+			   _mm256_extracti128_si256(sums, 1));
+      half = _mm_add_epi64(half, _mm_unpackhi_epi64(half, half));
+      distances[k] = _mm_cvtsi128_si32(half);
+    }
+}
+
+#endif	/* HAVE_X86_KERNELS  */
+
+
+
+#ifdef	HAVE_NEON_KERNEL
+
+/* *************************************************************************
+
+
+   NAME:  hamming_distances_neon
+
+
+   USAGE:
+
+   hamming_distances_neon(query, train, candidates, ncandidates,
+                          distances);
+
+   returns: void
+
+   DESCRIPTION:
+                 hamming_distances_scalar with NEON: two 16 byte
+		 XORs a descriptor, vcnt for each byte's bits, and
+		 pairwise adds down to one count.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void hamming_distances_neon(const unsigned char * query,
+			    const unsigned char * train,
+			    const int * candidates, int ncandidates,
+			    int * distances)
+{
+  uint8x16_t q0, q1, c;
+  uint64x2_t sums;
+  const unsigned char * t;
+  int k;
+
+  q0 = vld1q_u8(query);
+  q1 = vld1q_u8(query + 16);
+
+  for (k = 0; k < ncandidates; k++)
+    {
+      t = train + (size_t)candidates[k] * BRIEF_BYTES;
+      /* each byte at most 8 + 8: no overflow adding the halves  */
+      c = vaddq_u8(vcntq_u8(veorq_u8(q0, vld1q_u8(t))),
+		   vcntq_u8(veorq_u8(q1, vld1q_u8(t + 16))));
+      sums = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(c)));
+      distances[k] = (int)(vgetq_lane_u64(sums, 0) + vgetq_lane_u64(sums, 1));
+    }
+}
+
+#endif	/* HAVE_NEON_KERNEL  */
+
+
+
+/* *************************************************************************
+
+
+   NAME:  hamming_kernel_supported
+
+
+   USAGE:
+
+   if (hamming_kernel_supported(HAMMING_AVX2))
+   -- it's built in and this CPU runs it
+
+   returns: int
+
+   DESCRIPTION:
+                 return 1 if kernel is compiled in and this CPU can
+		 run it, 0 if not
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int hamming_kernel_supported(Hammingkernel_t kernel)
+{
+  int retval;
+
+  switch (kernel)
+    {
+    case HAMMING_SCALAR:
+      retval = 1;
+      break;
+
+    case HAMMING_POPCNT:
+#ifdef	HAVE_X86_KERNELS
+      retval = __builtin_cpu_supports("popcnt");
+#else
+      retval = 0;
+#endif
+      break;
+
+    case HAMMING_AVX2:
+#ifdef	HAVE_X86_KERNELS
+      retval = __builtin_cpu_supports("avx2");
+#else
+      retval = 0;
+#endif
+      break;
+
+    case HAMMING_NEON:
+#if defined(HAVE_NEON_KERNEL) && defined(__arm__)
+      retval = (0 != (getauxval(AT_HWCAP) & HWCAP_NEON));
+#elif defined(HAVE_NEON_KERNEL)
+      retval = 1; /* aarch64 always has it  */
+#else
+      retval = 0;
+#endif
+      break;
+
+    case HAMMING_AUTO:
+    default:
+      retval = 0;
+      break;
+    }
+
+  return(retval);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  hamming_kernel_function
+
+
+   USAGE:
+
+   Hammingfunc_t func;
+
+   func =  hamming_kernel_function(HAMMING_AVX2);
+
+   returns: Hammingfunc_t
+
+   DESCRIPTION:
+                 return the function that implements kernel. anything
+		 not compiled in gets the scalar version.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+     17-Oct-26  every kernel listed in the switch
+
+ ************************************************************************* */
+
+Hammingfunc_t hamming_kernel_function(Hammingkernel_t kernel)
+{
+  Hammingfunc_t retval;
+
+  switch (kernel)
+    {
+    case HAMMING_POPCNT:
+#ifdef	HAVE_X86_KERNELS
+      retval = hamming_distances_popcnt;
+#else
+      retval = hamming_distances_scalar;
+#endif
+      break;
+
+    case HAMMING_AVX2:
+#ifdef	HAVE_X86_KERNELS
+      retval = hamming_distances_avx2;
+#else
+      retval = hamming_distances_scalar;
+#endif
+      break;
+
+    case HAMMING_NEON:
+#ifdef	HAVE_NEON_KERNEL
+      retval = hamming_distances_neon;
+#else
+      retval = hamming_distances_scalar;
+#endif
+      break;
+
+    case HAMMING_AUTO:
+    case HAMMING_SCALAR:
+    default:
+      retval = hamming_distances_scalar;
+      break;
+    }
+
+  return(retval);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  check_hamming_kernel
+
+
+   USAGE:
+
+   if (0 == check_hamming_kernel(func))
+   -- func matches the scalar code
+
+   returns: int
+
+   DESCRIPTION:
+                 run func and the scalar code on one descriptor
+		 against CHECK_DESCRIPTORS pseudo-random ones (the
+		 first all zeros, the second all ones, so 0 and 256
+		 bits both turn up), in a scrambled order, and
+		 compare the distances.
+
+		 return 0 if they match
+		       -1 if they don't (or we couldn't get memory)
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int check_hamming_kernel(Hammingfunc_t func)
+{
+  unsigned char * descriptors;
+  int * candidates;
+  int * expected;
+  int * got;
+  unsigned int seed;
+  int i, retval;
+
+  descriptors = (unsigned char *)malloc((CHECK_DESCRIPTORS + 1)
+					* BRIEF_BYTES);
+  candidates = (int *)malloc(CHECK_DESCRIPTORS * sizeof(int));
+  expected = (int *)malloc(CHECK_DESCRIPTORS * sizeof(int));
+  got = (int *)malloc(CHECK_DESCRIPTORS * sizeof(int));
+
+  if ((NULL == descriptors) || (NULL == candidates) || (NULL == expected)
+      || (NULL == got))
+    {
+      retval = -1;
+    }
+  else
+    {
+      seed = 1;
+      for (i = 0; i < (CHECK_DESCRIPTORS + 1) * BRIEF_BYTES; i++)
+	{
+	  seed = seed * 1103515245u + 12345u;
+	  descriptors[i] = (unsigned char)(seed >> 16);
+	}
+      memset(descriptors + BRIEF_BYTES, 0, BRIEF_BYTES);
+      memset(descriptors + 2 * BRIEF_BYTES, 0xff, BRIEF_BYTES);
+
+      for (i = 0; i < CHECK_DESCRIPTORS; i++)
+	{
+	  candidates[i] = 1 + (i * 97) % CHECK_DESCRIPTORS;
+	}
+
+      hamming_distances_scalar(descriptors, descriptors, candidates,
+			       CHECK_DESCRIPTORS, expected);
+      func(descriptors, descriptors, candidates, CHECK_DESCRIPTORS, got);
+
+      retval = (0 == memcmp(expected, got, CHECK_DESCRIPTORS * sizeof(int)))
+	? 0 : -1;
+    }
+
+  free(descriptors);
+  free(candidates);
+  free(expected);
+  free(got);
+
+  return(retval);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  grow_featuregrid
+
+
+   USAGE:
+
+   if (0 == grow_featuregrid(grid, ncells, npoints))
+   -- grid has room
+
+   returns: int
+
+   DESCRIPTION:
+                 make sure grid's arrays have room for ncells cells
+		 and npoints train keypoints. they only ever grow.
+
+		 return 0 if all's well
+		       -1 if there's no memory (grid is as it was)
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int grow_featuregrid(Featuregrid_t * grid, int ncells, int npoints)
+{
+  int * cell_start;
+  int * order;
+  int * cell_of;
+  int * candidates;
+  int * distances;
+
+  if (ncells > grid->cells_allocated)
+    {
+      cell_start = (int *)realloc(grid->cell_start,
+				  (size_t)(ncells + 1) * sizeof(int));
+      if (NULL == cell_start)
+	{
+	  return(-1);
+	}
+      grid->cell_start = cell_start;
+      grid->cells_allocated = ncells;
+    }
+
+  if (npoints > grid->points_allocated)
+    {
+      order = (int *)realloc(grid->order, (size_t)npoints * sizeof(int));
+      if (NULL != order)
+	{
+	  grid->order = order;
+	}
+      cell_of = (int *)realloc(grid->cell_of, (size_t)npoints * sizeof(int));
+      if (NULL != cell_of)
+	{
+	  grid->cell_of = cell_of;
+	}
+      candidates = (int *)realloc(grid->candidates,
+				  (size_t)npoints * sizeof(int));
+      if (NULL != candidates)
+	{
+	  grid->candidates = candidates;
+	}
+      distances = (int *)realloc(grid->distances,
+				 (size_t)npoints * sizeof(int));
+      if (NULL != distances)
+	{
+	  grid->distances = distances;
+	}
+      if ((NULL == order) || (NULL == cell_of) || (NULL == candidates)
+	  || (NULL == distances))
+	{
+	  return(-1);
+	}
+      grid->points_allocated = npoints;
+    }
+
+  return(0);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  bucket_train_keypoints
+
+
+   USAGE:
+
+   if (0 == bucket_train_keypoints(grid, train_xy, ntrain, 25, 25))
+   -- grid->order holds them cell by cell
+
+   returns: int
+
+   DESCRIPTION:
+                 lay a grid of max_dx by max_dy cells over the train
+		 keypoints (from the smallest x and y up) and sort them
+		 into it: a counting sort, so each cell's keypoints
+		 stay in ascending order.
+
+		 a keypoint within max_dx, max_dy of a point is then in
+		 one of the 3x3 cells around that point's cell.
+
+		 return 0 if all's well
+		       -1 if there's no memory for the grid
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   the grid is capped at MAX_GRID_CELLS; past that the cells are made
+   bigger, which still finds everything, just with more candidates.
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int bucket_train_keypoints(Featuregrid_t * grid, const float * train_xy,
+			   int ntrain, float max_dx, float max_dy)
+{
+  float left, top, right, bottom, x, y;
+  int i, cell, col, row, ncells;
+
+  left = right = train_xy[0];
+  top = bottom = train_xy[1];
+  for (i = 1; i < ntrain; i++)
+    {
+      x = train_xy[2 * i];
+      y = train_xy[2 * i + 1];
+      left = (x < left) ? x : left;
+      right = (x > right) ? x : right;
+      top = (y < top) ? y : top;
+      bottom = (y > bottom) ? y : bottom;
+    }
+
+  grid->left = left;
+  grid->top = top;
+  grid->cell_width = max_dx;
+  grid->cell_height = max_dy;
+  grid->cols = (int)((right - left) / max_dx) + 1;
+  grid->rows = (int)((bottom - top) / max_dy) + 1;
+  while (MAX_GRID_CELLS < grid->cols * grid->rows)
+    {
+      grid->cell_width *= 2.0f;
+      grid->cell_height *= 2.0f;
+      grid->cols = (int)((right - left) / grid->cell_width) + 1;
+      grid->rows = (int)((bottom - top) / grid->cell_height) + 1;
+    }
+  ncells = grid->cols * grid->rows;
+
+  if (-1 == grow_featuregrid(grid, ncells, ntrain))
+    {
+      fprintf(stderr, "Error: no memory to match %d keypoints\n", ntrain);
+      return(-1);
+    }
+
+  memset(grid->cell_start, 0, (size_t)(ncells + 1) * sizeof(int));
+  for (i = 0; i < ntrain; i++)
+    {
+      col = (int)((train_xy[2 * i] - left) / grid->cell_width);
+      row = (int)((train_xy[2 * i + 1] - top) / grid->cell_height);
+      col = (col < grid->cols) ? col : grid->cols - 1; /* rounding  */
+      row = (row < grid->rows) ? row : grid->rows - 1;
+      cell = row * grid->cols + col;
+      grid->cell_of[i] = cell;
+      grid->cell_start[cell + 1]++;
+    }
+
+  for (cell = 0; cell < ncells; cell++)
+    {
+      grid->cell_start[cell + 1] += grid->cell_start[cell];
+    }
+
+  /* cell_start[c] is where the next of cell c's goes while filling  */
+  /* and ends up where cell c + 1 starts: shift back after  */
+  for (i = 0; i < ntrain; i++)
+    {
+      grid->order[grid->cell_start[grid->cell_of[i]]++] = i;
+    }
+  for (cell = ncells; 0 < cell; cell--)
+    {
+      grid->cell_start[cell] = grid->cell_start[cell - 1];
+    }
+  grid->cell_start[0] = 0;
+
+  return(0);
+}
@@ -0,0 +1,64 @@
+/* *************************************************************************
+* NAME: glutcam/featurematch.h
+*
+* DESCRIPTION:
+*
+* this is the header file for the functions exported from featurematch.c
+*
+* PROCESS:
+*
+*   Featuregrid_t grid;  -- zeroed
+*   Featurematch_t matches[nquery];
+*
+*   select_hamming_kernel(HAMMING_AUTO);
+*   loop:
+*     nmatches = match_features_windowed(&grid, query_xy, query_desc,
+*                                        nquery, train_xy, train_desc,
+*                                        ntrain, max_dx, max_dy, matches);
+*   free_featuregrid(&grid);
+*
+* GLOBALS: none
+*
+* REFERENCES:
+*
+* LIMITATIONS:
+*
+* REVISION HISTORY:
+*
+*   STR                Description                          Author
+*
+*   17-Oct-26          initial coding
+*
+* TARGET: Linux C
+*
+* This software is in the public domain. if it breaks you get to keep
+* both pieces.
+*
+* ************************************************************************* */
+
+#ifndef	__FEATUREMATCH_H__
+#define	__FEATUREMATCH_H__
+
+#include "glutcam.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+extern Hammingkernel_t select_hamming_kernel(Hammingkernel_t requested);
+extern const char * hamming_kernel_name(Hammingkernel_t kernel);
+extern Hammingkernel_t hamming_kernel_in_use(void);
+extern int match_features_windowed(Featuregrid_t * grid,
+				   const float * query_xy,
+				   const unsigned char * query_desc,
+				   int nquery, const float * train_xy,
+				   const unsigned char * train_desc,
+				   int ntrain, float max_dx, float max_dy,
+				   Featurematch_t * matches);
+extern void free_featuregrid(Featuregrid_t * grid);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	//__FEATUREMATCH_H__
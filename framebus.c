@@ -0,0 +1,1053 @@
+/* *************************************************************************
+* NAME: glutcam/framebus.c
+*
+* DESCRIPTION:
+*
+* a frame bus: share each captured frame with any number of other
+* processes (analytics, recorders) on the same machine, so they don't
+* each need the camera.
+*
+* the bus is a memfd holding a Framebusheader_t and FRAMEBUS_SLOTS
+* frames (see glutcam.h). the producer copies frame n into slot
+* n % nslots under the slot's sequence lock, bumps the header's
+* published count and wakes sleeping readers with a futex. it never
+* waits for a reader: a reader that falls FRAMEBUS_SLOTS frames
+* behind misses frames, and can tell.
+*
+* readers attach through a unix socket: they're sent a read only
+* file descriptor for the bus (SCM_RIGHTS) and map it. from then on
+* they read frames in place, without a copy or a message per frame,
+* and check the slot's sequence lock when they're done to know the
+* frame wasn't overwritten under them.
+*
+* unlike dmabuf.c this works with any source, and readers don't hold
+* up the driver's buffers; the price is one copy per frame.
+*
+* PROCESS:
+*
+* see framebus.h
+*
+* GLOBALS: none
+*
+* REFERENCES: memfd_create(2), unix(7) SCM_RIGHTS, futex(2),
+*             "seqlock" in the Linux kernel's Documentation/locking
+*
+* LIMITATIONS:
+*
+* the producer functions are called from the capture side only.
+*
+* readers run on the same kernel as the producer (the futex and
+* CLOCK_MONOTONIC are shared), and are trusted not to be slow on
+* purpose: a frame read while it's being overwritten is only
+* detected, not prevented.
+*
+* readers can't write to the bus only if the kernel has
+* F_SEAL_FUTURE_WRITE (5.1 and later); the read only descriptor alone
+* doesn't stop a reader reopening it read-write through /proc.
+*
+* REVISION HISTORY:
+*
+*   STR                Description                          Author
+*
+*   17-Oct-26          initial coding
+*   17-Oct-26          seal the bus against readers' writes
+*
+* TARGET: Linux C
+*
+* This software is in the public domain. if it breaks you get to keep
+* both pieces.
+*
+* ************************************************************************* */
+
+#define _GNU_SOURCE /* memfd_create, accept4  */
+#include <stdio.h>
+#include <string.h> /* memset, memcpy, memcmp, strncpy  */
+#include <errno.h>
+#include <limits.h> /* INT_MAX  */
+#include <fcntl.h> /* open, fcntl seals  */
+#include <unistd.h> /* close, unlink, ftruncate, syscall  */
+#include <time.h> /* struct timespec  */
+#include <sys/mman.h> /* memfd_create, mmap  */
+#include <sys/stat.h> /* fstat  */
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/syscall.h> /* SYS_futex  */
+#include <linux/futex.h> /* FUTEX_WAIT, FUTEX_WAKE  */
+
+#include "glutcam.h"
+#include "timeutil.h" /* monotonic_usec  */
+#include "framebus.h"
+
+/* F_SEAL_FUTURE_WRITE - Linux 5.1; older headers don't have it  */
+
+#ifndef F_SEAL_FUTURE_WRITE
+#define F_SEAL_FUTURE_WRITE 0x0010
+#endif
+
+/* local prototypes  */
+int send_framebus_fd(Framebus_t * bus, int reader);
+int set_framebus_address(struct sockaddr_un * address, const char * path);
+/* end local prototypes  */
+
+
+
+/* *************************************************************************
+
+
+   NAME:  start_framebus
+
+
+   USAGE:
+
+   int some_int;
+   Sourceparams_t * sourceparams;
+
+   some_int =  start_framebus(sourceparams);
+
+   if (0 == some_int)
+   -- readers can attach through sourceparams->framebus.path
+   else
+   -- carry on without the bus
+
+   returns: int
+
+   DESCRIPTION:
+                 create a bus big enough for FRAMEBUS_SLOTS frames
+		 the size of the source's, and listen for readers on
+		 sourceparams->framebus.path, replacing any socket a
+		 previous run left there.
+
+		 the memfd is sealed at that size so no reader can
+		 shrink it out from under us. once we've mapped it
+		 it's sealed against writes too (F_SEAL_FUTURE_WRITE):
+		 our mapping still works, but a reader can't get a
+		 writable one or write(), not even by reopening its
+		 read only descriptor through /proc.
+
+		 return 0 if all's well
+		       -1 (and say why) if the bus can't be set up
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   F_SEAL_FUTURE_WRITE needs Linux 5.1. an older kernel gets a warning
+   and a bus readers could write to.
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+     17-Oct-26  seal against writes once it's mapped
+
+ ************************************************************************* */
+
+int start_framebus(Sourceparams_t * sourceparams)
+{
+  Framebus_t * bus;
+  Framebusheader_t * header;
+  struct sockaddr_un address;
+  char fdpath[64];
+  size_t slot_bytes, data_offset;
+  void * map;
+  int i;
+
+  bus = &(sourceparams->framebus);
+  bus->running = 0;
+  bus->readers = 0;
+  bus->too_big = 0;
+
+  if (-1 == set_framebus_address(&address, bus->path))
+    {
+      fprintf(stderr, "Error: frame bus socket name %s is too long\n",
+	      bus->path);
+      return(-1);
+    }
+
+  slot_bytes = (sourceparams->captured.length + FRAMEBUS_ALIGN - 1) &
+    ~((size_t)FRAMEBUS_ALIGN - 1);
+  data_offset = (sizeof(Framebusheader_t) + FRAMEBUS_ALIGN - 1) &
+    ~((size_t)FRAMEBUS_ALIGN - 1);
+  bus->maplength = data_offset + FRAMEBUS_SLOTS * slot_bytes;
+
+  bus->memfd = memfd_create("glutcam-framebus",
+			    MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  if (-1 == bus->memfd)
+    {
+      perror("Error creating frame bus");
+      return(-1);
+    }
+
+  if ((-1 == ftruncate(bus->memfd, (off_t)bus->maplength))
+      || (-1 == fcntl(bus->memfd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW)))
+    {
+      perror("Error sizing frame bus");
+      close(bus->memfd);
+      return(-1);
+    }
+
+  /* a read only descriptor for the same file, for the readers  */
+  snprintf(fdpath, sizeof(fdpath), "/proc/self/fd/%d", bus->memfd);
+  bus->readonly_fd = open(fdpath, O_RDONLY | O_CLOEXEC);
+
+  map = mmap(NULL, bus->maplength, PROT_READ | PROT_WRITE, MAP_SHARED,
+	     bus->memfd, 0);
+
+  if ((-1 == bus->readonly_fd) || (MAP_FAILED == map))
+    {
+      perror("Error mapping frame bus");
+      if (-1 != bus->readonly_fd)
+	{
+	  close(bus->readonly_fd);
+	}
+      close(bus->memfd);
+      return(-1);
+    }
+
+  /* F_SEAL_WRITE would refuse: we've a writable shared mapping  */
+  if (-1 == fcntl(bus->memfd, F_ADD_SEALS, F_SEAL_FUTURE_WRITE | F_SEAL_SEAL))
+    {
+      perror("Warning: can't seal the frame bus against readers' writes");
+      (void)fcntl(bus->memfd, F_ADD_SEALS, F_SEAL_SEAL);
+    }
+
+  header = (Framebusheader_t *)map;
+  memcpy(header->magic, FRAMEBUS_MAGIC, sizeof(header->magic));
+  header->version = FRAMEBUS_VERSION;
+  header->header_bytes = sizeof(Framebusheader_t);
+  header->nslots = FRAMEBUS_SLOTS;
+  header->closed = 0;
+  header->slot_bytes = slot_bytes;
+  header->data_offset = data_offset;
+  header->published = 0;
+  for (i = 0; i < FRAMEBUS_SLOTS; i++)
+    {
+      header->slots[i].seq = 0;
+      header->slots[i].frame = ~0U; /* no frame yet  */
+    }
+  bus->header = header;
+
+  bus->listen_fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK |
+			  SOCK_CLOEXEC, 0);
+  (void)unlink(bus->path);
+
+  if ((-1 == bus->listen_fd)
+      || (-1 == bind(bus->listen_fd, (struct sockaddr *)&address,
+		     sizeof(address)))
+      || (-1 == listen(bus->listen_fd, SOMAXCONN)))
+    {
+      perror("Error listening on frame bus socket");
+      if (-1 != bus->listen_fd)
+	{
+	  close(bus->listen_fd);
+	}
+      munmap(map, bus->maplength);
+      close(bus->readonly_fd);
+      close(bus->memfd);
+      return(-1);
+    }
+
+  bus->running = 1;
+
+  fprintf(stderr, "frame bus on %s: %d slots of %lu bytes\n", bus->path,
+	  FRAMEBUS_SLOTS, (unsigned long)slot_bytes);
+
+  return(0);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  publish_framebus_frame
+
+
+   USAGE:
+
+   Sourceparams_t * sourceparams;
+   Frameslot_t slot;
+
+   -- in publish_video_frame, before the frame goes to the display
+   publish_framebus_frame(sourceparams, &slot);
+
+   returns: void
+
+   DESCRIPTION:
+                 take on any readers waiting to attach, then copy the
+		 frame in slot into the next slot of the bus:
+
+		 make the slot's seq odd, copy the pixels and describe
+		 them, make seq even again, bump the published count
+		 and wake the readers sleeping on it.
+
+		 does nothing if there's no bus.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   call this only from the producer (idle function or capture thread)
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void publish_framebus_frame(Sourceparams_t * sourceparams,
+			    const Frameslot_t * slot)
+{
+  Framebus_t * bus;
+  Framebusheader_t * header;
+  Framebusslot_t * busslot;
+  unsigned char * pixels;
+  uint32_t frame, seq;
+
+  bus = &(sourceparams->framebus);
+
+  if (0 == bus->running)
+    {
+      return;
+    }
+
+  (void)accept_framebus_readers(sourceparams);
+
+  header = bus->header;
+  if (header->slot_bytes < slot->length)
+    {
+      bus->too_big++;
+      return;
+    }
+
+  frame = header->published; /* only we write it  */
+  busslot = &(header->slots[frame % FRAMEBUS_SLOTS]);
+  pixels = (unsigned char *)header + header->data_offset +
+    (frame % FRAMEBUS_SLOTS) * header->slot_bytes;
+
+  seq = busslot->seq;
+  __atomic_store_n(&(busslot->seq), seq + 1, __ATOMIC_RELAXED);
+  /* readers must see seq go odd before any of the slot changes  */
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+
+  memcpy(pixels, slot->start, slot->length);
+  busslot->frame = frame;
+  busslot->sequence = slot->sequence;
+  busslot->width = (uint32_t)sourceparams->image_width;
+  busslot->height = (uint32_t)sourceparams->image_height;
+#ifdef	DEF_RGB
+  busslot->encoding = YUV422; /* what the device gives process()  */
+#else
+  busslot->encoding = (uint32_t)sourceparams->encoding;
+#endif
+  busslot->length = (uint32_t)slot->length;
+  busslot->capture_usec = slot->capture_usec;
+  busslot->published_usec = monotonic_usec();
+
+  __atomic_store_n(&(busslot->seq), seq + 2, __ATOMIC_RELEASE);
+  __atomic_store_n(&(header->published), frame + 1, __ATOMIC_RELEASE);
+
+  /* a wake with nobody waiting is one cheap system call a frame  */
+  (void)syscall(SYS_futex, &(header->published), FUTEX_WAKE, INT_MAX,
+		NULL, NULL, 0);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  accept_framebus_readers
+
+
+   USAGE:
+
+   unsigned int readers;
+   Sourceparams_t * sourceparams;
+
+   readers =  accept_framebus_readers(sourceparams);
+
+   returns: unsigned int
+
+   DESCRIPTION:
+                 send the bus to every reader waiting on the socket,
+		 then hang up on it: a reader needs nothing more from
+		 us than the descriptor.
+
+		 return the number of readers that have attached
+		 since start_framebus.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+unsigned int accept_framebus_readers(Sourceparams_t * sourceparams)
+{
+  Framebus_t * bus;
+  int reader;
+
+  bus = &(sourceparams->framebus);
+
+  if (0 == bus->running)
+    {
+      return(0);
+    }
+
+  while (-1 != (reader = accept4(bus->listen_fd, NULL, NULL, SOCK_CLOEXEC)))
+    {
+      if (0 == send_framebus_fd(bus, reader))
+	{
+	  bus->readers++;
+	}
+      close(reader);
+    }
+
+  return(bus->readers);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  stop_framebus
+
+
+   USAGE:
+
+   Sourceparams_t * sourceparams;
+
+   -- once nothing can call publish_framebus_frame any more
+   stop_framebus(sourceparams);
+
+   returns: void
+
+   DESCRIPTION:
+                 mark the bus closed and wake the readers so they
+		 find out, stop listening and remove the socket, and
+		 unmap the bus. readers keep their own mappings.
+
+		 does nothing if there's no bus.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void stop_framebus(Sourceparams_t * sourceparams)
+{
+  Framebus_t * bus;
+
+  bus = &(sourceparams->framebus);
+
+  if (0 == bus->running)
+    {
+      return;
+    }
+
+  __atomic_store_n(&(bus->header->closed), 1, __ATOMIC_RELEASE);
+  (void)syscall(SYS_futex, &(bus->header->published), FUTEX_WAKE, INT_MAX,
+		NULL, NULL, 0);
+
+  fprintf(stderr, "frame bus: %u frames published to %u readers",
+	  bus->header->published, bus->readers);
+  if (0 < bus->too_big)
+    {
+      fprintf(stderr, ", %u too big for it", bus->too_big);
+    }
+  fprintf(stderr, "\n");
+
+  close(bus->listen_fd);
+  (void)unlink(bus->path);
+  munmap(bus->header, bus->maplength);
+  close(bus->readonly_fd);
+  close(bus->memfd);
+  bus->header = NULL;
+  bus->running = 0;
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  attach_framebus
+
+
+   USAGE:
+
+   int some_int;
+   Framebusreader_t reader;
+
+   some_int =  attach_framebus("/tmp/glutcam.bus", &reader);
+
+   if (0 == some_int)
+   -- next_framebus_frame(&reader, ...) will give us frames
+   else
+   -- nobody's publishing there, and we've said why
+
+   returns: int
+
+   DESCRIPTION:
+                 connect to the producer's socket at path, take the
+		 bus it sends, map it read only and check it's a bus
+		 we understand.
+
+		 the first frame we'll be given is the next one
+		 published.
+
+		 return 0 on success
+		       -1 (and say why) on error
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int attach_framebus(const char * path, Framebusreader_t * reader)
+{
+  struct sockaddr_un address;
+  struct msghdr header;
+  struct iovec iov;
+  struct cmsghdr * cmsg;
+  union {
+    char buf[CMSG_SPACE(sizeof(int))];
+    struct cmsghdr align;
+  } control;
+  struct stat busstat;
+  uint64_t maplength;
+  const Framebusheader_t * bus;
+  void * map;
+  int sock, fd;
+
+  memset(reader, 0, sizeof(*reader));
+
+  if (-1 == set_framebus_address(&address, path))
+    {
+      fprintf(stderr, "Error: frame bus socket name %s is too long\n", path);
+      return(-1);
+    }
+
+  sock = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+  if ((-1 == sock)
+      || (-1 == connect(sock, (struct sockaddr *)&address, sizeof(address))))
+    {
+      perror(path);
+      if (-1 != sock)
+	{
+	  close(sock);
+	}
+      return(-1);
+    }
+
+  memset(&header, 0, sizeof(header));
+  iov.iov_base = &maplength;
+  iov.iov_len = sizeof(maplength);
+  header.msg_iov = &iov;
+  header.msg_iovlen = 1;
+  header.msg_control = control.buf;
+  header.msg_controllen = sizeof(control.buf);
+
+  fd = -1;
+  if ((ssize_t)sizeof(maplength) == recvmsg(sock, &header, MSG_CMSG_CLOEXEC))
+    {
+      cmsg = CMSG_FIRSTHDR(&header);
+      if ((NULL != cmsg) && (SOL_SOCKET == cmsg->cmsg_level)
+	  && (SCM_RIGHTS == cmsg->cmsg_type))
+	{
+	  memcpy(&fd, CMSG_DATA(cmsg), sizeof(fd));
+	}
+    }
+  close(sock);
+
+  if ((-1 == fd) || (-1 == fstat(fd, &busstat))
+      || ((off_t)maplength != busstat.st_size)
+      || (sizeof(Framebusheader_t) > maplength))
+    {
+      fprintf(stderr, "Error: no frame bus from %s\n", path);
+      if (-1 != fd)
+	{
+	  close(fd);
+	}
+      return(-1);
+    }
+
+  map = mmap(NULL, (size_t)maplength, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd); /* the mapping keeps the bus  */
+  if (MAP_FAILED == map)
+    {
+      perror("Error mapping frame bus");
+      return(-1);
+    }
+
+  bus = (const Framebusheader_t *)map;
+  if ((0 != memcmp(bus->magic, FRAMEBUS_MAGIC, sizeof(bus->magic)))
+      || (FRAMEBUS_VERSION != bus->version)
+      || (FRAMEBUS_SLOTS != bus->nslots)
+      || (bus->data_offset + bus->nslots * bus->slot_bytes > maplength))
+    {
+      fprintf(stderr, "Error: %s isn't a version %d frame bus\n", path,
+	      FRAMEBUS_VERSION);
+      munmap(map, (size_t)maplength);
+      return(-1);
+    }
+
+  reader->header = bus;
+  reader->maplength = (size_t)maplength;
+  reader->next = __atomic_load_n(&(bus->published), __ATOMIC_ACQUIRE);
+
+  return(0);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  next_framebus_frame
+
+
+   USAGE:
+
+   int some_int;
+   Framebusreader_t reader;
+   Framebusframe_t frame;
+
+   some_int =  next_framebus_frame(&reader, &frame, 100000);
+
+   if (0 == some_int)
+   -- frame.data has the next frame
+   else if (1 == some_int)
+   -- nothing published in 0.1 sec
+   else
+   -- the producer has gone
+
+   returns: int
+
+   DESCRIPTION:
+                 give the reader the next frame on the bus, waiting
+		 up to timeout_usec for one to be published.
+
+		 frames come in order. a reader that has fallen more
+		 than FRAMEBUS_SLOTS frames behind, or finds a frame
+		 being overwritten as it looks at it, skips ahead;
+		 the frames skipped are added to reader->missed.
+
+		 frame->data points into the bus: no copy. the
+		 producer may overwrite it once FRAMEBUS_SLOTS more
+		 frames are published, so check
+		 framebus_frame_intact after using it.
+
+		 return 0 if there's a frame
+		        1 on timeout
+		       -1 if the producer has closed the bus
+
+   REFERENCES: futex(2)
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int next_framebus_frame(Framebusreader_t * reader, Framebusframe_t * frame,
+			int timeout_usec)
+{
+  const Framebusheader_t * bus;
+  const Framebusslot_t * slot;
+  struct timespec timeout;
+  long long deadline_usec, left_usec;
+  uint32_t published, seq;
+
+  bus = reader->header;
+  deadline_usec = monotonic_usec() + timeout_usec;
+
+  for (;;)
+    {
+      published = __atomic_load_n(&(bus->published), __ATOMIC_ACQUIRE);
+
+      if (published == reader->next)
+	{
+	  if (0 != __atomic_load_n(&(bus->closed), __ATOMIC_ACQUIRE))
+	    {
+	      return(-1);
+	    }
+	  left_usec = deadline_usec - monotonic_usec();
+	  if (0 >= left_usec)
+	    {
+	      return(1);
+	    }
+	  timeout.tv_sec = left_usec / 1000000;
+	  timeout.tv_nsec = (left_usec % 1000000) * 1000;
+	  /* returns at once if published has moved since we looked  */
+	  (void)syscall(SYS_futex, &(bus->published), FUTEX_WAIT, published,
+			&timeout, NULL, 0);
+	  continue;
+	}
+
+      if (FRAMEBUS_SLOTS <= published - reader->next)
+	{
+	  /* lapped: the oldest frames left are about to go too;  */
+	  /* jump to the newest  */
+	  reader->missed += published - 1 - reader->next;
+	  reader->next = published - 1;
+	}
+
+      slot = &(bus->slots[reader->next % FRAMEBUS_SLOTS]);
+      seq = __atomic_load_n(&(slot->seq), __ATOMIC_ACQUIRE);
+
+      frame->frame = slot->frame;
+      frame->sequence = slot->sequence;
+      frame->width = slot->width;
+      frame->height = slot->height;
+      frame->encoding = slot->encoding;
+      frame->length = slot->length;
+      frame->capture_usec = slot->capture_usec;
+      frame->published_usec = slot->published_usec;
+
+      /* the copies above must be done before we look at seq again  */
+      __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+      if ((0 != (seq & 1))
+	  || (seq != __atomic_load_n(&(slot->seq), __ATOMIC_RELAXED))
+	  || (reader->next != frame->frame)
+	  || (bus->slot_bytes < frame->length))
+	{
+	  /* overwritten as we looked: it's gone  */
+	  reader->missed++;
+	  reader->next++;
+	  continue;
+	}
+
+      frame->data = (const unsigned char *)bus + bus->data_offset +
+	(reader->next % FRAMEBUS_SLOTS) * bus->slot_bytes;
+      frame->slot = slot;
+      frame->seq = seq;
+      reader->next++;
+      reader->frames++;
+      return(0);
+    }
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  framebus_frame_intact
+
+
+   USAGE:
+
+   Framebusreader_t reader;
+   Framebusframe_t frame;
+
+   -- after next_framebus_frame(&reader, &frame, ...) and using frame.data
+   if (framebus_frame_intact(&reader, &frame))
+   -- what we read was the frame and only the frame
+
+   returns: int
+
+   DESCRIPTION:
+                 return 1 if the producer hasn't started to overwrite
+		 frame's slot since next_framebus_frame gave it to us,
+		 0 if it has (anything read from frame->data since
+		 may be part of a newer frame).
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int framebus_frame_intact(const Framebusreader_t * reader,
+			  const Framebusframe_t * frame)
+{
+  (void)reader;
+
+  /* our reads of the pixels must be done before we look at seq  */
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+  return(frame->seq == __atomic_load_n(&(frame->slot->seq), __ATOMIC_RELAXED));
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  detach_framebus
+
+
+   USAGE:
+
+   Framebusreader_t reader;
+
+   detach_framebus(&reader);
+
+   returns: void
+
+   DESCRIPTION:
+                 unmap the bus. the producer doesn't need to know.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void detach_framebus(Framebusreader_t * reader)
+{
+  if (NULL != reader->header)
+    {
+      munmap((void *)reader->header, reader->maplength);
+      reader->header = NULL;
+    }
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  send_framebus_fd
+
+
+   USAGE:
+
+   int some_int;
+   Framebus_t * bus;
+   int reader;
+
+   some_int =  send_framebus_fd(bus, reader);
+
+   returns: int
+
+   DESCRIPTION:
+                 send the bus's read only descriptor, and its size,
+		 to the reader connected on socket reader.
+
+		 return 0 on success
+		       -1 on error
+
+   REFERENCES: unix(7) SCM_RIGHTS
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int send_framebus_fd(Framebus_t * bus, int reader)
+{
+  struct msghdr header;
+  struct iovec iov;
+  struct cmsghdr * cmsg;
+  union {
+    char buf[CMSG_SPACE(sizeof(int))];
+    struct cmsghdr align;
+  } control;
+  uint64_t maplength;
+
+  maplength = bus->maplength;
+
+  memset(&header, 0, sizeof(header));
+  memset(&control, 0, sizeof(control));
+  iov.iov_base = &maplength;
+  iov.iov_len = sizeof(maplength);
+  header.msg_iov = &iov;
+  header.msg_iovlen = 1;
+  header.msg_control = control.buf;
+  header.msg_controllen = sizeof(control.buf);
+
+  cmsg = CMSG_FIRSTHDR(&header);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+  memcpy(CMSG_DATA(cmsg), &(bus->readonly_fd), sizeof(int));
+
+  if ((ssize_t)sizeof(maplength) != sendmsg(reader, &header,
+					    MSG_DONTWAIT | MSG_NOSIGNAL))
+    {
+      perror("Error sending frame bus to reader");
+      return(-1);
+    }
+
+  return(0);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  set_framebus_address
+
+
+   USAGE:
+
+   int some_int;
+   struct sockaddr_un address;
+   const char * path;
+
+   some_int =  set_framebus_address(&address, path);
+
+   returns: int
+
+   DESCRIPTION:
+                 fill in address for the unix socket at path.
+
+		 return 0 on success
+		       -1 if path is too long for a socket name
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int set_framebus_address(struct sockaddr_un * address, const char * path)
+{
+  memset(address, 0, sizeof(*address));
+  address->sun_family = AF_UNIX;
+
+  if (sizeof(address->sun_path) <= strlen(path))
+    {
+      return(-1);
+    }
+
+  strncpy(address->sun_path, path, sizeof(address->sun_path) - 1);
+
+  return(0);
+}
@@ -0,0 +1,82 @@
+/* *************************************************************************
+* NAME: glutcam/framebus.h
+*
+* DESCRIPTION:
+*
+* this is the header file for the functions exported from framebus.c
+*
+* PROCESS:
+*
+* producer side (glutcam with -B socket, or busbench.c):
+*
+* start_framebus creates the bus and listens on sourceparams->framebus.path
+*
+* publish_framebus_frame copies a frame onto the bus and wakes the
+*   readers. publish_video_frame calls it.
+*
+* accept_framebus_readers takes on readers that are waiting to attach
+*   (publish_framebus_frame does this too)
+*
+* stop_framebus tells the readers nothing more is coming, removes the
+*   socket and unmaps the bus
+*
+* reader side (another process), the "reader library":
+*
+*   Framebusreader_t reader;
+*   Framebusframe_t frame;
+*
+*   attach_framebus(path, &reader);
+*   while (0 == next_framebus_frame(&reader, &frame, timeout_usec))
+*     {
+*       -- use frame.data, frame.length, frame.width, ...
+*       if (framebus_frame_intact(&reader, &frame))
+*       -- the producer didn't overwrite it while we used it
+*     }
+*   detach_framebus(&reader);
+*
+* GLOBALS: none
+*
+* REFERENCES: memfd_create(2), unix(7) SCM_RIGHTS, futex(2)
+*
+* LIMITATIONS:
+*
+* REVISION HISTORY:
+*
+*   STR                Description                          Author
+*
+*   17-Oct-26          initial coding
+*
+* TARGET: Linux C
+*
+* This software is in the public domain. if it breaks you get to keep
+* both pieces.
+*
+* ************************************************************************* */
+
+#ifndef	__FRAMEBUS_H__
+#define	__FRAMEBUS_H__
+
+#include "glutcam.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+extern int start_framebus(Sourceparams_t * sourceparams);
+extern void publish_framebus_frame(Sourceparams_t * sourceparams,
+				   const Frameslot_t * slot);
+extern unsigned int accept_framebus_readers(Sourceparams_t * sourceparams);
+extern void stop_framebus(Sourceparams_t * sourceparams);
+
+extern int attach_framebus(const char * path, Framebusreader_t * reader);
+extern int next_framebus_frame(Framebusreader_t * reader,
+			       Framebusframe_t * frame, int timeout_usec);
+extern int framebus_frame_intact(const Framebusreader_t * reader,
+				 const Framebusframe_t * frame);
+extern void detach_framebus(Framebusreader_t * reader);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	//__FRAMEBUS_H__
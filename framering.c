@@ -0,0 +1,288 @@
+/* ************************************************************************* 
+* NAME: glutcam/framering.c
+*
+* DESCRIPTION:
+*
+* a single-producer/single-consumer ring of captured frames.
+*
+* the producer owns head, the consumer owns tail. each side only ever
+* stores to its own index, and reads the other side's index with
+* acquire semantics, so a slot's contents are always visible before
+* the index that publishes it. head and tail run freely and wrap;
+* head - tail is the number of frames waiting.
+*
+* PROCESS:
+*
+* see framering.h
+*
+* GLOBALS: none
+*
+* REFERENCES:
+*
+* LIMITATIONS:
+*
+* FRAMERING_SIZE must be a power of two (we mask instead of mod).
+*
+* REVISION HISTORY:
+*
+*   STR                Description                          Author
+*
+*   17-Oct-26          initial coding
+*
+* TARGET: Linux C (gcc __atomic builtins)
+*
+* This software is in the public domain. if it breaks you get to keep
+* both pieces.
+*
+* ************************************************************************* */
+
+#include <string.h> /* memset  */
+
+#include "glutcam.h"
+#include "framering.h"
+
+/* FRAMERING_MASK - turn a free-running index into a slot number  */
+
+#define FRAMERING_MASK (FRAMERING_SIZE - 1)
+
+
+
+/* ************************************************************************* 
+
+
+   NAME:  init_framering
+
+
+   USAGE: 
+
+   Framering_t ring;
+
+   init_framering(&ring);
+
+   returns: void
+
+   DESCRIPTION:
+                 empty the ring. not thread safe: call it before
+		 the producer and consumer start.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void init_framering(Framering_t * ring)
+{
+  memset(ring, 0, sizeof(*ring));
+}
+
+
+
+/* ************************************************************************* 
+
+
+   NAME:  framering_push
+
+
+   USAGE: 
+
+   int some_int;
+   Framering_t * ring;
+   Frameslot_t slot;
+
+   some_int =  framering_push(ring, &slot);
+
+   if (-1 == some_int)
+   -- ring is full; slot was not added
+   
+   returns: int
+
+   DESCRIPTION:
+                 copy slot into the ring and publish it to the consumer.
+		 call this from the producer thread only.
+
+		 return 0 if the slot was added
+		       -1 if the ring is full
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int framering_push(Framering_t * ring, const Frameslot_t * slot)
+{
+  unsigned int head, tail;
+  int retval;
+
+  head = ring->head; /* only we write it  */
+  tail = __atomic_load_n(&(ring->tail), __ATOMIC_ACQUIRE);
+
+  if (FRAMERING_SIZE == head - tail)
+    {
+      retval = -1; /* full  */
+    }
+  else
+    {
+      ring->slots[head & FRAMERING_MASK] = *slot;
+      /* the slot contents must land before the consumer sees head move  */
+      __atomic_store_n(&(ring->head), head + 1, __ATOMIC_RELEASE);
+      retval = 0;
+    }
+
+  return(retval);
+}
+
+
+
+/* ************************************************************************* 
+
+
+   NAME:  framering_pop
+
+
+   USAGE: 
+
+   int some_int;
+   Framering_t * ring;
+   Frameslot_t slot;
+
+   some_int =  framering_pop(ring, &slot);
+
+   if (0 == some_int)
+   -- slot holds the oldest frame
+   else
+   -- ring was empty
+   
+   returns: int
+
+   DESCRIPTION:
+                 copy the oldest frame out of the ring and give its slot
+		 back to the producer. call this from the consumer thread
+		 only.
+
+		 return 0 if a frame was taken
+		       -1 if the ring is empty
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int framering_pop(Framering_t * ring, Frameslot_t * slot)
+{
+  unsigned int head, tail;
+  int retval;
+
+  tail = ring->tail; /* only we write it  */
+  head = __atomic_load_n(&(ring->head), __ATOMIC_ACQUIRE);
+
+  if (head == tail)
+    {
+      retval = -1; /* empty  */
+    }
+  else
+    {
+      *slot = ring->slots[tail & FRAMERING_MASK];
+      /* done reading the slot: let the producer reuse it  */
+      __atomic_store_n(&(ring->tail), tail + 1, __ATOMIC_RELEASE);
+      retval = 0;
+    }
+
+  return(retval);
+}
+
+
+
+/* ************************************************************************* 
+
+
+   NAME:  framering_count
+
+
+   USAGE: 
+
+   int nframes;
+   Framering_t * ring;
+
+   nframes =  framering_count(ring);
+
+   returns: int
+
+   DESCRIPTION:
+                 return the number of frames waiting in the ring.
+		 if the other side is running this is a snapshot that
+		 may already be stale.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int framering_count(Framering_t * ring)
+{
+  unsigned int head, tail;
+
+  head = __atomic_load_n(&(ring->head), __ATOMIC_ACQUIRE);
+  tail = __atomic_load_n(&(ring->tail), __ATOMIC_ACQUIRE);
+
+  return((int)(head - tail));
+}
@@ -0,0 +1,61 @@
+/* ************************************************************************* 
+* NAME: glutcam/framering.h
+*
+* DESCRIPTION:
+*
+* this is the header file for the functions exported from framering.c
+*
+* a Framering_t (see glutcam.h) passes captured frames from exactly one
+* producer (the GLUT idle function or the capture thread) to exactly one
+* consumer (the code that draws the window) without locks.
+*
+* PROCESS:
+*
+* init_framering empties the ring. call it before either side uses it.
+*
+* framering_push (producer only) adds a frame; -1 if the ring is full
+*
+* framering_pop (consumer only) takes the oldest frame; -1 if empty
+*
+* framering_count (either side) is how many frames are waiting
+*
+* GLOBALS: none
+*
+* REFERENCES:
+*
+* LIMITATIONS:
+*
+* one producer thread and one consumer thread. no more.
+*
+* REVISION HISTORY:
+*
+*   STR                Description                          Author
+*
+*   17-Oct-26          initial coding
+*
+* TARGET: Linux C (gcc __atomic builtins)
+*
+* This software is in the public domain. if it breaks you get to keep
+* both pieces.
+*
+* ************************************************************************* */
+
+#ifndef	__FRAMERING_H__
+#define	__FRAMERING_H__
+
+#include "glutcam.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+extern void init_framering(Framering_t * ring);
+extern int framering_push(Framering_t * ring, const Frameslot_t * slot);
+extern int framering_pop(Framering_t * ring, Frameslot_t * slot);
+extern int framering_count(Framering_t * ring);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	//__FRAMERING_H__
@@ -0,0 +1,626 @@
+/* *************************************************************************
+* NAME: glutcam/framesync.c
+*
+* DESCRIPTION:
+*
+* match up the frames of several sources (a stereo rig: two or more
+* -d devices in one process) by when they were captured. each
+* frame's Frameslot_t carries capture_usec, the time the driver
+* stamped on the buffer (v4l2_buffer.timestamp, monotonic clock),
+* so frames from different cameras can be compared even though they
+* were dequeued at different times.
+*
+* the sync stage sits between the sources' frame rings and the
+* consumer. it takes each source's frames out of its ring and holds
+* the newest SYNC_HOLD_FRAMES of them. a set is one frame from every
+* source with the newest and oldest no more than window_usec apart.
+* when the frames at the front don't make a set, the ones too old to
+* belong to any set with the newest front frame are given back
+* (dropped) and it tries again; when a source has nothing held yet,
+* everyone else's frames wait for it (held). when several complete
+* sets are waiting, the consumer gets the newest and the older ones
+* are given back.
+*
+* PROCESS:
+*
+* see framesync.h
+*
+* GLOBALS: none
+*
+* REFERENCES: VIDIOC_DQBUF, v4l2_buffer.timestamp
+*
+* LIMITATIONS:
+*
+* cameras that aren't hardware-triggered together drift apart; the
+* window has to be at least that drift or sets only come together
+* now and then. a held frame is a buffer the driver doesn't have:
+* with the default buffer count that's fine, with -b 2 it starves
+* the device.
+*
+* REVISION HISTORY:
+*
+*   STR                Description                          Author
+*
+*   17-Oct-26          initial coding
+*
+* TARGET: Linux C
+*
+* This software is in the public domain. if it breaks you get to keep
+* both pieces.
+*
+* ************************************************************************* */
+
+#include <stdio.h>
+#include <string.h> /* memset  */
+
+#include "glutcam.h"
+#include "capture.h" /* release_video_frame  */
+#include "framering.h" /* framering_pop  */
+#include "framesync.h"
+
+/* local prototypes  */
+void refill_held_frames(Sourceset_t * sourceset);
+void drop_held_frame(Sourceset_t * sourceset, int source);
+void take_held_frame(Framesync_t * sync, int source, Frameslot_t * slot);
+int match_frame_set(Sourceset_t * sourceset, Frameslot_t slots[],
+		    long long * spreadp);
+/* end local prototypes  */
+
+
+
+/* *************************************************************************
+
+
+   NAME:  init_framesync
+
+
+   USAGE:
+
+   Framesync_t * sync;
+   long long window_usec;
+
+   init_framesync(sync, window_usec);
+
+   returns: void
+
+   DESCRIPTION:
+                 empty sync and set its window: the frames of a set
+		 are captured no more than window_usec apart. a
+		 window of 0 means there's no sync stage and each
+		 source is drawn on its own.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void init_framesync(Framesync_t * sync, long long window_usec)
+{
+  memset(sync, 0, sizeof(*sync));
+  sync->window_usec = (0 < window_usec) ? window_usec : 0;
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  acquire_synced_frames
+
+
+   USAGE:
+
+   Sourceset_t * sourceset;
+   Frameslot_t slots[MAX_SOURCES];
+
+   if (0 == acquire_synced_frames(sourceset, slots))
+   {
+     -- slots[i] is sourceset->sources[i]'s frame
+     release_video_frame(sourceset->sources[i], &(slots[i])) ...
+   }
+
+   returns: int
+
+   DESCRIPTION:
+                 acquire_video_frame for the whole set at once: take
+		 whatever the sources have published and put one
+		 frame of each in slots, all captured within
+		 sourceset->sync.window_usec of each other. if more
+		 than one such set is ready, it's the newest one: the
+		 older ones are stale, so they're given back.
+
+		 the frames are the caller's until it gives each back
+		 to its source with release_video_frame.
+
+		 return 0 if there's a set in slots
+		       -1 if no complete set is ready yet
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   call this only from the consumer (the drawing thread)
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int acquire_synced_frames(Sourceset_t * sourceset, Frameslot_t slots[])
+{
+  Frameslot_t newer[MAX_SOURCES];
+  long long spread;
+  int i;
+
+  refill_held_frames(sourceset);
+
+  if (-1 == match_frame_set(sourceset, slots, &spread))
+    {
+      return(-1);
+    }
+
+  while (0 == match_frame_set(sourceset, newer, &spread))
+    {
+      for (i = 0; i < sourceset->nsources; i++)
+	{
+	  release_video_frame(sourceset->sources[i], &(slots[i]));
+	  slots[i] = newer[i];
+	}
+      sourceset->sync.stale_sets++;
+    }
+
+  sourceset->sync.sets++;
+  sourceset->sync.spread_total_usec += spread;
+  if (spread > sourceset->sync.spread_max_usec)
+    {
+      sourceset->sync.spread_max_usec = spread;
+    }
+
+  return(0);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  flush_framesync
+
+
+   USAGE:
+
+   Sourceset_t * sourceset;
+
+   flush_framesync(sourceset);
+
+   returns: void
+
+   DESCRIPTION:
+                 give every frame the sync stage is holding back to
+		 its source, before the sources are stopped.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void flush_framesync(Sourceset_t * sourceset)
+{
+  Framesync_t * sync;
+  int i, j;
+
+  sync = &(sourceset->sync);
+
+  for (i = 0; i < sourceset->nsources; i++)
+    {
+      for (j = 0; j < sync->nheld[i]; j++)
+	{
+	  release_video_frame(sourceset->sources[i], &(sync->held[i][j]));
+	}
+      sync->nheld[i] = 0;
+    }
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  report_framesync
+
+
+   USAGE:
+
+   const Sourceset_t * sourceset;
+   FILE * fp;
+
+   report_framesync(sourceset, fp);
+
+   returns: void
+
+   DESCRIPTION:
+                 print how the sync stage did to fp: the sets it
+		 handed out, the ones passed over, how far apart the
+		 frames of a set were captured, and how many frames
+		 of each source never made it into a set.
+
+		 prints nothing if there's no sync stage.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void report_framesync(const Sourceset_t * sourceset, FILE * fp)
+{
+  const Framesync_t * sync;
+  int i;
+
+  sync = &(sourceset->sync);
+
+  if (0 == sync->window_usec)
+    {
+      return;
+    }
+
+  fprintf(fp, "frame sync (%lld usec window): %u sets, %u stale sets passed"
+	  " over\n", sync->window_usec, sync->sets, sync->stale_sets);
+
+  if (0 < sync->sets)
+    {
+      fprintf(fp, "  capture spread: average %lld usec, max %lld usec\n",
+	      sync->spread_total_usec / (long long)sync->sets,
+	      sync->spread_max_usec);
+    }
+
+  for (i = 0; i < sourceset->nsources; i++)
+    {
+      fprintf(fp, "  source %d: %u frames dropped unmatched\n", i,
+	      sync->dropped[i]);
+    }
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  refill_held_frames
+
+
+   USAGE:
+
+   Sourceset_t * sourceset;
+
+   refill_held_frames(sourceset);
+
+   returns: void
+
+   DESCRIPTION:
+                 move everything waiting in each source's frame ring
+		 to the back of its held frames. a source can't hold
+		 more than SYNC_HOLD_FRAMES: when it's full, the
+		 oldest is dropped to make room. a source that far
+		 ahead of the others is never going to be matched
+		 with its oldest frames anyway.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void refill_held_frames(Sourceset_t * sourceset)
+{
+  Framesync_t * sync;
+  Frameslot_t slot;
+  int i;
+
+  sync = &(sourceset->sync);
+
+  for (i = 0; i < sourceset->nsources; i++)
+    {
+      while (0 == framering_pop(&(sourceset->sources[i]->ring), &slot))
+	{
+	  if (SYNC_HOLD_FRAMES == sync->nheld[i])
+	    {
+	      drop_held_frame(sourceset, i);
+	    }
+	  sync->held[i][sync->nheld[i]++] = slot;
+	}
+    }
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  drop_held_frame
+
+
+   USAGE:
+
+   Sourceset_t * sourceset;
+   int source;
+
+   drop_held_frame(sourceset, source);
+
+   returns: void
+
+   DESCRIPTION:
+                 give the oldest held frame of sourceset->sources[source]
+		 back to it unused, and count it as dropped.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   there has to be one
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void drop_held_frame(Sourceset_t * sourceset, int source)
+{
+  Frameslot_t slot;
+
+  take_held_frame(&(sourceset->sync), source, &slot);
+  release_video_frame(sourceset->sources[source], &slot);
+  sourceset->sync.dropped[source]++;
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  take_held_frame
+
+
+   USAGE:
+
+   Framesync_t * sync;
+   int source;
+   Frameslot_t slot;
+
+   take_held_frame(sync, source, &slot);
+
+   returns: void
+
+   DESCRIPTION:
+                 take the oldest frame held for source out of sync
+		 and put it in slot.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   there has to be one
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void take_held_frame(Framesync_t * sync, int source, Frameslot_t * slot)
+{
+  int j;
+
+  *slot = sync->held[source][0];
+
+  sync->nheld[source]--;
+  for (j = 0; j < sync->nheld[source]; j++)
+    {
+      sync->held[source][j] = sync->held[source][j + 1];
+    }
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  match_frame_set
+
+
+   USAGE:
+
+   int some_int;
+   Sourceset_t * sourceset;
+   Frameslot_t slots[MAX_SOURCES];
+   long long spread;
+
+   some_int =  match_frame_set(sourceset, slots, &spread);
+
+   returns: int
+
+   DESCRIPTION:
+                 make the oldest set out of the held frames. look at
+		 the oldest frame held for each source: if the newest
+		 of those and the oldest of those were captured
+		 within the window, they're a set. take them out and
+		 put them in slots, and how far apart they were
+		 captured in spreadp.
+
+		 if they're too far apart, any of them captured more
+		 than the window before the newest can't be in a
+		 set with it, or with anything later: drop those and
+		 try again with the frames behind them.
+
+		 return 0 if there's a set in slots
+		       -1 if a source has no frames held: the others'
+		          wait for it
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int match_frame_set(Sourceset_t * sourceset, Frameslot_t slots[],
+		    long long * spreadp)
+{
+  Framesync_t * sync;
+  long long oldest, newest, when, spread;
+  int i;
+
+  sync = &(sourceset->sync);
+
+  for (;;)
+    {
+      for (i = 0; i < sourceset->nsources; i++)
+	{
+	  if (0 == sync->nheld[i])
+	    {
+	      return(-1);
+	    }
+	}
+
+      oldest = newest = sync->held[0][0].capture_usec;
+      for (i = 1; i < sourceset->nsources; i++)
+	{
+	  when = sync->held[i][0].capture_usec;
+	  if (when < oldest)
+	    {
+	      oldest = when;
+	    }
+	  if (when > newest)
+	    {
+	      newest = when;
+	    }
+	}
+
+      spread = newest - oldest;
+
+      if (spread <= sync->window_usec)
+	{
+	  break;
+	}
+
+      for (i = 0; i < sourceset->nsources; i++)
+	{
+	  if (sync->held[i][0].capture_usec < newest - sync->window_usec)
+	    {
+	      drop_held_frame(sourceset, i);
+	    }
+	}
+    }
+
+  for (i = 0; i < sourceset->nsources; i++)
+    {
+      take_held_frame(sync, i, &(slots[i]));
+    }
+
+  *spreadp = spread;
+
+  return(0);
+}
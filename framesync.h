@@ -0,0 +1,65 @@
+/* *************************************************************************
+* NAME: glutcam/framesync.h
+*
+* DESCRIPTION:
+*
+* this is the header file for the functions exported from framesync.c
+*
+* PROCESS:
+*
+*   Sourceset_t sourceset;
+*   Frameslot_t slots[MAX_SOURCES];
+*
+*   init_framesync(&(sourceset.sync), window_usec);
+*   start_capture_sources(&sourceset);
+*   loop:
+*     if (0 == acquire_synced_frames(&sourceset, slots))
+*       {
+*         -- slots[i] is source i's frame; all captured within
+*         -- window_usec of each other
+*         release_video_frame(sourceset.sources[i], &(slots[i])) ...
+*       }
+*   stop_capture_sources(&sourceset);  -- flush_framesync,
+*                                      -- report_framesync
+*
+* GLOBALS: none
+*
+* REFERENCES:
+*
+* LIMITATIONS:
+*
+* REVISION HISTORY:
+*
+*   STR                Description                          Author
+*
+*   17-Oct-26          initial coding
+*
+* TARGET: Linux C
+*
+* This software is in the public domain. if it breaks you get to keep
+* both pieces.
+*
+* ************************************************************************* */
+
+#ifndef	__FRAMESYNC_H__
+#define	__FRAMESYNC_H__
+
+#include <stdio.h> /* FILE  */
+
+#include "glutcam.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+extern void init_framesync(Framesync_t * sync, long long window_usec);
+extern int acquire_synced_frames(Sourceset_t * sourceset,
+				 Frameslot_t slots[]);
+extern void flush_framesync(Sourceset_t * sourceset);
+extern void report_framesync(const Sourceset_t * sourceset, FILE * fp);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	//__FRAMESYNC_H__
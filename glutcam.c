@@ -38,6 +38,16 @@
 *   STR                Description                          Author
 *
 *   31-Dec-06          initial coding                        gpk
+*   17-Oct-26          draw offscreen with no X server (-O)
+*   17-Oct-26          play back capture files (-f, -F)
+*   17-Oct-26          record capture files (-r)
+*   17-Oct-26          share frames on a frame bus (-B)
+*   17-Oct-26          several sources at once (-d, -p, -f more than
+*                      once), captured on one epoll thread with -E
+*   17-Oct-26          draw them all at once, tiled (-M)
+*   17-Oct-26          match their frames up in time (-Y), give test
+*                      patterns a camera's timing (-Q)
+*   17-Oct-26          track by optical flow between detections (-L)
 *
 * TARGET: Linux C, GLUT, Opengl 2.0 or greater with shader support
 *
@@ -47,6 +57,7 @@
 * ************************************************************************* */
 
 #include <stdio.h>
+#include <stdlib.h> /* calloc, free  */
 #include <string.h> /* memset  */
 
 #include "glutcam.h"
@@ -55,9 +66,20 @@
 #include "capabilities.h"
 
 #include "testpattern.h" /* init_test_pattern */
+#include "capfile.h" /* init_capture_file  */
 #include "device.h" /* init_source_device, set_device_capture_parms  */
+#include "capture.h" /* run_headless_capture  */
+#include "framesync.h" /* init_framesync  */
+#include "colorconvert.h" /* select_convert_kernel  */
+#include "workpool.h" /* physical_core_count  */
+#include "trace.h" /* start_trace, trace_thread_name  */
+#include "cvProcess.h" /* g_flowInterval  */
 
 /* local prototypes  */
+int setup_capture_sources(Cmdargs_t argstruct, Sourceset_t * sourceset);
+void number_source_path(char * path, int which);
+int check_sources_match(const Sourceset_t * sourceset);
+void free_capture_sources(Sourceset_t * sourceset);
 int setup_capture_source(Cmdargs_t argstruct, Sourceparams_t * sourceparams);
 int init_image_source(Cmdargs_t argstruct, Sourceparams_t * sourceparams,
 		      Videocapabilities_t * capabilities);
@@ -76,7 +98,11 @@ int set_capture_parameters(Sourceparams_t * sourceparams,
 
 
    glutcam [-d devicefile] [-o color | greyscale ] [-w width] [-h height] 
-           [-e  LUMA |  YUV420 |  YUV422 | RGB ]
+           [-e  LUMA |  YUV420 |  YUV422 | RGB ] [-p] [-T] [-n nframes]
+           [-k auto | scalar | sse2 | avx2 | neon | opencv ] [-j nthreads]
+           [-P npbos] [-O nframes] [-f capturefile] [-F]
+           [-r recordfile] [-B socket] [-E] [-M] [-Y usec]
+           [-Q offset,jitter,drop]
 	   
    returns: int
 
@@ -88,6 +114,38 @@ int set_capture_parameters(Sourceparams_t * sourceparams,
 		 program exits when the user selects the exit option
 		 from the glut menu.
 
+		 with -n there's no window: capture that many frames,
+		 report CPU use and latency, and exit.
+
+		 with -O there's no window or X server either, but the
+		 display side runs: nframes are drawn offscreen (EGL or
+		 OSMesa, see offscreen.c) and the draw throughput is
+		 reported.
+
+		 with -J, write a trace of the run (stop_capture_source
+		 finishes it).
+
+		 with -r, record the frames to a capture file as they
+		 come in (see recorder.c).
+
+		 with -B, publish the frames on a frame bus other
+		 processes can read (see framebus.c).
+
+		 -d, -p and -f can be given more than once: each is
+		 a source with a pipeline of its own (see
+		 multicapture.c). -T gives each a capture thread, -E
+		 captures them all on one epoll thread. the window
+		 draws one of them at a time, or with -M all of them
+		 tiled in a grid (the mosaic).
+
+		 with -Y, the frames of all the sources are taken in
+		 sets captured within that many usec of each other
+		 (see framesync.c): stereo rigs. -Q makes test
+		 patterns stamp their frames like a camera would, to
+		 try it without one. -L has the tracker detect only
+		 every nth frame and follow the features by optical
+		 flow in between.
+
 		 exits on error
 
    REFERENCES:
@@ -98,7 +156,7 @@ int set_capture_parameters(Sourceparams_t * sourceparams,
 
       accessed: none
 
-      modified: none
+      modified: g_flowInterval (DEF_RGB builds)
 
    FUNCTIONS CALLED:
 
@@ -107,6 +165,18 @@ int set_capture_parameters(Sourceparams_t * sourceparams,
         STR                  Description of Revision                 Author
 
      31-Dec-06               initial coding                           gpk
+     17-Oct-26  threaded capture, headless runs
+     17-Oct-26  pick the colour conversion kernel
+     17-Oct-26  size the colour conversion worker pool
+     17-Oct-26  number of PBOs
+     17-Oct-26  start a trace for -J
+     17-Oct-26  draw offscreen for -O
+     17-Oct-26  record to a file for -r
+     17-Oct-26  frame bus for -B
+     17-Oct-26  a set of sources
+     17-Oct-26  the mosaic for -M
+     17-Oct-26  sync for -Y
+     17-Oct-26  flow interval for -L
 
  ************************************************************************* */
 
@@ -114,30 +184,62 @@ int main(int argc, char * argv[])
 {
   int argstat, capturestat, displaystat, retval;
   Cmdargs_t argstruct; /* command line parms  */
-  Sourceparams_t sourceparams; /* info about video source  */
+  Sourceset_t sourceset; /* info about the video sources  */
   Displaydata_t displaydata; /* info about dest display  */
   
   retval = 0;
 
-  memset(&sourceparams, 0, sizeof(sourceparams));
+  memset(&sourceset, 0, sizeof(sourceset));
   
   argstat =  parse_command_line(argc, argv, &argstruct);
 
   if (0 == argstat)
     {
-      
-      capturestat = setup_capture_source(argstruct, &sourceparams);
+      trace_thread_name("GL");
+      if ('\0' != argstruct.trace_file[0])
+	{
+	  (void)start_trace(argstruct.trace_file);
+	}
 
+      fprintf(stderr, "colour conversion: %s\n",
+	      convert_kernel_name(select_convert_kernel(argstruct.convert_kernel)));
+#ifdef	DEF_RGB
+      g_flowInterval = argstruct.flow_interval; /* before the tracker starts  */
+#endif
+
+      capturestat = setup_capture_sources(argstruct, &sourceset);
       if (0 == capturestat)
+	{
+	  fprintf(stderr, "colour conversion threads: %d\n",
+		  sourceset.sources[0]->convert_threads);
+	}
+
+      if ((0 == capturestat) && (0 < argstruct.headless_frames))
+	{
+	  retval = run_headless_capture(&sourceset,
+					argstruct.headless_frames);
+	}
+      else if ((0 == capturestat) && (0 == check_sources_match(&sourceset)))
 	{
 	  displaydata.window_width = argstruct.window_width;
 	  displaydata.window_height = argstruct.window_height;
+	  displaydata.pbo_count = argstruct.pbo_count;
+	  displaydata.pacing = argstruct.pacing;
+	  displaydata.offscreen = (0 < argstruct.offscreen_frames);
+	  displaydata.tiles = sourceset.nsources;
+	  displaydata.mosaic = ((0 != argstruct.mosaic)
+				&& (1 < sourceset.nsources));
     printf("display %dx%d\n", displaydata.window_width, displaydata.window_height);
-	  displaystat = setup_capture_display(&sourceparams, &displaydata,
-					      &argc, argv);
-	  if (0 == displaystat)
+	  displaystat = setup_capture_display(sourceset.sources[0],
+					      &displaydata, &argc, argv);
+	  if ((0 == displaystat) && (0 != displaydata.offscreen))
 	    {
-	      capture_and_display(&sourceparams);
+	      retval = capture_and_draw_offscreen(&sourceset, &displaydata,
+						  argstruct.offscreen_frames);
+	    }
+	  else if (0 == displaystat)
+	    {
+	      capture_and_display(&sourceset);
 	    }
 	  else
 	    {
@@ -154,12 +256,337 @@ int main(int argc, char * argv[])
       retval = -1; /* error parsing command line  */
     }
 
+  free_capture_sources(&sourceset);
+
   return(retval);
 }
 
 
 
 
+/* ************************************************************************* 
+
+
+   NAME:  setup_capture_sources
+
+
+   USAGE: 
+
+   int status;
+   Cmdargs_t argstruct;
+   Sourceset_t sourceset;
+
+   argstat =  parse_command_line(argc, argv, &argstruct);
+   
+   status =  setup_capture_sources(argstruct, &sourceset);
+
+   returns: int
+
+   DESCRIPTION:
+                 set up every source given on the command line
+		 (argstruct.sources[]; just the one argstruct
+		 describes if there's no list) with
+		 setup_capture_source, each in a Sourceparams_t of its
+		 own, and put them in sourceset.
+
+		 they all get the same size, encoding and buffering
+		 options. the second source's dmabuf socket, recording
+		 and frame bus get ".1" added to the name, the third's
+		 ".2" and so on, so they don't collide.
+
+		 with argstruct.epoll_capture, the set's epoll thread
+		 captures them all, so they count as threaded.
+
+		 the set's sync stage gets argstruct.sync_window_usec.
+		 with argstruct.mock_timing, test pattern i stamps its
+		 frames i * mock_offset_usec early, plus the jitter.
+
+		 return 0 if all's well
+		        -1 and complain if one of them can't be set up
+		        (sourceset holds the ones allocated so far)
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+     17-Oct-26  sync stage, mock test pattern timing
+
+ ************************************************************************* */
+
+int setup_capture_sources(Cmdargs_t argstruct, Sourceset_t * sourceset)
+{
+  Cmdargs_t sourceargs;
+  Sourceparams_t * sourceparams;
+  const Sourcearg_t * sourcearg;
+  int nsources, i;
+
+  nsources = (0 < argstruct.nsources) ? argstruct.nsources : 1;
+  sourceset->nsources = 0;
+  sourceset->epoll = argstruct.epoll_capture;
+  sourceset->epoll_fd = -1;
+  init_framesync(&(sourceset->sync), argstruct.sync_window_usec);
+
+  for (i = 0; i < nsources; i++)
+    {
+      sourceargs = argstruct;
+      if (0 < argstruct.nsources)
+	{
+	  sourcearg = &(argstruct.sources[i]);
+	  sourceargs.source = sourcearg->source;
+	  if (LIVESOURCE == sourcearg->source)
+	    {
+	      strncpy(sourceargs.devicename, sourcearg->name, MAX_DEVICENAME);
+	    }
+	  else if (FILESOURCE == sourcearg->source)
+	    {
+	      strncpy(sourceargs.capture_file, sourcearg->name,
+		      MAX_DEVICENAME);
+	    }
+	}
+      number_source_path(sourceargs.dmabuf_socket, i);
+      number_source_path(sourceargs.record_file, i);
+      number_source_path(sourceargs.framebus_socket, i);
+
+      sourceparams = (Sourceparams_t *)calloc(1, sizeof(Sourceparams_t));
+      if (NULL == sourceparams)
+	{
+	  fprintf(stderr, "Error: no memory for source %d\n", i);
+	  return(-1);
+	}
+      sourceset->sources[sourceset->nsources++] = sourceparams;
+
+      if (-1 == setup_capture_source(sourceargs, sourceparams))
+	{
+	  fprintf(stderr, "Error: unable to set up source %d\n", i);
+	  return(-1);
+	}
+
+      strncpy(sourceparams->recorder.path, sourceargs.record_file,
+	      MAX_DEVICENAME - 1);
+      strncpy(sourceparams->framebus.path, sourceargs.framebus_socket,
+	      MAX_DEVICENAME - 1);
+      sourceparams->threaded = (argstruct.threaded_capture
+				|| argstruct.epoll_capture);
+      sourceparams->convert_threads = (0 > argstruct.convert_threads) ?
+	physical_core_count() : argstruct.convert_threads;
+
+      if ((0 != argstruct.mock_timing)
+	  && (TESTPATTERN == sourceparams->source))
+	{
+	  mock_testpattern_timing(sourceparams,
+				  (long long)i * argstruct.mock_offset_usec,
+				  argstruct.mock_jitter_usec,
+				  argstruct.mock_drop_every,
+				  (unsigned int)i + 1);
+	}
+    }
+
+  return(0);
+}
+
+
+
+
+/* ************************************************************************* 
+
+
+   NAME:  number_source_path
+
+
+   USAGE: 
+
+   char path[MAX_DEVICENAME];
+
+   number_source_path(path, which);
+
+   returns: void
+
+   DESCRIPTION:
+                 make path (a socket or file name from the command
+		 line) source number which's own: add "." and which
+		 to the end of it. source 0 keeps the name as given,
+		 and so does an empty path (not in use).
+
+		 modifies path
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   a name too long for MAX_DEVICENAME with the number on it gets
+   cut short.
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void number_source_path(char * path, int which)
+{
+  char numbered[MAX_DEVICENAME];
+
+  if ((0 == which) || ('\0' == path[0]))
+    {
+      return;
+    }
+
+  snprintf(numbered, sizeof(numbered), "%s.%d", path, which);
+  strncpy(path, numbered, MAX_DEVICENAME);
+}
+
+
+
+
+/* ************************************************************************* 
+
+
+   NAME:  check_sources_match
+
+
+   USAGE: 
+
+   int some_int;
+   Sourceset_t sourceset;
+
+   some_int =  check_sources_match(&sourceset);
+
+   returns: int
+
+   DESCRIPTION:
+                 the display draws every source with textures and a
+		 shader set up for the first one (each in a tile of
+		 the same textures). make sure the
+		 others have its size and encoding (a camera can
+		 settle on a different size than the one asked for).
+
+		 return 0 if they all match
+		        -1 and complain if one doesn't
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int check_sources_match(const Sourceset_t * sourceset)
+{
+  const Sourceparams_t * first;
+  const Sourceparams_t * other;
+  int i;
+
+  first = sourceset->sources[0];
+  for (i = 1; i < sourceset->nsources; i++)
+    {
+      other = sourceset->sources[i];
+      if ((other->image_width != first->image_width)
+	  || (other->image_height != first->image_height)
+	  || (other->encoding != first->encoding))
+	{
+	  fprintf(stderr, "Error: source %d is %dx%d encoding %d, source 0"
+		  " is %dx%d encoding %d; the display needs them the same\n",
+		  i, other->image_width, other->image_height, other->encoding,
+		  first->image_width, first->image_height, first->encoding);
+	  return(-1);
+	}
+    }
+
+  return(0);
+}
+
+
+
+
+/* ************************************************************************* 
+
+
+   NAME:  free_capture_sources
+
+
+   USAGE: 
+
+   Sourceset_t sourceset;
+
+   free_capture_sources(&sourceset);
+
+   returns: void
+
+   DESCRIPTION:
+                 free the Sourceparams_t setup_capture_sources
+		 allocated, once they've been stopped.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void free_capture_sources(Sourceset_t * sourceset)
+{
+  int i;
+
+  for (i = 0; i < sourceset->nsources; i++)
+    {
+      free(sourceset->sources[i]);
+      sourceset->sources[i] = NULL;
+    }
+  sourceset->nsources = 0;
+}
+
+
+
+
 /* ************************************************************************* 
 
 
@@ -257,6 +684,7 @@ int setup_capture_source(Cmdargs_t argstruct, Sourceparams_t * sourceparams)
                  initialize the image source
 
 		 if the image source is a test pattern, create it
+		 if the image source is a capture file, map it
 		 if the image source is a device, initialize it
 
 		 set up of test pattern or device is done according
@@ -292,6 +720,7 @@ int setup_capture_source(Cmdargs_t argstruct, Sourceparams_t * sourceparams)
         STR                  Description of Revision                 Author
 
       7-Jan-07               initial coding                           gpk
+     17-Oct-26  play back a capture file
 
  ************************************************************************* */
 
@@ -309,6 +738,11 @@ int init_image_source(Cmdargs_t argstruct, Sourceparams_t * sourceparams,
       status = init_test_pattern(argstruct, sourceparams);
 
     }
+  else if (FILESOURCE == argstruct.source)
+    {
+      /* map the recording; it says what size and encoding it is  */
+      status = init_capture_file(argstruct, sourceparams);
+    }
   else
     {
       /* we were given a device: open it, get its characteristics  */
@@ -363,6 +797,7 @@ int init_image_source(Cmdargs_t argstruct, Sourceparams_t * sourceparams,
         STR                  Description of Revision                 Author
 
       7-Jan-07               initial coding                           gpk
+     17-Oct-26  nothing to set for a capture file either
 
  ************************************************************************* */
 
@@ -373,7 +808,8 @@ int set_capture_parameters(Sourceparams_t * sourceparams,
  int status;
 
 
-  if (TESTPATTERN ==  sourceparams->source)
+  if ((TESTPATTERN ==  sourceparams->source)
+      || (FILESOURCE == sourceparams->source))
     {    
       status = 0;
     }
@@ -33,7 +33,9 @@
 #ifndef	__GLUTCAM_H__
 #define __GLUTCAM_H__
 #define MAX_DEVICENAME 80
-#include "list.h"
+#include <stddef.h> /* size_t  */
+#include <stdint.h> /* uint32_t, uint64_t: capture file layout  */
+#include <pthread.h> /* pthread_t  */
 #ifdef	DEF_RGB
 #include	<cv.h>
 #include	<opencv2/features2d/features2d.hpp>
@@ -48,7 +50,8 @@
 
 typedef enum inputsource_e {
   TESTPATTERN, 
-  LIVESOURCE
+  LIVESOURCE,
+  FILESOURCE /* a recorded raw capture file (capfile.c)  */
 } Inputsource_t;
 
 /* Encodingmethod_t - how is the data video encoded?  */
@@ -71,6 +74,68 @@ typedef enum output_e {
   COLOR 
 } Output_t;
 #endif /* 0  */
+/* Convertkernel_t - which code turns YUYV into RGB (colorconvert.c)  */
+
+typedef enum convertkernel_e {
+  CONVERT_AUTO, /* the fastest one this CPU runs  */
+  CONVERT_SCALAR,
+  CONVERT_SSE2,
+  CONVERT_AVX2,
+  CONVERT_NEON,
+  CONVERT_OPENCV /* cvCvtColor  */
+} Convertkernel_t;
+
+/* Hammingkernel_t - which code counts the differing bits of two  */
+/* BRIEF descriptors (featurematch.c)  */
+
+typedef enum hammingkernel_e {
+  HAMMING_AUTO, /* the fastest one this CPU runs  */
+  HAMMING_SCALAR,
+  HAMMING_POPCNT,
+  HAMMING_AVX2,
+  HAMMING_NEON
+} Hammingkernel_t;
+
+/* Pacing_t - what makes the window redraw  */
+
+typedef enum pacing_e {
+  PACE_EVENT, /* a new frame arriving  */
+  PACE_VSYNC, /* a new frame arriving, swaps locked to vertical retrace  */
+  PACE_TIMER /* a 33 msec timer, new frame or not (the old way)  */
+} Pacing_t;
+
+/* Stage_t - the parts of a frame's trip through the program that  */
+/* stagestats.c keeps latency histograms for  */
+
+typedef enum stage_e {
+  STAGE_DEQUEUE, /* driver timestamp to publish_video_frame  */
+  STAGE_RING_WAIT, /* publish_video_frame to the display taking it  */
+  STAGE_CONVERT, /* YUYV to RGB in process()  */
+  STAGE_DETECT, /* process(): FAST keypoints  */
+  STAGE_DESCRIBE, /* process(): BRIEF descriptors  */
+  STAGE_MATCH, /* process(): descriptor matching  */
+  STAGE_HOMOGRAPHY, /* process(): findHomography  */
+  STAGE_FLOW, /* process(): optical flow instead of detecting  */
+  STAGE_PBO_MAP, /* map_pbo, including the wait for a free PBO  */
+  STAGE_PBO_FILL, /* map_pbo to unmap_pbo (includes process())  */
+  STAGE_UPLOAD, /* unmap_pbo to finish_pbo_upload  */
+  STAGE_SWAP, /* glutSwapBuffers  */
+  STAGE_CAPTURE_TO_SWAP, /* driver timestamp to after the swap  */
+  STAGE_RECORD, /* copied for the recorder to written to disk  */
+  NSTAGES
+} Stage_t;
+
+/* MAX_SOURCES - the most sources (-d, -p, -f) one glutcam runs at  */
+/* once  */
+#define MAX_SOURCES 8
+
+/* Sourcearg_t - one source named on the command line  */
+
+typedef struct sourcearg_s {
+  Inputsource_t source;
+  char name[MAX_DEVICENAME]; /* device or capture file, "" for a pattern  */
+} Sourcearg_t;
+
 /* Cmdargs_t - structure holding command line argument values  */
 
 typedef struct cmdargs {
@@ -82,6 +147,35 @@ typedef struct cmdargs {
   int image_height; /* in pixels  */
   int window_width;
   int window_height;
+  int threaded_capture; /* capture on a dedicated thread  */
+  int headless_frames; /* >0: run that many frames with no window  */
+  Convertkernel_t convert_kernel; /* YUYV->RGB conversion  */
+  int convert_threads; /* conversion workers, -1: one per physical core  */
+  int pbo_count; /* pixel buffer objects to cycle through for uploads  */
+  char dmabuf_socket[MAX_DEVICENAME]; /* export buffers there, "" if not  */
+  int userptr_io; /* capture into our own buffers (IO_METHOD_USERPTR)  */
+  int hugepages; /* ...allocated from huge pages  */
+  int video_buffers; /* to ask the driver for  */
+  Pacing_t pacing; /* when to redraw  */
+  char trace_file[MAX_DEVICENAME]; /* write a trace there, "" if not  */
+  int testpattern_frames; /* frames the test pattern cycles through,  */
+			  /* 0 for DEFAULT_BUFFER_COUNT  */
+  int offscreen_frames; /* >0: draw that many frames with no window  */
+  char capture_file[MAX_DEVICENAME]; /* play back this raw capture file  */
+  int playback_fast; /* ...as fast as frames are drawn, not as recorded  */
+  char record_file[MAX_DEVICENAME]; /* record the frames to this file  */
+  char framebus_socket[MAX_DEVICENAME]; /* share frames through a bus  */
+  Sourcearg_t sources[MAX_SOURCES]; /* every -d, -p and -f, in order  */
+  int nsources; /* 0: just the one above (/dev/video0 by default)  */
+  int epoll_capture; /* capture every source on one epoll thread  */
+  int mosaic; /* draw every source at once, tiled (-M)  */
+  int sync_window_usec; /* >0: match frames across sources (-Y)  */
+  int mock_timing; /* test patterns stamp frames like a camera (-Q)  */
+  int mock_offset_usec; /* ...each source stamped this much earlier  */
+  int mock_jitter_usec; /* ...give or take up to this  */
+  int mock_drop_every; /* ...and lose every nth frame, 0: none  */
+  int flow_interval; /* >1: the tracker detects every nth frame, optical  */
+		     /* flow in between (-L)  */
 } Cmdargs_t;
 
 
@@ -107,29 +201,350 @@ typedef struct testpattern_s {
   int nbuffers; /* number of buffers in the series  */
   void * bufferarray; /* where the pixel data is  */
   int current_buffer; 
+  long long next_frame_usec; /* when the next frame is due  */
+  unsigned int sequence; /* frames produced so far  */
+  int mock; /* stamp frames with the mock_ timing below (-Q)  */
+  long long mock_offset_usec; /* capture_usec this long before publishing  */
+  int mock_jitter_usec; /* plus up to this much, at random  */
+  int mock_drop_every; /* lose every nth frame, as a driver would  */
+  unsigned int mock_seed; /* rand_r state for the jitter  */
 } Testpattern_t;
 
+/* CAPFILE_MAGIC - the first 8 bytes of a raw capture file  */
+/* CAPFILE_VERSION - the layout described by Capfileheader_t and  */
+/* Capfileindex_t. bump it when they change.  */
+
+#define CAPFILE_MAGIC "GLUTCAP1"
+#define CAPFILE_VERSION 1
+
+/* Capfileheader_t - the start of a raw capture file. the frames  */
+/* are the raw pixels the camera gave us, in encoding; index_offset  */
+/* is where the file's index is: nframes Capfileindex_t, in capture  */
+/* order. both are written in the machine's byte order  */
+/* (little endian on x86 and ARM Linux).  */
+
+typedef struct capfileheader_s {
+  char magic[8]; /* CAPFILE_MAGIC, no nul  */
+  uint32_t version; /* CAPFILE_VERSION  */
+  uint32_t header_bytes; /* sizeof(Capfileheader_t) when it was written  */
+  uint32_t width; /* in pixels  */
+  uint32_t height;
+  uint32_t encoding; /* an Encodingmethod_t  */
+  uint32_t nframes;
+  uint64_t index_offset; /* bytes from the start of the file  */
+} Capfileheader_t;
+
+/* Capfileindex_t - where one frame is in a raw capture file  */
+
+typedef struct capfileindex_s {
+  uint64_t offset; /* of its pixels, from the start of the file  */
+  int64_t timestamp_usec; /* when it was captured (monotonic clock)  */
+  uint32_t length; /* bytes of pixels  */
+  uint32_t sequence; /* the driver's frame number (v4l2_buffer.sequence)  */
+} Capfileindex_t;
+
+/* Capfile_t - a raw capture file being played back (capfile.c).  */
+/* frames are handed out by pointer into the mapped file.  */
+
+typedef struct capfile_s {
+  void * map; /* the whole file, mapped read only  */
+  size_t maplength;
+  const Capfileindex_t * index; /* nframes of them, in map  */
+  unsigned int nframes;
+  unsigned int current_frame; /* the next one to publish  */
+  int fast; /* ignore the timestamps: next frame once the last's drawn  */
+  long long frame_usec; /* average time between recorded frames  */
+  long long start_usec; /* when frame 0 of this pass was due  */
+  long long next_frame_usec; /* when current_frame is due  */
+  int outstanding; /* frames published but not released yet  */
+  unsigned int frames_played;
+  unsigned int passes; /* times through the whole file  */
+} Capfile_t;
+
 /* Videobuffer_t - this points to video data from a live  */
 /* device. if the iomethod is IO_METHOD_READ then there   */
 /* will be a malloc-ed buffer. if the iomethod is   */
 /*  IO_METHOD_MMAP the start will point to a video buffer  */
 /* from the video driver that has been mmap-ed to user space  */
 /* if the iomethod is IO_METHOD_USERPTR then start is a  */
-/* pointer to malloc-ed space that the video device driver  */
-/* will stuff data directly into.  */
+/* page-aligned pointer into a pool we mmap-ed that the video  */
+/* device driver will stuff data directly into.  */
+/* dmabuf_fd is the buffer exported with VIDIOC_EXPBUF; it's only  */
+/* good for the first Dmabufserver_t.nfds buffers.  */
 
 typedef struct videobuffer_s {
-  struct list_head list;
   void * start; /* start of the buffer  */
   size_t length; /* buffer length in bytes  */
-#ifdef  DEF_RGB
-  IplImage *prgb;
-#endif
+  int dmabuf_fd; /* see above  */
+  long long timestamp_usec; /* capture_usec of the frame last dequeued  */
+  unsigned int sequence; /* ...and its v4l2_buffer.sequence  */
 } Videobuffer_t;
 
-/* MAX_VIDEO_BUFFERS - the number of video buffers we'll  */
-/* allocate pointers for.   */
-#define MAX_VIDEO_BUFFERS 4
+/* DEFAULT_VIDEO_BUFFERS - how many video buffers we ask the  */
+/* driver for if -b doesn't say. more buffers ride out a slow frame  */
+/* in process() without the driver dropping one; each costs a frame  */
+/* of memory.  */
+/* MAX_VIDEO_BUFFERS - the most we'll use (V4L2's VIDEO_MAX_FRAME)  */
+#define DEFAULT_VIDEO_BUFFERS 4
+#define MAX_VIDEO_BUFFERS 32
+
+/* Frameslot_t - one captured frame handed from the capture side  */
+/* to the display side through a Framering_t. index is the device  */
+/* buffer (or test pattern frame) the data lives in; it's what we  */
+/* give back to the source when the display is done with it.   */
+
+typedef struct frameslot_s {
+  int index; /* buffers[] index or test pattern frame  */
+  void * start; /* where the frame data is  */
+  size_t length; /* bytes of frame data  */
+  long long published_usec; /* monotonic time it entered the ring  */
+  long long capture_usec; /* monotonic time the driver stamped it, or  */
+			  /* published_usec if it didn't  */
+  unsigned int sequence; /* the driver's frame number, or our count  */
+} Frameslot_t;
+
+/* FRAMERING_SIZE - slots in a frame ring. must be a power of two  */
+/* and larger than MAX_VIDEO_BUFFERS so a device can never fill it.  */
+#define FRAMERING_SIZE 64
+
+/* FRAMERING_ALIGN - keep the producer and consumer indices on  */
+/* separate cache lines so the two threads don't fight over one.  */
+#define FRAMERING_ALIGN 64
+
+/* Framering_t - single-producer/single-consumer lock-free queue  */
+/* of captured frames. only the producer writes head, only the  */
+/* consumer writes tail. see framering.c  */
+
+typedef struct framering_s {
+  Frameslot_t slots[FRAMERING_SIZE];
+  unsigned int head __attribute__((aligned(FRAMERING_ALIGN)));
+  unsigned int tail __attribute__((aligned(FRAMERING_ALIGN)));
+} Framering_t;
+
+/* RECORDER_ALIGN - O_DIRECT wants buffers, file offsets and lengths  */
+/* in multiples of the disk's logical block size; a page covers any  */
+/* disk we're likely to meet. in a recording the header gets a  */
+/* block to itself and each frame starts on a block boundary.  */
+/* RECORDER_BUFFERS - frames copied and waiting for the writer  */
+/* thread (a power of two). at 1080p YUYV that's 64MB, or a quarter  */
+/* second at 60 fps, for the disk to stall before a frame's dropped  */
+/* RECORDER_BATCH - the most frames one pwritev writes  */
+/* RECORDER_PREALLOCATE - disk space reserved (fallocate) at a time  */
+#define RECORDER_ALIGN 4096
+#define RECORDER_BUFFERS 16
+#define RECORDER_MASK (RECORDER_BUFFERS - 1)
+#define RECORDER_BATCH 8
+#define RECORDER_PREALLOCATE (256LL << 20)
+
+/* Recorderslot_t - one frame copied for the recorder's writer  */
+
+typedef struct recorderslot_s {
+  long long capture_usec; /* Frameslot_t.capture_usec  */
+  long long queued_usec; /* when it was copied  */
+  unsigned int sequence; /* Frameslot_t.sequence  */
+  unsigned int length; /* bytes of pixels  */
+} Recorderslot_t;
+
+/* Recorder_t - writes captured frames to a raw capture file (the  */
+/* format capfile.c plays back). the capture side copies each  */
+/* frame into pool and gives the buffer straight back to the  */
+/* source; the writer thread writes the copies. slots[] is a  */
+/* single-producer/single-consumer ring like Framering_t: only  */
+/* the capture side writes head, only the writer writes tail.  */
+/* see recorder.c  */
+
+typedef struct recorder_s {
+  char path[MAX_DEVICENAME]; /* file to record to, "" for none  */
+  int fd;
+  int direct; /* fd was opened O_DIRECT  */
+  int preallocate; /* fallocate works on this file system  */
+  int running; /* the writer keeps going while set  */
+  int failed; /* a write failed: stop recording  */
+  pthread_t thread;
+  int wake_fd; /* eventfd: bumped for each frame queued  */
+  unsigned char * pool; /* RECORDER_BUFFERS of slot_bytes, aligned  */
+  size_t slot_bytes; /* a frame rounded up to RECORDER_ALIGN  */
+  Recorderslot_t slots[RECORDER_BUFFERS];
+  unsigned int head __attribute__((aligned(FRAMERING_ALIGN)));
+  unsigned int tail __attribute__((aligned(FRAMERING_ALIGN)));
+  uint64_t write_offset; /* where the next frame goes in the file  */
+  uint64_t allocated; /* bytes reserved with fallocate so far  */
+  Capfileindex_t * index; /* one per frame written  */
+  unsigned int nframes;
+  unsigned int index_capacity; /* entries index has room for  */
+  uint32_t width; /* for the file's header  */
+  uint32_t height;
+  uint32_t encoding;
+  unsigned int dropped; /* frames the writer had no room for  */
+  unsigned int max_backlog; /* most frames ever waiting  */
+  long long start_usec;
+} Recorder_t;
+
+/* FRAMEBUS_MAGIC - the first 8 bytes of a frame bus  */
+/* FRAMEBUS_VERSION - the layout described by Framebusheader_t.  */
+/* bump it when it changes.  */
+/* FRAMEBUS_SLOTS - frames the bus holds: how far behind a reader  */
+/* can fall before it misses frames  */
+/* FRAMEBUS_ALIGN - the slots' pixels start on page boundaries  */
+#define FRAMEBUS_MAGIC "GLUTBUS1"
+#define FRAMEBUS_VERSION 1
+#define FRAMEBUS_SLOTS 8
+#define FRAMEBUS_ALIGN 4096
+
+/* Framebusslot_t - describes the frame in one slot of the bus.  */
+/* seq is a sequence lock: the producer makes it odd while it  */
+/* rewrites the slot and even again after; a reader that sees the  */
+/* same even seq before and after using the frame had it intact.  */
+
+typedef struct framebusslot_s {
+  uint32_t seq; /* see above  */
+  uint32_t frame; /* which frame this is: counts up from 0  */
+  uint32_t sequence; /* Frameslot_t.sequence  */
+  uint32_t width; /* in pixels  */
+  uint32_t height;
+  uint32_t encoding; /* Encodingmethod_t  */
+  uint32_t length; /* bytes of pixels  */
+  uint32_t pad;
+  int64_t capture_usec; /* Frameslot_t.capture_usec (monotonic clock)  */
+  int64_t published_usec; /* when it went on the bus  */
+} __attribute__((aligned(64))) Framebusslot_t;
+
+/* Framebusheader_t - the start of a frame bus: a memfd holding this  */
+/* header and FRAMEBUS_SLOTS frames, slot i's pixels at  */
+/* data_offset + i * slot_bytes. frame n goes in slot n % nslots.  */
+/* published is also the futex readers sleep on.  */
+
+typedef struct framebusheader_s {
+  char magic[8]; /* FRAMEBUS_MAGIC, no nul  */
+  uint32_t version; /* FRAMEBUS_VERSION  */
+  uint32_t header_bytes; /* sizeof(Framebusheader_t)  */
+  uint32_t nslots;
+  uint32_t closed; /* the producer has gone: nothing more will come  */
+  uint64_t slot_bytes; /* room for pixels in each slot  */
+  uint64_t data_offset; /* bytes from the start of the bus  */
+  uint32_t published __attribute__((aligned(64))); /* frames so far  */
+  Framebusslot_t slots[FRAMEBUS_SLOTS];
+} Framebusheader_t;
+
+/* Framebus_t - the producer's side of a frame bus (framebus.c).  */
+/* readers connect to the unix socket at path and get a read only  */
+/* file descriptor for the bus.  */
+
+typedef struct framebus_s {
+  char path[MAX_DEVICENAME]; /* socket readers attach through, "" for none  */
+  int running; /* the bus is set up  */
+  int memfd; /* the bus  */
+  int readonly_fd; /* the bus, opened read only: what readers get  */
+  int listen_fd;
+  Framebusheader_t * header; /* the bus, mapped read/write  */
+  size_t maplength;
+  unsigned int readers; /* readers that have attached  */
+  unsigned int too_big; /* frames larger than slot_bytes, not published  */
+} Framebus_t;
+
+/* Framebusreader_t - a reader's side of a frame bus  */
+
+typedef struct framebusreader_s {
+  const Framebusheader_t * header; /* the bus, mapped read only  */
+  size_t maplength;
+  uint32_t next; /* the frame we want next  */
+  unsigned int frames; /* frames read  */
+  unsigned int missed; /* frames overwritten before we got to them  */
+} Framebusreader_t;
+
+/* Framebusframe_t - a frame a reader has been given: data points  */
+/* into the bus, good until framebus_frame_intact says otherwise  */
+
+typedef struct framebusframe_s {
+  const void * data;
+  uint32_t length; /* bytes of pixels  */
+  uint32_t width;
+  uint32_t height;
+  uint32_t encoding;
+  uint32_t frame; /* Framebusslot_t.frame  */
+  uint32_t sequence; /* the driver's frame number  */
+  int64_t capture_usec;
+  int64_t published_usec;
+  const Framebusslot_t * slot; /* where it came from  */
+  uint32_t seq; /* slot->seq when we took it  */
+} Framebusframe_t;
+
+
+/* WORKPOOL_MAX_THREADS - the most workers a Workpool_t will start  */
+#define WORKPOOL_MAX_THREADS 64
+
+/* Workfunc_t - one job for a worker pool: called with the arg  */
+/* given to run_workpool and the job number, 0...njobs - 1  */
+typedef void (*Workfunc_t)(void * arg, int job);
+
+/* Workpool_t - persistent worker threads that split a batch of  */
+/* jobs between them. see workpool.c  */
+
+typedef struct workpool_s {
+  pthread_t threads[WORKPOOL_MAX_THREADS];
+  int nthreads; /* 0: run_workpool does the jobs itself  */
+  pthread_mutex_t lock; /* protects everything below but next_job  */
+  pthread_cond_t wake; /* workers wait here for a batch  */
+  pthread_cond_t done; /* run_workpool waits here for the workers  */
+  unsigned int batch; /* bumped for every run_workpool  */
+  int shutdown; /* set by stop_workpool  */
+  int busy; /* workers that haven't finished the batch  */
+  Workfunc_t func;
+  void * arg;
+  int njobs;
+  int next_job; /* next job to hand out (atomic)  */
+} Workpool_t;
+
+
+/* MAX_DMABUF_CLIENTS - the most consumers a Dmabufserver_t serves  */
+#define MAX_DMABUF_CLIENTS 8
+
+/* Dmabufserver_t - hands the device's buffers, exported as dmabuf  */
+/* file descriptors, to other processes over a unix socket and  */
+/* tells them which one each new frame is in. a buffer a client is  */
+/* still reading doesn't go back to the driver until the client  */
+/* releases it. see dmabuf.c  */
+
+typedef struct dmabufserver_s {
+  char path[MAX_DEVICENAME]; /* socket to listen on, "" for none  */
+  int nfds; /* buffers exported; 0 means plain mmap  */
+  int running; /* listen_fd is open  */
+  int listen_fd;
+  int clients[MAX_DMABUF_CLIENTS];
+  int nclients;
+  unsigned int width; /* format of the frames in the buffers  */
+  unsigned int height;
+  unsigned int fourcc;
+  unsigned int bytesperline;
+  unsigned int sequence; /* frames announced so far  */
+  int held[MAX_DMABUF_CLIENTS]; /* buffer each client is reading, -1: none  */
+  int deferred[MAX_VIDEO_BUFFERS]; /* we're done with it, a client isn't  */
+  pthread_mutex_t lock; /* held[], deferred[]: capture and draw threads  */
+} Dmabufserver_t;
+
+/* DMABUF_MSG_BUFFERS - first message a client gets: the format and  */
+/*   nfds file descriptors, one per buffer index  */
+/* DMABUF_MSG_FRAME - a new frame is in buffer index  */
+/* DMABUF_MSG_RELEASE - client to server: done with the frame in index  */
+#define DMABUF_MSG_BUFFERS 1
+#define DMABUF_MSG_FRAME 2
+#define DMABUF_MSG_RELEASE 3
+
+/* Dmabufmsg_t - what goes over the socket, one per packet  */
+
+typedef struct dmabufmsg_s {
+  unsigned int type; /* DMABUF_MSG_...  */
+  unsigned int count; /* BUFFERS: file descriptors attached  */
+  unsigned int index; /* FRAME, RELEASE: buffer the frame is in  */
+  unsigned int length; /* bytes in a buffer / in this frame  */
+  unsigned int width;
+  unsigned int height;
+  unsigned int fourcc; /* V4L2_PIX_FMT_...  */
+  unsigned int bytesperline;
+  unsigned int sequence; /* FRAME: counts up from 0  */
+  unsigned int pad;
+  long long timestamp_usec; /* FRAME: monotonic capture time  */
+} Dmabufmsg_t;
 
 
 /* Sourceparams_t - structure that encapsulates a video source  */
@@ -140,6 +555,8 @@ typedef struct videobuffer_s {
 /*    fd is the file descriptor for the opened video device */
 /*    the video device driver will deposit images of the given   */
 /*    dimensions and encoding into buffers[0...buffercount -1]  */
+/* if source is FILESOURCE then capfile has the mapped file and  */
+/*    frames are published straight out of it  */
 typedef struct sourceparams {
   Inputsource_t source; /* live or test pattern  */
   int fd; /* of open device file or -1 for test pattern  */
@@ -147,14 +564,249 @@ typedef struct sourceparams {
   int image_width;  /* in pixels  */
   int image_height;  /* in pixels  */
   Iomethod_t iomethod; /* how to get to the data  */
+  int want_userptr; /* use IO_METHOD_USERPTR if the device can  */
+  int hugepages; /* IO_METHOD_USERPTR buffers from huge pages  */
+  void * userptr_pool; /* the one mapping IO_METHOD_USERPTR buffers are in  */
+  size_t userptr_pool_size; /* ...and its length, as mapped  */
   int buffercount; /* # buffers to juggle  */
+  int requested_buffers; /* what we asked the driver for  */
   float fps;
-  Videobuffer_t buffers[MAX_VIDEO_BUFFERS]; /* where the data is  */ 
+  Videobuffer_t * buffers; /* where the data is: buffercount of them  */ 
   Testpattern_t testpattern; /* where testpattern data is  */
+  Capfile_t capfile; /* the file FILESOURCE plays back  */
+  Recorder_t recorder; /* frames being written to disk (-r)  */
+  Framebus_t framebus; /* frames shared with other processes (-B)  */
   Videobuffer_t captured; /* copied from testpattern or buffers  */
-  struct list_head bufList;
+  Framering_t ring; /* frames captured, waiting to be displayed  */
+  int frame_event_fd; /* eventfd: counts frames published to ring  */
+  int threaded; /* capture runs on capture_thread  */
+  volatile int capture_running; /* capture_thread keeps going while set  */
+  pthread_t capture_thread;
+  int have_sequence; /* last_sequence is good  */
+  unsigned int last_sequence; /* v4l2_buffer.sequence of the last frame  */
+  unsigned int dropped_frames; /* gaps in the sequence: frames the driver lost  */
+  int fps_frames; /* frames counted toward the next fps update  */
+  long long fps_start_usec; /* when we started counting them  */
+  int convert_threads; /* colour conversion workers, 0: GL thread does it  */
+  Dmabufserver_t dmabuf; /* buffers shared with other processes  */
+  int id; /* which of its Sourceset_t's sources this is  */
+  int epoll_capture; /* the set's epoll thread captures it: no thread  */
+		     /* of its own even if threaded is set  */
+#ifdef  DEF_RGB
+  IplImage *prgb; /* header pointed at the mapped PBO each frame  */
+#endif
 } Sourceparams_t;
 
+/* SYNC_HOLD_FRAMES - the most frames of one source the sync  */
+/* stage holds waiting for the others to catch up. each is a  */
+/* buffer the driver doesn't have, so keep it small  */
+#define SYNC_HOLD_FRAMES 2
+
+/* Framesync_t - the sync stage: each source's frames waiting to be  */
+/* matched with the others' into a set captured within window_usec  */
+/* (by capture_usec). only the consumer uses it. see framesync.c  */
+
+typedef struct framesync_s {
+  long long window_usec; /* 0: no sync stage  */
+  Frameslot_t held[MAX_SOURCES][SYNC_HOLD_FRAMES]; /* oldest first  */
+  int nheld[MAX_SOURCES];
+  unsigned int sets; /* complete sets handed out  */
+  unsigned int stale_sets; /* ...passed over for a newer one  */
+  unsigned int dropped[MAX_SOURCES]; /* frames no set could use  */
+  long long spread_total_usec; /* newest - oldest capture_usec, summed  */
+  long long spread_max_usec;
+} Framesync_t;
+
+/* Sourceset_t - every source one glutcam runs. each source is a  */
+/* pipeline of its own: buffers, frame ring, recorder, frame bus.  */
+/* they're captured by one thread per source (threaded), by the  */
+/* display polling them all, or with epoll set by one thread that  */
+/* waits on all of them in epoll_wait. see multicapture.c  */
+
+typedef struct sourceset_s {
+  int nsources;
+  Sourceparams_t * sources[MAX_SOURCES];
+  int epoll; /* capture them all on epoll_thread  */
+  int epoll_fd; /* the devices' file descriptors  */
+  volatile int epoll_running; /* epoll_thread keeps going while set  */
+  pthread_t epoll_thread;
+  Framesync_t sync; /* frames of all the sources matched up in time  */
+} Sourceset_t;
+
+/* BRIEF_BYTES - the length of the descriptors the tracker matches  */
+/* (BRIEF-32: 256 bits)  */
+#define BRIEF_BYTES 32
+
+/* Featurematch_t - a query keypoint's best match among the train  */
+/* keypoints near it: indices into each set and the Hamming distance  */
+
+typedef struct featurematch_s {
+  int query;
+  int train;
+  int distance;
+} Featurematch_t;
+
+/* Featuregrid_t - the train keypoints bucketed by position into  */
+/* window-sized cells, so a query keypoint is only compared with the  */
+/* ones in the 3x3 cells around it. the arrays grow to the largest  */
+/* set seen and are reused. see featurematch.c  */
+
+typedef struct featuregrid_s {
+  float left, top; /* corner of cell 0: the smallest x and y  */
+  float cell_width, cell_height; /* the window  */
+  int cols, rows;
+  int * cell_start; /* cols * rows + 1: cell c is order[cell_start[c]...]  */
+  int * order; /* train indices, cell by cell, ascending in each  */
+  int * cell_of; /* each train keypoint's cell  */
+  int * candidates; /* one query's train keypoints in the window  */
+  int * distances; /* ...and their distances  */
+  int cells_allocated;
+  int points_allocated;
+} Featuregrid_t;
+
+/* MAX_BENCH_SIZES - the most image sizes one glutcam_bench run  */
+/* goes through  */
+#define MAX_BENCH_SIZES 8
+
+/* Benchargs_t - glutcam_bench's command line. see bench.c  */
+
+typedef struct benchargs_s {
+  int nsizes; /* how many of width[], height[] to run  */
+  int width[MAX_BENCH_SIZES];
+  int height[MAX_BENCH_SIZES];
+  int frames; /* timed frames at each size  */
+  int track; /* run the tracker in process() too  */
+  int verify; /* check the tracker's matcher against BFMatcher  */
+  int check_allocs; /* fail if the tracker's own code allocates  */
+  int flow_interval; /* >1: detect every nth frame, optical flow between  */
+  char capture_file[MAX_DEVICENAME]; /* frames from here, not a test pattern  */
+  int gl_upload; /* upload each frame through PBOs to a texture  */
+  int convert_threads; /* -1: one per physical core  */
+  Convertkernel_t convert_kernel;
+} Benchargs_t;
+
+/* Busbenchargs_t - glutcam_busbench's command line. see busbench.c  */
+
+typedef struct busbenchargs_s {
+  int readers; /* reader processes  */
+  int width; /* of the frames published  */
+  int height;
+  int frames; /* to publish  */
+  int fps; /* publish rate, 0: as fast as we can  */
+  char attach[MAX_DEVICENAME]; /* read a running glutcam's bus instead  */
+} Busbenchargs_t;
+
+/* Dmabufclientargs_t - glutcam_dmabufclient's command line. see  */
+/* dmabufclient.c  */
+
+typedef struct dmabufclientargs_s {
+  int buffers; /* the mock device's buffers  */
+  int width; /* of its frames  */
+  int height;
+  int frames; /* to publish  */
+  int fps; /* publish rate, 0: as fast as we can  */
+  int read_usec; /* the consumer takes this long over each frame  */
+  char attach[MAX_DEVICENAME]; /* read a running glutcam's buffers instead  */
+} Dmabufclientargs_t;
+
+/* Kernelbuffers_t - the frames glutcam_kernels runs a kernel on,  */
+/* at one image size. see kernelbench.c  */
+
+typedef struct kernelbuffers_s {
+  int width; /* in pixels  */
+  int height;
+  unsigned char * yuyv; /* width * height * 2 bytes  */
+  unsigned char * rgb; /* width * height * 3 bytes  */
+  unsigned char * ref; /* reference output, width * height * 3 bytes  */
+  unsigned int histogram[256];
+  Testpattern_t pattern; /* one YUYV frame, for deinterlace_testpattern  */
+} Kernelbuffers_t;
+
+/* Kernelcase_t - one kernel for glutcam_kernels to time and check  */
+
+typedef struct kernelcase_s {
+  const char * name;
+  Convertkernel_t kernel; /* for colour conversion, else CONVERT_AUTO  */
+  void (*run)(Kernelbuffers_t * buffers); /* once over the frame  */
+  int (*check)(Kernelbuffers_t * buffers); /* run once on fresh input,  */
+					   /* return the largest error  */
+  int tolerance; /* largest error that passes  */
+  int bytes_per_pixel; /* read + written, for GB/s  */
+} Kernelcase_t;
+
+/* STAGE_SUB_BITS - each power of two of latency is split into  */
+/* 2^STAGE_SUB_BITS linear buckets, so a bucket is at most 1/16 of  */
+/* its value wide (HDR histogram style).  */
+/* STAGE_EXPONENTS - powers of two above the linear range: usec  */
+/* values up to 2^(STAGE_SUB_BITS + STAGE_EXPONENTS) (about 19  */
+/* hours) get their own bucket, bigger ones land in the last  */
+/* STAGE_BUCKETS - buckets per stage  */
+#define STAGE_SUB_BITS 4
+#define STAGE_EXPONENTS 32
+#define STAGE_BUCKETS ((STAGE_EXPONENTS + 1) << STAGE_SUB_BITS)
+
+/* Stagehist_t - one stage's latency histogram. updated with  */
+/* relaxed atomics, so any thread can record into it.  */
+
+typedef struct stagehist_s {
+  unsigned int counts[STAGE_BUCKETS];
+  long long max_usec; /* largest sample  */
+} Stagehist_t;
+
+/* MAX_TRACE_THREADS - the most threads that get a trace track  */
+/* TRACE_RING_EVENTS - events a thread can have waiting for the  */
+/* trace writer (a power of two); past that new ones are dropped  */
+/* TRACE_NAME_LENGTH - longest thread name, with the '\0'  */
+#define MAX_TRACE_THREADS 32
+#define TRACE_RING_EVENTS 4096
+#define TRACE_NAME_LENGTH 32
+
+/* Traceevent_t - one span of time on one thread  */
+
+typedef struct traceevent_s {
+  const char * name; /* a string constant: only the pointer is kept  */
+  long long start_usec; /* monotonic_usec  */
+  long long duration_usec;
+} Traceevent_t;
+
+/* Tracering_t - a thread's trace events on their way to the file.  */
+/* only the thread writes head and dropped, only the writer thread  */
+/* writes tail. see trace.c  */
+
+typedef struct tracering_s {
+  Traceevent_t events[TRACE_RING_EVENTS];
+  char thread_name[TRACE_NAME_LENGTH];
+  int ready; /* a thread owns it and thread_name is set  */
+  int named; /* the writer has put out its thread_name record  */
+  unsigned int dropped; /* events that didn't fit  */
+  unsigned int head __attribute__((aligned(FRAMERING_ALIGN)));
+  unsigned int tail __attribute__((aligned(FRAMERING_ALIGN)));
+} Tracering_t;
+
+/* MAX_PBOS - the most pixel buffer objects a Pboring_t will cycle  */
+/* DEFAULT_PBO_COUNT - how many it cycles if -P doesn't say  */
+#define MAX_PBOS 8
+#define DEFAULT_PBO_COUNT 3
+
+/* Pboring_t - pixel buffer objects used in turn to upload frames,  */
+/* so the CPU can fill one while the GPU is still reading another.  */
+/* see pboring.c  */
+
+typedef struct pboring_s {
+  GLuint ids[MAX_PBOS];
+  GLsync fences[MAX_PBOS]; /* set when the upload from ids[i] was issued  */
+  int count; /* how many of ids[] are in use  */
+  int current; /* the one being filled/uploaded  */
+  size_t size; /* bytes in each  */
+  int use_fences; /* 1: wait on fences[], 0: orphan the buffer instead  */
+  int mapped; /* current is mapped  */
+  long long mark_usec; /* start of the step being timed  */
+  long long map_usec; /* total time waiting to map since the last report  */
+  long long fill_usec; /* total time mapped (filling)  */
+  long long upload_usec; /* total time issuing the texture upload  */
+  int frames; /* uploads since the last report  */
+} Pboring_t;
+
 /* Displaydata_t - this structure holds the data about the display  */
 /* (window size, opengl data, etc)  */
 typedef struct displaydata {
@@ -183,6 +835,17 @@ typedef struct displaydata {
   void * texture; /* the buffer with current pixels  */
   void * u_texture;
   void * v_texture;
-  GLuint pboIds;
+  int pbo_count; /* how many PBOs to upload through  */
+  Pboring_t pbos; /* PBOs for the primary texture  */
+  Pboring_t u_pbos; /* PBOs for the YUV420 u texture  */
+  Pboring_t v_pbos; /* PBOs for the YUV420 v texture  */
+  Pacing_t pacing; /* when to redraw  */
+  int offscreen; /* no window: draw into an FBO (see offscreen.c)  */
+  unsigned int offscreen_fbo; /* framebuffer object we draw into  */
+  unsigned int offscreen_renderbuffer; /* its colour buffer  */
+  int tiles; /* sources stacked one above the other in each texture  */
+  int mosaic; /* draw all tiles at once (1) or the chosen source's (0)  */
+  int tile_color[MAX_SOURCES]; /* each tile's color_output (shader.c)  */
+  int tile_processing[MAX_SOURCES]; /* each tile's image_processing  */
   } Displaydata_t;
 #endif	//__GLUTCAM_H__
@@ -0,0 +1,1225 @@
+/* *************************************************************************
+* NAME: glutcam/kernelbench.c
+*
+* DESCRIPTION:
+*
+* glutcam_kernels: time the per-pixel loops on their own, away from GL,
+* devices and threads, so a change to one can be measured by itself.
+*
+* each kernel (see Kernel_cases) runs over one frame at each image
+* size until KERNEL_MIN_USEC has gone by. the median run is reported
+* as msec, GB/s (bytes read + written) and cycles per pixel (time
+* stamp counter cycles, on x86).
+*
+* before it's timed, each kernel is run on fresh input and checked
+* against a plain reference written here: the SIMD colour conversions
+* against convert_yuyv_to_rgb24_scalar (bit exact), the test pattern
+* code against the equations it's meant to implement, the histogram
+* against a one-table count. a kernel that fails is still timed, but
+* the run exits non-zero.
+*
+* the display's histogram is computed by GL (glHistogram); the CPU
+* luma histogram here is what it would cost without the imaging
+* subset.
+*
+* PROCESS:
+*
+* make glutcam_kernels
+* ./glutcam_kernels                  -- 320x240 up to 3840x2160
+* ./glutcam_kernels -s 1920x1080 -m 1000
+*
+* GLOBALS: none
+*
+* REFERENCES:
+*
+* LIMITATIONS:
+*
+* the cycle counter ticks at a constant rate, not the core clock, so
+* cycles/pixel reads low when the core turbos up. off x86 it's left out.
+*
+* REVISION HISTORY:
+*
+*   STR                Description                          Author
+*
+*   17-Oct-26          initial coding
+*
+* TARGET: Linux C
+*
+* This software is in the public domain. if it breaks you get to keep
+* both pieces.
+*
+* ************************************************************************* */
+
+#include <stdio.h>
+#include <stdlib.h> /* malloc, free, abs, qsort, atoi  */
+#include <string.h> /* memset, memcpy, memcmp  */
+#include <unistd.h> /* getopt  */
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h> /* __rdtsc  */
+#endif
+
+#include "glutcam.h"
+#include "testpattern.h" /* generate_yuv422_testpattern_i, rgb2yuv422, ...  */
+#include "colorconvert.h" /* select_convert_kernel, convert_yuyv_to_rgb24  */
+#include "timeutil.h" /* monotonic_usec  */
+
+/* KERNEL_MIN_USEC - default time to spend running each kernel at  */
+/* each size  */
+/* KERNEL_MAX_RUNS - most timed runs kept for the median  */
+/* KERNEL_PATTERN_FRAMES, KERNEL_PATTERN_FRAME - which test pattern  */
+/* frame to generate (the middle one, so both squares are there)  */
+
+#define KERNEL_MIN_USEC 200000
+#define KERNEL_MAX_RUNS 2000
+#define KERNEL_PATTERN_FRAMES 30
+#define KERNEL_PATTERN_FRAME 15
+
+extern char *optarg; /* declared in the C library for getopt  */
+
+static struct {
+  int w;
+  int h;
+} Kernel_sizes[] = {
+  {320, 240}, {640, 480}, {1280, 720}, {1920, 1080}, {3840, 2160}
+};
+
+#define N_KERNEL_SIZES ((int)(sizeof(Kernel_sizes) / sizeof(Kernel_sizes[0])))
+
+/* local prototypes  */
+void run_convert(Kernelbuffers_t * buffers);
+int check_convert(Kernelbuffers_t * buffers);
+#ifdef	DEF_RGB
+void run_opencv_convert(Kernelbuffers_t * buffers);
+int check_opencv_convert(Kernelbuffers_t * buffers);
+#endif
+void run_yuv422_testpattern(Kernelbuffers_t * buffers);
+int check_yuv422_testpattern(Kernelbuffers_t * buffers);
+void run_rgb2yuv422(Kernelbuffers_t * buffers);
+int check_rgb2yuv422(Kernelbuffers_t * buffers);
+void run_deinterlace(Kernelbuffers_t * buffers);
+int check_deinterlace(Kernelbuffers_t * buffers);
+void run_luma_histogram(Kernelbuffers_t * buffers);
+int check_luma_histogram(Kernelbuffers_t * buffers);
+void luma_histogram(const unsigned char * yuyv, int npixels,
+		    unsigned int histogram[256]);
+void reference_yuv(int red, int green, int blue, int * luma, int * chroma_u,
+		   int * chroma_v);
+int largest_difference(const unsigned char * a, const unsigned char * b,
+		       size_t nbytes);
+void fill_kernel_inputs(Kernelbuffers_t * buffers);
+int time_kernel(const Kernelcase_t * kcase, Kernelbuffers_t * buffers,
+		long long min_usec);
+unsigned long long read_cycles(void);
+int compare_long_long(const void * a, const void * b);
+/* end local prototypes  */
+
+static const Kernelcase_t Kernel_cases[] = {
+  {"yuyv->rgb24 scalar", CONVERT_SCALAR, run_convert, check_convert, 0, 5},
+  {"yuyv->rgb24 sse2", CONVERT_SSE2, run_convert, check_convert, 0, 5},
+  {"yuyv->rgb24 avx2", CONVERT_AVX2, run_convert, check_convert, 0, 5},
+  {"yuyv->rgb24 neon", CONVERT_NEON, run_convert, check_convert, 0, 5},
+#ifdef	DEF_RGB
+  /* a different rounding than ours: it only has to be close  */
+  {"yuyv->rgb24 cvCvtColor", CONVERT_AUTO, run_opencv_convert,
+   check_opencv_convert, 4, 5},
+#endif
+  {"yuv422 test pattern", CONVERT_AUTO, run_yuv422_testpattern,
+   check_yuv422_testpattern, 0, 2},
+  {"rgb2yuv422", CONVERT_AUTO, run_rgb2yuv422, check_rgb2yuv422, 0, 5},
+  /* into a temporary frame and back again  */
+  {"deinterlace", CONVERT_AUTO, run_deinterlace, check_deinterlace, 0, 8},
+  {"luma histogram", CONVERT_AUTO, run_luma_histogram,
+   check_luma_histogram, 0, 2}
+};
+
+#define N_KERNEL_CASES ((int)(sizeof(Kernel_cases) / sizeof(Kernel_cases[0])))
+
+
+
+/* *************************************************************************
+
+
+   NAME:  main
+
+
+   USAGE:
+
+   glutcam_kernels [-s WxH]... [-m msec]
+
+   returns: int
+
+   DESCRIPTION:
+                 for each image size (the -s ones, or Kernel_sizes),
+		 check and time every kernel in Kernel_cases.
+
+		 return 0 if every kernel passed its check
+		       1 if any didn't
+		      -1 on a usage or memory error
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: optarg, Kernel_sizes, Kernel_cases
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int main(int argc, char * argv[])
+{
+  Kernelbuffers_t buffers;
+  int width[MAX_BENCH_SIZES], height[MAX_BENCH_SIZES];
+  int nsizes, opt, size, i, failed;
+  long long min_usec;
+  size_t npixels;
+
+  nsizes = 0;
+  min_usec = KERNEL_MIN_USEC;
+
+  while (-1 != (opt = getopt(argc, argv, "s:m:")))
+    {
+      switch (opt)
+	{
+	case 's':
+	  if ((MAX_BENCH_SIZES <= nsizes)
+	      || (2 != sscanf(optarg, "%dx%d", &(width[nsizes]),
+			      &(height[nsizes])))
+	      || (4 > width[nsizes]) || (2 > height[nsizes])
+	      || (0 != (width[nsizes] & 1)) || (0 != (height[nsizes] & 1)))
+	    {
+	      fprintf(stderr, "size (-s) must be WxH, both even, at most %d"
+		      " of them\n", MAX_BENCH_SIZES);
+	      return(-1);
+	    }
+	  nsizes++;
+	  break;
+
+	case 'm':
+	  min_usec = 1000LL * atoi(optarg);
+	  break;
+
+	default:
+	  fprintf(stderr, "Usage: %s [-s WxH]... [-m msec]\n", argv[0]);
+	  fprintf(stderr, "   -s: image size, repeatable; default 320x240"
+		  " up to 3840x2160\n");
+	  fprintf(stderr, "   -m: msec to run each kernel at each size,"
+		  " default %d\n", KERNEL_MIN_USEC / 1000);
+	  return(-1);
+	}
+    }
+
+  if (0 == nsizes)
+    {
+      for (i = 0; i < N_KERNEL_SIZES; i++)
+	{
+	  width[i] = Kernel_sizes[i].w;
+	  height[i] = Kernel_sizes[i].h;
+	}
+      nsizes = N_KERNEL_SIZES;
+    }
+
+  fprintf(stdout, "%-24s %10s %9s %8s %10s %9s  %s\n", "kernel", "size",
+	  "msec", "GB/s", "ns/pixel", "cyc/pixel", "check");
+
+  failed = 0;
+  for (size = 0; size < nsizes; size++)
+    {
+      memset(&buffers, 0, sizeof(buffers));
+      buffers.width = width[size];
+      buffers.height = height[size];
+      npixels = (size_t)width[size] * height[size];
+      buffers.yuyv = malloc(npixels * 2);
+      buffers.rgb = malloc(npixels * 3);
+      buffers.ref = malloc(npixels * 3);
+      if ((NULL == buffers.yuyv) || (NULL == buffers.rgb)
+	  || (NULL == buffers.ref))
+	{
+	  fprintf(stderr, "Error: unable to allocate %dx%d frames\n",
+		  width[size], height[size]);
+	  return(-1);
+	}
+
+      for (i = 0; i < N_KERNEL_CASES; i++)
+	{
+	  failed |= time_kernel(&(Kernel_cases[i]), &buffers, min_usec);
+	}
+
+      free(buffers.yuyv);
+      free(buffers.rgb);
+      free(buffers.ref);
+    }
+
+  (void)select_convert_kernel(CONVERT_AUTO);
+
+  return(failed);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  time_kernel
+
+
+   USAGE:
+
+   int failed;
+   Kernelcase_t kcase;
+   Kernelbuffers_t buffers;
+
+   failed =  time_kernel(&kcase, &buffers, min_usec);
+
+   returns: int
+
+   DESCRIPTION:
+                 check kcase on buffers' size, then run it until
+		 min_usec has gone by (at least 3 times) and print
+		 the median run.
+
+		 a colour conversion kernel that doesn't run on this
+		 CPU is skipped.
+
+		 return 0 if the check passed or was skipped
+		        1 if it failed
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int time_kernel(const Kernelcase_t * kcase, Kernelbuffers_t * buffers,
+		long long min_usec)
+{
+  static long long usecs[KERNEL_MAX_RUNS];
+  static long long cycles[KERNEL_MAX_RUNS];
+  long long start_usec, end_usec, total_usec, usec;
+  unsigned long long start_cycles;
+  char size[32], verdict[32];
+  double npixels;
+  int runs, error, failed;
+
+  if ((CONVERT_AUTO != kcase->kernel)
+      && (kcase->kernel != select_convert_kernel(kcase->kernel)))
+    {
+      return(0); /* select_convert_kernel said why  */
+    }
+
+  fill_kernel_inputs(buffers);
+  error = kcase->check(buffers);
+  failed = (error > kcase->tolerance);
+  if (0 != failed)
+    {
+      snprintf(verdict, sizeof(verdict), "FAILED (off by %d)", error);
+    }
+  else if (0 < error)
+    {
+      snprintf(verdict, sizeof(verdict), "ok (within %d)", error);
+    }
+  else
+    {
+      snprintf(verdict, sizeof(verdict), "exact");
+    }
+
+  kcase->run(buffers); /* warm the caches  */
+
+  total_usec = 0;
+  for (runs = 0; (runs < KERNEL_MAX_RUNS)
+	 && ((runs < 3) || (total_usec < min_usec)); runs++)
+    {
+      start_cycles = read_cycles();
+      start_usec = monotonic_usec();
+      kcase->run(buffers);
+      end_usec = monotonic_usec();
+      cycles[runs] = (long long)(read_cycles() - start_cycles);
+      usecs[runs] = end_usec - start_usec;
+      total_usec += usecs[runs];
+    }
+
+  qsort(usecs, runs, sizeof(usecs[0]), compare_long_long);
+  qsort(cycles, runs, sizeof(cycles[0]), compare_long_long);
+  usec = usecs[runs / 2];
+  if (1 > usec)
+    {
+      usec = 1; /* finer than the clock: say 1 usec  */
+    }
+
+  npixels = (double)buffers->width * buffers->height;
+  snprintf(size, sizeof(size), "%dx%d", buffers->width, buffers->height);
+
+  fprintf(stdout, "%-24s %10s %9.3f %8.2f %10.3f ", kcase->name, size,
+	  usec / 1000.0, kcase->bytes_per_pixel * npixels / (usec * 1000.0),
+	  usec * 1000.0 / npixels);
+  if (0 < cycles[runs / 2])
+    {
+      fprintf(stdout, "%9.2f", cycles[runs / 2] / npixels);
+    }
+  else
+    {
+      fprintf(stdout, "%9s", "-");
+    }
+  fprintf(stdout, "  %s\n", verdict);
+
+  return(failed);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  run_convert, check_convert
+
+
+   USAGE:
+
+   run_convert(&buffers);
+   error =  check_convert(&buffers);
+
+   returns: void, int
+
+   DESCRIPTION:
+                 run_convert turns buffers->yuyv into buffers->rgb
+		 with whichever kernel select_convert_kernel picked
+		 last.
+
+		 check_convert does that too, and also converts with
+		 convert_yuyv_to_rgb24_scalar into buffers->ref;
+		 it returns the largest difference between the two.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void run_convert(Kernelbuffers_t * buffers)
+{
+  convert_yuyv_to_rgb24(buffers->yuyv, buffers->rgb,
+			buffers->width * buffers->height);
+}
+
+int check_convert(Kernelbuffers_t * buffers)
+{
+  int npixels;
+
+  npixels = buffers->width * buffers->height;
+  convert_yuyv_to_rgb24_scalar(buffers->yuyv, buffers->ref, npixels);
+  run_convert(buffers);
+
+  return(largest_difference(buffers->rgb, buffers->ref, (size_t)npixels * 3));
+}
+
+
+
+#ifdef	DEF_RGB
+/* *************************************************************************
+
+
+   NAME:  run_opencv_convert, check_opencv_convert
+
+
+   USAGE:
+
+   run_opencv_convert(&buffers);
+   error =  check_opencv_convert(&buffers);
+
+   returns: void, int
+
+   DESCRIPTION:
+                 the same as run_convert and check_convert, with
+		 cvCvtColor(CV_YUV2RGB_YUYV) doing the conversion:
+		 what process() does with -k opencv.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void run_opencv_convert(Kernelbuffers_t * buffers)
+{
+  IplImage yuv, rgb;
+  CvSize size;
+
+  size = cvSize(buffers->width, buffers->height);
+  cvInitImageHeader(&yuv, size, IPL_DEPTH_8U, 2, IPL_ORIGIN_TL, 4);
+  cvInitImageHeader(&rgb, size, IPL_DEPTH_8U, 3, IPL_ORIGIN_TL, 4);
+  /* our frames aren't padded  */
+  yuv.widthStep = buffers->width * 2;
+  rgb.widthStep = buffers->width * 3;
+  yuv.imageData = (char *)buffers->yuyv;
+  rgb.imageData = (char *)buffers->rgb;
+
+  cvCvtColor(&yuv, &rgb, CV_YUV2RGB_YUYV);
+}
+
+int check_opencv_convert(Kernelbuffers_t * buffers)
+{
+  int npixels;
+
+  npixels = buffers->width * buffers->height;
+  convert_yuyv_to_rgb24_scalar(buffers->yuyv, buffers->ref, npixels);
+  run_opencv_convert(buffers);
+
+  return(largest_difference(buffers->rgb, buffers->ref, (size_t)npixels * 3));
+}
+#endif	//DEF_RGB
+
+
+
+/* *************************************************************************
+
+
+   NAME:  run_yuv422_testpattern, check_yuv422_testpattern
+
+
+   USAGE:
+
+   run_yuv422_testpattern(&buffers);
+   error =  check_yuv422_testpattern(&buffers);
+
+   returns: void, int
+
+   DESCRIPTION:
+                 run_yuv422_testpattern draws test pattern frame
+		 KERNEL_PATTERN_FRAME of KERNEL_PATTERN_FRAMES into
+		 buffers->yuyv with generate_yuv422_testpattern_i.
+
+		 check_yuv422_testpattern draws it, and also builds
+		 the frame it should be pixel by pixel in
+		 buffers->ref: black, with a red square growing from
+		 the top left corner of memory (i/n of the width and
+		 height) and a blue one filling the opposite corner.
+		 it returns the largest difference.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void run_yuv422_testpattern(Kernelbuffers_t * buffers)
+{
+  generate_yuv422_testpattern_i(KERNEL_PATTERN_FRAME, KERNEL_PATTERN_FRAMES,
+				buffers->width, buffers->height,
+				buffers->yuyv);
+}
+
+int check_yuv422_testpattern(Kernelbuffers_t * buffers)
+{
+  int red_y, red_u, red_v, blue_y, blue_u, blue_v, y, u, v;
+  int columnlimit, rowlimit, row, column;
+  unsigned char * pixelp;
+
+  reference_yuv((255 * KERNEL_PATTERN_FRAME) / KERNEL_PATTERN_FRAMES, 0, 0,
+		&red_y, &red_u, &red_v);
+  reference_yuv(0, 0, 255 - (255 * KERNEL_PATTERN_FRAME) / KERNEL_PATTERN_FRAMES,
+		&blue_y, &blue_u, &blue_v);
+  columnlimit = (KERNEL_PATTERN_FRAME * buffers->width)
+    / (2 * KERNEL_PATTERN_FRAMES);
+  rowlimit = (KERNEL_PATTERN_FRAME * buffers->height) / KERNEL_PATTERN_FRAMES;
+
+  pixelp = buffers->ref;
+  for (row = 0; row < buffers->height; row++)
+    {
+      for (column = 0; column < buffers->width / 2; column++)
+	{
+	  if ((row < rowlimit) && (column < columnlimit))
+	    {
+	      y = red_y; u = red_u; v = red_v;
+	    }
+	  else if ((row >= rowlimit) && (column >= columnlimit))
+	    {
+	      y = blue_y; u = blue_u; v = blue_v;
+	    }
+	  else
+	    {
+	      y = 16; u = 128; v = 128; /* black  */
+	    }
+	  pixelp[0] = y;
+	  pixelp[1] = u;
+	  pixelp[2] = y;
+	  pixelp[3] = v;
+	  pixelp += 4;
+	}
+    }
+
+  run_yuv422_testpattern(buffers);
+
+  return(largest_difference(buffers->yuyv, buffers->ref,
+			    (size_t)buffers->width * buffers->height * 2));
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  run_rgb2yuv422, check_rgb2yuv422
+
+
+   USAGE:
+
+   run_rgb2yuv422(&buffers);
+   error =  check_rgb2yuv422(&buffers);
+
+   returns: void, int
+
+   DESCRIPTION:
+                 run_rgb2yuv422 encodes buffers->rgb into
+		 buffers->yuyv a pair of pixels at a time with
+		 rgb2yuv422, the way the RGB test pattern would be
+		 turned into YUYV.
+
+		 check_rgb2yuv422 does that, and also encodes it
+		 into buffers->ref with reference_yuv (U from the
+		 first pixel of the pair, V from the second). it
+		 returns the largest difference.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void run_rgb2yuv422(Kernelbuffers_t * buffers)
+{
+  const unsigned char * rgbp;
+  unsigned char * yuyvp;
+  int luma0, chroma_u, luma1, chroma_v, pair, npairs;
+
+  rgbp = buffers->rgb;
+  yuyvp = buffers->yuyv;
+  npairs = buffers->width * buffers->height / 2;
+
+  for (pair = 0; pair < npairs; pair++)
+    {
+      rgb2yuv422(rgbp[0], rgbp[1], rgbp[2], rgbp[3], rgbp[4], rgbp[5],
+		 &luma0, &chroma_u, &luma1, &chroma_v);
+      yuyvp[0] = luma0;
+      yuyvp[1] = chroma_u;
+      yuyvp[2] = luma1;
+      yuyvp[3] = chroma_v;
+      rgbp += 6;
+      yuyvp += 4;
+    }
+}
+
+int check_rgb2yuv422(Kernelbuffers_t * buffers)
+{
+  const unsigned char * rgbp;
+  unsigned char * refp;
+  int luma, chroma_u, chroma_v, unused, pair, npairs;
+
+  rgbp = buffers->rgb;
+  refp = buffers->ref;
+  npairs = buffers->width * buffers->height / 2;
+
+  for (pair = 0; pair < npairs; pair++)
+    {
+      reference_yuv(rgbp[0], rgbp[1], rgbp[2], &luma, &chroma_u, &unused);
+      refp[0] = luma;
+      refp[1] = chroma_u;
+      reference_yuv(rgbp[3], rgbp[4], rgbp[5], &luma, &unused, &chroma_v);
+      refp[2] = luma;
+      refp[3] = chroma_v;
+      rgbp += 6;
+      refp += 4;
+    }
+
+  run_rgb2yuv422(buffers);
+
+  return(largest_difference(buffers->yuyv, buffers->ref, (size_t)npairs * 4));
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  run_deinterlace, check_deinterlace
+
+
+   USAGE:
+
+   run_deinterlace(&buffers);
+   error =  check_deinterlace(&buffers);
+
+   returns: void, int
+
+   DESCRIPTION:
+                 run_deinterlace runs deinterlace_testpattern on
+		 buffers->yuyv as a one frame YUYV test pattern.
+
+		 check_deinterlace keeps a copy of the frame in
+		 buffers->ref, deinterlaces it, and checks that line
+		 k of the top half is line 2k of the copy and line k
+		 of the bottom half is line 2k + 1. it returns the
+		 largest difference.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void run_deinterlace(Kernelbuffers_t * buffers)
+{
+  Testpattern_t * pattern;
+
+  pattern = &(buffers->pattern);
+  pattern->image_width = buffers->width;
+  pattern->image_height = buffers->height;
+  pattern->encoding = YUV422;
+  pattern->nbuffers = 1;
+  pattern->buffersize = buffers->width * buffers->height * 2;
+  pattern->bufferarray = buffers->yuyv;
+
+  deinterlace_testpattern(pattern);
+}
+
+int check_deinterlace(Kernelbuffers_t * buffers)
+{
+  size_t linebytes;
+  int line, half, error, worst;
+
+  linebytes = (size_t)buffers->width * 2;
+  half = buffers->height / 2;
+  memcpy(buffers->ref, buffers->yuyv, linebytes * buffers->height);
+
+  run_deinterlace(buffers);
+
+  worst = 0;
+  for (line = 0; line < half; line++)
+    {
+      error = largest_difference(buffers->yuyv + line * linebytes,
+				 buffers->ref + 2 * line * linebytes,
+				 linebytes);
+      worst = (error > worst) ? error : worst;
+      error = largest_difference(buffers->yuyv + (half + line) * linebytes,
+				 buffers->ref + (2 * line + 1) * linebytes,
+				 linebytes);
+      worst = (error > worst) ? error : worst;
+    }
+
+  return(worst);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  run_luma_histogram, check_luma_histogram
+
+
+   USAGE:
+
+   run_luma_histogram(&buffers);
+   error =  check_luma_histogram(&buffers);
+
+   returns: void, int
+
+   DESCRIPTION:
+                 run_luma_histogram counts buffers->yuyv's luma
+		 values into buffers->histogram with luma_histogram.
+
+		 check_luma_histogram does that, counts them again
+		 one at a time into one table, and returns the
+		 largest difference between the two counts.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void run_luma_histogram(Kernelbuffers_t * buffers)
+{
+  luma_histogram(buffers->yuyv, buffers->width * buffers->height,
+		 buffers->histogram);
+}
+
+int check_luma_histogram(Kernelbuffers_t * buffers)
+{
+  unsigned int reference[256];
+  int i, npixels, error, worst;
+
+  memset(reference, 0, sizeof(reference));
+  npixels = buffers->width * buffers->height;
+  for (i = 0; i < npixels; i++)
+    {
+      reference[buffers->yuyv[2 * i]]++;
+    }
+
+  run_luma_histogram(buffers);
+
+  worst = 0;
+  for (i = 0; i < 256; i++)
+    {
+      error = abs((int)buffers->histogram[i] - (int)reference[i]);
+      worst = (error > worst) ? error : worst;
+    }
+
+  return(worst);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  luma_histogram
+
+
+   USAGE:
+
+   unsigned int histogram[256];
+
+   luma_histogram(yuyv, npixels, histogram);
+
+   returns: void
+
+   DESCRIPTION:
+                 count how many of the npixels YUYV pixels have each
+		 luma value.
+
+		 counts go into four tables, one for each pixel of a
+		 group of four, added up at the end: a run of pixels
+		 the same brightness (common in video) would
+		 otherwise make every increment wait for the last one
+		 to the same counter.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void luma_histogram(const unsigned char * yuyv, int npixels,
+		    unsigned int histogram[256])
+{
+  unsigned int counts[4][256];
+  int i;
+
+  memset(counts, 0, sizeof(counts));
+
+  for (i = 0; i + 4 <= npixels; i += 4)
+    {
+      counts[0][yuyv[0]]++;
+      counts[1][yuyv[2]]++;
+      counts[2][yuyv[4]]++;
+      counts[3][yuyv[6]]++;
+      yuyv += 8;
+    }
+  for (; i < npixels; i++)
+    {
+      counts[0][yuyv[0]]++;
+      yuyv += 2;
+    }
+
+  for (i = 0; i < 256; i++)
+    {
+      histogram[i] = counts[0][i] + counts[1][i] + counts[2][i]
+	+ counts[3][i];
+    }
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  reference_yuv
+
+
+   USAGE:
+
+   int luma, chroma_u, chroma_v;
+
+   reference_yuv(red, green, blue, &luma, &chroma_u, &chroma_v);
+
+   returns: void
+
+   DESCRIPTION:
+                 the studio swing RGB to YUV equations the test
+		 pattern code uses, written out once, in double
+		 precision, each result clamped to 0...255.
+
+   REFERENCES: ITU-R BT.601
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void reference_yuv(int red, int green, int blue, int * luma, int * chroma_u,
+		   int * chroma_v)
+{
+  double y, u, v;
+
+  y = 0.257 * red + 0.504 * green + 0.098 * blue + 16.0;
+  u = -0.148 * red - 0.291 * green + 0.439 * blue + 128.0;
+  v = 0.439 * red - 0.368 * green - 0.071 * blue + 128.0;
+
+  *luma = (y > 255.0) ? 255 : ((y < 0.0) ? 0 : (int)y);
+  *chroma_u = (u > 255.0) ? 255 : ((u < 0.0) ? 0 : (int)u);
+  *chroma_v = (v > 255.0) ? 255 : ((v < 0.0) ? 0 : (int)v);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  largest_difference
+
+
+   USAGE:
+
+   int error;
+
+   error =  largest_difference(a, b, nbytes);
+
+   returns: int
+
+   DESCRIPTION:
+                 return the largest difference between a byte of a
+		 and the same byte of b (0 if they're the same)
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int largest_difference(const unsigned char * a, const unsigned char * b,
+		       size_t nbytes)
+{
+  size_t i;
+  int error, worst;
+
+  if (0 == memcmp(a, b, nbytes))
+    {
+      return(0);
+    }
+
+  worst = 0;
+  for (i = 0; i < nbytes; i++)
+    {
+      error = abs((int)a[i] - (int)b[i]);
+      worst = (error > worst) ? error : worst;
+    }
+
+  return(worst);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  fill_kernel_inputs
+
+
+   USAGE:
+
+   fill_kernel_inputs(&buffers);
+
+   returns: void
+
+   DESCRIPTION:
+                 fill buffers->yuyv and buffers->rgb with the same
+		 pseudo random bytes every time, so every kernel
+		 (and every run of this program) sees the same input
+		 and the checks cover every value.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void fill_kernel_inputs(Kernelbuffers_t * buffers)
+{
+  unsigned int state;
+  size_t i, npixels;
+
+  npixels = (size_t)buffers->width * buffers->height;
+  state = 12345;
+
+  /* a 32 bit linear congruential generator; the top byte is random  */
+  /* enough for this  */
+  for (i = 0; i < npixels * 2; i++)
+    {
+      state = state * 1664525u + 1013904223u;
+      buffers->yuyv[i] = (unsigned char)(state >> 24);
+    }
+  for (i = 0; i < npixels * 3; i++)
+    {
+      state = state * 1664525u + 1013904223u;
+      buffers->rgb[i] = (unsigned char)(state >> 24);
+    }
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  read_cycles
+
+
+   USAGE:
+
+   unsigned long long start;
+
+   start = read_cycles();
+
+   returns: unsigned long long
+
+   DESCRIPTION:
+                 read the time stamp counter, or return 0 where we
+		 don't have one
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+unsigned long long read_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return(__rdtsc());
+#else
+  return(0);
+#endif
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  compare_long_long
+
+
+   USAGE:
+
+   qsort(values, n, sizeof(long long), compare_long_long);
+
+   returns: int
+
+   DESCRIPTION:
+                 qsort comparison for ascending long longs
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int compare_long_long(const void * a, const void * b)
+{
+  long long x, y;
+
+  x = *(const long long *)a;
+  y = *(const long long *)b;
+
+  return((x > y) - (x < y));
+}
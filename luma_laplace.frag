@@ -28,6 +28,13 @@ uniform int shader_on;
 
 uniform int image_processing; // 0, 1
 
+// per_tile - if this is 1, the picture is a mosaic of tiles (see
+//   draw_video_tiles in callbacks.c) and each tile brings its own
+//   color_output and image_processing in gl_SecondaryColor.r and .g;
+//   the uniforms above are ignored.
+
+uniform int per_tile; // 0, 1
+
 // luma_texcoord_offsets - the offsets in texture coordinates to
 //   apply to our current coordinates to get the neighboring
 //   pixels (up, down, left, right). 
@@ -84,6 +91,22 @@ float laplace_luma()
 
 
 
+
+//
+// int tile_image_processing()
+//
+// image_processing for the tile being drawn
+//
+
+int tile_image_processing()
+{
+  if (1 == per_tile)
+    {
+      return(int(gl_SecondaryColor.g + 0.5));
+    }
+  return(image_processing);
+}
+
 void main()
 {
   float luma;
@@ -95,7 +118,7 @@ void main()
   else /* translate luma to RGB and ignoring interlacing scan lines  */
   {
 
-    if (0 == image_processing) // no image processing
+    if (0 == tile_image_processing()) // no image processing
       {	
 	// just look up the brightness
 	luma =texture2D(image_texture_unit,gl_TexCoord[0].st).r;
@@ -0,0 +1,779 @@
+/* *************************************************************************
+* NAME: glutcam/multicapture.c
+*
+* DESCRIPTION:
+*
+* run several sources (cameras, test patterns, capture files) in one
+* process: a Sourceset_t. each source keeps its own buffers and its
+* own pipeline (frame ring, recorder, frame bus, dmabuf server), the
+* way a single source always has; this code starts, stops and feeds
+* them together.
+*
+* three ways to capture them:
+*
+* * polled: the display calls poll_capture_sources from its idle
+*   loop, which polls each source the way it polls one.
+*
+* * a thread per source: each Sourceparams_t has threaded set and
+*   start_capture_source gives it a capture thread of its own.
+*
+* * one epoll thread for all of them (Sourceset_t.epoll, -E): the
+*   devices' file descriptors go in one epoll set, and the thread
+*   sleeps in epoll_wait until one of them has a frame, or until the
+*   next test pattern or capture file frame is due. one thread, one
+*   wakeup per frame, however many cameras.
+*
+* either way the frames end up in each source's own ring, so the
+* consumer side doesn't care which it is.
+*
+* PROCESS:
+*
+* see multicapture.h
+*
+* GLOBALS: none
+*
+* REFERENCES: epoll(7)
+*
+* LIMITATIONS:
+*
+* the stage latency histograms (stagestats.c) are shared by all the
+* sources.
+*
+* REVISION HISTORY:
+*
+*   STR                Description                          Author
+*
+*   17-Oct-26          initial coding
+*   17-Oct-26          wait_for_published_frames, for the mosaic
+*   17-Oct-26          stop_capture_sources flushes the sync stage
+*   17-Oct-26          the epoll thread requeues buffers dmabuf
+*                      clients released
+*
+* TARGET: Linux C, pthreads
+*
+* This software is in the public domain. if it breaks you get to keep
+* both pieces.
+*
+* ************************************************************************* */
+
+#include <stdio.h>
+#include <stdlib.h> /* abort  */
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h> /* close, read  */
+#include <poll.h>
+#include <sys/epoll.h>
+
+#include "glutcam.h"
+#include "capture.h" /* start_capture_source, requeue_released_buffers, ...  */
+#include "capabilities.h"
+#include "device.h" /* next_device_frame  */
+#include "timeutil.h" /* monotonic_usec  */
+#include "stagestats.h" /* report_stage_stats  */
+#include "trace.h" /* trace_thread_name, stop_trace  */
+#include "framesync.h" /* flush_framesync, report_framesync  */
+#include "multicapture.h"
+
+/* EPOLL_WAIT_USEC - the longest the epoll thread sleeps before  */
+/* checking whether it's been asked to stop  */
+
+#define EPOLL_WAIT_USEC 100000
+
+/* local prototypes  */
+int start_epoll_capture(Sourceset_t * sourceset);
+void stop_epoll_capture(Sourceset_t * sourceset);
+void * epoll_capture_main(void * arg);
+long long source_due_usec(const Sourceparams_t * sourceparams);
+/* end local prototypes  */
+
+
+
+/* *************************************************************************
+
+
+   NAME:  start_capture_sources
+
+
+   USAGE:
+
+   int some_int;
+   Sourceset_t * sourceset;
+
+   some_int =  start_capture_sources(sourceset);
+
+   returns: int
+
+   DESCRIPTION:
+                 start every source in sourceset (start_capture_source),
+		 numbering them 0...nsources - 1. with
+		 sourceset->epoll set, none of them gets a capture
+		 thread of its own: start the one thread that captures
+		 them all instead.
+
+		 if any of it fails, stop whatever was started.
+
+		 return 0 if all's well
+		       -1 if a source or the epoll thread wouldn't start
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int start_capture_sources(Sourceset_t * sourceset)
+{
+  Sourceparams_t * sourceparams;
+  int i;
+
+  for (i = 0; i < sourceset->nsources; i++)
+    {
+      sourceparams = sourceset->sources[i];
+      sourceparams->id = i;
+      sourceparams->epoll_capture = sourceset->epoll;
+
+      if (-1 == start_capture_source(sourceparams))
+	{
+	  fprintf(stderr, "Error: unable to start source %d\n", i);
+	  while (0 < i--)
+	    {
+	      (void)finish_capture_source(sourceset->sources[i]);
+	    }
+	  return(-1);
+	}
+    }
+
+  if ((0 != sourceset->epoll) && (-1 == start_epoll_capture(sourceset)))
+    {
+      for (i = 0; i < sourceset->nsources; i++)
+	{
+	  (void)finish_capture_source(sourceset->sources[i]);
+	}
+      return(-1);
+    }
+
+  return(0);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  stop_capture_sources
+
+
+   USAGE:
+
+   int some_int;
+   Sourceset_t * sourceset;
+
+   some_int =  stop_capture_sources(sourceset);
+
+   returns: int
+
+   DESCRIPTION:
+                 stop_capture_source for a whole set: give back the
+		 frames the sync stage is holding, stop the epoll
+		 thread if there is one, then each source, then print
+		 the stage latencies (and how the sync stage did) and
+		 finish the trace once for all of them.
+
+		 return 0 if all's well
+		       -1 if a source had trouble stopping
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+     17-Oct-26  flush and report the sync stage
+
+ ************************************************************************* */
+
+int stop_capture_sources(Sourceset_t * sourceset)
+{
+  int i, retval;
+
+  flush_framesync(sourceset);
+  stop_epoll_capture(sourceset);
+
+  retval = 0;
+  for (i = 0; i < sourceset->nsources; i++)
+    {
+      if (-1 == finish_capture_source(sourceset->sources[i]))
+	{
+	  retval = -1;
+	}
+    }
+
+  report_stage_stats(stderr);
+  report_framesync(sourceset, stderr);
+  stop_trace();
+
+  return(retval);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  poll_capture_sources
+
+
+   USAGE:
+
+   int ready;
+   Sourceset_t * sourceset;
+
+   ready =  poll_capture_sources(sourceset);
+
+   returns: int
+
+   DESCRIPTION:
+                 what the idle function does for one source, for all
+		 of them: capture whatever frames each has ready
+		 (capture_video_frame). if threads capture the sources
+		 there's nothing to do.
+
+		 return the number of sources that had a frame
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   call it from the consumer (the thread that draws) only
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int poll_capture_sources(Sourceset_t * sourceset)
+{
+  int i, ready, nbytes;
+
+  ready = 0;
+  for (i = 0; i < sourceset->nsources; i++)
+    {
+      if ((0 == sourceset->sources[i]->threaded)
+	  && (NULL != capture_video_frame(sourceset->sources[i], &nbytes)))
+	{
+	  ready++;
+	}
+    }
+
+  return(ready);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  drain_capture_sources
+
+
+   USAGE:
+
+   Sourceset_t * sourceset;
+   Sourceparams_t * shown;
+
+   drain_capture_sources(sourceset, shown);
+
+   returns: void
+
+   DESCRIPTION:
+                 give back every frame waiting in the rings of the
+		 sources other than keep, without using them.
+
+		 a source whose frames nobody takes runs out of
+		 buffers: the driver stops filling them, and its
+		 recorder and frame bus stop getting frames. the
+		 display calls this for the sources it isn't drawing.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   call it from the consumer (the thread that draws) only
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void drain_capture_sources(Sourceset_t * sourceset, Sourceparams_t * keep)
+{
+  Frameslot_t slot;
+  int i;
+
+  for (i = 0; i < sourceset->nsources; i++)
+    {
+      if ((keep != sourceset->sources[i])
+	  && (0 == acquire_video_frame(sourceset->sources[i], &slot)))
+	{
+	  release_video_frame(sourceset->sources[i], &slot);
+	}
+    }
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  wait_for_published_frames
+
+
+   USAGE:
+
+   Sourceset_t * sourceset;
+
+   if (0 < wait_for_published_frames(sourceset, 5000))
+   -- acquire_video_frame will find one for at least one source
+
+   returns: int
+
+   DESCRIPTION:
+                 wait_for_published_frame for all the sources at
+		 once: sleep until any of them publishes a frame or
+		 useconds go by.
+
+		 return the number of sources with new frames,
+		        0 if none came in time
+		       -1 on error
+
+   REFERENCES: poll(2), eventfd(2)
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int wait_for_published_frames(Sourceset_t * sourceset, int useconds)
+{
+  struct pollfd pollfds[MAX_SOURCES];
+  uint64_t count;
+  int i, status, ready;
+
+  for (i = 0; i < sourceset->nsources; i++)
+    {
+      pollfds[i].fd = sourceset->sources[i]->frame_event_fd;
+      pollfds[i].events = POLLIN;
+      pollfds[i].revents = 0;
+    }
+
+  status = poll(pollfds, sourceset->nsources, (useconds + 999) / 1000);
+
+  if (-1 == status)
+    {
+      perror("Error waiting for a frame");
+      return(-1);
+    }
+
+  ready = 0;
+  for (i = 0; (0 < status) && (i < sourceset->nsources); i++)
+    {
+      /* reading resets the count  */
+      if ((0 != (pollfds[i].revents & POLLIN))
+	  && ((ssize_t)sizeof(count) == read(pollfds[i].fd, &count,
+					     sizeof(count))))
+	{
+	  ready++;
+	}
+    }
+
+  return(ready);
+}
+
+
+/* *************************************************************************
+
+
+   NAME:  start_epoll_capture
+
+
+   USAGE:
+
+   int some_int;
+   Sourceset_t * sourceset;
+
+   some_int =  start_epoll_capture(sourceset);
+
+   returns: int
+
+   DESCRIPTION:
+                 put each device's file descriptor in a new epoll set
+		 (the event carries the source's number) and start
+		 the thread that runs epoll_capture_main on it.
+
+		 return 0 if all's well
+		       -1 if the epoll set or thread couldn't be made
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int start_epoll_capture(Sourceset_t * sourceset)
+{
+  struct epoll_event event;
+  int i, status;
+
+  sourceset->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (-1 == sourceset->epoll_fd)
+    {
+      perror("Error creating the capture epoll set");
+      return(-1);
+    }
+
+  for (i = 0; i < sourceset->nsources; i++)
+    {
+      if (LIVESOURCE != sourceset->sources[i]->source)
+	{
+	  continue; /* waited for with the epoll_wait timeout  */
+	}
+
+      event.events = EPOLLIN;
+      event.data.u32 = (uint32_t)i;
+      if (-1 == epoll_ctl(sourceset->epoll_fd, EPOLL_CTL_ADD,
+			  sourceset->sources[i]->fd, &event))
+	{
+	  perror("Error adding a device to the capture epoll set");
+	  close(sourceset->epoll_fd);
+	  sourceset->epoll_fd = -1;
+	  return(-1);
+	}
+    }
+
+  __atomic_store_n(&(sourceset->epoll_running), 1, __ATOMIC_RELEASE);
+
+  status = pthread_create(&(sourceset->epoll_thread), NULL,
+			  epoll_capture_main, sourceset);
+  if (0 != status)
+    {
+      fprintf(stderr, "Error: unable to start epoll capture thread (%d)\n",
+	      status);
+      sourceset->epoll_running = 0;
+      close(sourceset->epoll_fd);
+      sourceset->epoll_fd = -1;
+      return(-1);
+    }
+
+  return(0);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  stop_epoll_capture
+
+
+   USAGE:
+
+   Sourceset_t * sourceset;
+
+   stop_epoll_capture(sourceset);
+
+   returns: void
+
+   DESCRIPTION:
+                 ask the epoll thread to stop, wait for it (it
+		 notices within EPOLL_WAIT_USEC) and close the epoll
+		 set. does nothing if the thread isn't running.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void stop_epoll_capture(Sourceset_t * sourceset)
+{
+  if (0 != __atomic_exchange_n(&(sourceset->epoll_running), 0,
+			       __ATOMIC_ACQ_REL))
+    {
+      pthread_join(sourceset->epoll_thread, NULL);
+      close(sourceset->epoll_fd);
+      sourceset->epoll_fd = -1;
+    }
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  epoll_capture_main
+
+
+   USAGE:
+
+   pthread_create(&thread, NULL, epoll_capture_main, sourceset);
+
+   returns: void *
+
+   DESCRIPTION:
+                 the body of the epoll capture thread.
+
+		 sleep in epoll_wait until a device has a filled
+		 buffer or the next test pattern or capture file frame
+		 is due, whichever's first. dequeue everything the
+		 ready devices have into their rings, then publish
+		 the frames that are due. each time round, give the
+		 devices back the buffers their dmabuf clients have
+		 released.
+
+		 loop until sourceset->epoll_running is cleared.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   epoll_wait counts in milliseconds, so a test pattern or capture
+   file frame can be up to a millisecond late. device frames aren't
+   affected.
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+     17-Oct-26  requeue buffers dmabuf clients released
+
+ ************************************************************************* */
+
+void * epoll_capture_main(void * arg)
+{
+  Sourceset_t * sourceset;
+  Sourceparams_t * sourceparams;
+  struct epoll_event events[MAX_SOURCES];
+  long long now_usec, due_usec, wait_usec;
+  int i, nready, nbytes;
+
+  sourceset = (Sourceset_t *)arg;
+  trace_thread_name("capture");
+
+  while (0 != __atomic_load_n(&(sourceset->epoll_running), __ATOMIC_ACQUIRE))
+    {
+      now_usec = monotonic_usec();
+      wait_usec = EPOLL_WAIT_USEC;
+      for (i = 0; i < sourceset->nsources; i++)
+	{
+	  due_usec = source_due_usec(sourceset->sources[i]);
+	  if ((0 != due_usec) && (due_usec - now_usec < wait_usec))
+	    {
+	      wait_usec = (due_usec > now_usec) ? due_usec - now_usec : 0;
+	    }
+	}
+
+      /* round up: waking early would just mean waiting again  */
+      nready = epoll_wait(sourceset->epoll_fd, events, MAX_SOURCES,
+			  (int)((wait_usec + 999) / 1000));
+      if ((-1 == nready) && (EINTR != errno))
+	{
+	  perror("Error waiting for capture devices");
+	  break;
+	}
+
+      /* after the wait, so a client done with its frame meanwhile  */
+      /* is sent the one that woke us  */
+      for (i = 0; i < sourceset->nsources; i++)
+	{
+	  if (LIVESOURCE == sourceset->sources[i]->source)
+	    {
+	      requeue_released_buffers(sourceset->sources[i]);
+	    }
+	}
+
+      for (i = 0; i < nready; i++)
+	{
+	  sourceparams = sourceset->sources[events[i].data.u32];
+	  (void)next_device_frame(sourceparams, &nbytes);
+	}
+
+      for (i = 0; i < sourceset->nsources; i++)
+	{
+	  if (0 != source_due_usec(sourceset->sources[i]))
+	    {
+	      /* publishes the frame only if it's due  */
+	      (void)capture_video_frame(sourceset->sources[i], &nbytes);
+	    }
+	}
+    }
+
+  return(NULL);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  source_due_usec
+
+
+   USAGE:
+
+   long long due_usec;
+   const Sourceparams_t * sourceparams;
+
+   due_usec =  source_due_usec(sourceparams);
+
+   returns: long long
+
+   DESCRIPTION:
+                 return when a test pattern's or capture file's next
+		 frame is due (monotonic_usec), or 0 for a device:
+		 devices say when they have a frame themselves.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+long long source_due_usec(const Sourceparams_t * sourceparams)
+{
+  long long due_usec;
+
+  switch (sourceparams->source)
+    {
+    case TESTPATTERN:
+      due_usec = sourceparams->testpattern.next_frame_usec;
+      break;
+
+    case FILESOURCE:
+      due_usec = sourceparams->capfile.next_frame_usec;
+      break;
+
+    case LIVESOURCE:
+      due_usec = 0;
+      break;
+
+    default:
+      fprintf(stderr, "Error: %s doesn't have a case for source %d\n",
+	      __FUNCTION__, sourceparams->source);
+      fprintf(stderr, "add one and recompile\n");
+      abort();
+      break;
+    }
+
+  return(due_usec);
+}
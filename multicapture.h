@@ -0,0 +1,62 @@
+/* *************************************************************************
+* NAME: glutcam/multicapture.h
+*
+* DESCRIPTION:
+*
+* this is the header file for the functions exported from multicapture.c
+*
+* PROCESS:
+*
+*   Sourceset_t sourceset;  -- nsources, sources[], epoll filled in
+*
+*   start_capture_sources(&sourceset);
+*   loop:
+*     poll_capture_sources(&sourceset);   -- does nothing if threaded
+*     acquire_video_frame(sourceset.sources[i], &slot) ...
+*     drain_capture_sources(&sourceset, shown);  -- the ones not drawn
+*
+*   or to draw them all (the mosaic), instead of draining:
+*     if (0 < wait_for_published_frames(&sourceset, usec)) ...
+*   stop_capture_sources(&sourceset);
+*
+* GLOBALS: none
+*
+* REFERENCES:
+*
+* LIMITATIONS:
+*
+* REVISION HISTORY:
+*
+*   STR                Description                          Author
+*
+*   17-Oct-26          initial coding
+*   17-Oct-26          wait_for_published_frames
+*
+* TARGET: Linux C, pthreads
+*
+* This software is in the public domain. if it breaks you get to keep
+* both pieces.
+*
+* ************************************************************************* */
+
+#ifndef	__MULTICAPTURE_H__
+#define	__MULTICAPTURE_H__
+
+#include "glutcam.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+extern int start_capture_sources(Sourceset_t * sourceset);
+extern int stop_capture_sources(Sourceset_t * sourceset);
+extern int poll_capture_sources(Sourceset_t * sourceset);
+extern void drain_capture_sources(Sourceset_t * sourceset,
+				  Sourceparams_t * keep);
+extern int wait_for_published_frames(Sourceset_t * sourceset, int useconds);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	//__MULTICAPTURE_H__
@@ -0,0 +1,647 @@
+/* *************************************************************************
+* NAME: glutcam/offscreen.c
+*
+* DESCRIPTION:
+*
+* an OpenGL context with no window and no X server, for running the
+* display pipeline (PBO uploads, shaders, draw_video_frame) in CI or
+* on a server, and for timing it on a software rasterizer (llvmpipe).
+*
+* two backends, picked when compiling (see OFFSCREEN in the Makefile):
+*
+*  OFFSCREEN_EGL    - EGL on Mesa's surfaceless platform: a context
+*                     with no surface at all (EGL_KHR_surfaceless_context)
+*  OFFSCREEN_OSMESA - Mesa's off screen interface, rendering into a
+*                     buffer in our memory
+*
+* either way we draw into a framebuffer object the size of the window,
+* so the drawing code sees the same thing a glut window would give it.
+* without either, create_offscreen_context just says so and fails.
+*
+* PROCESS:
+*
+* see offscreen.h
+*
+* GLOBALS: none (the context is local to this file)
+*
+* REFERENCES: EGL_MESA_platform_surfaceless, EGL_KHR_surfaceless_context,
+*             GL_ARB_framebuffer_object, Mesa's GL/osmesa.h
+*
+* LIMITATIONS:
+*
+* one context per process, current on the thread that made it.
+*
+* GLEW finds GL functions through GLX unless it was built for another
+* window system. that works with EGL on a libglvnd system (GLX and EGL
+* share one dispatch table), but OSMesa needs a GLEW built with
+* GLEW_OSMESA.
+*
+* REVISION HISTORY:
+*
+*   STR                Description                          Author
+*
+*   17-Oct-26          initial coding
+*
+* TARGET: Linux C, OpenGL
+*
+* This software is in the public domain. if it breaks you get to keep
+* both pieces.
+*
+* ************************************************************************* */
+
+#include <stdio.h>
+#include <stdlib.h> /* malloc, free  */
+#include <string.h> /* strstr  */
+
+#include <GL/glew.h>
+
+#ifdef	OFFSCREEN_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif	//OFFSCREEN_EGL
+
+#ifdef	OFFSCREEN_OSMESA
+#include <GL/osmesa.h>
+#endif	//OFFSCREEN_OSMESA
+
+#include "glutcam.h"
+#include "offscreen.h"
+
+#ifdef	OFFSCREEN_EGL
+/* EGL_PLATFORM_SURFACELESS_MESA - from eglext.h, for older headers  */
+#ifndef	EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+static EGLDisplay Egl_display = EGL_NO_DISPLAY;
+static EGLContext Egl_context = EGL_NO_CONTEXT;
+#endif	//OFFSCREEN_EGL
+
+#ifdef	OFFSCREEN_OSMESA
+static OSMesaContext Osmesa_context = NULL;
+static void * Osmesa_buffer = NULL; /* OSMesa's own framebuffer  */
+#endif	//OFFSCREEN_OSMESA
+
+/* local prototypes  */
+#ifdef	OFFSCREEN_EGL
+int create_egl_context(void);
+#endif
+#ifdef	OFFSCREEN_OSMESA
+int create_osmesa_context(Displaydata_t * displaydata);
+#endif
+/* end local prototypes  */
+
+
+
+/* *************************************************************************
+
+
+   NAME:  offscreen_backend_name
+
+
+   USAGE:
+
+   fprintf(stderr, "offscreen: %s\n", offscreen_backend_name());
+
+   returns: const char *
+
+   DESCRIPTION:
+                 return the name of the backend this was built with,
+		 "none" if it wasn't built with one
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+const char * offscreen_backend_name(void)
+{
+#if defined(OFFSCREEN_EGL)
+  return("EGL (surfaceless)");
+#elif defined(OFFSCREEN_OSMESA)
+  return("OSMesa");
+#else
+  return("none");
+#endif
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  create_offscreen_context
+
+
+   USAGE:
+
+   int status;
+   Displaydata_t displaydata;
+
+   status =  create_offscreen_context(&displaydata);
+
+   if (0 == status)
+   -- a context is current: glewInit, then setup_offscreen_framebuffer
+   else
+   -- no offscreen GL here
+
+   returns: int
+
+   DESCRIPTION:
+                 make an OpenGL context with no window and make it
+		 current on this thread: the offscreen version of
+		 create_glut_window.
+
+		 return 0 on success
+		       -1 (and say why) on failure
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: Egl_display, Egl_context, Osmesa_context, Osmesa_buffer
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int create_offscreen_context(Displaydata_t * displaydata)
+{
+  int status;
+
+  displaydata->window_id = 0;
+  displaydata->offscreen_fbo = 0;
+  displaydata->offscreen_renderbuffer = 0;
+
+#if defined(OFFSCREEN_EGL)
+  status = create_egl_context();
+#elif defined(OFFSCREEN_OSMESA)
+  status = create_osmesa_context(displaydata);
+#else
+  fprintf(stderr, "Error: built without an offscreen backend: set OFFSCREEN");
+  fprintf(stderr, " to egl or osmesa in the Makefile and recompile\n");
+  status = -1;
+#endif
+
+  if (0 == status)
+    {
+      fprintf(stderr, "offscreen: %s, %dx%d\n", offscreen_backend_name(),
+	      displaydata->window_width, displaydata->window_height);
+    }
+
+  return(status);
+}
+
+
+
+#ifdef	OFFSCREEN_EGL
+/* *************************************************************************
+
+
+   NAME:  create_egl_context
+
+
+   USAGE:
+
+   int status;
+
+   status =  create_egl_context();
+
+   returns: int
+
+   DESCRIPTION:
+                 open Mesa's surfaceless EGL platform (or, failing
+		 that, the default display, which is whatever
+		 EGL_PLATFORM says), and make a desktop OpenGL
+		 context current on it with no surface.
+
+		 return 0 on success
+		       -1 (and say why) on failure
+
+   REFERENCES: EGL_MESA_platform_surfaceless, EGL_EXT_platform_base,
+               EGL_KHR_surfaceless_context
+
+   LIMITATIONS:
+
+   the drawing code uses the fixed function pipeline, so this asks
+   for a compatibility (not a core) context.
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: Egl_display, Egl_context
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int create_egl_context(void)
+{
+  static const EGLint config_attributes[] = {
+    EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+    EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+    EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+    EGL_NONE
+  };
+  PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display;
+  const char * extensions;
+  EGLConfig config;
+  EGLint major, minor, nconfigs;
+
+  get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)
+    eglGetProcAddress("eglGetPlatformDisplayEXT");
+  if (NULL != get_platform_display)
+    {
+      Egl_display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA,
+					 EGL_DEFAULT_DISPLAY, NULL);
+    }
+  if (EGL_NO_DISPLAY == Egl_display)
+    {
+      fprintf(stderr, "Warning: no surfaceless EGL platform, trying the");
+      fprintf(stderr, " default display\n");
+      Egl_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+
+  if ((EGL_NO_DISPLAY == Egl_display)
+      || (EGL_TRUE != eglInitialize(Egl_display, &major, &minor)))
+    {
+      fprintf(stderr, "Error: can't initialize EGL (0x%x)\n", eglGetError());
+      Egl_display = EGL_NO_DISPLAY;
+      return(-1);
+    }
+  fprintf(stderr, "EGL %d.%d, vendor '%s'\n", major, minor,
+	  eglQueryString(Egl_display, EGL_VENDOR));
+
+  extensions = eglQueryString(Egl_display, EGL_EXTENSIONS);
+  if ((NULL == extensions)
+      || (NULL == strstr(extensions, "EGL_KHR_surfaceless_context")))
+    {
+      fprintf(stderr, "Error: this EGL has no EGL_KHR_surfaceless_context\n");
+      eglTerminate(Egl_display);
+      Egl_display = EGL_NO_DISPLAY;
+      return(-1);
+    }
+
+  if ((EGL_TRUE != eglBindAPI(EGL_OPENGL_API))
+      || (EGL_TRUE != eglChooseConfig(Egl_display, config_attributes,
+				      &config, 1, &nconfigs))
+      || (1 > nconfigs))
+    {
+      fprintf(stderr, "Error: no EGL config for desktop OpenGL (0x%x)\n",
+	      eglGetError());
+      eglTerminate(Egl_display);
+      Egl_display = EGL_NO_DISPLAY;
+      return(-1);
+    }
+
+  Egl_context = eglCreateContext(Egl_display, config, EGL_NO_CONTEXT, NULL);
+  if ((EGL_NO_CONTEXT == Egl_context)
+      || (EGL_TRUE != eglMakeCurrent(Egl_display, EGL_NO_SURFACE,
+				     EGL_NO_SURFACE, Egl_context)))
+    {
+      fprintf(stderr, "Error: can't make an EGL context current (0x%x)\n",
+	      eglGetError());
+      if (EGL_NO_CONTEXT != Egl_context)
+	{
+	  eglDestroyContext(Egl_display, Egl_context);
+	  Egl_context = EGL_NO_CONTEXT;
+	}
+      eglTerminate(Egl_display);
+      Egl_display = EGL_NO_DISPLAY;
+      return(-1);
+    }
+
+  return(0);
+}
+#endif	//OFFSCREEN_EGL
+
+
+
+#ifdef	OFFSCREEN_OSMESA
+/* *************************************************************************
+
+
+   NAME:  create_osmesa_context
+
+
+   USAGE:
+
+   int status;
+   Displaydata_t displaydata;
+
+   status =  create_osmesa_context(&displaydata);
+
+   returns: int
+
+   DESCRIPTION:
+                 make an OSMesa RGBA context and make it current on a
+		 window sized buffer of our own. (we draw into an FBO,
+		 but OSMesa won't make a context current without a
+		 buffer.)
+
+		 return 0 on success
+		       -1 (and say why) on failure
+
+   REFERENCES: GL/osmesa.h
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: Osmesa_context, Osmesa_buffer
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int create_osmesa_context(Displaydata_t * displaydata)
+{
+  Osmesa_context = OSMesaCreateContextExt(OSMESA_RGBA, 24, 0, 0, NULL);
+  if (NULL == Osmesa_context)
+    {
+      fprintf(stderr, "Error: can't create an OSMesa context\n");
+      return(-1);
+    }
+
+  Osmesa_buffer = malloc((size_t)displaydata->window_width *
+			 displaydata->window_height * 4);
+  if ((NULL == Osmesa_buffer)
+      || (GL_TRUE != OSMesaMakeCurrent(Osmesa_context, Osmesa_buffer,
+				       GL_UNSIGNED_BYTE,
+				       displaydata->window_width,
+				       displaydata->window_height)))
+    {
+      fprintf(stderr, "Error: can't make the OSMesa context current\n");
+      free(Osmesa_buffer);
+      Osmesa_buffer = NULL;
+      OSMesaDestroyContext(Osmesa_context);
+      Osmesa_context = NULL;
+      return(-1);
+    }
+
+  return(0);
+}
+#endif	//OFFSCREEN_OSMESA
+
+
+
+/* *************************************************************************
+
+
+   NAME:  setup_offscreen_framebuffer
+
+
+   USAGE:
+
+   int status;
+   Displaydata_t displaydata;
+
+   status =  setup_offscreen_framebuffer(&displaydata);
+
+   returns: int
+
+   DESCRIPTION:
+                 make a framebuffer object with an RGBA renderbuffer
+		 the size of the window, bind it for drawing, and set
+		 the viewport to cover it. everything drawn from here
+		 on goes into it.
+
+		 record both names in displaydata.
+
+		 return 0 on success
+		       -1 (and say why) on failure
+
+   REFERENCES: GL_ARB_framebuffer_object (core in OpenGL 3.0)
+
+   LIMITATIONS:
+
+   call after glewInit (in test_ogl_features)
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int setup_offscreen_framebuffer(Displaydata_t * displaydata)
+{
+  GLuint fbo, renderbuffer;
+  GLenum status;
+
+  if (!glewIsSupported("GL_VERSION_3_0")
+      && !glewIsSupported("GL_ARB_framebuffer_object"))
+    {
+      fprintf(stderr, "Error: offscreen drawing needs framebuffer objects");
+      fprintf(stderr, " (GL_ARB_framebuffer_object)\n");
+      return(-1);
+    }
+
+  glGenRenderbuffers(1, &renderbuffer);
+  glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, displaydata->window_width,
+			displaydata->window_height);
+
+  glGenFramebuffers(1, &fbo);
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+			    GL_RENDERBUFFER, renderbuffer);
+
+  displaydata->offscreen_fbo = fbo;
+  displaydata->offscreen_renderbuffer = renderbuffer;
+
+  status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+  if (GL_FRAMEBUFFER_COMPLETE != status)
+    {
+      fprintf(stderr, "Error: offscreen framebuffer incomplete (0x%x)\n",
+	      status);
+      return(-1);
+    }
+
+  glViewport(0, 0, displaydata->window_width, displaydata->window_height);
+
+  return(0);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  swap_offscreen_buffers
+
+
+   USAGE:
+
+   Displaydata_t * displaydata;
+
+   swap_offscreen_buffers(displaydata);
+
+   returns: void
+
+   DESCRIPTION:
+                 what glutSwapBuffers is to a window: the end of a
+		 frame. there's nothing to show it on, so wait for the
+		 GL to finish drawing it; that makes the swap stage
+		 the time the GPU (or llvmpipe) took to catch up, and
+		 keeps a fast producer from queueing frames without
+		 bound.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   unlike a swap with vsync, the next frame's commands can't overlap
+   this one's drawing.
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void swap_offscreen_buffers(Displaydata_t * displaydata)
+{
+  (void)displaydata;
+
+  glFinish();
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  destroy_offscreen_context
+
+
+   USAGE:
+
+   Displaydata_t displaydata;
+
+   destroy_offscreen_context(&displaydata);
+
+   returns: void
+
+   DESCRIPTION:
+                 delete the framebuffer object, release the context
+		 and free what create_offscreen_context made
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   delete the PBOs and textures first: they go with the context.
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: Egl_display, Egl_context, Osmesa_context, Osmesa_buffer
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void destroy_offscreen_context(Displaydata_t * displaydata)
+{
+  GLuint name;
+
+  if (0 != displaydata->offscreen_fbo)
+    {
+      glBindFramebuffer(GL_FRAMEBUFFER, 0);
+      name = displaydata->offscreen_fbo;
+      glDeleteFramebuffers(1, &name);
+      name = displaydata->offscreen_renderbuffer;
+      glDeleteRenderbuffers(1, &name);
+      displaydata->offscreen_fbo = 0;
+      displaydata->offscreen_renderbuffer = 0;
+    }
+
+#ifdef	OFFSCREEN_EGL
+  if (EGL_NO_DISPLAY != Egl_display)
+    {
+      eglMakeCurrent(Egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE,
+		     EGL_NO_CONTEXT);
+      eglDestroyContext(Egl_display, Egl_context);
+      eglTerminate(Egl_display);
+      Egl_context = EGL_NO_CONTEXT;
+      Egl_display = EGL_NO_DISPLAY;
+    }
+#endif	//OFFSCREEN_EGL
+
+#ifdef	OFFSCREEN_OSMESA
+  if (NULL != Osmesa_context)
+    {
+      OSMesaDestroyContext(Osmesa_context);
+      Osmesa_context = NULL;
+      free(Osmesa_buffer);
+      Osmesa_buffer = NULL;
+    }
+#endif	//OFFSCREEN_OSMESA
+}
@@ -0,0 +1,56 @@
+/* *************************************************************************
+* NAME: glutcam/offscreen.h
+*
+* DESCRIPTION:
+*
+* this is the header file for the functions exported from offscreen.c
+*
+* PROCESS:
+*
+* instead of create_glut_window:
+*
+*   create_offscreen_context(&displaydata);   -- EGL or OSMesa context
+*   glewInit();                               -- (test_ogl_features)
+*   setup_offscreen_framebuffer(&displaydata); -- FBO the window's size
+*   ... draw as usual, swap_offscreen_buffers instead of glutSwapBuffers
+*   destroy_offscreen_context(&displaydata);
+*
+* GLOBALS: none
+*
+* REFERENCES:
+*
+* LIMITATIONS:
+*
+* REVISION HISTORY:
+*
+*   STR                Description                          Author
+*
+*   17-Oct-26          initial coding
+*
+* TARGET: Linux C, OpenGL
+*
+* This software is in the public domain. if it breaks you get to keep
+* both pieces.
+*
+* ************************************************************************* */
+
+#ifndef	__OFFSCREEN_H__
+#define	__OFFSCREEN_H__
+
+#include "glutcam.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+extern const char * offscreen_backend_name(void);
+extern int create_offscreen_context(Displaydata_t * displaydata);
+extern int setup_offscreen_framebuffer(Displaydata_t * displaydata);
+extern void swap_offscreen_buffers(Displaydata_t * displaydata);
+extern void destroy_offscreen_context(Displaydata_t * displaydata);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	//__OFFSCREEN_H__
@@ -7,7 +7,10 @@
 * code here expects to parse:
 *
 *      [-d devicefile] [-w width] [-h height]
-*      [-e  LUMA |  YUV420 |  YUV422 | RGB ]
+*      [-e  LUMA |  YUV420 |  YUV422 | RGB ] [-D index]
+*      [-p] [-T] [-n nframes]
+*      [-k auto | scalar | sse2 | avx2 | neon | opencv ] [-j nthreads]
+*      [-P npbos] [-E] [-M]
 * all args are optional:
 *
 * if devicefile is not supplied, the source is assumed to be testpattern
@@ -27,6 +30,11 @@
 *   STR                Description                          Author
 *
 *   31-Dec-06          initial coding                        gpk
+*   17-Oct-26          -d, -p and -f can be given more than once
+*   17-Oct-26          -M draws the sources tiled
+*   17-Oct-26          -Y matches the sources' frames up in time, -Q
+*                      gives test patterns a camera's timing
+*   17-Oct-26          -L tracks by optical flow between detections
 *
 * TARGET: unix C
 *
@@ -58,6 +66,11 @@ static struct {
 
 #define SZ_DIM	((int)sizeof(g_displayDim)/(int)sizeof(g_displayDim[0])) 
 
+/* local prototypes  */
+int add_source_arg(Cmdargs_t * args, Inputsource_t source,
+		   const char * name);
+/* end local prototypes  */
+
 /* ************************************************************************* 
 
 
@@ -87,7 +100,29 @@ static struct {
      expecting to get some of:
 
      [-d devicefile] [-w width] [-h height]
-     [-e  LUMA |  YUV420 |  YUV422 | RGB ]
+     [-e  LUMA |  YUV420 |  YUV422 | RGB ] [-D index]
+     [-p] -- use the test pattern instead of a device
+     [-T] -- capture on a dedicated thread instead of the idle function
+     [-n nframes] -- no window: capture nframes, report CPU and latency
+     [-k auto | scalar | sse2 | avx2 | neon | opencv ] -- YUYV->RGB code
+     [-j nthreads] -- YUYV->RGB worker threads, 0: convert on the GL thread
+     [-P npbos] -- pixel buffer objects to upload frames through
+     [-O nframes] -- no X server: draw nframes offscreen, report throughput
+     [-f capturefile] -- play back a raw capture file instead of a device
+     [-F] -- play the capture file as fast as possible, not in real time
+     [-r recordfile] -- record the frames to a capture file
+     [-B socket] -- share the frames with other processes on a frame bus
+     [-E] -- capture all the sources on one thread with epoll
+     [-M] -- draw all the sources at once, tiled in the window
+     [-Y usec] -- take frames of all the sources in sets captured
+                  within usec of each other
+     [-Q offset,jitter,drop] -- test patterns stamp frames like a
+                  camera: offset usec (times the source's number)
+                  plus up to jitter usec early, every drop'th lost
+
+     -d, -p and -f can be given up to MAX_SOURCES times between them;
+     each one is another source, run in args->sources[] order. with
+     just one, it's the only source, as it always was.
      
      return 0 on success, -1 on error
 
@@ -123,6 +158,23 @@ static struct {
      31-Dec-06               initial coding                           gpk
      20-Jan-08  remove '-o' option since it's been replaced by a menu gpk
                 option.
+     17-Oct-26  added -p, -T, -n
+     17-Oct-26  added -k
+     17-Oct-26  added -j
+     17-Oct-26  added -P
+     17-Oct-26  added -x
+     17-Oct-26  added -U, -H
+     17-Oct-26  added -b
+     17-Oct-26  added -S
+     17-Oct-26  added -J
+     17-Oct-26  added -O
+     17-Oct-26  added -f, -F
+     17-Oct-26  added -r
+     17-Oct-26  added -B
+     17-Oct-26  more than one -d, -p, -f; added -E
+     17-Oct-26  added -M
+     17-Oct-26  added -Y, -Q
+     17-Oct-26  added -L
 		
  ************************************************************************* */
 
@@ -137,6 +189,32 @@ int parse_command_line (int argc, char * argv[], Cmdargs_t *args)
   args->image_width = 320;
   args->image_height = 240;
   args->window_width = -1; //invalid
+  args->threaded_capture = 0;
+  args->headless_frames = 0;
+  args->convert_kernel = CONVERT_AUTO;
+  args->convert_threads = -1; /* one per physical core  */
+  args->pbo_count = DEFAULT_PBO_COUNT;
+  args->dmabuf_socket[0] = '\0';
+  args->userptr_io = 0;
+  args->hugepages = 0;
+  args->video_buffers = DEFAULT_VIDEO_BUFFERS;
+  args->pacing = PACE_EVENT;
+  args->trace_file[0] = '\0';
+  args->testpattern_frames = 0;
+  args->offscreen_frames = 0;
+  args->capture_file[0] = '\0';
+  args->playback_fast = 0;
+  args->record_file[0] = '\0';
+  args->framebus_socket[0] = '\0';
+  args->nsources = 0;
+  args->epoll_capture = 0;
+  args->mosaic = 0;
+  args->sync_window_usec = 0;
+  args->mock_timing = 0;
+  args->mock_offset_usec = 0;
+  args->mock_jitter_usec = 0;
+  args->mock_drop_every = 0;
+  args->flow_interval = 0;
 #ifdef  DEF_RGB
   args->encoding = RGB;
 #else
@@ -146,7 +224,7 @@ int parse_command_line (int argc, char * argv[], Cmdargs_t *args)
   unexpected = 0;
   retval = 0;
   
-  opt = getopt(argc, argv, "d:o:w:h:e:D:");
+  opt = getopt(argc, argv, "d:o:w:h:e:D:pTn:k:j:P:x:UHb:S:J:O:f:Fr:B:EMY:Q:L:");
 
   while ((-1 != opt) && (0 == unexpected))
     {
@@ -154,6 +232,192 @@ int parse_command_line (int argc, char * argv[], Cmdargs_t *args)
       case 'd':
 	strncpy(args->devicename, optarg, MAX_DEVICENAME);
 	args->source = LIVESOURCE;
+	unexpected = add_source_arg(args, LIVESOURCE, optarg);
+	break;
+
+      case 'p':
+	args->source = TESTPATTERN;
+	unexpected = add_source_arg(args, TESTPATTERN, "");
+	break;
+
+      case 'T':
+	args->threaded_capture = 1;
+	break;
+
+      case 'n':
+	args->headless_frames = atoi(optarg);
+	break;
+
+      case 'j':
+	args->convert_threads = atoi(optarg);
+	if (0 > args->convert_threads)
+	  {
+	    fprintf(stderr, "conversion threads (-j) must be 0 or more\n");
+	    unexpected = 1;
+	  }
+	break;
+
+      case 'P':
+	args->pbo_count = atoi(optarg);
+	if ((1 > args->pbo_count) || (MAX_PBOS < args->pbo_count))
+	  {
+	    fprintf(stderr, "PBO count (-P) must be 1 to %d\n", MAX_PBOS);
+	    unexpected = 1;
+	  }
+	break;
+
+      case 'x':
+	strncpy(args->dmabuf_socket, optarg, MAX_DEVICENAME - 1);
+	args->dmabuf_socket[MAX_DEVICENAME - 1] = '\0';
+	break;
+
+      case 'b':
+	args->video_buffers = atoi(optarg);
+	if ((2 > args->video_buffers) || (MAX_VIDEO_BUFFERS < args->video_buffers))
+	  {
+	    fprintf(stderr, "video buffer count (-b) must be 2 to %d\n",
+		    MAX_VIDEO_BUFFERS);
+	    unexpected = 1;
+	  }
+	break;
+
+      case 'S':
+	if (0 == strcmp("event", optarg))
+	  {
+	    args->pacing = PACE_EVENT;
+	  }
+	else if (0 == strcmp("vsync", optarg))
+	  {
+	    args->pacing = PACE_VSYNC;
+	  }
+	else if (0 == strcmp("timer", optarg))
+	  {
+	    args->pacing = PACE_TIMER;
+	  }
+	else
+	  {
+	    fprintf(stderr, "pacing (-S) option '%s' not recognized\n", optarg);
+	    fprintf(stderr, "must be event, vsync or timer\n");
+	    unexpected = 1;
+	  }
+	break;
+
+      case 'J':
+	strncpy(args->trace_file, optarg, MAX_DEVICENAME - 1);
+	args->trace_file[MAX_DEVICENAME - 1] = '\0';
+	break;
+
+      case 'O':
+	args->offscreen_frames = atoi(optarg);
+	if (1 > args->offscreen_frames)
+	  {
+	    fprintf(stderr, "offscreen frames (-O) must be at least 1\n");
+	    unexpected = 1;
+	  }
+	break;
+
+      case 'f':
+	strncpy(args->capture_file, optarg, MAX_DEVICENAME - 1);
+	args->capture_file[MAX_DEVICENAME - 1] = '\0';
+	args->source = FILESOURCE;
+	unexpected = add_source_arg(args, FILESOURCE, optarg);
+	break;
+
+      case 'F':
+	args->playback_fast = 1;
+	break;
+
+      case 'r':
+	strncpy(args->record_file, optarg, MAX_DEVICENAME - 1);
+	args->record_file[MAX_DEVICENAME - 1] = '\0';
+	break;
+
+      case 'B':
+	strncpy(args->framebus_socket, optarg, MAX_DEVICENAME - 1);
+	args->framebus_socket[MAX_DEVICENAME - 1] = '\0';
+	break;
+
+      case 'E':
+	args->epoll_capture = 1;
+	break;
+
+      case 'M':
+	args->mosaic = 1;
+	break;
+
+      case 'Y':
+	args->sync_window_usec = atoi(optarg);
+	if (1 > args->sync_window_usec)
+	  {
+	    fprintf(stderr, "sync window (-Y) must be at least 1 usec\n");
+	    unexpected = 1;
+	  }
+	break;
+
+      case 'L':
+	args->flow_interval = atoi(optarg);
+	if (0 > args->flow_interval)
+	  {
+	    fprintf(stderr, "detection interval (-L) must be 0 or more\n");
+	    unexpected = 1;
+	  }
+	break;
+
+      case 'Q':
+	if ((3 != sscanf(optarg, "%d,%d,%d", &(args->mock_offset_usec),
+			 &(args->mock_jitter_usec), &(args->mock_drop_every)))
+	    || (0 > args->mock_offset_usec) || (0 > args->mock_jitter_usec)
+	    || (0 > args->mock_drop_every))
+	  {
+	    fprintf(stderr, "mock timing (-Q) '%s' not recognized\n", optarg);
+	    fprintf(stderr, "must be offset,jitter,drop: 3 numbers >= 0\n");
+	    unexpected = 1;
+	  }
+	args->mock_timing = 1;
+	break;
+
+      case 'U':
+	args->userptr_io = 1;
+	break;
+
+      case 'H':
+	args->userptr_io = 1;
+	args->hugepages = 1;
+	break;
+
+      case 'k':
+	if (0 == strcmp("auto", optarg))
+	  {
+	    args->convert_kernel = CONVERT_AUTO;
+	  }
+	else if (0 == strcmp("scalar", optarg))
+	  {
+	    args->convert_kernel = CONVERT_SCALAR;
+	  }
+	else if (0 == strcmp("sse2", optarg))
+	  {
+	    args->convert_kernel = CONVERT_SSE2;
+	  }
+	else if (0 == strcmp("avx2", optarg))
+	  {
+	    args->convert_kernel = CONVERT_AVX2;
+	  }
+	else if (0 == strcmp("neon", optarg))
+	  {
+	    args->convert_kernel = CONVERT_NEON;
+	  }
+	else if (0 == strcmp("opencv", optarg))
+	  {
+	    args->convert_kernel = CONVERT_OPENCV;
+	  }
+	else
+	  {
+	    fprintf(stderr, "conversion (-k) option '%s' not recognized\n",
+		    optarg);
+	    fprintf(stderr,
+		    "must be auto, scalar, sse2, avx2, neon or opencv\n");
+	    unexpected = 1;
+	  }
 	break;
 
       case 'w':
@@ -216,8 +480,51 @@ int parse_command_line (int argc, char * argv[], Cmdargs_t *args)
 	fprintf(stderr, "Usage: %s %s %s\n", argv[0],
 		"[-d devicefile][-w width][-h height]",
 		"[-e  LUMA |  YUV420 |  YUV422 | RGB ] [-D index]"
+		" [-p] [-T] [-n nframes]"
+		" [-k auto | scalar | sse2 | avx2 | neon | opencv]"
+		" [-j nthreads] [-P npbos] [-x socket] [-U] [-H]"
+		" [-b nbuffers] [-S event | vsync | timer] [-J tracefile]"
+		" [-O nframes] [-f capturefile] [-F] [-r recordfile]"
+		" [-B socket] [-E] [-M] [-Y usec]"
+		" [-Q offset,jitter,drop] [-L frames]"
 		);
 fprintf(stderr, "Example: %s -d /dev/video0 -w 1280 -h 720 -D1\n", argv[0]);
+	fprintf(stderr, "   -p: use a test pattern instead of a device\n");
+	fprintf(stderr, "   -T: capture on its own thread\n");
+	fprintf(stderr, "   -n: no window; capture nframes and report cpu/latency\n");
+	fprintf(stderr, "   -k: YUYV to RGB conversion code, default auto\n");
+	fprintf(stderr, "   -j: YUYV to RGB threads, default one per core\n");
+	fprintf(stderr, "   -P: PBOs to upload through, default %d\n",
+		DEFAULT_PBO_COUNT);
+	fprintf(stderr, "   -x: share the device buffers (dmabuf) on this unix socket\n");
+	fprintf(stderr, "   -U: capture into our own buffers (V4L2 user pointer)\n");
+	fprintf(stderr, "   -H: same as -U, with the buffers in huge pages\n");
+	fprintf(stderr, "   -b: video buffers to ask the driver for, default %d\n",
+		DEFAULT_VIDEO_BUFFERS);
+	fprintf(stderr, "   -S: redraw on each new frame (event, the default), on\n");
+	fprintf(stderr, "       each new frame at vertical retrace (vsync), or\n");
+	fprintf(stderr, "       every 33 msec (timer)\n");
+	fprintf(stderr, "   -J: write a Chrome/Perfetto trace (JSON) of the run\n");
+	fprintf(stderr, "   -O: no X server; draw nframes offscreen (EGL/OSMesa)\n");
+	fprintf(stderr, "       and report the draw throughput\n");
+	fprintf(stderr, "   -f: play back a capture file instead of a device\n");
+	fprintf(stderr, "   -F: play it as fast as the display takes frames,\n");
+	fprintf(stderr, "       not at the recorded timestamps\n");
+	fprintf(stderr, "   -r: record the frames to a capture file (for -f)\n");
+	fprintf(stderr, "   -B: share the frames on a frame bus at this socket\n");
+	fprintf(stderr, "   -E: capture every source on one thread (epoll)\n");
+	fprintf(stderr, "   -M: draw every source at once, tiled ('m' toggles)\n");
+	fprintf(stderr, "   -Y: take the sources' frames in sets captured within\n");
+	fprintf(stderr, "       usec of each other (stereo rigs)\n");
+	fprintf(stderr, "   -Q: test patterns stamp frames offset usec (times\n");
+	fprintf(stderr, "       the source's number) plus up to jitter usec\n");
+	fprintf(stderr, "       before they're published, lose every drop'th\n");
+	fprintf(stderr, "   -L: the tracker ('t') detects features every frames'th\n");
+	fprintf(stderr, "       frame and follows them by optical flow between\n");
+	fprintf(stderr, "   -d, -p and -f can each be given more than once,\n");
+	fprintf(stderr, "   up to %d sources in all; the second one's -x, -r\n",
+		MAX_SOURCES);
+	fprintf(stderr, "   and -B files get .1 on the end, and so on\n");
 	fprintf(stderr, "   index 0: default window dimension, as that of image\n");
 	for( i=1; i<SZ_DIM; ++i ) 
 		fprintf(stderr, "       %d: %dx%d\n",\
@@ -226,7 +533,7 @@ fprintf(stderr, "Example: %s -d /dev/video0 -w 1280 -h 720 -D1\n", argv[0]);
 	retval = -1;
 	break;
       }
-      opt = getopt(argc, argv, "d:o:w:h:e:D:");
+      opt = getopt(argc, argv, "d:o:w:h:e:D:pTn:k:j:P:x:UHb:S:J:O:f:Fr:B:EMY:Q:L:");
     }
 
   if (1 == unexpected)
@@ -239,3 +546,67 @@ fprintf(stderr, "Example: %s -d /dev/video0 -w 1280 -h 720 -D1\n", argv[0]);
   }
   return(retval);
 }
+
+
+
+/* *************************************************************************
+
+
+   NAME:  add_source_arg
+
+
+   USAGE:
+
+   int some_int;
+   Cmdargs_t * args;
+
+   some_int =  add_source_arg(args, LIVESOURCE, "/dev/video1");
+
+   returns: int
+
+   DESCRIPTION:
+                 add a source to the end of args->sources[]. name is
+		 the device or capture file, "" for a test pattern.
+
+		 return 0 if all's well
+		        1 (and complain) if there are MAX_SOURCES already
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int add_source_arg(Cmdargs_t * args, Inputsource_t source,
+		   const char * name)
+{
+  Sourcearg_t * sourcearg;
+
+  if (MAX_SOURCES <= args->nsources)
+    {
+      fprintf(stderr, "Error: at most %d sources (-d, -p, -f)\n",
+	      MAX_SOURCES);
+      return(1);
+    }
+
+  sourcearg = &(args->sources[args->nsources++]);
+  sourcearg->source = source;
+  strncpy(sourcearg->name, name, MAX_DEVICENAME - 1);
+  sourcearg->name[MAX_DEVICENAME - 1] = '\0';
+
+  return(0);
+}
@@ -0,0 +1,687 @@
+/* *************************************************************************
+* NAME: glutcam/pboring.c
+*
+* DESCRIPTION:
+*
+* upload frames to a texture through a ring of pixel buffer objects.
+*
+* with one PBO, glMapBuffer stalls until the GPU has finished reading
+* the last frame out of it. with several we fill the next one while
+* the GPU is still busy with the last. before reusing a PBO we either
+*
+*  - wait on the fence we put after its last upload, then map it
+*    unsynchronized (GL_ARB_sync and GL_ARB_map_buffer_range), or
+*  - orphan it with glBufferData(NULL) so the driver hands us fresh
+*    storage and frees the old when the GPU is done with it.
+*
+* if a fence isn't signalled within PBO_FENCE_TIMEOUT_NSEC (or the
+* wait fails) the PBO is orphaned instead, for that frame: it's never
+* written while the GPU may still be reading it.
+*
+* report_pbo_timing prints how long, per frame, we waited to map, had
+* the buffer mapped (filling it), and spent issuing glTexSubImage2D,
+* when asked (the 's' key, with the stage latencies).
+*
+* PROCESS:
+*
+* see pboring.h
+*
+* GLOBALS: none
+*
+* REFERENCES: GL_ARB_pixel_buffer_object, GL_ARB_sync,
+*             GL_ARB_map_buffer_range
+*
+* LIMITATIONS:
+*
+* uses GL_PIXEL_UNPACK_BUFFER_ARB: call from the thread that owns the
+* GL context.
+*
+* REVISION HISTORY:
+*
+*   STR                Description                          Author
+*
+*   17-Oct-26          initial coding
+*   17-Oct-26          upload_through_pbo for frames already in memory
+*   17-Oct-26          record map, fill and upload stage latencies
+*   17-Oct-26          upload_tiles_through_pbo: several sources' frames
+*                      through one map
+*   17-Oct-26          orphan on a fence timeout; report timing only
+*                      when asked
+*
+* TARGET: Linux C, OpenGL
+*
+* This software is in the public domain. if it breaks you get to keep
+* both pieces.
+*
+* ************************************************************************* */
+
+#include <stdio.h>
+#include <string.h> /* memset, memcpy  */
+
+#include <GL/glew.h>
+
+#include "glutcam.h"
+#include "timeutil.h"
+#include "stagestats.h"
+#include "pboring.h"
+
+/* PBO_FENCE_TIMEOUT_NSEC - longest we'll wait for the GPU to finish  */
+/* with a PBO before giving up and orphaning it instead.               */
+
+#define PBO_FENCE_TIMEOUT_NSEC 1000000000ULL
+
+
+
+/* *************************************************************************
+
+
+   NAME:  init_pboring
+
+
+   USAGE:
+
+   int some_int;
+   Pboring_t ring;
+   int count;
+   size_t size;
+
+   some_int =  init_pboring(&ring, count, size);
+
+   if (0 == some_int)
+   -- we're okay
+   else
+   -- handle an error
+
+   returns: int
+
+   DESCRIPTION:
+                 create count (1...MAX_PBOS) pixel buffer objects of
+		 size bytes each and decide whether to guard them with
+		 fences or orphan them.
+
+		 return 0 if all's well
+		       -1 on error
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   needs a current GL context and glewInit() already called
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int init_pboring(Pboring_t * ring, int count, size_t size)
+{
+  int i;
+
+  memset(ring, 0, sizeof(*ring));
+
+  if (count < 1)
+    {
+      count = 1;
+    }
+  else if (count > MAX_PBOS)
+    {
+      fprintf(stderr, "Warning: using %d PBOs, not %d\n", MAX_PBOS, count);
+      count = MAX_PBOS;
+    }
+
+  ring->count = count;
+  ring->size = size;
+  ring->current = count - 1; /* so the first map_pbo uses ids[0]  */
+  ring->use_fences = (glewIsSupported("GL_ARB_sync")
+		      && glewIsSupported("GL_ARB_map_buffer_range"));
+
+  glGenBuffersARB(count, ring->ids);
+  for (i = 0; i < count; i++)
+    {
+      glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, ring->ids[i]);
+      glBufferDataARB(GL_PIXEL_UNPACK_BUFFER_ARB, (GLsizeiptrARB)size, NULL,
+		      GL_STREAM_DRAW_ARB);
+    }
+  glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+
+  if (GL_NO_ERROR != glGetError())
+    {
+      fprintf(stderr, "Error: unable to create %d pixel buffer objects\n",
+	      count);
+      fini_pboring(ring);
+      return(-1);
+    }
+
+  fprintf(stderr, "uploading through %d PBO%s, %s\n", count,
+	  (1 == count) ? "" : "s",
+	  ring->use_fences ? "fenced" : "orphaned");
+
+  return(0);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  fini_pboring
+
+
+   USAGE:
+
+   Pboring_t ring;
+
+   fini_pboring(&ring);
+
+   returns: void
+
+   DESCRIPTION:
+                 delete the fences and pixel buffer objects in ring
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void fini_pboring(Pboring_t * ring)
+{
+  int i;
+
+  for (i = 0; i < ring->count; i++)
+    {
+      if (NULL != ring->fences[i])
+	{
+	  glDeleteSync(ring->fences[i]);
+	  ring->fences[i] = NULL;
+	}
+    }
+
+  if (0 < ring->count)
+    {
+      glDeleteBuffersARB(ring->count, ring->ids);
+    }
+
+  ring->count = 0;
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  map_pbo
+
+
+   USAGE:
+
+   void * ptr;
+   Pboring_t ring;
+
+   ptr =  map_pbo(&ring);
+
+   returns: void *
+
+   DESCRIPTION:
+                 move on to the next PBO in ring, bind it as the
+		 GL_PIXEL_UNPACK_BUFFER_ARB, make sure the GPU is done
+		 with it (fence or orphan) and map it for writing.
+		 a fence that times out or fails gets the PBO
+		 orphaned, as if we weren't using fences.
+
+		 return where to write the frame, or NULL if the map
+		 failed. the PBO stays bound either way.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+     17-Oct-26  add the time to the stage histograms
+     17-Oct-26  orphan if the fence wait times out or fails
+
+ ************************************************************************* */
+
+void * map_pbo(Pboring_t * ring)
+{
+  GLsync fence;
+  GLenum status;
+  void * ptr;
+  long long now;
+  int orphan;
+
+  ring->current = (ring->current + 1) % ring->count;
+  ring->mark_usec = monotonic_usec();
+
+  glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, ring->ids[ring->current]);
+
+  orphan = !ring->use_fences;
+  if (ring->use_fences)
+    {
+      fence = ring->fences[ring->current];
+      if (NULL != fence)
+	{
+	  status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+				    PBO_FENCE_TIMEOUT_NSEC);
+	  glDeleteSync(fence);
+	  ring->fences[ring->current] = NULL;
+	  /* GL_TIMEOUT_EXPIRED, GL_WAIT_FAILED: the GPU may still be  */
+	  /* reading it, so an unsynchronized map could write under it  */
+	  orphan = ((GL_ALREADY_SIGNALED != status)
+		    && (GL_CONDITION_SATISFIED != status));
+	}
+    }
+
+  if (0 == orphan)
+    {
+      ptr = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER_ARB, 0,
+			     (GLsizeiptr)ring->size,
+			     GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    }
+  else
+    {
+      /* orphan: the GPU keeps the old storage until it's done with it  */
+      glBufferDataARB(GL_PIXEL_UNPACK_BUFFER_ARB, (GLsizeiptrARB)ring->size,
+		      NULL, GL_STREAM_DRAW_ARB);
+      ptr = glMapBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, GL_WRITE_ONLY_ARB);
+    }
+
+  ring->mapped = (NULL != ptr);
+  now = record_stage_since(STAGE_PBO_MAP, ring->mark_usec);
+  ring->map_usec += now - ring->mark_usec;
+  ring->mark_usec = now;
+
+  return(ptr);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  unmap_pbo
+
+
+   USAGE:
+
+   Pboring_t ring;
+
+   unmap_pbo(&ring);
+
+   returns: void
+
+   DESCRIPTION:
+                 unmap the PBO map_pbo mapped, once it's filled. it
+		 stays bound for glTexSubImage2D.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+     17-Oct-26  add the time to the stage histograms
+
+ ************************************************************************* */
+
+void unmap_pbo(Pboring_t * ring)
+{
+  long long now;
+
+  if (ring->mapped)
+    {
+      glUnmapBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB);
+      ring->mapped = 0;
+    }
+
+  now = record_stage_since(STAGE_PBO_FILL, ring->mark_usec);
+  ring->fill_usec += now - ring->mark_usec;
+  ring->mark_usec = now;
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  finish_pbo_upload
+
+
+   USAGE:
+
+   Pboring_t ring;
+
+   glTexSubImage2D(..., 0);
+   finish_pbo_upload(&ring);
+
+   returns: void
+
+   DESCRIPTION:
+                 call after the glTexSubImage2D that reads from the
+		 current PBO: put a fence after it (if we're using
+		 fences) so map_pbo knows when the PBO is free again,
+		 unbind it, and count the frame for report_pbo_timing.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+     17-Oct-26  add the time to the stage histograms
+
+ ************************************************************************* */
+
+void finish_pbo_upload(Pboring_t * ring)
+{
+  if (ring->use_fences)
+    {
+      ring->fences[ring->current] =
+	glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+  glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+
+  ring->upload_usec += record_stage_since(STAGE_UPLOAD, ring->mark_usec)
+    - ring->mark_usec;
+  ring->frames++;
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  upload_through_pbo
+
+
+   USAGE:
+
+   Pboring_t ring;
+
+   glActiveTexture(GL_TEXTURE0);
+   upload_through_pbo(&ring, data, nbytes, width, height, pixelformat);
+
+   returns: void
+
+   DESCRIPTION:
+                 copy nbytes of pixels from data into the next PBO in
+		 ring and start an upload of a width x height
+		 pixelformat image from it into the texture bound to
+		 the active texture unit.
+
+		 glTexSubImage2D from client memory has to copy the
+		 data before it returns; from a PBO it just queues the
+		 transfer, so we only wait on the memcpy.
+
+		 if the PBO won't map, upload straight from data.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   nbytes is clipped to the size of the PBOs
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void upload_through_pbo(Pboring_t * ring, const void * data, size_t nbytes,
+			int width, int height, GLenum pixelformat)
+{
+  void * ptr;
+
+  ptr = map_pbo(ring);
+  if (NULL != ptr)
+    {
+      memcpy(ptr, data, (nbytes < ring->size) ? nbytes : ring->size);
+      unmap_pbo(ring);
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, pixelformat,
+		      GL_UNSIGNED_BYTE, 0);
+    }
+  else
+    {
+      glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, pixelformat,
+		      GL_UNSIGNED_BYTE, data);
+    }
+
+  finish_pbo_upload(ring);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  upload_tiles_through_pbo
+
+
+   USAGE:
+
+   Pboring_t ring;
+   const void * data[MAX_SOURCES];  -- NULL: no new frame for that tile
+
+   glActiveTexture(GL_TEXTURE0);
+   upload_tiles_through_pbo(&ring, data, ntiles, tile_bytes, width,
+                            height, tile_height, pixelformat);
+
+   returns: void
+
+   DESCRIPTION:
+                 the texture bound to the active texture unit holds
+		 ntiles width x height images one above the other,
+		 tile i starting at row i * tile_height. copy the
+		 tile_bytes of each one that has new data into its
+		 part of the next PBO in ring and upload it from
+		 there to its tile.
+
+		 the PBO is mapped, fenced and counted once however
+		 many tiles there are, so the cost per frame doesn't
+		 grow with the number of sources beyond the memcpy
+		 and one glTexSubImage2D each. tiles with no new
+		 frame are left as they were.
+
+		 if the PBO won't map, upload straight from data.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   the ring's PBOs have to hold ntiles * tile_bytes; tiles that
+   don't fit are skipped.
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void upload_tiles_through_pbo(Pboring_t * ring, const void * const data[],
+			      int ntiles, size_t tile_bytes, int width,
+			      int height, int tile_height,
+			      GLenum pixelformat)
+{
+  char * ptr;
+  int i;
+
+  ptr = (char *)map_pbo(ring);
+  if (NULL != ptr)
+    {
+      for (i = 0; (i < ntiles) && ((i + 1) * tile_bytes <= ring->size); i++)
+	{
+	  if (NULL != data[i])
+	    {
+	      memcpy(ptr + i * tile_bytes, data[i], tile_bytes);
+	    }
+	}
+      unmap_pbo(ring);
+      for (i = 0; (i < ntiles) && ((i + 1) * tile_bytes <= ring->size); i++)
+	{
+	  if (NULL != data[i])
+	    {
+	      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, i * tile_height, width,
+			      height, pixelformat, GL_UNSIGNED_BYTE,
+			      (const GLvoid *)(i * tile_bytes));
+	    }
+	}
+    }
+  else
+    {
+      glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+      for (i = 0; i < ntiles; i++)
+	{
+	  if (NULL != data[i])
+	    {
+	      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, i * tile_height, width,
+			      height, pixelformat, GL_UNSIGNED_BYTE, data[i]);
+	    }
+	}
+    }
+
+  finish_pbo_upload(ring);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  report_pbo_timing
+
+
+   USAGE:
+
+   report_pbo_timing(&ring, stderr);
+
+   returns: void
+
+   DESCRIPTION:
+                 print the average map wait, fill and upload times
+		 per frame since the last report to fp, and start
+		 over. nothing if there's been no upload since.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+     17-Oct-26  only when asked: to fp, not every 300 frames
+
+ ************************************************************************* */
+
+void report_pbo_timing(Pboring_t * ring, FILE * fp)
+{
+  double nframes;
+
+  if (0 >= ring->frames)
+    {
+      return;
+    }
+  nframes = (double)ring->frames;
+
+  fprintf(fp, "pbo x%d %s: map wait %.3f fill %.3f upload %.3f"
+	  " msec/frame\n", ring->count,
+	  ring->use_fences ? "fenced" : "orphaned",
+	  ring->map_usec / 1000.0 / nframes,
+	  ring->fill_usec / 1000.0 / nframes,
+	  ring->upload_usec / 1000.0 / nframes);
+
+  ring->map_usec = 0;
+  ring->fill_usec = 0;
+  ring->upload_usec = 0;
+  ring->frames = 0;
+}
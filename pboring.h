@@ -0,0 +1,83 @@
+/* *************************************************************************
+* NAME: glutcam/pboring.h
+*
+* DESCRIPTION:
+*
+* this is the header file for the functions exported from pboring.c
+*
+* PROCESS:
+*
+* init_pboring creates the pixel buffer objects in a Pboring_t (see
+*   glutcam.h); fini_pboring deletes them
+*
+* each frame:
+*   ptr = map_pbo(&ring);            -- binds the next PBO, maps it
+*   if (NULL != ptr)
+*     {
+*       fill ptr
+*       unmap_pbo(&ring);
+*     }
+*   glTexSubImage2D(..., 0);          -- from the bound PBO
+*   finish_pbo_upload(&ring);         -- fence it, unbind
+*
+* upload_through_pbo does all of that for a frame (or plane) that's
+*   already in memory somewhere: it copies it into the next PBO
+*
+* upload_tiles_through_pbo does it for several sources' frames at once,
+*   each into its own tile of a texture they're stacked up in
+*
+* report_pbo_timing prints the map, fill and upload times per frame
+*   since it was last called
+*
+* GLOBALS: none
+*
+* REFERENCES:
+*
+* LIMITATIONS:
+*
+* REVISION HISTORY:
+*
+*   STR                Description                          Author
+*
+*   17-Oct-26          initial coding
+*   17-Oct-26          upload_through_pbo
+*   17-Oct-26          upload_tiles_through_pbo
+*   17-Oct-26          report_pbo_timing exported
+*
+* TARGET: Linux C, OpenGL
+*
+* This software is in the public domain. if it breaks you get to keep
+* both pieces.
+*
+* ************************************************************************* */
+
+#ifndef	__PBORING_H__
+#define	__PBORING_H__
+
+#include <stdio.h> /* FILE  */
+
+#include "glutcam.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+extern int init_pboring(Pboring_t * ring, int count, size_t size);
+extern void fini_pboring(Pboring_t * ring);
+extern void * map_pbo(Pboring_t * ring);
+extern void unmap_pbo(Pboring_t * ring);
+extern void finish_pbo_upload(Pboring_t * ring);
+extern void upload_through_pbo(Pboring_t * ring, const void * data,
+			       size_t nbytes, int width, int height,
+			       GLenum pixelformat);
+extern void upload_tiles_through_pbo(Pboring_t * ring,
+				     const void * const data[], int ntiles,
+				     size_t tile_bytes, int width, int height,
+				     int tile_height, GLenum pixelformat);
+extern void report_pbo_timing(Pboring_t * ring, FILE * fp);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	//__PBORING_H__
@@ -0,0 +1,965 @@
+/* *************************************************************************
+* NAME: glutcam/recorder.c
+*
+* DESCRIPTION:
+*
+* record the captured frames to a raw capture file (-r), the format
+* capfile.c plays back: a header, the frames' raw pixels, and an
+* index giving each frame's offset, length, capture time and the
+* driver's sequence number.
+*
+* 1080p YUYV at 60 fps is 250MB/s, and a disk that usually keeps up
+* can still stall for tens of milliseconds. so nothing here writes on
+* the capture side: record_video_frame copies the frame into one of
+* RECORDER_BUFFERS aligned buffers and returns, and the buffer goes
+* back to the driver as usual. a writer thread writes the copies out,
+* several to a pwritev, at increasing offsets in the file. if the
+* writer falls RECORDER_BUFFERS frames behind, new frames are dropped
+* (and counted) rather than holding up capture.
+*
+* the file is opened O_DIRECT where the file system allows it, so
+* the frames don't push everything else out of the page cache and
+* writeback doesn't arrive in bursts. for that every frame starts on
+* a RECORDER_ALIGN boundary and is padded out to one; the index has
+* the real length. disk space is reserved RECORDER_PREALLOCATE at a
+* time with fallocate so the file system isn't allocating blocks in
+* the middle of each write.
+*
+* the header's written with nframes 0 when recording starts; the
+* index is appended and the header filled in when it stops.
+*
+* PROCESS:
+*
+* see recorder.h
+*
+* GLOBALS: none
+*
+* REFERENCES: open(2) (O_DIRECT), pwritev(2), fallocate(2)
+*
+* LIMITATIONS:
+*
+* a recording cut off before stop_recorder (a crash) has frames but
+* no index, so it can't be played back.
+*
+* REVISION HISTORY:
+*
+*   STR                Description                          Author
+*
+*   17-Oct-26          initial coding
+*
+* TARGET: Linux C, pthreads
+*
+* This software is in the public domain. if it breaks you get to keep
+* both pieces.
+*
+* ************************************************************************* */
+
+#define _GNU_SOURCE /* O_DIRECT, fallocate  */
+
+#include <stdio.h>
+#include <stdlib.h> /* posix_memalign, realloc, free  */
+#include <string.h> /* memcpy, memset, strerror  */
+#include <errno.h>
+#include <fcntl.h> /* open, fallocate, fcntl  */
+#include <unistd.h> /* pwrite, ftruncate, fdatasync, close  */
+#include <pthread.h>
+#include <sys/uio.h> /* pwritev  */
+#include <sys/eventfd.h> /* eventfd  */
+
+#include "glutcam.h"
+#include "timeutil.h" /* monotonic_usec  */
+#include "stagestats.h" /* record_stage_since  */
+#include "trace.h" /* trace_thread_name, trace_begin, trace_end  */
+#include "recorder.h"
+
+/* RECORDER_INDEX_START - index entries to allocate at first; the  */
+/* index doubles when it fills  */
+
+#define RECORDER_INDEX_START 1024
+
+/* local prototypes  */
+void * recorder_thread_main(void * arg);
+void write_recorded_frames(Recorder_t * recorder);
+int add_recorder_index(Recorder_t * recorder, const Recorderslot_t * slot,
+		       uint64_t offset);
+void reserve_recorder_space(Recorder_t * recorder, uint64_t end);
+int write_recorder_header(Recorder_t * recorder, uint64_t index_offset);
+int finish_recording(Recorder_t * recorder);
+void close_recorder(Recorder_t * recorder);
+/* end local prototypes  */
+
+
+
+/* *************************************************************************
+
+
+   NAME:  start_recorder
+
+
+   USAGE:
+
+   int some_int;
+   Sourceparams_t * sourceparams;
+
+   -- after the source is set up, before frames are captured
+   some_int =  start_recorder(sourceparams);
+
+   if (0 == some_int)
+   -- every frame published from now on gets recorded
+   else
+   -- the file couldn't be created, and we've said why
+
+   returns: int
+
+   DESCRIPTION:
+                 create sourceparams->recorder.path, write a header
+		 for frames the size and encoding of the source's,
+		 set aside the buffers frames are copied into and
+		 start the writer thread.
+
+		 the buffers are touched here so the first frames
+		 don't take page faults on the capture side.
+
+		 return 0 on success
+		       -1 (and say why) on error
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   file systems without O_DIRECT (tmpfs, some network file systems)
+   get written through the page cache.
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int start_recorder(Sourceparams_t * sourceparams)
+{
+  Recorder_t * recorder;
+  int status;
+
+  recorder = &(sourceparams->recorder);
+  recorder->fd = -1;
+  recorder->wake_fd = -1;
+  recorder->pool = NULL;
+  recorder->index = NULL;
+
+  if (0 == sourceparams->captured.length)
+    {
+      fprintf(stderr, "Error: no frame size to record\n");
+      return(-1);
+    }
+
+  recorder->slot_bytes = (sourceparams->captured.length + RECORDER_ALIGN - 1) &
+    ~((size_t)RECORDER_ALIGN - 1);
+  recorder->width = (uint32_t)sourceparams->image_width;
+  recorder->height = (uint32_t)sourceparams->image_height;
+#ifdef	DEF_RGB
+  recorder->encoding = YUV422; /* what the device gives process()  */
+#else
+  recorder->encoding = (uint32_t)sourceparams->encoding;
+#endif
+
+  recorder->direct = 1;
+  recorder->fd = open(recorder->path,
+		      O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT | O_CLOEXEC, 0644);
+  if ((-1 == recorder->fd) && (EINVAL == errno))
+    {
+      recorder->direct = 0;
+      recorder->fd = open(recorder->path,
+			  O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    }
+  if (-1 == recorder->fd)
+    {
+      perror(recorder->path);
+      return(-1);
+    }
+
+  status = posix_memalign((void **)&(recorder->pool), RECORDER_ALIGN,
+			  RECORDER_BUFFERS * recorder->slot_bytes);
+  recorder->index_capacity = RECORDER_INDEX_START;
+  recorder->index = (Capfileindex_t *)malloc(recorder->index_capacity *
+					     sizeof(Capfileindex_t));
+  recorder->wake_fd = eventfd(0, EFD_CLOEXEC);
+
+  if ((0 != status) || (NULL == recorder->index) || (-1 == recorder->wake_fd))
+    {
+      fprintf(stderr, "Error: unable to set up the recorder\n");
+      if (0 != status)
+	{
+	  recorder->pool = NULL;
+	}
+      close_recorder(recorder);
+      return(-1);
+    }
+  memset(recorder->pool, 0, RECORDER_BUFFERS * recorder->slot_bytes);
+
+  recorder->head = 0;
+  recorder->tail = 0;
+  recorder->nframes = 0;
+  recorder->dropped = 0;
+  recorder->max_backlog = 0;
+  recorder->failed = 0;
+  recorder->preallocate = 1;
+  recorder->allocated = 0;
+  recorder->write_offset = RECORDER_ALIGN; /* the header's block  */
+
+  reserve_recorder_space(recorder, RECORDER_ALIGN);
+  if (-1 == write_recorder_header(recorder, 0))
+    {
+      close_recorder(recorder);
+      return(-1);
+    }
+
+  recorder->start_usec = monotonic_usec();
+  __atomic_store_n(&(recorder->running), 1, __ATOMIC_RELEASE);
+
+  status = pthread_create(&(recorder->thread), NULL, recorder_thread_main,
+			  recorder);
+  if (0 != status)
+    {
+      fprintf(stderr, "Error: unable to start recorder thread (%d)\n", status);
+      recorder->running = 0;
+      close_recorder(recorder);
+      return(-1);
+    }
+
+  fprintf(stderr, "recording to %s%s: %dx%d, %u buffers of %lu bytes\n",
+	  recorder->path, (0 != recorder->direct) ? " (O_DIRECT)" : "",
+	  sourceparams->image_width, sourceparams->image_height,
+	  RECORDER_BUFFERS, (unsigned long)recorder->slot_bytes);
+
+  return(0);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  record_video_frame
+
+
+   USAGE:
+
+   Sourceparams_t * sourceparams;
+   Frameslot_t slot;
+
+   -- in publish_video_frame, before the frame goes to the display
+   record_video_frame(sourceparams, &slot);
+
+   returns: void
+
+   DESCRIPTION:
+                 if we're recording, copy the frame in slot into the
+		 next free recorder buffer and wake the writer. the
+		 frame's buffer is ours to give back as soon as this
+		 returns.
+
+		 if the writer is RECORDER_BUFFERS frames behind
+		 (or a write failed), count the frame as dropped
+		 instead.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   call this only from the producer (idle function or capture thread)
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void record_video_frame(Sourceparams_t * sourceparams,
+			const Frameslot_t * slot)
+{
+  Recorder_t * recorder;
+  Recorderslot_t * copy;
+  unsigned int head, tail, backlog;
+  uint64_t one;
+
+  recorder = &(sourceparams->recorder);
+
+  if (0 == __atomic_load_n(&(recorder->running), __ATOMIC_RELAXED))
+    {
+      return;
+    }
+
+  head = recorder->head; /* only we write it  */
+  tail = __atomic_load_n(&(recorder->tail), __ATOMIC_ACQUIRE);
+
+  if ((RECORDER_BUFFERS == head - tail)
+      || (recorder->slot_bytes < slot->length)
+      || (0 != __atomic_load_n(&(recorder->failed), __ATOMIC_RELAXED)))
+    {
+      __atomic_fetch_add(&(recorder->dropped), 1, __ATOMIC_RELAXED);
+      return;
+    }
+
+  backlog = head - tail + 1;
+  if (recorder->max_backlog < backlog)
+    {
+      recorder->max_backlog = backlog;
+    }
+
+  memcpy(recorder->pool + (head & RECORDER_MASK) * recorder->slot_bytes,
+	 slot->start, slot->length);
+  copy = &(recorder->slots[head & RECORDER_MASK]);
+  copy->capture_usec = slot->capture_usec;
+  copy->sequence = slot->sequence;
+  copy->length = (unsigned int)slot->length;
+  copy->queued_usec = monotonic_usec();
+
+  /* the copy must land before the writer sees head move  */
+  __atomic_store_n(&(recorder->head), head + 1, __ATOMIC_RELEASE);
+
+  one = 1;
+  (void)write(recorder->wake_fd, &one, sizeof(one));
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  stop_recorder
+
+
+   USAGE:
+
+   Sourceparams_t * sourceparams;
+
+   -- once nothing can call record_video_frame any more
+   stop_recorder(sourceparams);
+
+   returns: void
+
+   DESCRIPTION:
+                 let the writer finish the frames it has, then write
+		 the index and fill in the header so the file can be
+		 played back. report how much was written, how fast,
+		 how far behind the writer got and how many frames
+		 it dropped.
+
+		 does nothing if we aren't recording.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void stop_recorder(Sourceparams_t * sourceparams)
+{
+  Recorder_t * recorder;
+  uint64_t one, bytes;
+  double seconds;
+
+  recorder = &(sourceparams->recorder);
+
+  if (0 == __atomic_exchange_n(&(recorder->running), 0, __ATOMIC_ACQ_REL))
+    {
+      return;
+    }
+
+  one = 1;
+  (void)write(recorder->wake_fd, &one, sizeof(one));
+  pthread_join(recorder->thread, NULL);
+
+  seconds = (monotonic_usec() - recorder->start_usec) / 1e6;
+  bytes = recorder->write_offset - RECORDER_ALIGN;
+
+  if (-1 == finish_recording(recorder))
+    {
+      fprintf(stderr, "Error: %s can't be played back\n", recorder->path);
+    }
+
+  fprintf(stderr, "recorded %u frames (%.1f MB) to %s in %.2f sec: "
+	  "%.1f MB/s\n", recorder->nframes, bytes / 1e6, recorder->path,
+	  seconds, (0 < seconds) ? bytes / 1e6 / seconds : 0.0);
+  fprintf(stderr, "recorder: %u frames dropped, deepest backlog %u of %d "
+	  "buffers\n", recorder->dropped, recorder->max_backlog,
+	  RECORDER_BUFFERS);
+
+  close_recorder(recorder);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  recorder_thread_main
+
+
+   USAGE:
+
+   pthread_create(&thread, NULL, recorder_thread_main, recorder);
+
+   returns: void *
+
+   DESCRIPTION:
+                 the body of the writer thread: sleep on
+		 recorder->wake_fd until frames are queued, write them
+		 all. once recorder->running is cleared, write what's
+		 left and quit.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void * recorder_thread_main(void * arg)
+{
+  Recorder_t * recorder;
+  uint64_t count;
+  int running;
+
+  recorder = (Recorder_t *)arg;
+  trace_thread_name("recorder");
+
+  do
+    {
+      (void)read(recorder->wake_fd, &count, sizeof(count));
+      running = __atomic_load_n(&(recorder->running), __ATOMIC_ACQUIRE);
+      write_recorded_frames(recorder);
+    }
+  while (0 != running);
+
+  return(NULL);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  write_recorded_frames
+
+
+   USAGE:
+
+   Recorder_t * recorder;
+
+   write_recorded_frames(recorder);
+
+   returns: void
+
+   DESCRIPTION:
+                 write every frame queued in recorder->slots to the
+		 file, up to RECORDER_BATCH of them at a time in one
+		 pwritev, index them, and give their buffers back to
+		 the capture side.
+
+		 each frame's time from being copied to being written
+		 goes in the STAGE_RECORD histogram.
+
+		 after a failed write, set recorder->failed and
+		 throw away (count as dropped) whatever comes in.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   call this only from the writer thread
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void write_recorded_frames(Recorder_t * recorder)
+{
+  struct iovec iov[RECORDER_BATCH];
+  unsigned int head, tail, nframes, i, slot;
+  ssize_t written;
+  size_t wanted;
+  long long start_usec;
+
+  tail = recorder->tail; /* only we write it  */
+  head = __atomic_load_n(&(recorder->head), __ATOMIC_ACQUIRE);
+
+  while (tail != head)
+    {
+      nframes = head - tail;
+      if (RECORDER_BATCH < nframes)
+	{
+	  nframes = RECORDER_BATCH;
+	}
+
+      if (0 != recorder->failed)
+	{
+	  __atomic_fetch_add(&(recorder->dropped), nframes, __ATOMIC_RELAXED);
+	}
+      else
+	{
+	  /* the buffers wrap around the pool but their places in  */
+	  /* the file don't: one write covers them all  */
+	  for (i = 0; i < nframes; i++)
+	    {
+	      slot = (tail + i) & RECORDER_MASK;
+	      iov[i].iov_base = recorder->pool + slot * recorder->slot_bytes;
+	      iov[i].iov_len = recorder->slot_bytes;
+	    }
+	  wanted = nframes * recorder->slot_bytes;
+	  reserve_recorder_space(recorder, recorder->write_offset + wanted);
+
+	  start_usec = trace_begin();
+	  written = pwritev(recorder->fd, iov, (int)nframes,
+			    (off_t)recorder->write_offset);
+	  trace_end("disk write", start_usec);
+
+	  if ((ssize_t)wanted != written)
+	    {
+	      fprintf(stderr, "Error writing %s: %s\n", recorder->path,
+		      (-1 == written) ? strerror(errno) : "disk full?");
+	      __atomic_store_n(&(recorder->failed), 1, __ATOMIC_RELAXED);
+	      __atomic_fetch_add(&(recorder->dropped), nframes,
+				 __ATOMIC_RELAXED);
+	    }
+	  else
+	    {
+	      for (i = 0; i < nframes; i++)
+		{
+		  slot = (tail + i) & RECORDER_MASK;
+		  (void)add_recorder_index(recorder, &(recorder->slots[slot]),
+					   recorder->write_offset +
+					   i * recorder->slot_bytes);
+		  (void)record_stage_since(STAGE_RECORD,
+					   recorder->slots[slot].queued_usec);
+		}
+	      recorder->write_offset += wanted;
+	    }
+	}
+
+      tail += nframes;
+      /* we're done with the buffers before the producer reuses them  */
+      __atomic_store_n(&(recorder->tail), tail, __ATOMIC_RELEASE);
+      head = __atomic_load_n(&(recorder->head), __ATOMIC_ACQUIRE);
+    }
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  add_recorder_index
+
+
+   USAGE:
+
+   int some_int;
+   Recorder_t * recorder;
+   Recorderslot_t * slot;
+   uint64_t offset;
+
+   some_int =  add_recorder_index(recorder, slot, offset);
+
+   returns: int
+
+   DESCRIPTION:
+                 add an index entry for the frame described by slot,
+		 written at offset. double the index if it's full.
+
+		 return 0 on success
+		       -1 if there's no memory for a bigger index (and
+		          the recording is marked failed)
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int add_recorder_index(Recorder_t * recorder, const Recorderslot_t * slot,
+		       uint64_t offset)
+{
+  Capfileindex_t * bigger;
+  Capfileindex_t * entry;
+
+  if (recorder->index_capacity == recorder->nframes)
+    {
+      bigger = (Capfileindex_t *)realloc(recorder->index,
+					 2 * recorder->index_capacity *
+					 sizeof(Capfileindex_t));
+      if (NULL == bigger)
+	{
+	  fprintf(stderr, "Error: no memory for the recording's index\n");
+	  __atomic_store_n(&(recorder->failed), 1, __ATOMIC_RELAXED);
+	  return(-1);
+	}
+      recorder->index = bigger;
+      recorder->index_capacity *= 2;
+    }
+
+  entry = &(recorder->index[recorder->nframes++]);
+  entry->offset = offset;
+  entry->timestamp_usec = slot->capture_usec;
+  entry->length = slot->length;
+  entry->sequence = slot->sequence;
+
+  return(0);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  reserve_recorder_space
+
+
+   USAGE:
+
+   Recorder_t * recorder;
+   uint64_t end;
+
+   reserve_recorder_space(recorder, recorder->write_offset + nbytes);
+
+   returns: void
+
+   DESCRIPTION:
+                 make sure the file has disk space reserved up to end,
+		 taking it RECORDER_PREALLOCATE at a time.
+
+		 a file system without fallocate just allocates as
+		 we write: stop asking.
+
+   REFERENCES: fallocate(2)
+
+   LIMITATIONS:
+
+   the reserved space past the last frame is given back when
+   finish_recording truncates the file.
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void reserve_recorder_space(Recorder_t * recorder, uint64_t end)
+{
+  while ((0 != recorder->preallocate) && (recorder->allocated < end))
+    {
+      if (-1 == fallocate(recorder->fd, 0, (off_t)recorder->allocated,
+			  (off_t)RECORDER_PREALLOCATE))
+	{
+	  recorder->preallocate = 0;
+	}
+      else
+	{
+	  recorder->allocated += RECORDER_PREALLOCATE;
+	}
+    }
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  write_recorder_header
+
+
+   USAGE:
+
+   int some_int;
+   Recorder_t * recorder;
+   uint64_t index_offset;
+
+   some_int =  write_recorder_header(recorder, 0);  -- to start with
+   ...
+   some_int =  write_recorder_header(recorder, recorder->write_offset);
+
+   returns: int
+
+   DESCRIPTION:
+                 write the file's Capfileheader_t, with
+		 recorder->nframes frames and the index at
+		 index_offset, in the file's first RECORDER_ALIGN
+		 bytes.
+
+		 the block is built in the first frame buffer (it's
+		 aligned for O_DIRECT), so call this only when no
+		 frames are queued.
+
+		 return 0 on success
+		       -1 (and say why) on error
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int write_recorder_header(Recorder_t * recorder, uint64_t index_offset)
+{
+  Capfileheader_t header;
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, CAPFILE_MAGIC, sizeof(header.magic));
+  header.version = CAPFILE_VERSION;
+  header.header_bytes = sizeof(header);
+  header.width = recorder->width;
+  header.height = recorder->height;
+  header.encoding = recorder->encoding;
+  header.nframes = recorder->nframes;
+  header.index_offset = index_offset;
+
+  memset(recorder->pool, 0, RECORDER_ALIGN);
+  memcpy(recorder->pool, &header, sizeof(header));
+
+  if (RECORDER_ALIGN != pwrite(recorder->fd, recorder->pool, RECORDER_ALIGN, 0))
+    {
+      fprintf(stderr, "Error writing the header of %s: %s\n", recorder->path,
+	      strerror(errno));
+      return(-1);
+    }
+
+  return(0);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  finish_recording
+
+
+   USAGE:
+
+   int some_int;
+   Recorder_t * recorder;
+
+   -- with the writer thread stopped
+   some_int =  finish_recording(recorder);
+
+   returns: int
+
+   DESCRIPTION:
+                 append the index after the last frame, point the
+		 header at it, trim the disk space we reserved but
+		 didn't use, and make sure it's all on the disk.
+
+		 the index isn't a whole number of blocks, so
+		 O_DIRECT is turned off for it.
+
+		 return 0 on success
+		       -1 (and say why) on error
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int finish_recording(Recorder_t * recorder)
+{
+  size_t index_bytes;
+  int flags;
+
+  if (0 != recorder->direct)
+    {
+      flags = fcntl(recorder->fd, F_GETFL);
+      (void)fcntl(recorder->fd, F_SETFL, flags & ~O_DIRECT);
+    }
+
+  index_bytes = recorder->nframes * sizeof(Capfileindex_t);
+  if ((ssize_t)index_bytes != pwrite(recorder->fd, recorder->index, index_bytes,
+				     (off_t)recorder->write_offset))
+    {
+      fprintf(stderr, "Error writing the index of %s: %s\n", recorder->path,
+	      strerror(errno));
+      return(-1);
+    }
+
+  if ((-1 == write_recorder_header(recorder, recorder->write_offset))
+      || (-1 == ftruncate(recorder->fd,
+			  (off_t)(recorder->write_offset + index_bytes)))
+      || (-1 == fdatasync(recorder->fd)))
+    {
+      perror(recorder->path);
+      return(-1);
+    }
+
+  return(0);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  close_recorder
+
+
+   USAGE:
+
+   Recorder_t * recorder;
+
+   close_recorder(recorder);
+
+   returns: void
+
+   DESCRIPTION:
+                 close the file and the wake-up eventfd, free the
+		 frame buffers and the index. safe to call on a
+		 recorder that's only partly set up.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void close_recorder(Recorder_t * recorder)
+{
+  if (-1 != recorder->fd)
+    {
+      close(recorder->fd);
+      recorder->fd = -1;
+    }
+  if (-1 != recorder->wake_fd)
+    {
+      close(recorder->wake_fd);
+      recorder->wake_fd = -1;
+    }
+  free(recorder->pool);
+  recorder->pool = NULL;
+  free(recorder->index);
+  recorder->index = NULL;
+}
@@ -0,0 +1,55 @@
+/* *************************************************************************
+* NAME: glutcam/recorder.h
+*
+* DESCRIPTION:
+*
+* this is the header file for the functions exported from recorder.c
+*
+* PROCESS:
+*
+* with sourceparams->recorder.path set:
+*
+*   start_recorder(sourceparams);        -- (start_capture_source)
+*   record_video_frame(sourceparams, &slot); -- each frame, from
+*                                           publish_video_frame
+*   stop_recorder(sourceparams);         -- (stop_capture_source) once
+*                                           no more frames can come
+*
+* GLOBALS: none
+*
+* REFERENCES:
+*
+* LIMITATIONS:
+*
+* REVISION HISTORY:
+*
+*   STR                Description                          Author
+*
+*   17-Oct-26          initial coding
+*
+* TARGET: Linux C, pthreads
+*
+* This software is in the public domain. if it breaks you get to keep
+* both pieces.
+*
+* ************************************************************************* */
+
+#ifndef	__RECORDER_H__
+#define	__RECORDER_H__
+
+#include "glutcam.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+extern int start_recorder(Sourceparams_t * sourceparams);
+extern void record_video_frame(Sourceparams_t * sourceparams,
+			       const Frameslot_t * slot);
+extern void stop_recorder(Sourceparams_t * sourceparams);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	//__RECORDER_H__
@@ -29,6 +29,13 @@ uniform int color_output; // 0 , 1
 
 uniform int image_processing; // 0, 1
 
+// per_tile - if this is 1, the picture is a mosaic of tiles (see
+//   draw_video_tiles in callbacks.c) and each tile brings its own
+//   color_output and image_processing in gl_SecondaryColor.r and .g;
+//   the uniforms above are ignored.
+
+uniform int per_tile; // 0, 1
+
 // luma_texcoord_offsets - the offsets in texture coordinates to
 //   apply to our current coordinates to get the neighboring
 //   pixels (up, down, left, right). 
@@ -82,6 +89,37 @@ vec4 laplace_rgb()
 
 
 
+
+//
+// int tile_color_output()
+//
+// color_output for the tile being drawn
+//
+
+int tile_color_output()
+{
+  if (1 == per_tile)
+    {
+      return(int(gl_SecondaryColor.r + 0.5));
+    }
+  return(color_output);
+}
+
+//
+// int tile_image_processing()
+//
+// image_processing for the tile being drawn
+//
+
+int tile_image_processing()
+{
+  if (1 == per_tile)
+    {
+      return(int(gl_SecondaryColor.g + 0.5));
+    }
+  return(image_processing);
+}
+
 void main()
 {
   vec4 color;
@@ -94,7 +132,7 @@ void main()
   else
     {
       
-      if (0 == image_processing) // no image processing
+      if (0 == tile_image_processing()) // no image processing
 	{
 	  color = texture2D(image_texture_unit, gl_TexCoord[0].st);
 	}
@@ -103,7 +141,7 @@ void main()
 	  color = laplace_rgb();
 	}
       
-      if (1 == color_output) // we want color
+      if (1 == tile_color_output()) // we want color
 	{
 	  red = color.r;
 	  green = color.g;
@@ -11,6 +11,9 @@
 *
 * shader_off turns the shader off (opengl rendering instead)
 *
+* per_tile_processing makes each tile of a mosaic use its own
+*   color_output and image_processing
+*
 * check_error is a debugging function that prints out any opengl errors
 *
 *
@@ -19,6 +22,7 @@
 * shader_on_loc
 * color_output_location
 * image_processing_location
+* per_tile_location
 *
 * REFERENCES:
 *
@@ -29,6 +33,8 @@
 *   STR                Description                          Author
 *
 *    7-Jan-07          initial coding                        gpk
+*   17-Oct-26          per_tile_processing; laplacian offsets for a
+*                      texture of stacked tiles
 *
 * TARGET:  C
 *
@@ -113,6 +119,20 @@ static int color_output_location = 1;
 static int image_processing_location = 0;
 
 
+/*
+    static int per_tile_location = -1
+
+        range of values: -1 (the shader has no per_tile), any location
+
+        accessors: per_tile_processing
+                     
+        modifiers: setup_shader_interface
+                     
+    */
+
+static int per_tile_location = -1;
+
+
 /* ************************************************************************* 
 
 
@@ -315,6 +335,59 @@ void image_processing_algorithm(int algorithm)
   glUniform1i(image_processing_location, algorithm);
 }
 
+
+
+/* ************************************************************************* 
+
+
+   NAME:  per_tile_processing
+
+
+   USAGE: 
+
+    
+   int onoff;
+
+   per_tile_processing(onoff);
+
+   returns: void
+
+   DESCRIPTION:
+                 set the per_tile variable in the shader: if onoff
+		 is non-zero, the color_output and image_processing
+		 of each fragment come from its vertices' secondary
+		 color (red and green), so each tile of a mosaic can
+		 have its own. otherwise color_output and
+		 image_processing_algorithm set them for the picture.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: per_tile_location
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void per_tile_processing(int onoff)
+{
+  if (-1 != per_tile_location)
+    {
+      glUniform1i(per_tile_location, (0 == onoff) ? 0 : 1);
+    }
+}
+
 /* ************************************************************************* 
 
 
@@ -625,7 +698,8 @@ void print_shader_info_log(GLuint obj)
 
       accessed: none
 
-      modified: shader_on_location, color_output_location
+      modified: shader_on_location, color_output_location,
+                per_tile_location
 
    FUNCTIONS CALLED:
 
@@ -634,6 +708,7 @@ void print_shader_info_log(GLuint obj)
         STR                  Description of Revision                 Author
 
      27-Jan-07               initial coding                           gpk
+     17-Oct-26  offsets for the stacked tiles; per_tile
 
  ************************************************************************* */
 
@@ -886,7 +961,8 @@ int setup_shader_interface(GLuint program, Sourceparams_t * sourceparams,
 	initialize_texture_coord_offsets(luma_texture_coordinate_offsets,
 					 CONVOLUTION_KERNEL_SIZE,
 					 displaydata->texture_width,
-					 displaydata->texture_height);
+					 displaydata->texture_height *
+					 displaydata->tiles);
 	glUniform2fv(luma_texture_coord_offset_loc, CONVOLUTION_KERNEL_SIZE *
 		     CONVOLUTION_KERNEL_SIZE, luma_texture_coordinate_offsets);
       }
@@ -910,7 +986,8 @@ int setup_shader_interface(GLuint program, Sourceparams_t * sourceparams,
 	initialize_texture_coord_offsets(chroma_texture_coordinate_offsets,
 					 CONVOLUTION_KERNEL_SIZE,
 					 displaydata->texture_width / 2,
-					 displaydata->texture_height/ 2);
+					 displaydata->texture_height *
+					 displaydata->tiles / 2);
 	glUniform2fv(chroma_texture_coord_offset_loc,
 		     CONVOLUTION_KERNEL_SIZE * CONVOLUTION_KERNEL_SIZE ,
 		     chroma_texture_coordinate_offsets);
@@ -932,6 +1009,21 @@ int setup_shader_interface(GLuint program, Sourceparams_t * sourceparams,
 	image_processing_algorithm(0); /* pass through  */
       }
   }
+
+  {
+    per_tile_location = glGetUniformLocation(program, "per_tile");
+
+    if (-1 == per_tile_location)
+      {
+	fprintf(stderr, "Warning: can't get per_tile location\n");
+	check_error("Warning: can't get per_tile location");
+      }
+    else
+      {
+	/* several sources: each tile says how it's processed  */
+	per_tile_processing(1 < displaydata->tiles);
+      }
+  }
   return(0);
 }
 
@@ -13,6 +13,9 @@
 *
 * shader_off turns the shader off (opengl rendering instead)
 *
+* per_tile_processing makes each tile of a mosaic use its own
+*   color_output and image_processing
+*
 * check_error is a debugging function that prints out any opengl errors
 *
 * GLOBALS: none
@@ -26,6 +29,7 @@
 *   STR                Description                          Author
 *
 *    7-Jan-07          initial coding                        gpk
+*   17-Oct-26          per_tile_processing
 *
 * TARGET: C
 *
@@ -41,4 +45,5 @@ extern void shader_on(void);
 extern void shader_off(void);
 extern void color_output(int onoff);
 extern void image_processing_algorithm(int algorithm);
+extern void per_tile_processing(int onoff);
 extern void check_error(char *label);
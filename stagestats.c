@@ -0,0 +1,520 @@
+/* *************************************************************************
+* NAME: glutcam/stagestats.c
+*
+* DESCRIPTION:
+*
+* per-stage latency histograms. every frame's time in each stage (see
+* Stage_t in glutcam.h) goes into a log-bucketed histogram: values
+* under 2^STAGE_SUB_BITS usec get a bucket each, and every power of
+* two above that is split into 2^STAGE_SUB_BITS equal buckets. so a
+* percentile read off the histogram is within about 6% of the real
+* one, whatever the scale, and recording is one increment.
+*
+* the capture thread, the convert workers and the GL thread all record
+* into the same histograms with relaxed atomics; there's no lock.
+*
+* PROCESS:
+*
+* see stagestats.h
+*
+* GLOBALS: none (Stage_hist is local to this file)
+*
+* REFERENCES: the HdrHistogram bucket layout
+*
+* LIMITATIONS:
+*
+* a report taken while frames are being recorded can be off by the
+* samples that land during it.
+*
+* REVISION HISTORY:
+*
+*   STR                Description                          Author
+*
+*   17-Oct-26          initial coding
+*   17-Oct-26          timed stages go into the trace too
+*   17-Oct-26          the recorder's disk writes
+*
+* TARGET: Linux C (gcc __atomic builtins)
+*
+* This software is in the public domain. if it breaks you get to keep
+* both pieces.
+*
+* ************************************************************************* */
+
+#include <stdio.h>
+
+#include "glutcam.h"
+#include "timeutil.h"
+#include "trace.h" /* trace_span  */
+#include "stagestats.h"
+
+/* STAGE_SUB_COUNT - linear buckets per power of two  */
+
+#define STAGE_SUB_COUNT (1 << STAGE_SUB_BITS)
+
+static Stagehist_t Stage_hist[NSTAGES];
+
+static const char * Stage_names[NSTAGES] = {
+  "dequeue", "ring wait", "convert", "detect", "describe", "match",
+  "homography", "flow", "pbo map", "pbo fill", "upload", "swap",
+  "capture->swap", "record"
+};
+
+/* local prototypes  */
+int stage_bucket(long long usec);
+long long stage_bucket_usec(int bucket);
+long long stage_percentile(const Stagehist_t * hist, unsigned int total,
+			   double fraction);
+/* end local prototypes  */
+
+
+
+/* *************************************************************************
+
+
+   NAME:  record_stage_usec
+
+
+   USAGE:
+
+   Stage_t stage;
+   long long usec;
+
+   record_stage_usec(stage, usec);
+
+   returns: void
+
+   DESCRIPTION:
+                 add a usec long sample to stage's histogram.
+		 negative samples (clock skew between the driver's
+		 timestamp and ours) count as 0.
+
+		 safe to call from any thread.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: Stage_hist
+
+      modified: Stage_hist
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void record_stage_usec(Stage_t stage, long long usec)
+{
+  Stagehist_t * hist;
+  long long max;
+
+  if ((0 > (int)stage) || (NSTAGES <= stage))
+    {
+      return;
+    }
+
+  if (0 > usec)
+    {
+      usec = 0;
+    }
+
+  hist = &(Stage_hist[stage]);
+  __atomic_fetch_add(&(hist->counts[stage_bucket(usec)]), 1,
+		     __ATOMIC_RELAXED);
+
+  max = __atomic_load_n(&(hist->max_usec), __ATOMIC_RELAXED);
+  while ((usec > max)
+	 && !__atomic_compare_exchange_n(&(hist->max_usec), &max, usec, 1,
+					 __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+      /* max now holds what someone else stored: try again  */
+    }
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  record_stage_since
+
+
+   USAGE:
+
+   long long start;
+
+   start = monotonic_usec();
+   ...
+   start = record_stage_since(STAGE_SOMETHING, start);
+
+   returns: long long
+
+   DESCRIPTION:
+                 record the time from start_usec to now as a sample
+		 for stage (and as a span on this thread's trace track)
+		 and return now, so back to back stages can share one
+		 clock read.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: Stage_hist, Stage_names
+
+      modified: Stage_hist
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+     17-Oct-26  trace the stage too
+
+ ************************************************************************* */
+
+long long record_stage_since(Stage_t stage, long long start_usec)
+{
+  long long now;
+
+  now = monotonic_usec();
+  record_stage_usec(stage, now - start_usec);
+  trace_span(Stage_names[stage], start_usec, now);
+
+  return(now);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  report_stage_stats
+
+
+   USAGE:
+
+   report_stage_stats(stderr);
+
+   returns: void
+
+   DESCRIPTION:
+                 print a line for each stage that has samples: how
+		 many, the 50th, 90th and 99th percentiles and the
+		 largest, in msec.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   percentiles are the top of their bucket, so they read up to 1/16
+   high.
+
+   GLOBAL VARIABLES:
+
+      accessed: Stage_hist, Stage_names
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void report_stage_stats(FILE * fp)
+{
+  const Stagehist_t * hist;
+  unsigned int total;
+  int stage, i;
+
+  fprintf(fp, "%-14s %8s %9s %9s %9s %9s  (msec)\n",
+	  "stage", "count", "p50", "p90", "p99", "max");
+
+  for (stage = 0; stage < NSTAGES; stage++)
+    {
+      hist = &(Stage_hist[stage]);
+
+      total = 0;
+      for (i = 0; i < STAGE_BUCKETS; i++)
+	{
+	  total += __atomic_load_n(&(hist->counts[i]), __ATOMIC_RELAXED);
+	}
+
+      if (0 == total)
+	{
+	  continue;
+	}
+
+      fprintf(fp, "%-14s %8u %9.3f %9.3f %9.3f %9.3f\n",
+	      Stage_names[stage], total,
+	      stage_percentile(hist, total, 0.50) / 1000.0,
+	      stage_percentile(hist, total, 0.90) / 1000.0,
+	      stage_percentile(hist, total, 0.99) / 1000.0,
+	      __atomic_load_n(&(hist->max_usec), __ATOMIC_RELAXED) / 1000.0);
+    }
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  reset_stage_stats
+
+
+   USAGE:
+
+   reset_stage_stats();
+
+   returns: void
+
+   DESCRIPTION:
+                 empty every stage's histogram
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   a sample recorded while this runs may survive it
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: Stage_hist
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void reset_stage_stats(void)
+{
+  int stage, i;
+
+  for (stage = 0; stage < NSTAGES; stage++)
+    {
+      for (i = 0; i < STAGE_BUCKETS; i++)
+	{
+	  __atomic_store_n(&(Stage_hist[stage].counts[i]), 0,
+			   __ATOMIC_RELAXED);
+	}
+      __atomic_store_n(&(Stage_hist[stage].max_usec), 0, __ATOMIC_RELAXED);
+    }
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  stage_bucket
+
+
+   USAGE:
+
+   int bucket;
+
+   bucket =  stage_bucket(usec);
+
+   returns: int
+
+   DESCRIPTION:
+                 return the histogram bucket a usec (>= 0) sample
+		 goes in.
+
+		 below STAGE_SUB_COUNT, the bucket is the value.
+		 above, with e the position of the top bit, the
+		 STAGE_SUB_BITS bits under it pick one of the
+		 STAGE_SUB_COUNT buckets for that power of two.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int stage_bucket(long long usec)
+{
+  int shift;
+
+  if (STAGE_SUB_COUNT > usec)
+    {
+      return((int)usec);
+    }
+
+  /* 63 - clz is the top bit's position, at least STAGE_SUB_BITS here  */
+  shift = 63 - __builtin_clzll((unsigned long long)usec) - STAGE_SUB_BITS;
+  if (STAGE_EXPONENTS <= shift)
+    {
+      return(STAGE_BUCKETS - 1);
+    }
+
+  return(((shift + 1) << STAGE_SUB_BITS)
+	 + (int)((usec >> shift) & (STAGE_SUB_COUNT - 1)));
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  stage_bucket_usec
+
+
+   USAGE:
+
+   long long usec;
+
+   usec =  stage_bucket_usec(bucket);
+
+   returns: long long
+
+   DESCRIPTION:
+                 return the largest value that lands in bucket:
+		 the inverse of stage_bucket, rounded up.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+long long stage_bucket_usec(int bucket)
+{
+  int shift;
+
+  if (STAGE_SUB_COUNT > bucket)
+    {
+      return(bucket);
+    }
+
+  shift = (bucket >> STAGE_SUB_BITS) - 1;
+
+  return((((long long)(STAGE_SUB_COUNT + (bucket & (STAGE_SUB_COUNT - 1))))
+	  << shift) + (1LL << shift) - 1);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  stage_percentile
+
+
+   USAGE:
+
+   long long p99;
+
+   p99 =  stage_percentile(hist, total, 0.99);
+
+   returns: long long
+
+   DESCRIPTION:
+                 walk hist's buckets until they hold fraction of its
+		 total samples and return that bucket's top value,
+		 but never more than the largest sample seen (the
+		 overflow bucket just reports that).
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+long long stage_percentile(const Stagehist_t * hist, unsigned int total,
+			   double fraction)
+{
+  unsigned long long wanted, seen;
+  long long usec, max;
+  int i;
+
+  wanted = (unsigned long long)(fraction * total + 0.5);
+  if (1 > wanted)
+    {
+      wanted = 1;
+    }
+
+  seen = 0;
+  for (i = 0; i < STAGE_BUCKETS - 1; i++)
+    {
+      seen += __atomic_load_n(&(hist->counts[i]), __ATOMIC_RELAXED);
+      if (seen >= wanted)
+	{
+	  break;
+	}
+    }
+
+  usec = stage_bucket_usec(i);
+  max = __atomic_load_n(&(hist->max_usec), __ATOMIC_RELAXED);
+  if ((usec > max) || (STAGE_BUCKETS - 1 == i)) /* last has no top  */
+    {
+      usec = max;
+    }
+
+  return(usec);
+}
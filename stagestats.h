@@ -0,0 +1,60 @@
+/* *************************************************************************
+* NAME: glutcam/stagestats.h
+*
+* DESCRIPTION:
+*
+* this is the header file for the functions exported from stagestats.c
+*
+* PROCESS:
+*
+* time a stage with
+*
+*   start = monotonic_usec();
+*   ... the stage ...
+*   start = record_stage_since(STAGE_SOMETHING, start);
+*
+* (it returns now, so the next stage can start from there), or record
+* a latency that's already known with record_stage_usec.
+*
+* report_stage_stats prints count, p50, p90, p99 and max for every
+* stage that has samples; reset_stage_stats empties the histograms.
+*
+* GLOBALS: none
+*
+* REFERENCES:
+*
+* LIMITATIONS:
+*
+* REVISION HISTORY:
+*
+*   STR                Description                          Author
+*
+*   17-Oct-26          initial coding
+*
+* TARGET: Linux C
+*
+* This software is in the public domain. if it breaks you get to keep
+* both pieces.
+*
+* ************************************************************************* */
+
+#ifndef	__STAGESTATS_H__
+#define	__STAGESTATS_H__
+
+#include <stdio.h> /* FILE  */
+#include "glutcam.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+extern void record_stage_usec(Stage_t stage, long long usec);
+extern long long record_stage_since(Stage_t stage, long long start_usec);
+extern void report_stage_stats(FILE * fp);
+extern void reset_stage_stats(void);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	//__STAGESTATS_H__
@@ -20,6 +20,10 @@
 *   it into sourceparams->captured (where the display code expects
 *   to find it.)
 *
+* mock_testpattern_timing makes a test pattern behave like a camera
+*   for the sync stage (framesync.c): its frames carry a capture
+*   time some way before they're published, and some never arrive.
+*
 *
 * GLOBALS: none
 *
@@ -33,6 +37,8 @@
 *
 *    1-Jan-07          initial coding                        gpk
 *    2-Jan-08       added documentation                      gpk
+*   17-Oct-26          mock camera timing: stamp frames with an offset
+*                      and jitter, lose some, as a real device would
 *
 * TARGET:  C
 *
@@ -51,12 +57,19 @@
 #include "capabilities.h"
 
 #include "testpattern.h"
+#include "capture.h" /* publish_video_frame  */
+#include "timeutil.h" /* monotonic_usec  */
 
 /* DEFAULT_BUFFER_COUNT - number of frames worth of image */
 /* to store in a test pattern: a second worth of video  */
 
 #define DEFAULT_BUFFER_COUNT 30
 
+/* TESTPATTERN_FRAME_USEC - how often the test pattern delivers a  */
+/* frame: 30 frames/sec, like a typical camera.  */
+
+#define TESTPATTERN_FRAME_USEC (1000000LL / 30)
+
 
 /* local prototypes  */
 int compute_bytes_per_frame(int image_width, int image_height,
@@ -69,12 +82,6 @@ void generate_yuv420_testpattern(Testpattern_t *testpatternp);
 void generate_yuv420_testpattern_i(int i, int nframes, int width,
 				   int height, void * framep);
 void generate_yuv422_testpattern(Testpattern_t *testpatternp);
-void generate_yuv422_testpattern_i(int i, int nframes, int width,
-				   int height, void * framep);
-void rgb2yuv422(int red0, int green0, int blue0,
-		int red1, int green1, int blue1,
-		int *luma0, int *chroma_u,
-		int *luma1, int *chroma_v);
 int get_rgb_luma(int red, int green, int blue);
 void generate_rgb_testpattern(Testpattern_t *testpatternp);
 void generate_rgb_testpattern_i(int i, int nframes, int width,
@@ -82,7 +89,6 @@ void generate_rgb_testpattern_i(int i, int nframes, int width,
 void describe_testpattern(char * label, Testpattern_t *testpatternp,
 			  int nbytes);
 void dump_image_bytes(char * label, void * imagep, int nbytes);
-void deinterlace_testpattern(Testpattern_t *testpatternp);
 /* end local prototypes  */
 
 
@@ -117,8 +123,9 @@ void deinterlace_testpattern(Testpattern_t *testpatternp);
 		 data stored there.
 
 		 the test pattern gives you simulated video
-		 by constructing DEFAULT_BUFFER_COUNT
-		 images that are displayed one after the other.
+		 by constructing argstruct.testpattern_frames
+		 (DEFAULT_BUFFER_COUNT if that's 0) images that are
+		 displayed one after the other.
 
 		 the images are constructed with the height,
 		 width, type, and encoding read from the command line.
@@ -140,13 +147,23 @@ void deinterlace_testpattern(Testpattern_t *testpatternp);
         STR                  Description of Revision                 Author
 
       2-Jan-07               initial coding                           gpk
+     17-Oct-26  argstruct.testpattern_frames
 
  ************************************************************************* */
 
 int init_test_pattern(Cmdargs_t argstruct, Sourceparams_t * sourceparams)
 {
   Testpattern_t *testpatternp;
-  int retval, buffersize;
+  int retval, buffersize, nbuffers;
+  Encodingmethod_t pattern_encoding;
+
+#ifdef	DEF_RGB
+  /* the RGB display converts YUYV camera data (see process() in  */
+  /* cvProcess.cpp), so give it the same thing a camera would.  */
+  pattern_encoding = YUV422;
+#else
+  pattern_encoding = argstruct.encoding;
+#endif
 
   /* in the sourceparams struct show that we're to take data   */
   /* from the testpattern, what size the image is to be and  */
@@ -157,11 +174,13 @@ int init_test_pattern(Cmdargs_t argstruct, Sourceparams_t * sourceparams)
   sourceparams->image_width = argstruct.image_width;
   sourceparams->image_height = argstruct.image_height;
   sourceparams->iomethod = IO_METHOD_USERPTR; /* access by following pointer */
-  sourceparams->buffercount = DEFAULT_BUFFER_COUNT; /* this many buffers  */
+  nbuffers = (0 < argstruct.testpattern_frames) ?
+    argstruct.testpattern_frames : DEFAULT_BUFFER_COUNT;
+  sourceparams->buffercount = nbuffers; /* this many buffers  */
 
   buffersize = compute_bytes_per_frame(argstruct.image_width,
 				       argstruct.image_height,
-				       argstruct.encoding);
+				       pattern_encoding);
   
   sourceparams->captured.start = malloc(buffersize);
 
@@ -184,8 +203,8 @@ int init_test_pattern(Cmdargs_t argstruct, Sourceparams_t * sourceparams)
       testpatternp->current_buffer = 0; /* start with this one  */
       testpatternp->image_width = argstruct.image_width;
       testpatternp->image_height = argstruct.image_height;
-      testpatternp->encoding = argstruct.encoding;
-      testpatternp->nbuffers = DEFAULT_BUFFER_COUNT;
+      testpatternp->encoding = pattern_encoding;
+      testpatternp->nbuffers = nbuffers;
 
 
       /* since different ways of encoding an image of the same  */
@@ -1357,9 +1376,12 @@ void generate_rgb_testpattern_i(int i, int nframes, int width,
 
    DESCRIPTION:
                  start the test pattern at the first image in the series
-		 by setting current_buffer to 0.
+		 by setting current_buffer to 0. the first frame is due
+		 right away and is numbered 0.
 
-		 modifies sourceparams->testpattern.current_buffer
+		 modifies sourceparams->testpattern.current_buffer,
+		          sourceparams->testpattern.next_frame_usec,
+		          sourceparams->testpattern.sequence
 
    REFERENCES:
 
@@ -1378,6 +1400,7 @@ void generate_rgb_testpattern_i(int i, int nframes, int width,
         STR                  Description of Revision                 Author
 
       3-Jan-08               initial coding                           gpk
+     17-Oct-26  reset the frame number
 
  ************************************************************************* */
 
@@ -1386,6 +1409,8 @@ int start_testpattern(Sourceparams_t * sourceparams)
   /* current_buffer will range between 0 and nbuffers -1  */
   
   sourceparams->testpattern.current_buffer = 0;
+  sourceparams->testpattern.next_frame_usec = monotonic_usec();
+  sourceparams->testpattern.sequence = 0;
 
   return (0); /* success  */
 }
@@ -1409,14 +1434,17 @@ int start_testpattern(Sourceparams_t * sourceparams)
    returns: void *
 
    DESCRIPTION:
-                 get the next test pattern from the series and copy it into
-		 sourceparams->captured.start; increment the current_buffer
+                 if it's time for the next frame (we deliver one every
+		 TESTPATTERN_FRAME_USEC, like a camera would), get the
+		 next test pattern from the series and publish it to
+		 sourceparams->ring; increment the current_buffer
 		 pointer so the next time we fetch a frame we get the
 		 next one in the series.
 
 		 put the number of bytes of data into nbytesp.
 		 
-		 return a pointer to the image data
+		 return a pointer to the image data, or NULL if the
+		 next frame isn't due yet.
 
    REFERENCES:
 
@@ -1437,17 +1465,61 @@ int start_testpattern(Sourceparams_t * sourceparams)
       3-Jan-08               initial coding                           gpk
      20-Jan-08  instead of copying data from imagesource, just        gpk
                 point captured.start at it
+     17-Oct-26  pace frames at TESTPATTERN_FRAME_USEC; publish to the
+                frame ring instead of pointing captured.start at it
+     17-Oct-26  stamp the frame with its capture time
+     17-Oct-26  number the frames
+     17-Oct-26  mock camera timing
 		
  ************************************************************************* */
 
 void * next_testpattern_frame(Sourceparams_t * sourceparams, int * nbytesp)
 {
-  void * retval;
   int buff_index, buffersize;
   char * imagesource;
+  long long now_usec;
+  Frameslot_t slot;
+
+  now_usec = monotonic_usec();
+
+  if (now_usec < sourceparams->testpattern.next_frame_usec)
+    {
+      *nbytesp = 0;
+      return(NULL); /* not time yet  */
+    }
+
+  sourceparams->testpattern.next_frame_usec += TESTPATTERN_FRAME_USEC;
+  if (sourceparams->testpattern.next_frame_usec < now_usec)
+    {
+      /* we fell way behind; don't try to catch up with a burst  */
+      sourceparams->testpattern.next_frame_usec = now_usec +
+	TESTPATTERN_FRAME_USEC;
+    }
   
   buff_index = sourceparams->testpattern.current_buffer;
   buffersize = sourceparams->testpattern.buffersize;
+  slot.index = buff_index;
+  slot.capture_usec = now_usec;
+  slot.sequence = sourceparams->testpattern.sequence++;
+
+  if (0 != sourceparams->testpattern.mock)
+    {
+      slot.capture_usec = now_usec - sourceparams->testpattern.mock_offset_usec;
+      if (0 < sourceparams->testpattern.mock_jitter_usec)
+	{
+	  slot.capture_usec -=
+	    rand_r(&(sourceparams->testpattern.mock_seed)) %
+	    sourceparams->testpattern.mock_jitter_usec;
+	}
+      if ((0 < sourceparams->testpattern.mock_drop_every) &&
+	  (0 == (slot.sequence + 1) %
+	   (unsigned int)sourceparams->testpattern.mock_drop_every))
+	{
+	  /* lost: the sequence number skips it, like the driver's  */
+	  *nbytesp = 0;
+	  return(NULL);
+	}
+    }
   
   imagesource = (char *)(sourceparams->testpattern.bufferarray) +
     buffersize * buff_index++; 
@@ -1459,18 +1531,80 @@ void * next_testpattern_frame(Sourceparams_t * sourceparams, int * nbytesp)
   /* run current_buffer between 0 and sourceparams->testpattern.nbuffers - 1 */
   sourceparams->testpattern.current_buffer = buff_index;
 
-#if 0 /* start here  */
-  memcpy(sourceparams->captured.start, imagesource,
-	 sourceparams->captured.length);
-#else
-  sourceparams->captured.start= imagesource;
-#endif /* 0  */
-  retval = sourceparams->captured.start;
+  slot.start = imagesource;
+  slot.length = (size_t)buffersize;
+  (void)publish_video_frame(sourceparams, &slot);
   
-  *nbytesp = sourceparams->captured.length;
+  *nbytesp = buffersize;
+
+  return(imagesource);
+
+}
+
+
+
+/* ************************************************************************* 
 
-  return(retval);
 
+   NAME:  mock_testpattern_timing
+
+
+   USAGE: 
+
+   Sourceparams_t * sourceparams;
+   long long offset_usec;
+   int jitter_usec, drop_every;
+   unsigned int seed;
+
+   mock_testpattern_timing(sourceparams, offset_usec, jitter_usec,
+                           drop_every, seed);
+
+   returns: void
+
+   DESCRIPTION:
+                 make the test pattern in sourceparams stamp its
+		 frames the way a camera's driver would: each frame's
+		 capture_usec is offset_usec, plus up to jitter_usec
+		 at random, before it's published. every drop_every'th
+		 frame is lost: it's never published, but the
+		 sequence number counts it.
+
+		 seed starts the jitter's random numbers; give each
+		 source its own and runs are repeatable.
+
+		 drop_every of 0 loses nothing.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   call before start_capture_source
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+		
+ ************************************************************************* */
+
+void mock_testpattern_timing(Sourceparams_t * sourceparams,
+			     long long offset_usec, int jitter_usec,
+			     int drop_every, unsigned int seed)
+{
+  sourceparams->testpattern.mock = 1;
+  sourceparams->testpattern.mock_offset_usec = offset_usec;
+  sourceparams->testpattern.mock_jitter_usec = jitter_usec;
+  sourceparams->testpattern.mock_drop_every = drop_every;
+  sourceparams->testpattern.mock_seed = seed;
 }
 /* LISTWIDTH - number of bytes of data printed on each line by  */
 /* describe_testpattern, dump_image_bytes  */
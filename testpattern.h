@@ -29,6 +29,8 @@
 *   STR                Description                          Author
 *
 *    1-Jan-07          initial coding                        gpk
+*   17-Oct-26          export the pixel kernels for kernelbench.c
+*   17-Oct-26          mock_testpattern_timing
 *
 * TARGET:  C
 *
@@ -45,10 +47,22 @@ extern int init_test_pattern(Cmdargs_t argstruct,
 extern int start_testpattern(Sourceparams_t * sourceparams);
 extern void * next_testpattern_frame(Sourceparams_t * sourceparams,
 				     int * nbytesp);
+extern void mock_testpattern_timing(Sourceparams_t * sourceparams,
+				    long long offset_usec, int jitter_usec,
+				    int drop_every, unsigned int seed);
 
 /* available as a utility...  */
 extern int compute_bytes_per_frame(int image_width, int image_height,
 				   Encodingmethod_t encoding);
+
+/* ...and to the kernel benchmarks (kernelbench.c)  */
+extern void generate_yuv422_testpattern_i(int i, int nframes, int width,
+					  int height, void * framep);
+extern void rgb2yuv422(int red0, int green0, int blue0,
+		       int red1, int green1, int blue1,
+		       int *luma0, int *chroma_u,
+		       int *luma1, int *chroma_v);
+extern void deinterlace_testpattern(Testpattern_t *testpatternp);
 #ifdef  __cplusplus
 }	//extern "C"
 #endif
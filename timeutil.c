@@ -0,0 +1,138 @@
+/* ************************************************************************* 
+* NAME: glutcam/timeutil.c
+*
+* DESCRIPTION:
+*
+* small wrappers around the POSIX monotonic clock so the capture,
+* display and measurement code all count time the same way.
+*
+* PROCESS:
+*
+* see timeutil.h
+*
+* GLOBALS: none
+*
+* REFERENCES: clock_gettime(2), clock_nanosleep(2)
+*
+* LIMITATIONS:
+*
+* REVISION HISTORY:
+*
+*   STR                Description                          Author
+*
+*   17-Oct-26          initial coding
+*
+* TARGET: Linux C
+*
+* This software is in the public domain. if it breaks you get to keep
+* both pieces.
+*
+* ************************************************************************* */
+
+#include <time.h> /* clock_gettime, clock_nanosleep  */
+#include <errno.h> /* EINTR  */
+
+#include "timeutil.h"
+
+
+
+/* ************************************************************************* 
+
+
+   NAME:  monotonic_usec
+
+
+   USAGE: 
+
+   long long now;
+
+   now = monotonic_usec();
+
+   returns: long long
+
+   DESCRIPTION:
+                 return the current CLOCK_MONOTONIC time in microseconds.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+long long monotonic_usec(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return((long long)now.tv_sec * 1000000LL + now.tv_nsec / 1000);
+}
+
+
+
+/* ************************************************************************* 
+
+
+   NAME:  sleep_until_usec
+
+
+   USAGE: 
+
+   long long wakeup_usec;
+
+   wakeup_usec = monotonic_usec() + 33333;
+   sleep_until_usec(wakeup_usec);
+
+   returns: void
+
+   DESCRIPTION:
+                 sleep until the monotonic clock reaches wakeup_usec.
+		 returns immediately if that time has already passed.
+		 signals don't cut the sleep short.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void sleep_until_usec(long long wakeup_usec)
+{
+  struct timespec wakeup;
+  int status;
+
+  wakeup.tv_sec = (time_t)(wakeup_usec / 1000000LL);
+  wakeup.tv_nsec = (long)(wakeup_usec % 1000000LL) * 1000L;
+
+  do
+    status = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeup, NULL);
+  while (EINTR == status);
+}
@@ -0,0 +1,50 @@
+/* ************************************************************************* 
+* NAME: glutcam/timeutil.h
+*
+* DESCRIPTION:
+*
+* this is the header file for the functions exported from timeutil.c
+*
+* PROCESS:
+*
+* monotonic_usec returns a timestamp in microseconds from a clock that
+*   never jumps (CLOCK_MONOTONIC). use it to measure intervals, frame
+*   latency, etc. it's safe to call from any thread, unlike
+*   glutGet(GLUT_ELAPSED_TIME).
+*
+* sleep_until_usec sleeps until monotonic_usec() reaches the given time
+*
+* GLOBALS: none
+*
+* REFERENCES:
+*
+* LIMITATIONS:
+*
+* REVISION HISTORY:
+*
+*   STR                Description                          Author
+*
+*   17-Oct-26          initial coding
+*
+* TARGET: Linux C
+*
+* This software is in the public domain. if it breaks you get to keep
+* both pieces.
+*
+* ************************************************************************* */
+
+#ifndef	__TIMEUTIL_H__
+#define	__TIMEUTIL_H__
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+extern long long monotonic_usec(void);
+extern void sleep_until_usec(long long wakeup_usec);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	//__TIMEUTIL_H__
@@ -0,0 +1,758 @@
+/* *************************************************************************
+* NAME: glutcam/trace.c
+*
+* DESCRIPTION:
+*
+* write what the threads are doing, frame by frame, as Chrome trace
+* event JSON: one track per thread (capture, conversion workers, the
+* GL thread that also runs the tracker), one span per stage. where an
+* average frame rate hides a stall, the trace shows which thread held
+* things up and doing what.
+*
+* each thread puts its spans in its own ring (Tracering_t): no locks,
+* no allocation and no I/O on the thread being traced, just a few
+* stores. a writer thread empties the rings into the file every
+* TRACE_FLUSH_USEC. if a ring fills up anyway, new spans are dropped
+* and counted rather than making the thread wait.
+*
+* with tracing off, trace_begin and trace_span cost one load.
+*
+* PROCESS:
+*
+* see trace.h
+*
+* GLOBALS: none (the Trace_ variables are local to this file)
+*
+* REFERENCES: the Trace Event Format, "JSON Object Format"
+*
+* LIMITATIONS:
+*
+* names go into the JSON as they are: keep quotes and backslashes out
+* of them.
+*
+* the first MAX_TRACE_THREADS threads to record something get a
+* track; the rest are ignored.
+*
+* REVISION HISTORY:
+*
+*   STR                Description                          Author
+*
+*   17-Oct-26          initial coding
+*
+* TARGET: Linux C (pthreads, gcc __thread and __atomic builtins)
+*
+* This software is in the public domain. if it breaks you get to keep
+* both pieces.
+*
+* ************************************************************************* */
+
+#include <stdio.h>
+#include <string.h> /* strncpy  */
+#include <unistd.h> /* getpid  */
+#include <pthread.h>
+
+#include "glutcam.h"
+#include "timeutil.h"
+#include "trace.h"
+
+/* TRACE_FLUSH_USEC - how often the writer empties the rings  */
+
+#define TRACE_FLUSH_USEC 100000
+
+/* the rings live in bss: pages a thread never writes cost nothing  */
+static Tracering_t Trace_rings[MAX_TRACE_THREADS];
+static int Trace_nrings = 0; /* rings handed out (atomic)  */
+static int Trace_on = 0;
+static int Trace_quit = 0; /* tells the writer to finish  */
+static FILE * Trace_fp = NULL;
+static pthread_t Trace_writer;
+static int Trace_pid;
+static long long Trace_records = 0; /* written so far, for the commas  */
+
+static __thread Tracering_t * Thread_ring = NULL;
+static __thread int Thread_has_no_ring = 0;
+static __thread char Thread_name[TRACE_NAME_LENGTH];
+
+/* local prototypes  */
+Tracering_t * claim_trace_ring(void);
+void * trace_writer_main(void * arg);
+void flush_trace_rings(void);
+void begin_trace_record(void);
+/* end local prototypes  */
+
+
+
+/* *************************************************************************
+
+
+   NAME:  start_trace
+
+
+   USAGE:
+
+   int some_int;
+
+   some_int =  start_trace("glutcam.json");
+
+   if (0 == some_int)
+   -- we're okay
+   else
+   -- handle an error
+
+   returns: int
+
+   DESCRIPTION:
+                 create path, start the JSON in it and start the
+		 writer thread. spans are recorded from now until
+		 stop_trace.
+
+		 return 0 if all's well
+		       -1 if the file can't be written, the writer
+		          can't start, or a trace is already running
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: Trace_on
+
+      modified: Trace_fp, Trace_pid, Trace_records, Trace_quit,
+                Trace_on, Trace_writer, Trace_rings
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int start_trace(const char * path)
+{
+  int status, i;
+
+  if (0 != Trace_on)
+    {
+      return(-1);
+    }
+
+  Trace_fp = fopen(path, "w");
+  if (NULL == Trace_fp)
+    {
+      perror(path);
+      return(-1);
+    }
+
+  for (i = 0; i < MAX_TRACE_THREADS; i++)
+    {
+      Trace_rings[i].named = 0; /* new file, name them again  */
+      Trace_rings[i].dropped = 0;
+    }
+
+  Trace_pid = (int)getpid();
+  Trace_records = 0;
+  fprintf(Trace_fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  begin_trace_record();
+  fprintf(Trace_fp,
+	  "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,"
+	  "\"args\":{\"name\":\"glutcam\"}}", Trace_pid);
+
+  Trace_quit = 0;
+  __atomic_store_n(&Trace_on, 1, __ATOMIC_RELEASE);
+
+  status = pthread_create(&Trace_writer, NULL, trace_writer_main, NULL);
+  if (0 != status)
+    {
+      fprintf(stderr, "Error: unable to start trace writer (%d)\n", status);
+      __atomic_store_n(&Trace_on, 0, __ATOMIC_RELEASE);
+      fclose(Trace_fp);
+      Trace_fp = NULL;
+      return(-1);
+    }
+
+  fprintf(stderr, "tracing to %s\n", path);
+
+  return(0);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  stop_trace
+
+
+   USAGE:
+
+   stop_trace();
+
+   returns: void
+
+   DESCRIPTION:
+                 stop recording, let the writer write what's left,
+		 finish the JSON and close the file. say how many
+		 spans didn't fit in their rings, if any.
+
+		 does nothing if no trace is running.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   call it after the traced threads are done (stop_capture_source
+   does): a span recorded while this runs may not make the file.
+
+   GLOBAL VARIABLES:
+
+      accessed: Trace_rings, Trace_nrings, Trace_writer
+
+      modified: Trace_on, Trace_quit, Trace_fp
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void stop_trace(void)
+{
+  unsigned int dropped;
+  int i, nrings;
+
+  if (0 == Trace_on)
+    {
+      return;
+    }
+
+  __atomic_store_n(&Trace_on, 0, __ATOMIC_RELEASE);
+  __atomic_store_n(&Trace_quit, 1, __ATOMIC_RELEASE);
+  pthread_join(Trace_writer, NULL);
+
+  flush_trace_rings();
+
+  nrings = __atomic_load_n(&Trace_nrings, __ATOMIC_ACQUIRE);
+  if (nrings > MAX_TRACE_THREADS)
+    {
+      nrings = MAX_TRACE_THREADS;
+    }
+  dropped = 0;
+  for (i = 0; i < nrings; i++)
+    {
+      dropped += __atomic_load_n(&(Trace_rings[i].dropped), __ATOMIC_RELAXED);
+    }
+  if (0 < dropped)
+    {
+      fprintf(stderr, "Warning: %u trace events dropped (rings full)\n",
+	      dropped);
+    }
+
+  fprintf(Trace_fp, "\n]}\n");
+  fclose(Trace_fp);
+  Trace_fp = NULL;
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  trace_thread_name
+
+
+   USAGE:
+
+   trace_thread_name("capture");
+
+   returns: void
+
+   DESCRIPTION:
+                 name the calling thread's track. call it before the
+		 thread records anything; threads that don't are
+		 called "thread N".
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   names longer than TRACE_NAME_LENGTH - 1 are cut short
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: Thread_name
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void trace_thread_name(const char * name)
+{
+  strncpy(Thread_name, name, TRACE_NAME_LENGTH - 1);
+  Thread_name[TRACE_NAME_LENGTH - 1] = '\0';
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  trace_begin
+
+
+   USAGE:
+
+   long long start;
+
+   start = trace_begin();
+   ...
+   trace_end("something", start);
+
+   returns: long long
+
+   DESCRIPTION:
+                 return monotonic_usec() if we're tracing, 0 (which
+		 trace_end ignores) if we're not, so an untraced run
+		 doesn't even read the clock.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: Trace_on
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+long long trace_begin(void)
+{
+  if (0 == __atomic_load_n(&Trace_on, __ATOMIC_RELAXED))
+    {
+      return(0);
+    }
+
+  return(monotonic_usec());
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  trace_end
+
+
+   USAGE:
+
+   trace_end("something", start);
+
+   returns: void
+
+   DESCRIPTION:
+                 record a span called name from start_usec (from
+		 trace_begin) to now on the calling thread's track
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void trace_end(const char * name, long long start_usec)
+{
+  if (0 != start_usec)
+    {
+      trace_span(name, start_usec, monotonic_usec());
+    }
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  trace_span
+
+
+   USAGE:
+
+   trace_span("something", start_usec, end_usec);
+
+   returns: void
+
+   DESCRIPTION:
+                 record a span called name from start_usec to end_usec
+		 (monotonic_usec times) on the calling thread's track,
+		 if we're tracing.
+
+		 the first span a thread records claims it a ring.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   name has to stay put until stop_trace: use a string constant
+
+   GLOBAL VARIABLES:
+
+      accessed: Trace_on, Thread_ring, Thread_has_no_ring
+
+      modified: Thread_ring, Trace_rings
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void trace_span(const char * name, long long start_usec, long long end_usec)
+{
+  Tracering_t * ring;
+  Traceevent_t * event;
+  unsigned int head;
+
+  if (0 == __atomic_load_n(&Trace_on, __ATOMIC_RELAXED))
+    {
+      return;
+    }
+
+  ring = Thread_ring;
+  if (NULL == ring)
+    {
+      if (0 != Thread_has_no_ring)
+	{
+	  return;
+	}
+      ring = claim_trace_ring();
+      if (NULL == ring)
+	{
+	  return;
+	}
+    }
+
+  head = ring->head; /* only we write it  */
+  if (TRACE_RING_EVENTS
+      <= head - __atomic_load_n(&(ring->tail), __ATOMIC_ACQUIRE))
+    {
+      __atomic_store_n(&(ring->dropped), ring->dropped + 1, __ATOMIC_RELAXED);
+      return;
+    }
+
+  event = &(ring->events[head & (TRACE_RING_EVENTS - 1)]);
+  event->name = name;
+  event->start_usec = start_usec;
+  event->duration_usec = end_usec - start_usec;
+
+  __atomic_store_n(&(ring->head), head + 1, __ATOMIC_RELEASE);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  claim_trace_ring
+
+
+   USAGE:
+
+   Tracering_t * ring;
+
+   ring =  claim_trace_ring();
+
+   returns: Tracering_t *
+
+   DESCRIPTION:
+                 give the calling thread the next free ring, named
+		 from trace_thread_name, and remember it in
+		 Thread_ring.
+
+		 return the ring, or NULL if they're all taken (and
+		 remember that too, so we don't ask again).
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: Thread_name
+
+      modified: Trace_nrings, Trace_rings, Thread_ring,
+                Thread_has_no_ring
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+Tracering_t * claim_trace_ring(void)
+{
+  Tracering_t * ring;
+  int i;
+
+  i = __atomic_fetch_add(&Trace_nrings, 1, __ATOMIC_RELAXED);
+  if (MAX_TRACE_THREADS <= i)
+    {
+      Thread_has_no_ring = 1;
+      return(NULL);
+    }
+
+  ring = &(Trace_rings[i]);
+  if ('\0' != Thread_name[0])
+    {
+      strncpy(ring->thread_name, Thread_name, TRACE_NAME_LENGTH);
+    }
+  else
+    {
+      snprintf(ring->thread_name, TRACE_NAME_LENGTH, "thread %d", i);
+    }
+
+  /* the writer doesn't look at the ring until it sees ready  */
+  __atomic_store_n(&(ring->ready), 1, __ATOMIC_RELEASE);
+  Thread_ring = ring;
+
+  return(ring);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  trace_writer_main
+
+
+   USAGE:
+
+   pthread_create(&Trace_writer, NULL, trace_writer_main, NULL);
+
+   returns: void *
+
+   DESCRIPTION:
+                 the writer thread: empty the rings into the file
+		 every TRACE_FLUSH_USEC until stop_trace says quit.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: Trace_quit
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void * trace_writer_main(void * arg)
+{
+  (void)arg;
+
+  trace_thread_name("trace writer");
+
+  while (0 == __atomic_load_n(&Trace_quit, __ATOMIC_ACQUIRE))
+    {
+      sleep_until_usec(monotonic_usec() + TRACE_FLUSH_USEC);
+      flush_trace_rings();
+    }
+
+  return(NULL);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  flush_trace_rings
+
+
+   USAGE:
+
+   flush_trace_rings();
+
+   returns: void
+
+   DESCRIPTION:
+                 write every span waiting in the rings to Trace_fp as
+		 a complete ("X") event, after a thread_name ("M")
+		 record the first time we see a ring. then give the
+		 space back to the threads.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   only one thread at a time: the writer, or stop_trace once the
+   writer is gone
+
+   GLOBAL VARIABLES:
+
+      accessed: Trace_nrings, Trace_fp, Trace_pid
+
+      modified: Trace_rings
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void flush_trace_rings(void)
+{
+  Tracering_t * ring;
+  const Traceevent_t * event;
+  unsigned int head, tail;
+  int i, nrings;
+
+  nrings = __atomic_load_n(&Trace_nrings, __ATOMIC_ACQUIRE);
+  if (nrings > MAX_TRACE_THREADS)
+    {
+      nrings = MAX_TRACE_THREADS;
+    }
+
+  for (i = 0; i < nrings; i++)
+    {
+      ring = &(Trace_rings[i]);
+      if (0 == __atomic_load_n(&(ring->ready), __ATOMIC_ACQUIRE))
+	{
+	  continue; /* claimed, not named yet  */
+	}
+
+      if (0 == ring->named)
+	{
+	  begin_trace_record();
+	  fprintf(Trace_fp,
+		  "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,"
+		  "\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+		  Trace_pid, i + 1, ring->thread_name);
+	  ring->named = 1;
+	}
+
+      head = __atomic_load_n(&(ring->head), __ATOMIC_ACQUIRE);
+      for (tail = ring->tail; tail != head; tail++)
+	{
+	  event = &(ring->events[tail & (TRACE_RING_EVENTS - 1)]);
+	  begin_trace_record();
+	  fprintf(Trace_fp,
+		  "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,"
+		  "\"ts\":%lld,\"dur\":%lld}",
+		  event->name, Trace_pid, i + 1,
+		  event->start_usec, event->duration_usec);
+	}
+
+      __atomic_store_n(&(ring->tail), head, __ATOMIC_RELEASE);
+    }
+
+  fflush(Trace_fp);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  begin_trace_record
+
+
+   USAGE:
+
+   begin_trace_record();
+   fprintf(Trace_fp, "{...}");
+
+   returns: void
+
+   DESCRIPTION:
+                 put the comma and newline between JSON records
+		 (JSON won't take one after the last)
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: Trace_fp
+
+      modified: Trace_records
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void begin_trace_record(void)
+{
+  if (0 < Trace_records)
+    {
+      fprintf(Trace_fp, ",\n");
+    }
+  Trace_records++;
+}
@@ -0,0 +1,67 @@
+/* *************************************************************************
+* NAME: glutcam/trace.h
+*
+* DESCRIPTION:
+*
+* this is the header file for the functions exported from trace.c
+*
+* PROCESS:
+*
+* start_trace(path) opens the trace file and starts the writer thread
+*
+* each thread that wants its own named track calls
+*   trace_thread_name("capture");
+* (before or after start_trace)
+*
+* time something with
+*   start = trace_begin();
+*   ... the work ...
+*   trace_end("what it was", start);
+* or, when the times are already known,
+*   trace_span("what it was", start_usec, end_usec);
+* names have to be string constants.
+*
+* stop_trace writes out what's left and closes the file. open it in
+* chrome://tracing or ui.perfetto.dev
+*
+* GLOBALS: none
+*
+* REFERENCES: the Trace Event Format ("X" and "M" events)
+*
+* LIMITATIONS:
+*
+* REVISION HISTORY:
+*
+*   STR                Description                          Author
+*
+*   17-Oct-26          initial coding
+*
+* TARGET: Linux C
+*
+* This software is in the public domain. if it breaks you get to keep
+* both pieces.
+*
+* ************************************************************************* */
+
+#ifndef	__TRACE_H__
+#define	__TRACE_H__
+
+#include "glutcam.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+extern int start_trace(const char * path);
+extern void stop_trace(void);
+extern void trace_thread_name(const char * name);
+extern long long trace_begin(void);
+extern void trace_end(const char * name, long long start_usec);
+extern void trace_span(const char * name, long long start_usec,
+		       long long end_usec);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	//__TRACE_H__
@@ -0,0 +1,563 @@
+/* *************************************************************************
+* NAME: glutcam/workpool.c
+*
+* DESCRIPTION:
+*
+* a pool of worker threads that stay alive between frames. each call
+* to run_workpool is a batch of numbered jobs; the workers take job
+* numbers off a shared counter until there are none left, so a worker
+* that gets a slow job doesn't hold the others up.
+*
+* the caller doesn't do any of the jobs itself (unless the pool has no
+* threads): it waits until every worker has finished the batch. that
+* wait also guarantees nobody is still reading the old batch's func
+* and arg when the next batch starts.
+*
+* PROCESS:
+*
+* see workpool.h
+*
+* GLOBALS: none
+*
+* REFERENCES:
+*
+* LIMITATIONS:
+*
+* REVISION HISTORY:
+*
+*   STR                Description                          Author
+*
+*   17-Oct-26          initial coding
+*   17-Oct-26          workers get a trace track
+*
+* TARGET: Linux C (pthreads, gcc __atomic builtins)
+*
+* This software is in the public domain. if it breaks you get to keep
+* both pieces.
+*
+* ************************************************************************* */
+
+#include <stdio.h>
+#include <string.h> /* memset  */
+#include <unistd.h> /* sysconf  */
+#include <pthread.h>
+
+#include "glutcam.h"
+#include "workpool.h"
+#include "trace.h" /* trace_thread_name  */
+
+/* MAX_CORE_IDS - the most distinct (package, core) pairs we'll count  */
+
+#define MAX_CORE_IDS 1024
+
+/* local prototypes  */
+void * workpool_thread_main(void * arg);
+void do_workpool_jobs(Workpool_t * pool);
+int read_topology_value(int cpu, const char * name);
+/* end local prototypes  */
+
+
+
+/* *************************************************************************
+
+
+   NAME:  start_workpool
+
+
+   USAGE:
+
+   int some_int;
+   Workpool_t pool;
+   int nthreads;
+
+   some_int =  start_workpool(&pool, nthreads);
+
+   if (0 == some_int)
+   -- we're okay
+   else
+   -- handle an error
+
+   returns: int
+
+   DESCRIPTION:
+                 set up pool and start nthreads workers (at most
+		 WORKPOOL_MAX_THREADS). with 0 threads, run_workpool
+		 just does the jobs on the calling thread.
+
+		 if only some of the threads start, keep the ones that
+		 did and say so.
+
+		 return 0 if all's well
+		       -1 if the pool couldn't be set up at all
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int start_workpool(Workpool_t * pool, int nthreads)
+{
+  int i, status;
+
+  memset(pool, 0, sizeof(*pool));
+
+  if ((0 != pthread_mutex_init(&(pool->lock), NULL))
+      || (0 != pthread_cond_init(&(pool->wake), NULL))
+      || (0 != pthread_cond_init(&(pool->done), NULL)))
+    {
+      fprintf(stderr, "Error: unable to set up worker pool\n");
+      return(-1);
+    }
+
+  if (nthreads > WORKPOOL_MAX_THREADS)
+    {
+      nthreads = WORKPOOL_MAX_THREADS;
+    }
+
+  for (i = 0; i < nthreads; i++)
+    {
+      status = pthread_create(&(pool->threads[i]), NULL,
+			      workpool_thread_main, pool);
+      if (0 != status)
+	{
+	  fprintf(stderr, "Error: started only %d of %d worker threads (%d)\n",
+		  i, nthreads, status);
+	  break;
+	}
+      pool->nthreads = i + 1;
+    }
+
+  return(0);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  run_workpool
+
+
+   USAGE:
+
+   Workpool_t pool;
+
+   run_workpool(&pool, some_func, &some_args, njobs);
+
+   returns: void
+
+   DESCRIPTION:
+                 call func(arg, job) for job = 0...njobs - 1 on the
+		 pool's threads and return when they're all done.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   func has to be safe to run on several threads at once for
+   different jobs.
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void run_workpool(Workpool_t * pool, Workfunc_t func, void * arg, int njobs)
+{
+  int job;
+
+  if (0 == pool->nthreads)
+    {
+      for (job = 0; job < njobs; job++)
+	{
+	  func(arg, job);
+	}
+      return;
+    }
+
+  pthread_mutex_lock(&(pool->lock));
+
+  pool->func = func;
+  pool->arg = arg;
+  pool->njobs = njobs;
+  __atomic_store_n(&(pool->next_job), 0, __ATOMIC_RELAXED);
+  pool->busy = pool->nthreads;
+  pool->batch++;
+  pthread_cond_broadcast(&(pool->wake));
+
+  while (0 < pool->busy)
+    {
+      pthread_cond_wait(&(pool->done), &(pool->lock));
+    }
+
+  pthread_mutex_unlock(&(pool->lock));
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  stop_workpool
+
+
+   USAGE:
+
+   Workpool_t pool;
+
+   stop_workpool(&pool);
+
+   returns: void
+
+   DESCRIPTION:
+                 tell the workers to quit and wait for them. safe to
+		 call on a pool that's already stopped.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void stop_workpool(Workpool_t * pool)
+{
+  int i;
+
+  if (0 == pool->nthreads)
+    {
+      return;
+    }
+
+  pthread_mutex_lock(&(pool->lock));
+  pool->shutdown = 1;
+  pthread_cond_broadcast(&(pool->wake));
+  pthread_mutex_unlock(&(pool->lock));
+
+  for (i = 0; i < pool->nthreads; i++)
+    {
+      pthread_join(pool->threads[i], NULL);
+    }
+
+  pool->nthreads = 0;
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  physical_core_count
+
+
+   USAGE:
+
+   int ncores;
+
+   ncores =  physical_core_count();
+
+   returns: int
+
+   DESCRIPTION:
+                 count the distinct (physical package, core) pairs
+		 among the online CPUs in sysfs, so hyperthread
+		 siblings count once. if sysfs doesn't tell us, return
+		 the number of online CPUs.
+
+   REFERENCES: /sys/devices/system/cpu/cpuN/topology
+
+   LIMITATIONS:
+
+   assumes the online CPUs are numbered 0...n - 1
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int physical_core_count(void)
+{
+  static long long seen[MAX_CORE_IDS];
+  long long id;
+  int ncpus, ncores, cpu, package, core, i;
+
+  ncpus = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  if (1 > ncpus)
+    {
+      return(1);
+    }
+
+  ncores = 0;
+  for (cpu = 0; cpu < ncpus; cpu++)
+    {
+      package = read_topology_value(cpu, "physical_package_id");
+      core = read_topology_value(cpu, "core_id");
+      if ((0 > package) || (0 > core))
+	{
+	  return(ncpus); /* no topology information  */
+	}
+
+      id = ((long long)package << 32) | core;
+      for (i = 0; (i < ncores) && (seen[i] != id); i++)
+	{
+	  /* look for it  */
+	}
+
+      if ((i == ncores) && (ncores < MAX_CORE_IDS))
+	{
+	  seen[ncores++] = id;
+	}
+    }
+
+  return(ncores);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  workpool_thread_main
+
+
+   USAGE:
+
+   pthread_create(&thread, NULL, workpool_thread_main, pool);
+
+   returns: void *
+
+   DESCRIPTION:
+                 the body of a worker: wait for a batch, help with it,
+		 report done, repeat until the pool shuts down.
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+     17-Oct-26  name the trace track
+
+ ************************************************************************* */
+
+void * workpool_thread_main(void * arg)
+{
+  Workpool_t * pool;
+  unsigned int seen;
+
+  pool = (Workpool_t *)arg;
+  trace_thread_name("worker");
+  /* start_workpool left batch at 0. don't read it under the lock:  */
+  /* a batch may already have started before we got here.           */
+  seen = 0;
+
+  pthread_mutex_lock(&(pool->lock));
+
+  while (1)
+    {
+      while ((seen == pool->batch) && (0 == pool->shutdown))
+	{
+	  pthread_cond_wait(&(pool->wake), &(pool->lock));
+	}
+
+      if (0 != pool->shutdown)
+	{
+	  break;
+	}
+
+      seen = pool->batch;
+      pthread_mutex_unlock(&(pool->lock));
+
+      do_workpool_jobs(pool);
+
+      pthread_mutex_lock(&(pool->lock));
+      pool->busy--;
+      if (0 == pool->busy)
+	{
+	  pthread_cond_signal(&(pool->done));
+	}
+    }
+
+  pthread_mutex_unlock(&(pool->lock));
+
+  return(NULL);
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  do_workpool_jobs
+
+
+   USAGE:
+
+   do_workpool_jobs(pool);
+
+   returns: void
+
+   DESCRIPTION:
+                 take jobs from the current batch until there are
+		 none left
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   call without pool->lock held; func, arg and njobs don't change
+   until every worker has finished the batch.
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+void do_workpool_jobs(Workpool_t * pool)
+{
+  int job;
+
+  while ((job = __atomic_fetch_add(&(pool->next_job), 1, __ATOMIC_RELAXED))
+	 < pool->njobs)
+    {
+      pool->func(pool->arg, job);
+    }
+}
+
+
+
+/* *************************************************************************
+
+
+   NAME:  read_topology_value
+
+
+   USAGE:
+
+   int core;
+
+   core =  read_topology_value(cpu, "core_id");
+
+   returns: int
+
+   DESCRIPTION:
+                 read /sys/devices/system/cpu/cpu<cpu>/topology/<name>
+
+		 return the number in it, or -1 if it can't be read
+
+   REFERENCES:
+
+   LIMITATIONS:
+
+   GLOBAL VARIABLES:
+
+      accessed: none
+
+      modified: none
+
+   FUNCTIONS CALLED:
+
+   REVISION HISTORY:
+
+        STR                  Description of Revision                 Author
+
+     17-Oct-26               initial coding
+
+ ************************************************************************* */
+
+int read_topology_value(int cpu, const char * name)
+{
+  char path[128];
+  FILE * fp;
+  int value;
+
+  snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/%s",
+	   cpu, name);
+
+  fp = fopen(path, "r");
+  if (NULL == fp)
+    {
+      return(-1);
+    }
+
+  if (1 != fscanf(fp, "%d", &value))
+    {
+      value = -1;
+    }
+
+  fclose(fp);
+
+  return(value);
+}
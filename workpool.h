@@ -0,0 +1,60 @@
+/* *************************************************************************
+* NAME: glutcam/workpool.h
+*
+* DESCRIPTION:
+*
+* this is the header file for the functions exported from workpool.c
+*
+* PROCESS:
+*
+* start_workpool starts a Workpool_t (see glutcam.h) with n threads
+*
+* run_workpool hands a batch of jobs to the threads and waits until
+*   they're all done
+*
+* stop_workpool shuts the threads down
+*
+* physical_core_count is the number of CPU cores, not counting
+*   hyperthreads: the default size for a pool
+*
+* GLOBALS: none
+*
+* REFERENCES:
+*
+* LIMITATIONS:
+*
+* one thread at a time calls run_workpool on a given pool.
+*
+* REVISION HISTORY:
+*
+*   STR                Description                          Author
+*
+*   17-Oct-26          initial coding
+*
+* TARGET: Linux C
+*
+* This software is in the public domain. if it breaks you get to keep
+* both pieces.
+*
+* ************************************************************************* */
+
+#ifndef	__WORKPOOL_H__
+#define	__WORKPOOL_H__
+
+#include "glutcam.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+extern int start_workpool(Workpool_t * pool, int nthreads);
+extern void run_workpool(Workpool_t * pool, Workfunc_t func, void * arg,
+			 int njobs);
+extern void stop_workpool(Workpool_t * pool);
+extern int physical_core_count(void);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	//__WORKPOOL_H__
@@ -54,6 +54,13 @@ uniform int color_output; // 0 , 1
 
 uniform int image_processing; // 0, 1
 
+// per_tile - if this is 1, the picture is a mosaic of tiles (see
+//   draw_video_tiles in callbacks.c) and each tile brings its own
+//   color_output and image_processing in gl_SecondaryColor.r and .g;
+//   the uniforms above are ignored.
+
+uniform int per_tile; // 0, 1
+
 // luma_texcoord_offsets - the offsets in texture coordinates to
 //   apply to our current coordinates to get the neighboring
 //   pixels (up, down, left, right). 
@@ -109,6 +116,37 @@ float laplace_luma()
 
 
 
+
+//
+// int tile_color_output()
+//
+// color_output for the tile being drawn
+//
+
+int tile_color_output()
+{
+  if (1 == per_tile)
+    {
+      return(int(gl_SecondaryColor.r + 0.5));
+    }
+  return(color_output);
+}
+
+//
+// int tile_image_processing()
+//
+// image_processing for the tile being drawn
+//
+
+int tile_image_processing()
+{
+  if (1 == per_tile)
+    {
+      return(int(gl_SecondaryColor.g + 0.5));
+    }
+  return(image_processing);
+}
+
 void main(void) 
 {
   
@@ -122,7 +160,7 @@ void main(void)
     {
       int i;
 
-      if (0 == image_processing) // no image processing
+      if (0 == tile_image_processing()) // no image processing
 	{
 	  // just look up the brightness
 	  y=texture2D(image_texture_unit,gl_TexCoord[0].st).r;
@@ -135,7 +173,7 @@ void main(void)
 	  y = laplace_luma();
 	}
       
-      if (1 == color_output) // we want color
+      if (1 == tile_color_output()) // we want color
 	{
 	  //
 	  // do the math to turn YUV into RGB
@@ -53,6 +53,13 @@ uniform int color_output; // 0 , 1
 
 uniform int image_processing; // 0, 1
 
+// per_tile - if this is 1, the picture is a mosaic of tiles (see
+//   draw_video_tiles in callbacks.c) and each tile brings its own
+//   color_output and image_processing in gl_SecondaryColor.r and .g;
+//   the uniforms above are ignored.
+
+uniform int per_tile; // 0, 1
+
 
 
 // luma_texcoord_offsets - the offsets in texture coordinates to
@@ -169,6 +176,37 @@ vec3 laplace_yuv422()
   return(yuv);
 }
   
+
+//
+// int tile_color_output()
+//
+// color_output for the tile being drawn
+//
+
+int tile_color_output()
+{
+  if (1 == per_tile)
+    {
+      return(int(gl_SecondaryColor.r + 0.5));
+    }
+  return(color_output);
+}
+
+//
+// int tile_image_processing()
+//
+// image_processing for the tile being drawn
+//
+
+int tile_image_processing()
+{
+  if (1 == per_tile)
+    {
+      return(int(gl_SecondaryColor.g + 0.5));
+    }
+  return(image_processing);
+}
+
 void main()
 {
   float red, green, blue;
@@ -203,7 +241,7 @@ void main()
  
       luma_chroma = texture2D(image_texture_unit, vec2(pixelx, pixely));
 
-      if (0 == image_processing) // no image processing
+      if (0 == tile_image_processing()) // no image processing
 	{
 	  // just look up the brightness
 	  luma = (luma_chroma.r - 0.0625) * 1.1643;
@@ -244,7 +282,7 @@ void main()
 
 	}
     
-      if (0 == color_output) // greyscale output desired
+      if (0 == tile_color_output()) // greyscale output desired
         {
 	  
 	  red = luma;